@@ -5,6 +5,7 @@
 #include "AStar.h"
 #include "AStarTile2D.h"
 #include "TVector2.h"
+#include "AllocBenchmark.h"
 
 #include <algorithm>
 
@@ -419,6 +420,17 @@ namespace AStar
 				}
 				while( node );
 			}
+
+			if ( mHaveBenchResult )
+			{
+				g.setTextColor( 0 , 0 , 0 );
+				for( int i = 0 ; i < NumAllocBenchCase ; ++i )
+				{
+					FixString< 64 > str;
+					str.format( "%s(%d) : malloc %.1f ms pool %.1f ms" , mBenchResult[i].name , (int)mBenchResult[i].size , mBenchResult[i].mallocMs , mBenchResult[i].poolMs );
+					g.drawText( Vec2i( 400 , 20 + 16 * i ) , str );
+				}
+			}
 		}
 
 
@@ -428,6 +440,7 @@ namespace AStar
 			mAStar.mClearance = 1;
 			mStartPos = Vec2i( 0 ,0 );
 			mPath = nullptr;
+			mHaveBenchResult = false;
 		}
 
 
@@ -475,10 +488,16 @@ namespace AStar
 			switch( key )
 			{
 			case 'R': restart(); break;
+			case 'B':
+				runAllocBenchmark( 20000 , 50 , mBenchResult );
+				mHaveBenchResult = true;
+				break;
 			}
 			return false;
 		}
 		MyAStar::NodeType* mPath;
+		AllocBenchResult   mBenchResult[ NumAllocBenchCase ];
+		bool               mHaveBenchResult;
 		Vec2i   mStartPos;
 		MyAStar mAStar;
 	};
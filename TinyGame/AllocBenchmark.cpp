@@ -0,0 +1,84 @@
+#include "TinyGamePCH.h"
+#include "AllocBenchmark.h"
+
+#include "PoolAllocator.h"
+#include "AStarTile2D.h"
+#include "TUnsignedHash.h"
+#include "TQuadTreeTile.h"
+#include "Clock.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+struct MallocBenchPolicy
+{
+	static void* Alloc( size_t size ){ return ::malloc( size ); }
+	static void  Free( void* ptr , size_t ){ ::free( ptr ); }
+};
+
+struct PoolBenchPolicy
+{
+	static void* Alloc( size_t size ){ return PoolAllocator::Alloc( size ); }
+	static void  Free( void* ptr , size_t size ){ PoolAllocator::Free( ptr , size ); }
+};
+
+template< class Policy >
+static unsigned long RunAllocLoop( size_t size , int numLoop , std::vector< int > const& order , std::vector< void* >& blocks )
+{
+	int numBlock = (int)blocks.size();
+
+	TClock clock;
+	for( int i = 0 ; i < numBlock ; ++i )
+		blocks[i] = Policy::Alloc( size );
+
+	for( int loop = 0 ; loop < numLoop ; ++loop )
+	{
+		//free half in shuffled order , so free lists are not in address order
+		for( int i = 0 ; i < numBlock / 2 ; ++i )
+		{
+			int idx = order[ ( i + loop ) % numBlock ];
+			Policy::Free( blocks[ idx ] , size );
+			blocks[ idx ] = NULL;
+		}
+		for( int i = 0 ; i < numBlock ; ++i )
+		{
+			if ( !blocks[i] )
+				blocks[i] = Policy::Alloc( size );
+		}
+	}
+
+	for( int i = 0 ; i < numBlock ; ++i )
+		Policy::Free( blocks[i] , size );
+
+	return clock.getTimeMicroseconds();
+}
+
+void runAllocBenchmark( int numBlock , int numLoop , AllocBenchResult result[] )
+{
+	typedef AStar::Tile2DNode AStarNode;
+	typedef Private::Node< int > HashNode;
+
+	char const* caseName[ NumAllocBenchCase ] = { "AStarNode" , "HashNode" , "QuadLeafNode" , "QuadGrayNode" };
+	size_t caseSize[ NumAllocBenchCase ] =
+	{
+		sizeof( AStarNode ) ,
+		sizeof( HashNode ) ,
+		sizeof( TQuadTreeTile::LeafNode ) ,
+		sizeof( TQuadTreeTile::GrayNode ) ,
+	};
+
+	std::vector< int > order( numBlock );
+	for( int i = 0 ; i < numBlock ; ++i )
+		order[i] = i;
+	std::random_shuffle( order.begin() , order.end() );
+
+	std::vector< void* > blocks( numBlock );
+	for( int n = 0 ; n < NumAllocBenchCase ; ++n )
+	{
+		result[n].name = caseName[n];
+		result[n].size = caseSize[n];
+		result[n].mallocMs = RunAllocLoop< MallocBenchPolicy >( caseSize[n] , numLoop , order , blocks ) / 1000.0f;
+		result[n].poolMs   = RunAllocLoop< PoolBenchPolicy >( caseSize[n] , numLoop , order , blocks ) / 1000.0f;
+	}
+}
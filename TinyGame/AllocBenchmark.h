@@ -0,0 +1,22 @@
+#ifndef AllocBenchmark_h__
+#define AllocBenchmark_h__
+
+#include <cstddef>
+
+struct AllocBenchResult
+{
+	char const* name;
+	size_t      size;
+	//time of all alloc and free calls
+	float       mallocMs;
+	float       poolMs;
+};
+
+int const NumAllocBenchCase = 4;
+
+//  Allocates and frees numBlock blocks of the node sizes of AStarT , TUnisgnedHash
+//  and TQuadTree for numLoop loops with malloc and PoolAllocator.
+//  Half of blocks are freed and allocated again in shuffled order each loop.
+void runAllocBenchmark( int numBlock , int numLoop , AllocBenchResult result[] );
+
+#endif // AllocBenchmark_h__
@@ -5,6 +5,8 @@
 
 #include "CoreShare.h"
 
+#include <algorithm>
+
 //FIXME
 #include "GameGlobal.h"
 
@@ -97,12 +99,19 @@ namespace BomberMan
 		mFreeIndex  = -1;
 		mListener = NULL;
 		mIsEntitiesDirty = true;
+		mColOrder = 0;
+		mColVisitStamp = 0;
+		mColDispatchLevel = 0;
 	}
 
 	void World::setupMap( Vec2i const& size , uint16 const* id )
 	{
 		if ( mMap.getSizeX() != size.x || mMap.getSizeY() != size.y )
+		{
 			mMap.resize( size.x , size.y );
+			mColGrid.resize( size.x , size.y );
+			rebuildColGrid();
+		}
 
 		int num = size.x * size.y;
 		if ( id )
@@ -163,38 +172,45 @@ namespace BomberMan
 		CollisionInfo info;
 		info.type = COL_OBJECT;
 
-		for( ColObjectList::iterator iter1 = mColObjList.begin();
-			iter1 != mColObjList.end() ; ++iter1 )
+		for( ColObjectList::iterator iter = mColObjList.begin();
+			iter != mColObjList.end() ; ++iter )
 		{
-			ColObjectData& data = *iter1;
-			ColObject* obj1 = iter1->obj;
-			Entity*    client1 = obj1->getClient();
-			data.bMin = client1->getPos() - obj1->getHalfBoundSize();
-			data.bMax = client1->getPos() + obj1->getHalfBoundSize();
+			updateColBound( *iter );
 		}
 
+		++mColDispatchLevel;
 		for( ColObjectList::iterator iter1 = mColObjList.begin();
 			iter1 != mColObjList.end() ; ++iter1 )
 		{
-			ColObjectData& data = *iter1;
-			ColObject* obj1 = iter1->obj;
-			Entity*    client1 = obj1->getClient();
+			ColObjectData& data1 = *iter1;
+			if ( !data1.obj )
+				continue;
 
-			ColObjectList::iterator iter2 = iter1;
-			++iter2;
+			//only objects added later , so every pair is tested once
+			beginColQuery();
+			queryColObjects( data1.bMin , data1.bMax , data1.order );
+			std::sort( mColQueryList.begin() , mColQueryList.end() , compareColOrder );
 
-			for ( ; iter2 != mColObjList.end() ; ++iter2 )
+			for( size_t i = 0 ; i < mColQueryList.size() ; ++i )
 			{
-				ColObject* obj2 = iter2->obj;
-				Entity*    client2 = obj2->getClient();
+				ColObject* obj1 = data1.obj;
+				if ( !obj1 )
+					break;
+				ColObjectData& data2 = *mColQueryList[i];
+				ColObject* obj2 = data2.obj;
+				if ( !obj2 )
+					continue;
+
+				Entity* client1 = obj1->getClient();
+				Entity* client2 = obj2->getClient();
 
 				bool b1 = ( obj1->getColMask() & gTypeMask[ client2->getType() ] ) != 0;
 				bool b2 = ( obj2->getColMask() & gTypeMask[ client1->getType() ] ) != 0;
 				if ( b1 && b2 )
 				{
-					if ( testIntersect( iter1->bMin , iter1->bMax , iter2->bMin , iter2->bMax ) )
+					if ( testIntersect( data1.bMin , data1.bMax , data2.bMin , data2.bMax ) )
 					{
-						Msg( "Object Collision ( %d , %d )" , obj1->getClient()->getType() , obj2->getClient()->getType() );
+						Msg( "Object Collision ( %d , %d )" , client1->getType() , client2->getType() );
 						info.obj = obj2;
 						obj1->notifyCollision( info );
 						info.obj = obj1;
@@ -203,6 +219,8 @@ namespace BomberMan
 				}
 			}
 		}
+		--mColDispatchLevel;
+		purgeColObjects();
 
 		int  index = mUsingIndex;
 		int* pLinkIndex = &mUsingIndex;
@@ -587,10 +605,18 @@ namespace BomberMan
 		info.type = COL_FIRE;
 		info.bomb = &bomb;
 
-		for( ColObjectList::iterator iter = mColObjList.begin();
-				iter != mColObjList.end() ; ++iter )
+		//fire is a cross , query the box of each arm
+		beginColQuery();
+		for( int i = 0 ; i < 4 ; ++i )
+			queryColObjects( bombPos + minFire[i] , bombPos + maxFire[i] , 0 );
+		std::sort( mColQueryList.begin() , mColQueryList.end() , compareColOrder );
+
+		++mColDispatchLevel;
+		for( size_t idx = 0 ; idx < mColQueryList.size() ; ++idx )
 		{
-			ColObjectData& data = *iter;
+			ColObjectData& data = *mColQueryList[ idx ];
+			if ( !data.obj )
+				continue;
 
 			if ( data.obj->getColMask() & CMB_FIRE )
 			{
@@ -602,12 +628,15 @@ namespace BomberMan
 					if ( testIntersect( minFire[i] , maxFire[i] , minObj , maxObj ) )
 					{
 						data.obj->notifyCollision( info );
-						bomb.owner->onFireCollision( bomb , *data.obj );
+						if ( data.obj )
+							bomb.owner->onFireCollision( bomb , *data.obj );
 						break;
 					}
 				}
 			}
 		}
+		--mColDispatchLevel;
+		purgeColObjects();
 	}
 
 
@@ -672,8 +701,17 @@ namespace BomberMan
 	void World::addColObject( ColObject& obj )
 	{
 		ColObjectData data;
-		data.obj       = &obj;
+		data.obj        = &obj;
+		data.order      = ++mColOrder;
+		data.visitStamp = 0;
+		data.cellMin    = Vec2i( 0 , 0 );
+		data.cellMax    = Vec2i( -1 , -1 );
 		mColObjList.push_back( data );
+
+		ColObjectData& dataAdded = mColObjList.back();
+		dataAdded.bMin = obj.getClient()->getPos() - obj.getHalfBoundSize();
+		dataAdded.bMax = obj.getClient()->getPos() + obj.getHalfBoundSize();
+		addColCells( dataAdded );
 	}
 
 	void World::removeColObject( ColObject& obj )
@@ -683,12 +721,153 @@ namespace BomberMan
 		{
 			if ( iter->obj == &obj )
 			{
-				mColObjList.erase( iter );
+				removeColCells( *iter );
+				//the data may be in a query list , erase it after dispatching
+				if ( mColDispatchLevel )
+					iter->obj = NULL;
+				else
+					mColObjList.erase( iter );
 				return;
 			}
 		}
 	}
 
+	void World::purgeColObjects()
+	{
+		if ( mColDispatchLevel )
+			return;
+
+		for( ColObjectList::iterator iter = mColObjList.begin();
+			iter != mColObjList.end() ; )
+		{
+			if ( iter->obj == NULL )
+				iter = mColObjList.erase( iter );
+			else
+				++iter;
+		}
+	}
+
+	static int ToColCell( float pos , int size )
+	{
+		int result = int( std::floor( pos / gTileLength ) );
+		if ( result < 0 )
+			return 0;
+		if ( result > size - 1 )
+			return size - 1;
+		return result;
+	}
+
+	void World::calcColCellRange( Vec2f const& bMin , Vec2f const& bMax , Vec2i& cellMin , Vec2i& cellMax )
+	{
+		cellMin.x = ToColCell( bMin.x , mColGrid.getSizeX() );
+		cellMin.y = ToColCell( bMin.y , mColGrid.getSizeY() );
+		cellMax.x = ToColCell( bMax.x , mColGrid.getSizeX() );
+		cellMax.y = ToColCell( bMax.y , mColGrid.getSizeY() );
+	}
+
+	void World::updateColBound( ColObjectData& data )
+	{
+		if ( !data.obj )
+			return;
+
+		ColObject* obj = data.obj;
+		Entity*    client = obj->getClient();
+		data.bMin = client->getPos() - obj->getHalfBoundSize();
+		data.bMax = client->getPos() + obj->getHalfBoundSize();
+
+		if ( mColGrid.getRawDataSize() == 0 )
+			return;
+
+		Vec2i cellMin , cellMax;
+		calcColCellRange( data.bMin , data.bMax , cellMin , cellMax );
+		if ( cellMin == data.cellMin && cellMax == data.cellMax )
+			return;
+
+		removeColCells( data );
+		addColCells( data );
+	}
+
+	void World::addColCells( ColObjectData& data )
+	{
+		if ( mColGrid.getRawDataSize() == 0 )
+			return;
+
+		calcColCellRange( data.bMin , data.bMax , data.cellMin , data.cellMax );
+		for( int j = data.cellMin.y ; j <= data.cellMax.y ; ++j )
+		for( int i = data.cellMin.x ; i <= data.cellMax.x ; ++i )
+		{
+			mColGrid.getData( i , j ).push_back( &data );
+		}
+	}
+
+	void World::removeColCells( ColObjectData& data )
+	{
+		for( int j = data.cellMin.y ; j <= data.cellMax.y ; ++j )
+		for( int i = data.cellMin.x ; i <= data.cellMax.x ; ++i )
+		{
+			ColCell& cell = mColGrid.getData( i , j );
+			ColCell::iterator iter = std::find( cell.begin() , cell.end() , &data );
+			assert( iter != cell.end() );
+			*iter = cell.back();
+			cell.pop_back();
+		}
+		data.cellMin = Vec2i( 0 , 0 );
+		data.cellMax = Vec2i( -1 , -1 );
+	}
+
+	void World::rebuildColGrid()
+	{
+		for( ColObjectList::iterator iter = mColObjList.begin();
+			iter != mColObjList.end() ; ++iter )
+		{
+			iter->cellMin = Vec2i( 0 , 0 );
+			iter->cellMax = Vec2i( -1 , -1 );
+		}
+		for( TGrid2D< ColCell >::iterator iter = mColGrid.begin() ; iter != mColGrid.end() ; ++iter )
+			iter->clear();
+
+		for( ColObjectList::iterator iter = mColObjList.begin();
+			iter != mColObjList.end() ; ++iter )
+		{
+			if ( iter->obj )
+				addColCells( *iter );
+		}
+	}
+
+	bool World::compareColOrder( ColObjectData const* lhs , ColObjectData const* rhs )
+	{
+		return lhs->order < rhs->order;
+	}
+
+	void World::beginColQuery()
+	{
+		mColQueryList.clear();
+		++mColVisitStamp;
+	}
+
+	void World::queryColObjects( Vec2f const& bMin , Vec2f const& bMax , unsigned minOrder )
+	{
+		if ( mColGrid.getRawDataSize() == 0 )
+			return;
+
+		Vec2i cellMin , cellMax;
+		calcColCellRange( bMin , bMax , cellMin , cellMax );
+
+		for( int j = cellMin.y ; j <= cellMax.y ; ++j )
+		for( int i = cellMin.x ; i <= cellMax.x ; ++i )
+		{
+			ColCell& cell = mColGrid.getData( i , j );
+			for( ColCell::iterator iter = cell.begin() ; iter != cell.end() ; ++iter )
+			{
+				ColObjectData* data = *iter;
+				if ( data->order <= minOrder || data->visitStamp == mColVisitStamp )
+					continue;
+				data->visitStamp = mColVisitStamp;
+				mColQueryList.push_back( data );
+			}
+		}
+	}
+
 	void World::moveBomb( int idx , Dir dir , float speed , bool beForce )
 	{
 		Bomb& bomb = getBomb( idx );
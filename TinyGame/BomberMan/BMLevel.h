@@ -728,6 +728,8 @@ namespace BomberMan
 				iter != mColObjList.end() ; ++iter )
 			{
 				ColObject* obj = iter->obj;
+				if ( !obj )
+					continue;
 				fun( obj );
 			}
 		}
@@ -735,13 +737,41 @@ namespace BomberMan
 	private:
 		struct ColObjectData
 		{
+			//NULL if removed while collision is dispatching
 			ColObject* obj;
 			Vec2f      bMin;
 			Vec2f      bMax;
+			//add order , collisions are reported in this order
+			unsigned   order;
+			unsigned   visitStamp;
+			Vec2i      cellMin;
+			Vec2i      cellMax;
 		};
 		typedef std::list< ColObjectData > ColObjectList;
 		ColObjectList mColObjList;
 
+		//  Spatial hash of collision objects , a cell is one tile of the map.
+		//  An object is in all cells its bound box touches , objects out of
+		//  the map are in the border cells.
+		typedef std::vector< ColObjectData* > ColCell;
+		TGrid2D< ColCell >             mColGrid;
+		std::vector< ColObjectData* >  mColQueryList;
+		unsigned mColOrder;
+		unsigned mColVisitStamp;
+		int      mColDispatchLevel;
+
+		void updateColBound( ColObjectData& data );
+		void addColCells( ColObjectData& data );
+		void removeColCells( ColObjectData& data );
+		void rebuildColGrid();
+		void calcColCellRange( Vec2f const& bMin , Vec2f const& bMax , Vec2i& cellMin , Vec2i& cellMax );
+		//add objects in cells of the box and added after minOrder to mColQueryList ,
+		//an object is added once between beginColQuery calls
+		void beginColQuery();
+		void queryColObjects( Vec2f const& bMin , Vec2f const& bMax , unsigned minOrder );
+		static bool compareColOrder( ColObjectData const* lhs , ColObjectData const* rhs );
+		void purgeColObjects();
+
 		void testFireCollision( Bomb& bomb );
 		void resolveCollision( ColObjectData& data1 , ColObjectData& data2 );
 		void resolvePlayerCollision( ColObjectData& data1 , ColObjectData& data2 );
@@ -73,6 +73,8 @@ namespace BomberMan
 	protected:
 		//virtual 
 		IFrameActionTemplate* createActionTemplate( unsigned version );
+		//TODO : level still moves in float and gives no calcFrameChecksum , so lockstep
+		//desync isn't detected , move it to Fixed like Bubble
 		bool                  setupNetwork( NetWorker* netWorker , INetEngine** engine );
 		StageStep        mStep;
 		Mode*            mMode;
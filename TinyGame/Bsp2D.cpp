@@ -2,6 +2,9 @@
 #include "Bsp2D.h"
 
 #include "FixVector.h"
+#include "FrameAllocator.h"
+
+#include <cfloat>
 
 namespace Bsp2D
 {
@@ -75,7 +78,7 @@ namespace Bsp2D
 		return SIDE_SPLIT;
 	}
 
-	Side Plane::testSide( Vec2f const& p , float& dist )
+	Side Plane::testSide( Vec2f const& p , float& dist ) const
 	{
 		dist = calcDistance( p );
 		if ( dist > WallThin )
@@ -85,7 +88,7 @@ namespace Bsp2D
 		return SIDE_IN;
 	}
 
-	Bsp2D::Side Plane::testSegment( Vec2f const& v0 , Vec2f const& v1 )
+	Bsp2D::Side Plane::testSegment( Vec2f const& v0 , Vec2f const& v1 ) const
 	{
 		float dist;
 		Side s0 = testSide( v0 , dist );
@@ -113,19 +116,11 @@ namespace Bsp2D
 
 	void Tree::clear()
 	{
-		if ( mRoot )
-		{
-			struct DeleteFun
-			{
-				void operator() ( Node* node ){ delete node; }
-			};
-			std::for_each( mNodes.begin() , mNodes.end() , DeleteFun() );
-			//deleteNode_R( mRoot );
-			mNodes.clear();
-			mRoot = nullptr;
-		}
+		mNodes.clear();
 		mEdges.clear();
 		mLeaves.clear();
+		mNumSplitNode = 0;
+		mMaxDepth = 0;
 	}
 
 	void Tree::build( PolyArea* polys[] , int num , Vec2f const& bbMin , Vec2f const& bbMax )
@@ -169,56 +164,58 @@ namespace Bsp2D
 		IndexVec idxEdges( numEdge );
 		std::generate_n( idxEdges.begin() , numEdge , CountFun() );
 
-		assert( mRoot == nullptr );
+		//split edges are appended , avoid most reallocations
+		mEdges.reserve( 2 * numEdge );
+		mNodes.reserve( 2 * numEdge );
 
-		mRoot = contructTree_R( idxEdges );
-		mRoot->parent = nullptr;
+		contructTree_R( idxEdges , -1 , 0 );
 	}
 
-	Tree::Node* Tree::contructTree_R( IndexVec& idxEdges )
+	int Tree::contructTree_R( IndexVec& idxEdges , int parent , int depth )
 	{
 		if ( idxEdges.empty() )
-			return nullptr;
+			return -1;
 
-		int idx = choiceBestSplitEdge( idxEdges );
+		mMaxDepth = std::max( mMaxDepth , depth );
 
-		Node* node = new Node;
+		int idx = choiceBestSplitEdge( idxEdges );
 
-		node->idxEdge   = idx;
+		int idxNode = (int)mNodes.size();
+		mNodes.push_back( Node() );
+		Node& node = mNodes.back();
+		node.idxEdge = idx;
+		node.parent  = parent;
+		node.front   = -1;
+		node.back    = -1;
 
 		if ( idx < 0 ) // leaf
 		{
-			node->tag   = ~uint32( mLeaves.size() );
-			node->front = nullptr;
-			node->back  = nullptr;
+			node.tag = ~uint32( mLeaves.size() );
 
 			mLeaves.push_back( Leaf() );
 			Leaf& data = mLeaves.back();
-			data.node = node;
+			data.node = idxNode;
 			data.edges.swap( idxEdges );
-			return node;
-		}
-		else
-		{
-			node->tag = uint32( mNodes.size() );
-			mNodes.push_back( node );
+			return idxNode;
 		}
 
-		//triList.erase( cIter );
+		node.tag   = uint32( idxNode );
+		node.plane = mEdges[ idx ].plane;
+		++mNumSplitNode;
 
 		IndexVec idxFronts;
 		IndexVec idxBacks;
 
-		Plane& plane = mEdges[ idx ].plane;
+		//mEdges can grow in the loop , don't keep reference
+		Plane plane = mEdges[ idx ].plane;
 
 		for( IndexVec::iterator iter( idxEdges.begin() ) , itEnd( idxEdges.end() ) ; 
 			iter != itEnd ; ++iter  )
 		{
 			int idxTest = *iter;
-			Edge& edgeTest = mEdges[ idxTest ];
 
 			Vec2f vSplit[2];
-			switch ( plane.splice( edgeTest.v , vSplit ) )
+			switch ( plane.splice( mEdges[ idxTest ].v , vSplit ) )
 			{
 			case SIDE_FRONT:
 			case SIDE_IN:
@@ -231,69 +228,134 @@ namespace Bsp2D
 				{
 					idxFronts.push_back( idxTest );
 					idxBacks.push_back( (int)mEdges.size() );
-					mEdges.push_back( Edge() );
-					Edge& edge = mEdges.back();
-					edge.v[0] = vSplit[0];
-					edge.v[1] = vSplit[1];
-					edge.plane = edgeTest.plane;
-					edge.idx   = edgeTest.idx;
+					Edge edge;
+					edge.v[0]  = vSplit[0];
+					edge.v[1]  = vSplit[1];
+					edge.plane = mEdges[ idxTest ].plane;
+					edge.idx   = mEdges[ idxTest ].idx;
+					mEdges.push_back( edge );
 				}
 				break;
 			}				
 		}
+		IndexVec().swap( idxEdges );
+
+		//front subtree follows the node in the array
+		int front = contructTree_R( idxFronts , idxNode , depth + 1 );
+		int back  = contructTree_R( idxBacks , idxNode , depth + 1 );
+		mNodes[ idxNode ].front = front;
+		mNodes[ idxNode ].back  = back;
+		return idxNode;
+	}
 
-		node->front = contructTree_R( idxFronts );
-		if ( node->front )
-			node->front->parent = node;
-
-		node->back  = contructTree_R( idxBacks );
-		if ( node->back )
-			node->back->parent = node;
+	struct EdgeBound
+	{
+		EdgeBound():min( FLT_MAX , FLT_MAX ),max( -FLT_MAX , -FLT_MAX ){}
 
-		node->tag   = 0;
+		void add( Vec2f const& p )
+		{
+			min.x = std::min( min.x , p.x ); min.y = std::min( min.y , p.y );
+			max.x = std::max( max.x , p.x ); max.y = std::max( max.y , p.y );
+		}
+		//half perimeter , chance of a random line hitting the bound
+		float getCostArea() const
+		{
+			if ( min.x > max.x )
+				return 0;
+			return ( max.x - min.x ) + ( max.y - min.y );
+		}
+		Vec2f min;
+		Vec2f max;
+	};
 
-		return node;
-	}
+	//split cost = traversal + hit chance of child * edges of child + split penalty
+	float const SplitTraversalCost = 1.0f;
+	float const SplitEdgeCost      = 4.0f;
+	//only test part of the candidates on large sets
+	int const   MaxSplitCandidate  = 64;
 
 	int Tree::choiceBestSplitEdge( IndexVec const& idxEdges )
 	{
-		int minVal = INT_MAX;
-		int result = -1;
+		int numEdge = (int)idxEdges.size();
 
-		//return result;
-		for( IndexVec::const_iterator iter ( idxEdges.begin() ) , itEnd( idxEdges.end() ) ; 
-			iter != itEnd ; ++iter  )
+		EdgeBound bound;
+		for( int i = 0 ; i < numEdge ; ++i )
 		{
-			int numFront = 0;
-			int numBack = 0;
-			int numSplit = 0;
-			int numOnPlane = 0;
+			Edge const& edge = mEdges[ idxEdges[i] ];
+			bound.add( edge.v[0] );
+			bound.add( edge.v[1] );
+		}
+		float area = std::max( bound.getCostArea() , FLOAT_EPSILON );
+
+		float minCost = FLT_MAX;
+		int   result  = -1;
 
-			Edge& edge = mEdges[ *iter ];
-			Plane& plane = edge.plane;
+		int step = std::max( 1 , numEdge / MaxSplitCandidate );
+		for( int pass = 0 ; pass < 2 && result == -1 ; ++pass )
+		{
+			//convex set check needs all candidates if samples can't split
+			if ( pass == 1 )
+			{
+				if ( step == 1 )
+					break;
+				step = 1;
+			}
 
-			for( IndexVec::const_iterator iter2 ( idxEdges.begin() )  ; 
-				iter2 != itEnd ; ++iter2  )
+			for( int n = 0 ; n < numEdge ; n += step )
 			{
-				Edge& edgeTest = mEdges[ *iter2 ];
-				switch( plane.testSegment( edgeTest.v ) )
+				Plane const& plane = mEdges[ idxEdges[n] ].plane;
+
+				int numFront = 0;
+				int numBack  = 0;
+				int numSplit = 0;
+				int numOnPlane = 0;
+				EdgeBound frontBound;
+				EdgeBound backBound;
+
+				for( int i = 0 ; i < numEdge ; ++i )
 				{
-				case SIDE_FRONT: ++numFront; break;
-				case SIDE_BACK:  ++numBack;  break;
-				case SIDE_SPLIT: ++numSplit; break;
-				case SIDE_IN:    ++numOnPlane; break;
+					Edge& edgeTest = mEdges[ idxEdges[i] ];
+					switch( plane.testSegment( edgeTest.v ) )
+					{
+					case SIDE_IN:
+						++numOnPlane;
+						frontBound.add( edgeTest.v[0] );
+						frontBound.add( edgeTest.v[1] );
+						break;
+					case SIDE_FRONT:
+						++numFront;
+						frontBound.add( edgeTest.v[0] );
+						frontBound.add( edgeTest.v[1] );
+						break;
+					case SIDE_BACK:
+						++numBack;
+						backBound.add( edgeTest.v[0] );
+						backBound.add( edgeTest.v[1] );
+						break;
+					case SIDE_SPLIT:
+						++numSplit;
+						++numFront;
+						++numBack;
+						frontBound.add( edgeTest.v[0] );
+						frontBound.add( edgeTest.v[1] );
+						backBound.add( edgeTest.v[0] );
+						backBound.add( edgeTest.v[1] );
+						break;
+					}
 				}
-			}
 
-			if ( ( numSplit == 0 ) &&
-				( numBack == 0 || numFront == 0) )
-				continue;
+				//all edges on one side : plane doesn't separate anything
+				if ( numSplit == 0 && ( numBack == 0 || numFront == 0 ) )
+					continue;
 
-			int val = abs( numFront - numBack ) + 8 * numSplit;
-			if ( val < minVal )
-			{
-				result = *iter;
-				minVal = val;
+				float cost = SplitTraversalCost + 
+					( frontBound.getCostArea() * ( numFront + numOnPlane ) + backBound.getCostArea() * numBack ) / area +
+					SplitEdgeCost * numSplit;
+				if ( cost < minCost )
+				{
+					result  = idxEdges[n];
+					minCost = cost;
+				}
 			}
 		}
 		return result;
@@ -302,99 +364,124 @@ namespace Bsp2D
 	class Tree::SegmentColSolver
 	{
 	public:
-		bool solve( Tree& tree , Vec2f const& start , Vec2f const& end , ColInfo& info )
+		//stack lives in the frame allocator , solver is made every segment test
+		SegmentColSolver( Tree& tree )
+			:mTree( tree )
+			,mStack( TFrameStlAllocator< StackEntry >( Global::getFrameAllocator() ) )
 		{
-			if ( !tree.getRoot() )
-				return false;
-
-			mTree  = &tree;
-			mInfo  = &info;
-			mStart = start;
-			mEnd   = end;
-			return solve_R( mTree->getRoot() );
+			mStack.reserve( 64 );
 		}
 
-	private:
-
-		bool solve_R( Node* node )
+		bool solve( Vec2f const& start , Vec2f const& end , ColInfo& info )
 		{
-			assert( node );
+			info.indexEdge = -1;
+			info.frac      = 1.0f;
+			if ( mTree.mNodes.empty() )
+				return false;
 
-			if ( node->isLeaf() )
+			float bestFrac = FLT_MAX;
+
+			mStack.clear();
+			StackEntry entry = { 0 , 0.0f , 1.0f };
+			mStack.push_back( entry );
+
+			while( !mStack.empty() )
 			{
-				Leaf& leaf = mTree->getLeaf( node );
-				for( int i = 0 ; i < leaf.edges.size(); ++i )
-				{
-					int idxEdge = leaf.edges[i];
-					Edge& edge = mTree->getEdge( idxEdge );
+				entry = mStack.back();
+				mStack.pop_back();
 
-					float frac;
-					if ( SegmentInterection( mStart , mEnd , edge.v[0] , edge.v[1] , frac ) )
+				//a nearer hit is found
+				if ( entry.tMin > bestFrac )
+					continue;
+
+				Node const& node = mTree.mNodes[ entry.node ];
+				if ( node.isLeaf() )
+				{
+					Leaf const& leaf = mTree.mLeaves[ ~node.tag ];
+					for( int i = 0 ; i < (int)leaf.edges.size(); ++i )
 					{
-						mInfo->indexEdge = idxEdge;
-						mInfo->frac = frac;
-						return true;
+						int idxEdge = leaf.edges[i];
+						Edge const& edge = mTree.mEdges[ idxEdge ];
+
+						float frac;
+						if ( SegmentInterection( start , end , edge.v[0] , edge.v[1] , frac ) && frac < bestFrac )
+						{
+							bestFrac = frac;
+							info.indexEdge = idxEdge;
+							info.frac = frac;
+						}
 					}
-
+					continue;
 				}
-				return false;
-			}
 
-			Edge& edge = mTree->getEdge( node->idxEdge );
+				float d0 = node.plane.calcDistance( start );
+				float d1 = node.plane.calcDistance( end );
+				float dA = d0 + ( d1 - d0 ) * entry.tMin;
+				float dB = d0 + ( d1 - d0 ) * entry.tMax;
 
-			float dist;
-			Side s0 = edge.plane.testSide( mStart , dist );
-			Side s1 = edge.plane.testSide( mEnd , dist );
+				bool needFront = ( dA > -WallThin || dB > -WallThin ) && node.front != -1;
+				bool needBack  = ( dA <  WallThin || dB <  WallThin ) && node.back  != -1;
 
-			if ( s0 == SIDE_IN )
-			{
-				if ( solve_R( node->front ) )
-					return true;
-				if ( s1 == SIDE_BACK )
-					return solve_R( node->back );
-			}
-			else if ( s0 == s1 )
-			{
-				if ( s0 == SIDE_FRONT )
+				if ( needFront && needBack && dA != dB )
 				{
-					return solve_R( node->front );
+					//split the range at the plane , pad it by the wall thin
+					float scale = ( entry.tMax - entry.tMin ) / ( dB - dA );
+					float tSplit = entry.tMin - dA * scale;
+					float pad = WallThin * std::fabs( scale );
+					bool  frontFirst = dA > dB;
+
+					StackEntry nearEntry = { frontFirst ? node.front : node.back , entry.tMin , std::min( entry.tMax , tSplit + pad ) };
+					StackEntry farEntry  = { frontFirst ? node.back : node.front , std::max( entry.tMin , tSplit - pad ) , entry.tMax };
+					mStack.push_back( farEntry );
+					mStack.push_back( nearEntry );
 				}
 				else
 				{
-					return solve_R( node->back  );
-				}
-			}
-			else
-			{
-				if ( s0 == SIDE_FRONT )
-				{
-					if ( solve_R( node->front ) )
-						return true;
-					if ( solve_R( node->back ) )
-						return true;
-				}
-				else
-				{
-					if ( solve_R( node->back ) )
-						return true;
-					if ( solve_R( node->front ) )
-						return true;
+					if ( needBack )
+					{
+						entry.node = node.back;
+						mStack.push_back( entry );
+					}
+					if ( needFront )
+					{
+						entry.node = node.front;
+						mStack.push_back( entry );
+					}
 				}
 			}
 
-			return false;
+			return info.indexEdge != -1;
 		}
 
-		Tree::ColInfo* mInfo;
-		Tree*  mTree;
-		Vec2f  mStart;
-		Vec2f  mEnd;
+	private:
+
+		struct StackEntry
+		{
+			int   node;
+			float tMin;
+			float tMax;
+		};
+
+		Tree&  mTree;
+		std::vector< StackEntry , TFrameStlAllocator< StackEntry > > mStack;
 	};
 
 	bool Tree::segmentTest( Vec2f const& start , Vec2f const& end , ColInfo& info )
 	{
-		SegmentColSolver solver;
-		return solver.solve( *this , start , end , info );
+		SegmentColSolver solver( *this );
+		return solver.solve( start , end , info );
+	}
+
+	int Tree::segmentTest( Vec2f const starts[] , Vec2f const ends[] , int num , ColInfo infos[] )
+	{
+		SegmentColSolver solver( *this );
+		int result = 0;
+		for( int i = 0 ; i < num ; ++i )
+		{
+			if ( solver.solve( starts[i] , ends[i] , infos[i] ) )
+				++result;
+		}
+		return result;
 	}
 
 
@@ -403,7 +490,7 @@ namespace Bsp2D
 		int numNodes = mTree->mNodes.size();
 		for( int i = 0 ; i < numNodes ; ++i )
 		{
-			Node* node = mTree->mNodes[i];
+			Node* node = &mTree->mNodes[i];
 
 			if ( node->isLeaf() )
 				continue;
@@ -439,14 +526,14 @@ namespace Bsp2D
 	
 
 
-		Node* cur = node->parent;
-		while( cur )
+		int cur = node->parent;
+		while( cur != -1 )
 		{
 
 
 
 
-			cur = cur->parent;
+			cur = mTree->mNodes[ cur ].parent;
 		}
 
 		return splane;
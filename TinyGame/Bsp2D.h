@@ -6,6 +6,7 @@
 #include "CppVersion.h"
 
 #include <algorithm>
+#include <vector>
 
 namespace Bsp2D
 {
@@ -51,15 +52,19 @@ namespace Bsp2D
 		float d;
 
 		void  init( Vec2f const& v1 , Vec2f const& v2 );
-		float calcDistance( Vec2f const& p ){  return normal.dot( p ) + d;  }
+		float calcDistance( Vec2f const& p ) const {  return normal.dot( p ) + d;  }
 		bool  getInteractPos( Vec2f const& v1 , Vec2f const& v2 , Vec2f& out );
-		Side  testSide( Vec2f const& p , float& dist );
-		Side  testSegment( Vec2f const& v0 , Vec2f const& v1 );
-		Side  testSegment( Vec2f const v[2] ){  return testSegment( v[0] , v[1] );  }
+		Side  testSide( Vec2f const& p , float& dist ) const;
+		Side  testSegment( Vec2f const& v0 , Vec2f const& v1 ) const;
+		Side  testSegment( Vec2f const v[2] ) const {  return testSegment( v[0] , v[1] );  }
 		Side  splice( Vec2f v[2] , Vec2f vSplit[2] );
 	};
 
 
+	//  Leafy 2D bsp tree : split planes come from edges , a leaf keeps the
+	//  edges of a convex set. Nodes and leaves live in flat arrays , children
+	//  are indices ( -1 if empty ) and nodes are stored in depth first order ,
+	//  so traversal walks a compact block of memory without recursion.
 	class Tree
 	{
 	public:
@@ -71,25 +76,26 @@ namespace Bsp2D
 			Plane plane;
 		};
 
-
-
 		typedef std::vector< Edge > EdgeVec;
 		typedef std::vector< int > IndexVec;
 
 
 		struct Node
 		{
-			bool isLeaf(){ return ( tag & 0x80000000 ) != 0; }
+			bool isLeaf() const { return ( tag & 0x80000000 ) != 0; }
+			//node index , or ~leaf index for leaf
 			uint32    tag;
 			int       idxEdge;
-			Node*     parent;
-			Node*     front;
-			Node*     back;
+			int       parent;
+			int       front;
+			int       back;
+			//copy of split edge plane , so traversal doesn't touch edges
+			Plane     plane;
 		};
 
 		struct Leaf
 		{
-			Node*     node;
+			int       node;
 			IndexVec  edges;
 		};
 
@@ -100,27 +106,23 @@ namespace Bsp2D
 		};
 
 		typedef std::vector< Leaf > LeafVec;
-		typedef std::vector< Node* > NodeVec;
+		typedef std::vector< Node > NodeVec;
 
 		NodeVec   mNodes;
 		EdgeVec   mEdges;
 		LeafVec   mLeaves;
-		Node*     mRoot;
 		int       mNumSplitNode;
+		int       mMaxDepth;
 
 
 		Tree()
 		{
-			mRoot = nullptr;
-		}
-
-		~Tree()
-		{
-			if ( mRoot )
-				deleteNode_R( mRoot );
+			mNumSplitNode = 0;
+			mMaxDepth = 0;
 		}
 
-		Node* getRoot(){ return mRoot; }
+		Node* getRoot(){ return mNodes.empty() ? nullptr : &mNodes[0]; }
+		Node& getNode( int idx ){ return mNodes[ idx ]; }
 
 		Edge& getEdge( int idx )
 		{
@@ -139,73 +141,87 @@ namespace Bsp2D
 		{
 			float frac;
 			float depth;
+			//-1 if no collision
 			int   indexEdge;
 		};
 
 		bool segmentTest( Vec2f const& start , Vec2f const& end , ColInfo& info );
+		//test many segments with one traversal stack , return number of hit segments
+		int  segmentTest( Vec2f const starts[] , Vec2f const ends[] , int num , ColInfo infos[] );
 
 
-
-		template < class Visitor >
-		void treasure( Vec2f const& pos , Visitor& visitor ){ treasure_R( mRoot , pos , visitor ); }
-
 		template < class Visitor >
-		void treasure_R( Node* node , Vec2f const& pos , Visitor& visitor )
+		void treasure( Vec2f const& pos , Visitor& visitor )
 		{
-			if ( !node )
+			if ( mNodes.empty() )
 				return;
 
-			if ( node->isLeaf() )
+			//idx >= 0 : expand node , ~idx : visit node itself
+			std::vector< int > stack;
+			stack.reserve( 2 * mMaxDepth + 2 );
+			stack.push_back( 0 );
+			while( !stack.empty() )
 			{
-				visitor.visit( mLeaves[ ~node->tag ] );
-				return;
-			}
+				int idx = stack.back();
+				stack.pop_back();
+				if ( idx < 0 )
+				{
+					visitor.visit( mNodes[ ~idx ] );
+					continue;
+				}
 
-			Edge& edge = mEdges[ node->idxEdge ];
-			switch( edge.plane.testSide( pos ) )
-			{
-			case SIDE_FRONT:
-			case SIDE_IN:
-				treasure_R( node->front , pos , visitor );
-				visitor.visit( *node );
-				treasure_R( node->back , pos , visitor );
-				break;
-			case SIDE_BACK:
-				treasure_R( node->back , pos , visitor );
-				visitor.visit( *node );
-				treasure_R( node->front , pos , visitor );
-				break;
+				Node& node = mNodes[ idx ];
+				if ( node.isLeaf() )
+				{
+					visitor.visit( mLeaves[ ~node.tag ] );
+					continue;
+				}
+
+				float dist;
+				int first  = node.front;
+				int second = node.back;
+				if ( node.plane.testSide( pos , dist ) == SIDE_BACK )
+					std::swap( first , second );
+				if ( second != -1 )
+					stack.push_back( second );
+				stack.push_back( ~idx );
+				if ( first != -1 )
+					stack.push_back( first );
 			}
 		}
 
-
-		template< class Visitor >
-		void visit( Visitor& visitor ){ visit_R( mRoot , visitor ); }
-
 		template< class Visitor >
-		void visit_R( Node* node , Visitor& visitor )
+		void visit( Visitor& visitor )
 		{
-			if ( !node )
+			if ( mNodes.empty() )
 				return;
 
-			if ( node->isLeaf() )
+			std::vector< int > stack;
+			stack.reserve( 2 * mMaxDepth + 2 );
+			stack.push_back( 0 );
+			while( !stack.empty() )
 			{
-				visitor.visit( mLeaves[ ~node->tag ] );
-				return;
-			}
+				int idx = stack.back();
+				stack.pop_back();
+				if ( idx < 0 )
+				{
+					visitor.visit( mNodes[ ~idx ] );
+					continue;
+				}
 
-			visit_R( node->front , visitor );
-			visitor.visit( *node );
-			visit_R( node->back , visitor );
-		}
+				Node& node = mNodes[ idx ];
+				if ( node.isLeaf() )
+				{
+					visitor.visit( mLeaves[ ~node.tag ] );
+					continue;
+				}
 
-		static void deleteNode_R( Node* node )
-		{
-			if ( node->front )
-				deleteNode_R( node->front );
-			if ( node->back )
-				deleteNode_R( node->back );
-			delete node;
+				if ( node.back != -1 )
+					stack.push_back( node.back );
+				stack.push_back( ~idx );
+				if ( node.front != -1 )
+					stack.push_back( node.front );
+			}
 		}
 
 		static bool isInRect( Vec2f const& p , Vec2f const& min , Vec2f const& max )
@@ -225,11 +241,8 @@ namespace Bsp2D
 		}
 		void  build( PolyArea* polys[] , int num , Vec2f const& bbMin , Vec2f const& bbMax );
 
-		
-		
-
 	private:
-		Node* contructTree_R( IndexVec& idxEdges );
+		int   contructTree_R( IndexVec& idxEdges , int parent , int depth );
 		int   choiceBestSplitEdge( IndexVec const& idxEdges  );
 
 		class SegmentColSolver;
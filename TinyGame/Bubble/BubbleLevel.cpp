@@ -4,17 +4,22 @@
 #include "GameGlobal.h"
 
 #include <cmath>
-
-#define  SIN_60 ( 1.73205081f * 0.5f )
+#include <cstring>
 
 namespace Bubble
 {
 	int  const  g_MinBubbleDestroyNum = 2;
-	float const g_MinCollisionDistance = g_BubbleDiameter - 0.5f;
+
+	//same sizes as the float ones in fixed point for simulation
+	Fixed const g_FixBubbleRadius( 15 );
+	Fixed const g_FixBubbleDiameter( 30 );
+	Fixed const g_FixMinCollisionDistance = g_FixBubbleDiameter - Fixed::FromRatio( 1 , 2 );
+	//sqrt(3)/2
+	Fixed const g_FixSin60 = Fixed::FromRaw( 56756 );
 
 	struct PosCache
 	{
-		Vec2f* data;
+		Vec2x* data;
 		int    refCount;
 		int    numCellLayer;
 	};
@@ -26,12 +31,11 @@ namespace Bubble
 		mCellData      = NULL;
 		mIndexPopCell  = NULL;
 		mIndexFallCell = NULL;
-		mColFlag       = NULL;
 		mPosCache      = NULL;
 
 		mNumPopCell  = 0;
 		mNumFallCell = 0;
-		mTopOffset   = 0.0f;
+		mTopOffset   = 0;
 	}
 
 	LevelCore::~LevelCore()
@@ -53,7 +57,9 @@ namespace Bubble
 
 		mIndexPopCell  = new short[ num ];
 		mIndexFallCell = new short[ num ];
-		mColFlag       = new unsigned char[ num ];
+		mPopMark.resize( num );
+		mFallMark.resize( num );
+		mConnector.reserve( num );
 
 		mCellData = new BubbleCell[ num ];
 
@@ -75,14 +81,14 @@ namespace Bubble
 			gCurPosCache = new PosCache;
 			gCurPosCache->numCellLayer = mNumCellLayer;
 			gCurPosCache->refCount     = 0;
-			gCurPosCache->data     = new Vec2f[ mNumCellData ];
+			gCurPosCache->data     = new Vec2x[ mNumCellData ];
 
 			for( int i = 0 ; i < mNumCellData ; ++i )
 			{
 				int layer = i / mNumCellLayer;
 				int nx    = i % mNumCellLayer;
-				gCurPosCache->data[i].x = nx * g_BubbleDiameter - (layer % 2) * g_BubbleRadius;
-				gCurPosCache->data[i].y = SIN_60 * float( layer - 1 ) * g_BubbleDiameter + g_BubbleRadius;
+				gCurPosCache->data[i].x = g_FixBubbleDiameter * nx - g_FixBubbleRadius * ( layer % 2 );
+				gCurPosCache->data[i].y = g_FixSin60 * g_FixBubbleDiameter * ( layer - 1 ) + g_FixBubbleRadius;
 			}
 		}
 
@@ -98,8 +104,6 @@ namespace Bubble
 		mIndexPopCell = NULL;
 		delete [] mIndexFallCell;
 		mIndexFallCell = NULL;
-		delete [] mColFlag;
-		mColFlag = NULL;
 
 		mNumLayer = 0;
 		mNumFreeCellLayer = 0;
@@ -128,29 +132,34 @@ namespace Bubble
 
 	Vec2f LevelCore::calcCellCenterPos( int index )
 	{
-		Vec2f out = mPosCache->data[index];
+		return ToVec2f( calcCellSimPos( index ) );
+		//return calcCellCenterPos( index / mNumCellLayer , index % mNumCellLayer );
+	}
+
+	Vec2x LevelCore::calcCellSimPos( int index )
+	{
+		Vec2x out = mPosCache->data[index];
 		out.y += mTopOffset;
 		return out;
-		//return calcCellCenterPos( index / mNumCellLayer , index % mNumCellLayer );
 	}
 
-	int LevelCore::calcCellIndex( Vec2f const& pos  , int& layer , int& nx )
+	int LevelCore::calcCellIndex( Vec2x const& pos  , int& layer , int& nx )
 	{
-		assert( 0 <= pos.x && pos.x < mNumFreeCellLayer * g_BubbleDiameter );
-		assert( 0 <= pos.y && pos.y < mNumLayer * g_BubbleDiameter );
+		assert( 0 <= pos.x && pos.x < g_FixBubbleDiameter * mNumFreeCellLayer );
+		assert( 0 <= pos.y && pos.y < g_FixBubbleDiameter * mNumLayer );
 
-		layer = int( float( pos.y - mTopOffset )  / ( g_BubbleDiameter * SIN_60 ) ) + 1;
+		layer = ( ( pos.y - mTopOffset ) / ( g_FixBubbleDiameter * g_FixSin60 ) ).toInt() + 1;
 
-		float x = pos.x + g_BubbleRadius;
+		Fixed x = pos.x + g_FixBubbleRadius;
 		if ( layer % 2 )
-			x += g_BubbleRadius;
+			x += g_FixBubbleRadius;
 
-		nx = int( x / g_BubbleDiameter );
+		nx = ( x / g_FixBubbleDiameter ).toInt();
 
 		return layer * mNumCellLayer + nx;
 	}
 
-	int LevelCore::processCollision( Vec2f const& pos , Vec2f const& vel , int color )
+	int LevelCore::processCollision( Vec2x const& pos , Vec2x const& vel , int color )
 	{
 		int layer,nx;
 		int index = calcCellIndex( pos , layer , nx );
@@ -170,12 +179,12 @@ namespace Bubble
 			return -1;
 
 
-		Vec2f cellPos = calcCellCenterPos( layer , nx );
+		Vec2x cellPos = calcCellSimPos( index );
 
 		if ( layer == 1  )
 		{
-			float const g_MinTopLayerLockDistance = 0.5f * g_BubbleRadius;
-			Vec2f offset = pos - cellPos;
+			Fixed const g_MinTopLayerLockDistance = g_FixBubbleRadius / 2;
+			Vec2x offset = pos - cellPos;
 			if ( offset.length2() <  g_MinTopLayerLockDistance * g_MinTopLayerLockDistance ||
 				vel.y > 0 )
 				return index;
@@ -183,8 +192,9 @@ namespace Bubble
 
 		bool isEven = ( layer % 2 ) == 0;
 
-		float dist2Test = g_MinCollisionDistance * g_MinCollisionDistance;
-		float idxTest   = -1;
+		//cells are near , so squared distances are in fixed range
+		Fixed dist2Test = g_FixMinCollisionDistance * g_FixMinCollisionDistance;
+		int   idxTest   = -1;
 		for( int i = 0 ; i < NUM_LINK_DIR ; ++i )
 		{
 			int linkIdx = getLinkCellIndex( index , LinkDir(i) , isEven );
@@ -194,9 +204,9 @@ namespace Bubble
 			if ( linkCell.isEmpty() || linkCell.isBlock() )
 				continue;
 
-			Vec2f linkCellPos = calcCellCenterPos( linkIdx );
+			Vec2x linkCellPos = calcCellSimPos( linkIdx );
 
-			float dist2 = ( linkCellPos - pos ).length2();
+			Fixed dist2 = ( linkCellPos - pos ).length2();
 			
 			if ( dist2 < dist2Test )
 			{
@@ -227,55 +237,78 @@ namespace Bubble
 		return idx;
 	}
 
-	unsigned LevelCore::lockBubble( int index , int color )
+	struct BubbleLinker
 	{
-		BubbleCell& cell = getCell( index );
-		assert( !cell.isBlock() );
-
-		cell.setColor( color );
-
-		memset( mColFlag , 0 , mNumCellData * sizeof( mColFlag[0]) );
+		BubbleLinker( LevelCore& level ):level( level ){}
 
-		addColFlag( index , eCheckColor | eMarkPop );
+		int  getLinkNum() const { return NUM_LINK_DIR; }
+		int  getLinkIndex( int idx , int dir ) const 
+		{
+			return level.getLinkCellIndex( idx , LinkDir( dir ) , level.isEvenLayer( idx ) );
+		}
+		LevelCore& level;
+	};
 
-		unsigned result = BUBBLE_LOCK;
+	struct PopLinker : BubbleLinker
+	{
+		PopLinker( LevelCore& level , GridVisitMap& popMark , int color )
+			:BubbleLinker( level ),popMark( popMark ),color( color ){}
 
-		mIndexPopCell[0] = index;
+		bool visit( int idx )
+		{
+			BubbleCell& cell = level.getCell( idx );
+			if ( cell.isBlock() || cell.isEmpty() || cell.getColor() != color )
+				return false;
+			return popMark.testAndMark( idx );
+		}
+		GridVisitMap& popMark;
+		int           color;
+	};
 
-		short* idxCur   = mIndexPopCell;
-		short* idxPop   = mIndexPopCell;
-		short* idxCheck = mIndexPopCell + mNumCellData;
+	struct FallLinker : BubbleLinker
+	{
+		FallLinker( LevelCore& level , GridVisitMap& popMark , GridVisitMap& fallMark )
+			:BubbleLinker( level ),popMark( popMark ),fallMark( fallMark ),beLinkWall( false ){}
 
-		do
+		bool visit( int idx )
 		{
-			bool isEven = isEvenLayer( *idxCur );
+			BubbleCell& cell = level.getCell( idx );
+			if ( cell.isBlock() || cell.isEmpty() || popMark.test( idx ) )
+				return false;
+			if ( !fallMark.testAndMark( idx ) )
+				return false;
 
-			for( int i = 0 ; i < NUM_LINK_DIR ; ++i )
+			//odd layer always link wall when linking one block;
+			if ( !beLinkWall && !level.isEvenLayer( idx ) )
 			{
-				int linkIdx = getLinkCellIndex( *idxCur , LinkDir(i) , isEven );
-
-				BubbleCell& linkCell = getCell( linkIdx );
-
-				if ( linkCell.isBlock() || linkCell.isEmpty() ||
-					checkColFlag( linkIdx , eCheckColor ) )
-					continue;
-
-				if ( linkCell.getColor() == color )
+				for( int i = 0 ; i < NUM_LINK_DIR ; ++i )
 				{
-					*( ++idxPop ) = linkIdx;
-					addColFlag( linkIdx , eCheckColor | eMarkPop );
-				}
-				else
-				{
-					*( --idxCheck ) = linkIdx;
-					addColFlag( linkIdx , eCheckColor );
+					if ( level.getCell( getLinkIndex( idx , i ) ).isBlock() )
+					{
+						beLinkWall = true;
+						break;
+					}
 				}
 			}
-			++idxCur;
+			return true;
 		}
-		while( idxPop >= idxCur );
+		GridVisitMap& popMark;
+		GridVisitMap& fallMark;
+		bool          beLinkWall;
+	};
+
+	unsigned LevelCore::lockBubble( int index , int color )
+	{
+		BubbleCell& cell = getCell( index );
+		assert( !cell.isBlock() );
+
+		cell.setColor( color );
+
+		unsigned result = BUBBLE_LOCK;
 
-		mNumPopCell = int( idxPop - mIndexPopCell ) + 1;
+		mPopMark.clear();
+		PopLinker popLinker( *this , mPopMark , color );
+		mNumPopCell = mConnector.collect( index , popLinker , mIndexPopCell );
 
 		if ( mNumPopCell <= g_MinBubbleDestroyNum )
 		{
@@ -285,17 +318,23 @@ namespace Bubble
 
 		result |= BUBBLE_POP;
 
-		short* idxEnd = mIndexPopCell + mNumCellData;
-
-		int tempNumFallCell;
-		tempNumFallCell = mNumFallCell = 0;
-
-		while( idxCheck != idxEnd )
+		//bubble groups linking pop bubbles fall if they don't link wall
+		mFallMark.clear();
+		mNumFallCell = 0;
+		FallLinker fallLinker( *this , mPopMark , mFallMark );
+		for( int n = 0 ; n < mNumPopCell ; ++n )
 		{
-			if ( testFallBubble_R( *(idxCheck++) ) )
-				tempNumFallCell = mNumFallCell;
-			else
-				mNumFallCell = tempNumFallCell;
+			int idxPop = mIndexPopCell[n];
+			bool isEven = isEvenLayer( idxPop );
+			for( int i = 0 ; i < NUM_LINK_DIR ; ++i )
+			{
+				int linkIdx = getLinkCellIndex( idxPop , LinkDir(i) , isEven );
+
+				fallLinker.beLinkWall = false;
+				int num = mConnector.collect( linkIdx , fallLinker , mIndexFallCell + mNumFallCell );
+				if ( !fallLinker.beLinkWall )
+					mNumFallCell += num;
+			}
 		}
 
 		if ( mNumFallCell )
@@ -304,65 +343,29 @@ namespace Bubble
 		return result;
 	}
 
-	bool LevelCore::testFallBubble_R( int index )
-	{
-		BubbleCell& cell = getCell( index );
-
-		if ( checkColFlag( index , eLinkWall ) )
-			return false;
-		if ( checkColFlag( index , eTestFall | eMarkPop ) )
-			return true;
-
-		assert( !( cell.isEmpty() || cell.isBlock() ) );
-
-		mIndexFallCell[ mNumFallCell++ ] = index;
-		addColFlag( index , eTestFall );
-
-		bool isEven = isEvenLayer( index );
-
-		for( int i = 0 ; i < NUM_LINK_DIR ; ++i )
-		{
-			int linkIdx = getLinkCellIndex( index , LinkDir(i) , isEven );
-			BubbleCell& linkCell = getCell( linkIdx );
-
-			if ( linkCell.isEmpty() )
-				continue;
-
-			//odd layer always link wall when linking one block;
-			// ( isBlock && !isEven ) ||
-			// (!isBlock && !testFallBubble )
-			if ( ( linkCell.isBlock() ? !isEven  : !testFallBubble_R( linkIdx )  ) )
-			{
-				addColFlag( index , eLinkWall );
-				return false;
-			}
-		}
-		return true;
-	}
-
 	Level::Level( LevelListener* listener )
 	{
 		mListener = listener;
 		mListener->mLevel = this;
 
 		int num = 10;
-		mLauncherPos = Vec2f( num * g_BubbleDiameter / 2 , 15 * g_BubbleDiameter );
+		mLauncherPos = Vec2x( g_FixBubbleDiameter * num / 2 , g_FixBubbleDiameter * 15 );
 
 		mShootBubbleColor = Global::RandomNet() % g_BubbleColorNum + 1;
-		mShootBubbleSpeed = 800.0f;
-		mShootBubbleTimeStep = g_BubbleDiameter / ( gDefaultGameFPS * mShootBubbleSpeed );
+		mShootBubbleSpeed = 800;
+		mShootBubbleTimeStep = g_FixBubbleDiameter / mShootBubbleSpeed / gDefaultGameFPS;
 
 		mLauncherAngle = 0;
 
 
-		mMaxDepth = mLauncherPos.y + g_BubbleDiameter;
-		setupCell( num , (int)(mMaxDepth / g_BubbleDiameter) + 5 );
+		mMaxDepth = mLauncherPos.y + g_FixBubbleDiameter;
+		setupCell( num , ( mMaxDepth / g_FixBubbleDiameter ).toInt() + 5 );
 
 
 		roteRight( 0 );
 	}
 
-	void Level::update( float dt )
+	void Level::update( Fixed dt )
 	{
 
 		for( BubbleList::iterator iter = mShootList.begin();
@@ -410,12 +413,12 @@ namespace Bubble
 		}
 	}
 
-	unsigned Level::updateShootBubble( Bubble& bubble , float totalTime )
+	unsigned Level::updateShootBubble( Bubble& bubble , Fixed totalTime )
 	{
 		bool done = false;
 
 		unsigned result = BUBBLE_SHOOTING;
-		int rightSide = int( mNumFreeCellLayer * g_BubbleDiameter - g_BubbleRadius );
+		Fixed rightSide = g_FixBubbleDiameter * mNumFreeCellLayer - g_FixBubbleRadius;
 
 		while( !done )
 		{
@@ -430,9 +433,9 @@ namespace Bubble
 				bubble.update( totalTime );
 			}
 
-			if ( bubble.pos.x < g_BubbleRadius )
+			if ( bubble.pos.x < g_FixBubbleRadius )
 			{
-				bubble.pos.x = 2 * g_BubbleRadius - bubble.pos.x;
+				bubble.pos.x = g_FixBubbleDiameter - bubble.pos.x;
 				//bubble.pos.x = g_BubbleRadius;
 
 				if ( bubble.vel.x < 0 )
@@ -447,9 +450,9 @@ namespace Bubble
 					bubble.vel.x = -bubble.vel.x;
 			}
 
-			if ( bubble.pos.y < g_BubbleRadius )
+			if ( bubble.pos.y < g_FixBubbleRadius )
 			{
-				bubble.pos.y = g_BubbleRadius;
+				bubble.pos.y = g_FixBubbleRadius;
 				if ( bubble.vel.y < 0 )
 					bubble.vel.y = -bubble.vel.y;
 			}
@@ -478,16 +481,51 @@ namespace Bubble
 		mShootBubbleColor = Global::RandomNet() % g_BubbleColorNum + 1;
 	}
 
-	void Level::roteRight( float delta )
+	void Level::roteRight( Fixed delta )
 	{
-		static float const MaxBarrelAngle = DEG2RAD( 87 );
+		Fixed const MaxBarrelAngle = FixedMath::PI< Fixed::NumFracBits >() * 87 / 180;
 		mLauncherAngle += delta;
 		if ( mLauncherAngle > MaxBarrelAngle )
 			mLauncherAngle = MaxBarrelAngle;
 		else if ( mLauncherAngle < -MaxBarrelAngle )
 			mLauncherAngle = -MaxBarrelAngle;
 
-		mLauncherDir.setValue( -sin(mLauncherAngle) , -cos( mLauncherAngle ) );
+		mLauncherDir.setValue( -FixedMath::Sin( mLauncherAngle ) , -FixedMath::Cos( mLauncherAngle ) );
+	}
+
+	static unsigned HashValue( unsigned hash , unsigned value )
+	{
+		//FNV-1a of 4 bytes
+		for( int i = 0 ; i < 4 ; ++i )
+		{
+			hash ^= ( value >> ( 8 * i ) ) & 0xff;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	unsigned Level::calcChecksum() const
+	{
+		unsigned hash = 2166136261u;
+		for( int i = 0 ; i < mNumCellData ; ++i )
+			hash = HashValue( hash , unsigned( mCellData[i].getColor() << 4 ) | mCellData[i].getFlag() );
+
+		hash = HashValue( hash , (unsigned)mLauncherAngle.getRaw() );
+		hash = HashValue( hash , (unsigned)mShootBubbleColor );
+		hash = HashValue( hash , (unsigned)mTopOffset.getRaw() );
+
+		for( BubbleList::const_iterator iter = mShootList.begin() ; iter != mShootList.end() ; ++iter )
+		{
+			Bubble const* bubble = *iter;
+			hash = HashValue( hash , (unsigned)bubble->pos.x.getRaw() );
+			hash = HashValue( hash , (unsigned)bubble->pos.y.getRaw() );
+			hash = HashValue( hash , (unsigned)bubble->vel.x.getRaw() );
+			hash = HashValue( hash , (unsigned)bubble->vel.y.getRaw() );
+			hash = HashValue( hash , (unsigned)bubble->color );
+		}
+		hash = HashValue( hash , (unsigned)mFallList.size() );
+		//0 means no checksum
+		return hash ? hash : 1;
 	}
 
 	void Level::generateRandomLevel( int maxLayer , int density )
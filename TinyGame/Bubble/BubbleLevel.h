@@ -2,8 +2,13 @@
 #define BubbleLevel_h__
 
 #include "TVector2.h"
+#include "FixedPoint.h"
+#include "GridConnector.h"
 typedef TVector2< float > Vec2f;
 
+//simulation runs in fixed point , float is only used to render
+inline Vec2f ToVec2f( Vec2x const& v ){ return Vec2f( v.x.toFloat() , v.y.toFloat() ); }
+
 #include <list>
 #include <cassert>
 
@@ -83,27 +88,28 @@ namespace Bubble
 		BubbleCell& getCell( int layer , int nx ){ return mCellData[ layer * mNumCellLayer + nx ];}
 		BubbleCell& getCell( int idx ){  return mCellData[idx];  }
 
-		int   calcCellIndex( Vec2f const& pos , int& layer , int& nx );
+		int   calcCellIndex( Vec2x const& pos , int& layer , int& nx );
 		int   getLinkCellIndex( int idx , LinkDir dir , bool isEven );
 		bool  isEvenLayer( int index ){  return ( index / mNumCellLayer ) % 2 == 0;  }
 
 		Vec2f calcCellCenterPos( int index );
 		Vec2f calcCellCenterPos( int layer , int nx );
+		//position used by simulation
+		Vec2x calcCellSimPos( int index );
 
 		short const* getLastPopCellIndex() const { return mIndexPopCell; }
 		int          getLastPopCellNum()   const { return mNumPopCell; }
 		short const* getLastFallCellIndex()const { return mIndexFallCell; }
 		int          getLastFallCellNum()  const { return mNumFallCell; }
 
-		float        getTopOffset(){ return mTopOffset; }
-		void         setTopOffset( float offset ){ mTopOffset = offset;  }
+		Fixed        getTopOffset(){ return mTopOffset; }
+		void         setTopOffset( Fixed offset ){ mTopOffset = offset;  }
 	protected:
 		void        setupCell( int width , int layer );
-		int         processCollision( Vec2f const& pos , Vec2f const& vel , int color );
+		int         processCollision( Vec2x const& pos , Vec2x const& vel , int color );
 		unsigned    lockBubble( int index , int color );
-		bool        testFallBubble_R( int index );
 
-		float  mTopOffset;
+		Fixed  mTopOffset;
 		int    mNumPopCell;
 		int    mNumFallCell;
 		short* mIndexPopCell;
@@ -121,20 +127,9 @@ namespace Bubble
 		friend class Scene;
 
 	private:
-
-		enum
-		{
-			eCheckColor  = BIT(0),
-			eMarkPop     = BIT(1),
-			eTestFall    = BIT(2),
-			eLinkWall    = BIT(3),
-
-		};
-
-		bool checkColFlag( int idx , unsigned bit ){ assert( !getCell( idx ).isBlock() ); return ( mColFlag[idx] & bit ) != 0; }
-		void addColFlag  ( int idx , unsigned bit ){ assert( !getCell( idx ).isBlock() ); mColFlag[idx] |=  bit;  }
-
-		unsigned char*  mColFlag;
+		GridConnector  mConnector;
+		GridVisitMap   mPopMark;
+		GridVisitMap   mFallMark;
 	};
 
 	class LevelListener;
@@ -146,36 +141,39 @@ namespace Bubble
 
 		struct Bubble
 		{
-			Vec2f pos;
-			Vec2f vel;
+			Vec2x pos;
+			Vec2x vel;
 			int   color;
-			void  update( float dt ){  pos += dt * vel; }
+			void  update( Fixed dt ){  pos += dt * vel; }
 		};
 		void    generateRandomLevel( int maxLayer , int density );
-		float   getMaxDepth(){ return mMaxDepth; }
+		float   getMaxDepth(){ return mMaxDepth.toFloat(); }
+		//hash of cells , launcher and moving bubbles
+		unsigned calcChecksum() const;
 
 	protected:
-		void     update( float dt );
+		void     update( Fixed dt );
 		void     shoot( Bubble* bubble );
-		void     roteRight( float delta );
-		unsigned updateShootBubble( Bubble& bubble , float totalTime );
+		void     roteRight( Fixed delta );
+		unsigned updateShootBubble( Bubble& bubble , Fixed totalTime );
 		typedef std::list< Bubble* > BubbleList;
 
 		BubbleList mShootList;
 		BubbleList mFallList;
 
 
-		float mMaxDepth;
+		Fixed mMaxDepth;
 
 		int   mShootBufDelay;
 
 		int   mShootBubbleColor;
-		float mShootBubbleSpeed;
-		float mShootBubbleTimeStep;
+		Fixed mShootBubbleSpeed;
+		Fixed mShootBubbleTimeStep;
 
-		float mLauncherAngle;
-		Vec2f mLauncherDir;
-		Vec2f mLauncherPos;
+		//sin and cos of CRT are not same everywhere , so angle is fixed point too
+		Fixed mLauncherAngle;
+		Vec2x mLauncherDir;
+		Vec2x mLauncherPos;
 
 		LevelListener* mListener;
 		friend class Scene;
@@ -32,6 +32,9 @@ namespace Bubble
 		};
 		int   type;
 		float alpha;
+		//render state , shoot bubbles copy the simulation pos , others move by themselves
+		Vec2f drawPos;
+		Vec2f drawVel;
 
 		int   action;
 		BubbleList::iterator iter;
@@ -128,20 +131,20 @@ namespace Bubble
 			iter != iterEnd ; ++iter )
 		{
 			SceneBubble* bubble = *iter;
-			Vec2f bPos = pos + bubble->pos;
+			Vec2f bPos = pos + bubble->drawPos;
 
 			if ( bubble->alpha != 1.0f )
 			{
 				g.beginBlend( bPos - Vec2f( g_BubbleRadius , g_BubbleRadius ) , 
 					Vec2f( g_BubbleDiameter , g_BubbleDiameter ) , bubble->alpha );
 
-				renderBubble( g , pos + bubble->pos , bubble->color );
+				renderBubble( g , bPos , bubble->color );
 
 				g.endBlend();
 			}
 			else
 			{
-				renderBubble( g , pos + bubble->pos , bubble->color );
+				renderBubble( g , bPos , bubble->color );
 			}
 		}
 
@@ -168,10 +171,10 @@ namespace Bubble
 			Vec2i(   width + 2 * BlockSize , BlockSize ) , Color::eGray );
 
 		RenderUtility::drawBlock( g , pos - Vec2f( (float)BlockSize , 0 ) , 
-			Vec2i( BlockSize , (int)mLevel.mMaxDepth ) , Color::eGray );
+			Vec2i( BlockSize , (int)mLevel.getMaxDepth() ) , Color::eGray );
 
 		RenderUtility::drawBlock( g , pos + Vec2f( (float)width , 0 ) , 
-			Vec2i( BlockSize , (int)mLevel.mMaxDepth ) , Color::eGray );
+			Vec2i( BlockSize , (int)mLevel.getMaxDepth() ) , Color::eGray );
 
 	}
 
@@ -180,10 +183,11 @@ namespace Bubble
 		RenderUtility::setBrush( g ,  mLevel.mShootBubbleColor );
 		RenderUtility::setPen( g ,  mLevel.mShootBubbleColor );
 
-		Vec2f bPos = pos + mLevel.mLauncherPos;
+		Vec2f bPos = pos + ToVec2f( mLevel.mLauncherPos );
+		Vec2f dir  = ToVec2f( mLevel.mLauncherDir );
 
-		Vec2f startPos = bPos + 10 * mLevel.mLauncherDir;
-		Vec2f offset = 15 * mLevel.mLauncherDir;
+		Vec2f startPos = bPos + 10 * dir;
+		Vec2f offset = 15 * dir;
 		int idx = ( mTimeCount / 120 ) % 13 - 4;
 		for( int i = 0 ; i < 5 ; ++ i )
 		{
@@ -199,9 +203,9 @@ namespace Bubble
 
 	void Scene::onUpdateShootBubble( Level::Bubble* bubble , unsigned result )
 	{
-		(void)bubble;
 		(void)result;
-
+		SceneBubble* sBubble = static_cast< SceneBubble* >( bubble );
+		sBubble->drawPos = ToVec2f( bubble->pos );
 	}
 
 	void Scene::onRemoveShootBubble( Level::Bubble* bubble )
@@ -217,8 +221,8 @@ namespace Bubble
 
 		sBubble->type = SceneBubble::eVanish;
 		sBubble->alpha = 1.0f;
-		sBubble->pos = getLevel().calcCellCenterPos( index );
-		sBubble->vel.setValue( 0,0 );
+		sBubble->drawPos = getLevel().calcCellCenterPos( index );
+		sBubble->drawVel.setValue( 0,0 );
 		sBubble->color = cell.getColor();
 
 		mFallList.push_back( sBubble );
@@ -231,8 +235,8 @@ namespace Bubble
 
 		sBubble->type = SceneBubble::eFall;
 		sBubble->alpha = 1.0f;
-		sBubble->pos = getLevel().calcCellCenterPos( index );
-		sBubble->vel.setValue( 0,0 );
+		sBubble->drawPos = getLevel().calcCellCenterPos( index );
+		sBubble->drawVel.setValue( 0,0 );
 		sBubble->color = cell.getColor();
 
 		mFallList.push_back( sBubble );
@@ -245,6 +249,7 @@ namespace Bubble
 		bubble->alpha = 1.0f;
 
 		getLevel().shoot( bubble );
+		bubble->drawPos = ToVec2f( bubble->pos );
 		mShootList.push_front( bubble );
 
 		bubble->iter = mShootList.begin();
@@ -252,7 +257,7 @@ namespace Bubble
 
 	void Scene::tick()
 	{
-		getLevel().update( gDefaultTickTime / 1000.0f );
+		getLevel().update( Fixed::FromRatio( gDefaultTickTime , 1000 ) );
 	}
 
 	void Scene::updateFrame( int frame )
@@ -272,17 +277,17 @@ namespace Bubble
 			switch( bubble->type )
 			{
 			case SceneBubble::eFall:
-				bubble->vel.y += mFallBubbleAcc * dt;
-				bubble->update( dt );
+				bubble->drawVel.y += mFallBubbleAcc * dt;
+				bubble->drawPos += dt * bubble->drawVel;
 
-				if ( bubble->pos.y > getLevel().getMaxDepth() + 200 )
+				if ( bubble->drawPos.y > getLevel().getMaxDepth() + 200 )
 					beDelete = true;
 
 				break;
 
 			case SceneBubble::eVanish:
 				bubble->alpha -= 0.06f;
-				bubble->update( dt );
+				bubble->drawPos += dt * bubble->drawVel;
 
 				if ( bubble->alpha < 0 )
 					beDelete = true;
@@ -302,7 +307,7 @@ namespace Bubble
 		}
 	}
 
-	void Scene::roteRight( float delta )
+	void Scene::roteRight( Fixed delta )
 	{
 		getLevel().roteRight( delta );
 	}
@@ -312,8 +317,8 @@ namespace Bubble
 		if ( !trigger.haveUpdateFrame() )
 			return;
 
-		float const angle = DEG2RAD(3);
-		float const mouseAngle = - 0.01f; 
+		Fixed const angle = FixedMath::PI< Fixed::NumFracBits >() * 3 / 180;
+		Fixed const mouseAngle = -Fixed::FromRatio( 1 , 100 );
 
 		int offset = 0;
 
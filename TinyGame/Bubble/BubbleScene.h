@@ -30,7 +30,7 @@ namespace Bubble
 		void   updateFrame( int frame );
 
 		void   shoot();
-		void   roteRight( float delta );
+		void   roteRight( Fixed delta );
 		void   render( Graphics2D& g );
 
 		void   fireAction( ActionTrigger& tigger );
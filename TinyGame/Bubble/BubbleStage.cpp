@@ -158,6 +158,15 @@ namespace Bubble
 		mDataManager.updateFrame( frame );
 	}
 
+	unsigned LevelStage::calcFrameChecksum()
+	{
+		unsigned result = 0;
+		PlayerDataManager::PlayerDataVec& dataVec = mDataManager.mPlayerDataVec;
+		for( int i = 0 ; i < (int)dataVec.size() ; ++i )
+			result = result * 31 + dataVec[i]->getScene().getLevel().calcChecksum();
+		return result;
+	}
+
 	bool LevelStage::getAttribValue( AttribValue& value )
 	{
 		return BaseClass::getAttribValue( value );
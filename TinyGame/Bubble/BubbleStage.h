@@ -53,6 +53,7 @@ namespace Bubble
 
 		IFrameActionTemplate* createActionTemplate( unsigned version );
 		bool                  setupNetwork( NetWorker* netWorker , INetEngine** engine );
+		unsigned              calcFrameChecksum();
 		PlayerDataManager mDataManager;
 		Mode*   mMode;
 		Scene*  scene;
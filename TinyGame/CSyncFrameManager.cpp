@@ -85,7 +85,69 @@ CSyncFrameManager::CSyncFrameManager( IFrameActionTemplate* actionTemp , INetFra
 	mFrameGenerator = frameGenerator;
 	mProcessor.setEnumer( this );
 	mProcessor.setListener( frameGenerator );
-	
+
+	for( int i = 0 ; i < NumChecksumHistory ; ++i )
+	{
+		mLocalChecksums[i].frame  = -1;
+		mRemoteChecksums[i].frame = -1;
+	}
+	mLastChecksumFrame = -1;
+	mDesyncFrame = -1;
+	mbDesyncReported = false;
+}
+
+void CSyncFrameManager::recordChecksum( long frame , unsigned checksum )
+{
+	if ( checksum == 0 )
+		return;
+
+	ChecksumInfo& info = mLocalChecksums[ frame % NumChecksumHistory ];
+	info.frame = frame;
+	info.value = checksum;
+	mLastChecksumFrame = frame;
+
+	ChecksumInfo const& remote = mRemoteChecksums[ frame % NumChecksumHistory ];
+	if ( remote.frame == frame && remote.value != checksum )
+		onDesync( frame , checksum , remote.value );
+}
+
+void CSyncFrameManager::checkRemoteChecksum( long frame , unsigned checksum )
+{
+	if ( checksum == 0 || frame < 0 )
+		return;
+
+	ChecksumInfo const& local = mLocalChecksums[ frame % NumChecksumHistory ];
+	if ( local.frame == frame )
+	{
+		if ( local.value != checksum )
+			onDesync( frame , local.value , checksum );
+		return;
+	}
+
+	//remote is ahead , check when local frame is updated
+	ChecksumInfo& info = mRemoteChecksums[ frame % NumChecksumHistory ];
+	info.frame = frame;
+	info.value = checksum;
+}
+
+void CSyncFrameManager::fillChecksum( GDPFrameStream& stream )
+{
+	if ( mLastChecksumFrame == -1 )
+	{
+		stream.checkFrame = -1;
+		stream.checksum   = 0;
+		return;
+	}
+	stream.checkFrame = mLastChecksumFrame;
+	stream.checksum   = mLocalChecksums[ mLastChecksumFrame % NumChecksumHistory ].value;
+}
+
+void CSyncFrameManager::onDesync( long frame , unsigned localChecksum , unsigned remoteChecksum )
+{
+	if ( mDesyncFrame != -1 )
+		return;
+	mDesyncFrame = frame;
+	Msg( "Frame %d desync : checksum %x != %x" , (int)frame , localChecksum , remoteChecksum );
 }
 
 bool CSyncFrameManager::scanInput( bool beUpdateFrame )
@@ -109,6 +171,18 @@ int CSyncFrameManager::evalFrame( IFrameUpdater& updater , int updateFrames , in
 {
 	int frameCount = 0;
 
+	//states are not same anymore , stop simulation and let game handle it
+	if ( mDesyncFrame != -1 )
+	{
+		if ( !mbDesyncReported )
+		{
+			mbDesyncReported = true;
+			updater.onFrameDesync( mDesyncFrame );
+		}
+		updater.updateFrame( 0 );
+		return mFrameMgr.getFrame();
+	}
+
 	int deltaFrame = mFrameMgr.getLastDataFrame() - mFrameMgr.getFrame();
 	if (  deltaFrame > maxDelayFrames + updateFrames )
 		++updateFrames;
@@ -121,6 +195,7 @@ int CSyncFrameManager::evalFrame( IFrameUpdater& updater , int updateFrames , in
 		{
 			mFrameMgr.beginFrame();
 			updater.tick();
+			recordChecksum( mFrameMgr.getFrame() , updater.calcFrameChecksum() );
 			mFrameMgr.endFrame();
 
 			++frameCount;
@@ -264,6 +339,7 @@ bool SVSyncFrameManager::sendFrameData()
 	mFrameStream->buffer.clear();
 	mFrameStream->frame = mFrameMgr.getFrame() + 1;
 	mFrameGenerator->generate( DataSerializer( mFrameStream->buffer ) );
+	fillChecksum( *mFrameStream );
 
 	//DevMsg( 10 ,"Send Frame Data frame = %d" , fp->frame  );
 	mWorker->sendCommand( UseChannel , mFrameStream.get() , WSF_IGNORE_LOCAL );
@@ -290,6 +366,8 @@ void SVSyncFrameManager::procFrameData( IComPacket* cp )
 	GDPFrameStream* fp = cp->cast< GDPFrameStream >();
 	ServerPlayer* player = mWorker->getPlayerManager()->getPlayer( id );
 
+	checkRemoteChecksum( fp->checkFrame , fp->checksum );
+
 	int maxDiscardDifFrame = 5;
 	if ( player->lastUpdateFrame >= fp->frame + maxDiscardDifFrame )
 		return;
@@ -403,6 +481,7 @@ bool CLSyncFrameManager::sendFrameData()
 	mFrameStream->buffer.clear();
 
 	mFrameGenerator->generate( DataSerializer( mFrameStream->buffer ) );
+	fillChecksum( *mFrameStream );
 
 
 #if 0
@@ -425,6 +504,8 @@ void CLSyncFrameManager::procFrameData( IComPacket* cp )
 {
 	GDPFrameStream* data = cp->cast< GDPFrameStream >();
 
+	checkRemoteChecksum( data->checkFrame , data->checksum );
+
 	if ( data->frame <= mFrameMgr.getFrame() )
 		return;
 
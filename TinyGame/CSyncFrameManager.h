@@ -76,6 +76,23 @@ public:
 	bool  checkAction( ActionParam& param );
 
 protected:
+	void  recordChecksum( long frame , unsigned checksum );
+	void  checkRemoteChecksum( long frame , unsigned checksum );
+	void  fillChecksum( GDPFrameStream& stream );
+	void  onDesync( long frame , unsigned localChecksum , unsigned remoteChecksum );
+
+	//frames of two peers are not same at the time , keep a window of both
+	static int const NumChecksumHistory = 64;
+	struct ChecksumInfo
+	{
+		long     frame;
+		unsigned value;
+	};
+	ChecksumInfo  mLocalChecksums[ NumChecksumHistory ];
+	ChecksumInfo  mRemoteChecksums[ NumChecksumHistory ];
+	long          mLastChecksumFrame;
+	long          mDesyncFrame;
+	bool          mbDesyncReported;
 
 	ActionProcessor       mProcessor;
 	FrameDataManager      mFrameMgr;
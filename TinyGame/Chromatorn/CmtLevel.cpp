@@ -176,6 +176,70 @@ namespace Chromatron
 	}
 
 	void Level::updateWorld()
+	{
+		if ( !updateWorldIncremental() )
+			updateWorldFull();
+
+		bool goal = true;
+
+		for( MapDCInfoList::iterator iter = mMapDCList.begin(); 
+			iter != mMapDCList.end() ;++iter )
+		{
+			Device* dc = iter->dc;
+
+			iter->tracedId    = dc->getId();
+			iter->tracedDir   = dc->getDir();
+			iter->tracedColor = dc->getColor();
+
+			if ( !dc->check( mWorld ) )
+			{
+				goal = false;
+				dc->getFlag().removeBits( DFB_GOAL );
+			}
+			else 
+			{
+				dc->getFlag().addBits( DFB_GOAL );
+			}
+		}
+
+		mIsGoal = goal;
+	}
+
+	bool Level::updateWorldIncremental()
+	{
+		if ( !mWorld.haveLightRecord() )
+			return false;
+
+		for( MapDCInfoList::iterator iter = mMapDCList.begin(); 
+			iter != mMapDCList.end() ;++iter )
+		{
+			//their effect depends on more than the light reaching them
+			switch( iter->dc->getId() )
+			{
+			case DC_TELEPORTER:
+			case DC_COMPLEMENTOR:
+			case DC_QTANGLER:
+				return false;
+			}
+		}
+
+		for( MapDCInfoList::iterator iter = mMapDCList.begin(); 
+			iter != mMapDCList.end() ;++iter )
+		{
+			Device* dc = iter->dc;
+			if ( iter->tracedId    != dc->getId() ||
+				 iter->tracedDir   != dc->getDir() ||
+				 iter->tracedColor != dc->getColor() )
+			{
+				mWorld.markDirty( dc->getPos() );
+			}
+		}
+
+		mWorld.setLightParam( 0 );
+		return mWorld.updateDirtyLight() == TSS_OK;
+	}
+
+	void Level::updateWorldFull()
 	{
 		resetDeviceFlag( true );
 
@@ -208,27 +272,6 @@ namespace Chromatron
 
 			resetDeviceFlag( false );
 		} 
-
-
-		bool goal = true;
-
-		for( MapDCInfoList::iterator iter = mMapDCList.begin(); 
-			iter != mMapDCList.end() ;++iter )
-		{
-			Device* dc = iter->dc;
-
-			if ( !dc->check( mWorld ) )
-			{
-				goal = false;
-				dc->getFlag().removeBits( DFB_GOAL );
-			}
-			else 
-			{
-				dc->getFlag().addBits( DFB_GOAL );
-			}
-		}
-
-		mIsGoal = goal;
 	}
 
 	void Level::destoryAllDevice()
@@ -303,6 +346,8 @@ namespace Chromatron
 			return;
 
 		data.setType( type );
+		//type of tile can block light of neighbor tile corner
+		mWorld.invalidLightRecord();
 	}
 
 	void Level::loadWorld( LevelInfoHeader& header , std::istream& stream , unsigned version)
@@ -769,7 +814,13 @@ namespace Chromatron
 		if ( inWorld )
 		{
 			Tile::DeviceInfo info;
-			info.dc = &dc;
+			info.dc            = &dc;
+			info.emittedColor  = 0;
+			info.receivedColor = 0;
+			info.lazyColor     = 0;
+			info.tracedId      = ErrorDeviceId;
+			info.tracedDir     = 0;
+			info.tracedColor   = COLOR_NULL;
 			mMapDCList.push_back( info );
 			mWorld.getMapData( pos ).setDevice( &mMapDCList.back() );
 			dc.getFlag().addBits( DFB_IN_WORLD );
@@ -788,6 +839,7 @@ namespace Chromatron
 		if ( dc.isInWorld() )
 		{
 			mWorld.getMapData( dc.getPos() ).setDevice( NULL );
+			mWorld.markDirty( dc.getPos() );
 
 			for( MapDCInfoList::iterator iter = mMapDCList.begin();
 				 iter != mMapDCList.end() ; ++iter )
@@ -815,17 +867,17 @@ namespace Chromatron
 
 		GameInfoHeaderV2* gameHeader = (GameInfoHeaderV2*) malloc( gameHeaderSize );
 
-		gameHeader->version = GAME_DATA_VERSION;
-
 		if ( gameHeader == NULL )
 			return false;
 
+		memset( gameHeader , 0 , gameHeaderSize );
+		gameHeader->version = GAME_DATA_VERSION;
 		gameHeader->totalSize = gameHeaderSize;
 
 		std::ios::pos_type pos = stream.tellp();
 
-		stream.seekp(  gameHeaderSize , ios::cur );
-		//stream.write( (char*)gameHeader , gameHeaderSize );
+		//reserve header , memory stream can't seek over the end
+		stream.write( (char*)gameHeader , gameHeaderSize );
 
 		unsigned totalSize = 0;
 		for( int i = 0 ; i < num ; ++i )
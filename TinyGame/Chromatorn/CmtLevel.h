@@ -73,6 +73,7 @@ namespace Chromatron
 		bool     isVaildRange( const Vec2D& pos , bool inWorld );
 
 		World const&  getWorld() const { return mWorld;  }
+		void     setSetupTileBlockLight( bool beB ){ mWorld.setSetupTileBlockLight( beB ); }
 		void     restart();
 
 	public:
@@ -98,6 +99,9 @@ namespace Chromatron
 
 		
 		void   resetDeviceFlag( bool beRestart );
+		//retrace the light changed by moved or rotated devices , false if it needs full update
+		bool   updateWorldIncremental();
+		void   updateWorldFull();
 
 		static int const MaxNumMapDC  = 15 * 15;
 
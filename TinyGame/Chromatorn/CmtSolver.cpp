@@ -0,0 +1,817 @@
+#include "CmtPCH.h"
+#include "CmtSolver.h"
+
+#include "CmtLevel.h"
+#include "CmtDevice.h"
+#include "CmtDeviceID.h"
+#include "CmtLightTrace.h"
+#include "IntegerType.h"
+
+#include <sstream>
+#include <algorithm>
+
+namespace Chromatron
+{
+	static uint64 MixHash( uint64 value )
+	{
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdULL;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ULL;
+		value ^= value >> 33;
+		return value;
+	}
+
+	static uint64 HashMove( int idxClass , int idxTile , int dir )
+	{
+		return MixHash( ( uint64( idxClass ) << 32 ) | ( uint64( idxTile ) << 3 ) | uint64( dir ) );
+	}
+
+	class Solver::Worker
+	{
+	public:
+		Worker()
+		{
+			mLevel      = NULL;
+			mFixedLevel = NULL;
+		}
+		~Worker()
+		{
+			delete mLevel;
+			delete mFixedLevel;
+		}
+
+		bool init( Solver& solver , std::string const& data , int maxSearchNode );
+		unsigned run();
+
+		void collectMoves( std::vector< Move >& moves );
+		int  evalReceiverScore();
+		void expandNode( int idxNode );
+		void applyState( std::vector< Move > const& moves );
+		void place( Move const& move );
+		void unplace( Move const& move );
+		bool checkFixedLight();
+		bool checkReceiverReach();
+		void saveLightState( std::vector< unsigned >& outState );
+		bool isLightChanged( std::vector< unsigned > const& state );
+		uint64 calcLightStateKey();
+		Color calcRayColorBound( Vec2D const& pos , int dir );
+		Color calcRayLitColor( Vec2D const& pos , int dir );
+
+		Solver*  mSolver;
+		Level*   mLevel;
+		//empty tiles block light , only light that can't be cut remains
+		Level*   mFixedLevel;
+		bool     mbUseFixedLight;
+		//every device acts only on the light reaching it
+		bool     mbLocalEffect;
+		int      mMaxSearchNode;
+		int      mNumSearchNode;
+		int      mNumPruneNode;
+		int      mNumPlaced;
+		uint64   mStateKey;
+
+		struct DeviceData
+		{
+			Device* dc;
+			Device* fixedDC;
+			int     idxClass;
+			bool    bPlaced;
+		};
+		std::vector< DeviceData >           mDevices;
+		std::vector< Vec2D >                mReceiverPos;
+		std::vector< Move >                 mPlacedMoves;
+		std::vector< Move >                 mNodeMoves;
+		std::vector< Move >                 mChildMoves;
+		std::vector< unsigned >             mNodeLight;
+	};
+
+	//effect of these devices is same after rotating half circle
+	static int GetRotationNum( Device const& dc )
+	{
+		if ( !dc.isRotatable() )
+			return 1;
+
+		switch( dc.getId() )
+		{
+		case DC_FILTER:
+		case DC_MULTIFILTER:
+		case DC_DUALREFLECTOR:
+		case DC_SPECTROSCOPE:
+		case DC_QUADBENDER:
+			return NumDir / 2;
+		}
+		return NumDir;
+	}
+
+	//a placed device should bring two color bits to receivers , or fewer placements go first
+	static int const PlaceScoreCost = 4;
+
+	static int CountColorBits( Color color )
+	{
+		return ( ( color & COLOR_R ) ? 1 : 0 ) + ( ( color & COLOR_G ) ? 1 : 0 ) + ( ( color & COLOR_B ) ? 1 : 0 );
+	}
+
+	static Level* LoadLevelCopy( std::string const& data )
+	{
+		std::istringstream ss( data , std::ios::binary );
+		Level* level = NULL;
+		if ( Level::loadLevelData( ss , &level , 1 ) != 1 )
+			return NULL;
+		return level;
+	}
+
+	bool Solver::Worker::init( Solver& solver , std::string const& data , int maxSearchNode )
+	{
+		mSolver        = &solver;
+		mMaxSearchNode = maxSearchNode;
+		mNumSearchNode = 0;
+		mNumPruneNode  = 0;
+		mNumPlaced     = 0;
+		mStateKey      = 0;
+
+		mLevel = LoadLevelCopy( data );
+		if ( !mLevel )
+			return false;
+
+		int const mapSize = mLevel->getMapSize();
+		for( int j = 0 ; j < mapSize ; ++j )
+		{
+			for( int i = 0 ; i < mapSize ; ++i )
+			{
+				Device const* dc = mLevel->getWorld().getMapData( Vec2D( i , j ) ).getDevice();
+				if ( !dc )
+					continue;
+				if ( dc->getId() == DC_PINWHEEL )
+					mReceiverPos.push_back( Vec2D( i , j ) );
+			}
+		}
+
+		int numDC = mLevel->getUserDCNum();
+		mDevices.resize( numDC );
+		for( int i = 0 ; i < numDC ; ++i )
+		{
+			DeviceData& data = mDevices[i];
+			data.dc       = mLevel->getDevice( Level::PT_STROAGE , Vec2D( i , 0 ) );
+			data.fixedDC  = NULL;
+			data.bPlaced  = false;
+			data.idxClass = i;
+			for( int n = 0 ; n < i ; ++n )
+			{
+				Device* other = mDevices[n].dc;
+				if ( other->getId() == data.dc->getId() && other->getColor() == data.dc->getColor() )
+				{
+					data.idxClass = mDevices[n].idxClass;
+					break;
+				}
+			}
+		}
+
+		//teleporter and these color devices depend on more than the light reaching them ,
+		//so more device may remove light that can't be cut
+		mbLocalEffect = true;
+		for( int i = 0 ; i < numDC ; ++i )
+		{
+			switch( mDevices[i].dc->getId() )
+			{
+			case DC_TELEPORTER:
+			case DC_COMPLEMENTOR:
+			case DC_QTANGLER:
+				mbLocalEffect = false;
+			}
+		}
+		for( int j = 0 ; j < mapSize && mbLocalEffect ; ++j )
+		{
+			for( int i = 0 ; i < mapSize ; ++i )
+			{
+				Device const* dc = mLevel->getWorld().getMapData( Vec2D( i , j ) ).getDevice();
+				if ( dc && ( dc->getId() == DC_TELEPORTER || dc->getId() == DC_COMPLEMENTOR || dc->getId() == DC_QTANGLER ) )
+				{
+					mbLocalEffect = false;
+					break;
+				}
+			}
+		}
+
+		mbUseFixedLight = mbLocalEffect;
+		if ( mReceiverPos.empty() )
+			mbUseFixedLight = false;
+
+		if ( mbUseFixedLight )
+		{
+			mFixedLevel = LoadLevelCopy( data );
+			if ( !mFixedLevel )
+				return false;
+			mFixedLevel->setSetupTileBlockLight( true );
+			mFixedLevel->updateWorld();
+			for( int i = 0 ; i < numDC ; ++i )
+				mDevices[i].fixedDC = mFixedLevel->getDevice( Level::PT_STROAGE , Vec2D( i , 0 ) );
+		}
+
+		mLevel->updateWorld();
+		return true;
+	}
+
+	void Solver::Worker::collectMoves( std::vector< Move >& moves )
+	{
+		moves.clear();
+
+		int const mapSize = mLevel->getMapSize();
+		World const& world = mLevel->getWorld();
+
+		int numDC = (int)mDevices.size();
+		for( int idx = 0 ; idx < numDC ; ++idx )
+		{
+			DeviceData const& data = mDevices[ idx ];
+			if ( data.bPlaced )
+				continue;
+
+			//only first unplaced device of the class
+			bool haveTried = false;
+			for( int n = 0 ; n < idx ; ++n )
+			{
+				if ( !mDevices[n].bPlaced && mDevices[n].idxClass == data.idxClass )
+				{
+					haveTried = true;
+					break;
+				}
+			}
+			if ( haveTried )
+				continue;
+
+			int numDir = GetRotationNum( *data.dc );
+			for( int j = 0 ; j < mapSize ; ++j )
+			{
+				for( int i = 0 ; i < mapSize ; ++i )
+				{
+					//device on the tile without light changes nothing now
+					Tile const& tile = world.getMapData( Vec2D( i , j ) );
+					if ( !tile.canSetup() || !tile.haveLight() )
+						continue;
+
+					Move move;
+					move.idxDC = idx;
+					move.pos   = Vec2D( i , j );
+					for( int dir = 0 ; dir < numDir ; ++dir )
+					{
+						move.dir = dir;
+						moves.push_back( move );
+					}
+				}
+			}
+		}
+	}
+
+	void Solver::Worker::place( Move const& move )
+	{
+		DeviceData& data = mDevices[ move.idxDC ];
+		data.bPlaced = true;
+		++mNumPlaced;
+		mStateKey += HashMove( data.idxClass , move.pos.x + mLevel->getMapSize() * move.pos.y , move.dir );
+
+		mLevel->moveDevice( *data.dc , move.pos , true );
+		data.dc->changeDir( Dir::ValueNoCheck( move.dir ) );
+		mLevel->updateWorld();
+
+		if ( mbUseFixedLight )
+		{
+			mFixedLevel->moveDevice( *data.fixedDC , move.pos , true );
+			data.fixedDC->changeDir( Dir::ValueNoCheck( move.dir ) );
+			mFixedLevel->updateWorld();
+		}
+	}
+
+	void Solver::Worker::unplace( Move const& move )
+	{
+		DeviceData& data = mDevices[ move.idxDC ];
+		data.bPlaced = false;
+		--mNumPlaced;
+		mStateKey -= HashMove( data.idxClass , move.pos.x + mLevel->getMapSize() * move.pos.y , move.dir );
+
+		mLevel->moveDevice( *data.dc , Vec2D( move.idxDC , 0 ) , false );
+		mLevel->updateWorld();
+
+		if ( mbUseFixedLight )
+		{
+			mFixedLevel->moveDevice( *data.fixedDC , Vec2D( move.idxDC , 0 ) , false );
+			mFixedLevel->updateWorld();
+		}
+	}
+
+	bool Solver::Worker::checkFixedLight()
+	{
+		World const& world = mFixedLevel->getWorld();
+		for( int i = 0 ; i < (int)mReceiverPos.size() ; ++i )
+		{
+			Tile const& tile = world.getMapData( mReceiverPos[i] );
+			Color invColor = complementary( tile.getDevice()->getColor() );
+			for( int dir = 0 ; dir < NumDir ; ++dir )
+			{
+				if ( tile.getLightPathColor( Dir::ValueNoCheck( dir ) ) & invColor )
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void Solver::Worker::saveLightState( std::vector< unsigned >& outState )
+	{
+		int const mapSize = mLevel->getMapSize();
+		World const& world = mLevel->getWorld();
+
+		outState.resize( mapSize * mapSize );
+		for( int j = 0 ; j < mapSize ; ++j )
+		{
+			for( int i = 0 ; i < mapSize ; ++i )
+				outState[ i + mapSize * j ] = world.getMapData( Vec2D( i , j ) ).getLightPathState();
+		}
+	}
+
+	bool Solver::Worker::isLightChanged( std::vector< unsigned > const& state )
+	{
+		int const mapSize = mLevel->getMapSize();
+		World const& world = mLevel->getWorld();
+		for( int j = 0 ; j < mapSize ; ++j )
+		{
+			for( int i = 0 ; i < mapSize ; ++i )
+			{
+				if ( state[ i + mapSize * j ] != world.getMapData( Vec2D( i , j ) ).getLightPathState() )
+					return true;
+			}
+		}
+		return false;
+	}
+
+	//light on every tile , free setup tiles and the devices left to place ;
+	//with local effect devices , placements that give the same key have the same children
+	uint64 Solver::Worker::calcLightStateKey()
+	{
+		int const mapSize = mLevel->getMapSize();
+		World const& world = mLevel->getWorld();
+
+		uint64 key = 0;
+		for( int j = 0 ; j < mapSize ; ++j )
+		{
+			for( int i = 0 ; i < mapSize ; ++i )
+			{
+				Tile const& tile = world.getMapData( Vec2D( i , j ) );
+				key = key * 0x100000001b3ULL + ( uint64( tile.getLightPathState() ) << 1 | ( tile.canSetup() ? 1 : 0 ) );
+			}
+		}
+		//unplaced devices as a multiset of class , placed tile index out of map range
+		for( int i = 0 ; i < (int)mDevices.size() ; ++i )
+		{
+			if ( !mDevices[i].bPlaced )
+				key += HashMove( mDevices[i].idxClass , mapSize * mapSize , 0 );
+		}
+		//keep it apart from the keys of placement sets
+		return MixHash( key ^ 0x9e3779b97f4a7c15ULL );
+	}
+
+	//colors can come to pos from ray of dir , light only goes straight between devices
+	Color Solver::Worker::calcRayColorBound( Vec2D const& pos , int dir )
+	{
+		World const& world = mLevel->getWorld();
+		Vec2D offset = LightTrace::getDirOffset( Dir::ValueNoCheck( dir ) );
+		Dir   inDir  = Dir::ValueNoCheck( dir ).inverse();
+
+		for( Vec2D cur = pos + offset ; world.isVaildRange( cur ) ; cur += offset )
+		{
+			Tile const& tile = world.getMapData( cur );
+			if ( tile.blockLight() )
+				return COLOR_NULL;
+
+			Device const* dc = tile.getDevice();
+			if ( dc == NULL )
+			{
+				//a device may still be placed here
+				if ( tile.canSetup() && mNumPlaced < (int)mDevices.size() )
+					return COLOR_W;
+				continue;
+			}
+
+			switch( dc->getId() )
+			{
+			case DC_PINWHEEL:
+				//light passes through receiver
+				continue;
+			case DC_LIGHTSOURCE:
+				return ( dc->getDir() == inDir ) ? dc->getColor() : COLOR_NULL;
+			}
+			return COLOR_W;
+		}
+		return COLOR_NULL;
+	}
+
+	//light colors on empty tiles of the ray , one device there can turn it to pos
+	Color Solver::Worker::calcRayLitColor( Vec2D const& pos , int dir )
+	{
+		World const& world = mLevel->getWorld();
+		Vec2D offset = LightTrace::getDirOffset( Dir::ValueNoCheck( dir ) );
+
+		Color result = COLOR_NULL;
+		for( Vec2D cur = pos + offset ; world.isVaildRange( cur ) ; cur += offset )
+		{
+			Tile const& tile = world.getMapData( cur );
+			if ( tile.blockLight() )
+				break;
+			Device const* dc = tile.getDevice();
+			if ( dc && dc->getId() != DC_PINWHEEL )
+				break;
+			if ( !tile.canSetup() )
+				continue;
+
+			for( int i = 0 ; i < NumDir ; ++i )
+				result |= tile.getLightPathColor( Dir::ValueNoCheck( i ) );
+		}
+		return result;
+	}
+
+	//receiver needs all goal color from a ray , one ray passes both sides
+	bool Solver::Worker::checkReceiverReach()
+	{
+		World const& world = mLevel->getWorld();
+		for( int i = 0 ; i < (int)mReceiverPos.size() ; ++i )
+		{
+			Vec2D const& pos = mReceiverPos[i];
+			Color color = COLOR_NULL;
+			for( int dir = 0 ; dir < NumDir ; ++dir )
+				color |= calcRayColorBound( pos , dir );
+
+			Color goalColor = world.getMapData( pos ).getDevice()->getColor();
+			if ( ( color & goalColor ) != goalColor )
+				return false;
+		}
+		return true;
+	}
+
+	int Solver::Worker::evalReceiverScore()
+	{
+		//same rule as check of pinwheel , score the part of color already reached
+		World const& world = mLevel->getWorld();
+		int score = 0;
+		for( int i = 0 ; i < (int)mReceiverPos.size() ; ++i )
+		{
+			Tile const& tile = world.getMapData( mReceiverPos[i] );
+			Color goalColor = tile.getDevice()->getColor();
+			Color invColor  = complementary( goalColor );
+
+			Color color = COLOR_NULL;
+			bool  haveWrongColor = false;
+			for( int dir = 0 ; dir < NumDir / 2 ; ++dir )
+			{
+				Color c1 = tile.getLightPathColor( Dir::ValueNoCheck( dir ) );
+				Color c2 = tile.getLightPathColor( Dir::ValueNoCheck( dir ).inverse() );
+				if ( ( c1 | c2 ) & invColor )
+					haveWrongColor = true;
+				color |= c1 & c2;
+			}
+
+			if ( haveWrongColor )
+			{
+				score -= 2;
+			}
+			else if ( color == goalColor )
+			{
+				score += 8;
+			}
+			else
+			{
+				score += 2 * CountColorBits( color );
+				//missing color is one device away
+				if ( mNumPlaced < (int)mDevices.size() )
+				{
+					Color nearColor = COLOR_NULL;
+					for( int dir = 0 ; dir < NumDir ; ++dir )
+						nearColor |= calcRayLitColor( mReceiverPos[i] , dir );
+					score += CountColorBits( nearColor & goalColor & ~color );
+				}
+			}
+		}
+		return score;
+	}
+
+	void Solver::Worker::applyState( std::vector< Move > const& moves )
+	{
+		//order of placements doesn't change the light , only update the difference
+		for( int i = (int)mPlacedMoves.size() - 1 ; i >= 0 ; --i )
+		{
+			Move const& move = mPlacedMoves[i];
+			bool bKeep = false;
+			for( int n = 0 ; n < (int)moves.size() ; ++n )
+			{
+				if ( move == moves[n] )
+				{
+					bKeep = true;
+					break;
+				}
+			}
+			if ( bKeep )
+				continue;
+
+			unplace( move );
+			mPlacedMoves.erase( mPlacedMoves.begin() + i );
+		}
+
+		for( int n = 0 ; n < (int)moves.size() ; ++n )
+		{
+			Move const& move = moves[n];
+			if ( mDevices[ move.idxDC ].bPlaced )
+				continue;
+			place( move );
+			mPlacedMoves.push_back( move );
+		}
+	}
+
+	void Solver::Worker::expandNode( int idxNode )
+	{
+		if ( (int)mPlacedMoves.size() == (int)mDevices.size() )
+			return;
+
+		if ( mbLocalEffect )
+			saveLightState( mNodeLight );
+
+		collectMoves( mChildMoves );
+		for( int i = 0 ; i < (int)mChildMoves.size() ; ++i )
+		{
+			if ( mSolver->mbFound || mSolver->mbCancel )
+				return;
+			if ( mNumSearchNode >= mMaxSearchNode )
+			{
+				mSolver->mbOverLimit = true;
+				return;
+			}
+
+			Move const& move = mChildMoves[i];
+
+			//same devices at same places , only the order or the same type device is different ;
+			//test it before placing , light update is the most cost of a node
+			uint64 key = mStateKey + HashMove( mDevices[ move.idxDC ].idxClass , move.pos.x + mLevel->getMapSize() * move.pos.y , move.dir );
+			if ( !mSolver->addVisitedState( key ) )
+				continue;
+
+			++mNumSearchNode;
+			place( move );
+
+			if ( mLevel->isGoal() )
+			{
+				mSolver->reportSolution( *mLevel );
+			}
+			//device passes all light as empty tile , it is only needed after other device
+			//changes the light on its tile , so it can be placed after that
+			else if ( mbLocalEffect && !isLightChanged( mNodeLight ) )
+			{
+				++mNumPruneNode;
+			}
+			//other placements already made the same light
+			else if ( mbLocalEffect && !mSolver->addVisitedState( calcLightStateKey() ) )
+			{
+				++mNumPruneNode;
+			}
+			else if ( mNumPlaced == (int)mDevices.size() ||
+				      ( mbUseFixedLight && !checkFixedLight() ) ||
+				      !checkReceiverReach() )
+			{
+				++mNumPruneNode;
+			}
+			else
+			{
+				mSolver->addNode( idxNode , move , evalReceiverScore() - PlaceScoreCost * mNumPlaced );
+			}
+
+			unplace( move );
+		}
+	}
+
+	unsigned Solver::Worker::run()
+	{
+		for(;;)
+		{
+			int idxNode;
+			if ( !mSolver->fetchNode( mNodeMoves , idxNode ) )
+				break;
+
+			applyState( mNodeMoves );
+			expandNode( idxNode );
+			mSolver->finishNode();
+		}
+		return 0;
+	}
+
+	Solver::Solver()
+	{
+		mMaxSearchNode   = 2000000;
+		mbCancel         = false;
+		mNumSearchNode   = 0;
+		mNumPruneNode    = 0;
+		mNumActiveWorker = 0;
+		mLenSolutionCode = 0;
+		mSolutionCode[0] = 0;
+	}
+
+	Solver::~Solver()
+	{
+
+	}
+
+	Solver::Result Solver::solve( Level& level , int numThread )
+	{
+		numThread = std::max( 1 , std::min( numThread , (int)MaxThreadNum ) );
+
+		mbFound          = false;
+		mbOverLimit      = false;
+		mNumSearchNode   = 0;
+		mNumPruneNode    = 0;
+		mNumActiveWorker = 0;
+		mLenSolutionCode = 0;
+		mSolutionCode[0] = 0;
+		mNodes.clear();
+		mOpenNodes = std::priority_queue< OpenNode >();
+		mVisitedStates.clear();
+
+		if ( mbCancel )
+			return eOverLimit;
+
+		std::string data;
+		{
+			std::ostringstream ss( std::ios::binary );
+			Level* levels[] = { &level };
+			if ( !Level::saveLevelData( ss , levels , 1 ) )
+				return eNoSolution;
+			data = ss.str();
+		}
+
+		Worker workers[ MaxThreadNum ];
+		for( int i = 0 ; i < numThread ; ++i )
+		{
+			if ( !workers[i].init( *this , data , mMaxSearchNode / numThread ) )
+				return eNoSolution;
+		}
+
+		Worker& rootWorker = workers[0];
+		mNumSearchNode = 1;
+		if ( rootWorker.mLevel->isGoal() )
+		{
+			reportSolution( *rootWorker.mLevel );
+			return eSolved;
+		}
+		if ( ( rootWorker.mbUseFixedLight && !rootWorker.checkFixedLight() ) ||
+			 !rootWorker.checkReceiverReach() )
+		{
+			mNumPruneNode = 1;
+			return eNoSolution;
+		}
+
+		//root node : no device placed
+		SearchNode root;
+		root.parent = -1;
+		root.depth  = 0;
+		mNodes.push_back( root );
+		mVisitedStates.insert( 0 );
+		OpenNode open;
+		open.score   = rootWorker.evalReceiverScore();
+		open.depth   = 0;
+		open.idxNode = 0;
+		mOpenNodes.push( open );
+
+		{
+			MemberFunThread< Worker > threads[ MaxThreadNum ];
+			for( int i = 1 ; i < numThread ; ++i )
+			{
+				threads[i].init( &workers[i] , &Worker::run );
+				threads[i].start();
+			}
+			workers[0].run();
+			for( int i = 1 ; i < numThread ; ++i )
+				threads[i].join();
+		}
+
+		for( int i = 0 ; i < numThread ; ++i )
+		{
+			mNumSearchNode += workers[i].mNumSearchNode;
+			mNumPruneNode  += workers[i].mNumPruneNode;
+		}
+
+		mNodes.clear();
+		mOpenNodes = std::priority_queue< OpenNode >();
+		mVisitedStates.clear();
+
+		if ( mbFound )
+			return eSolved;
+		if ( mbOverLimit || mbCancel )
+			return eOverLimit;
+		return eNoSolution;
+	}
+
+	bool Solver::fetchNode( std::vector< Move >& outMoves , int& outIdxNode )
+	{
+		Mutex::Locker locker( mMutex );
+		for(;;)
+		{
+			if ( mbFound || mbOverLimit || mbCancel )
+				return false;
+			if ( !mOpenNodes.empty() )
+				break;
+			if ( mNumActiveWorker == 0 )
+				return false;
+			//other workers may add nodes
+			mNodeCondition.waitTime( mMutex );
+		}
+
+		outIdxNode = mOpenNodes.top().idxNode;
+		mOpenNodes.pop();
+		++mNumActiveWorker;
+
+		outMoves.clear();
+		for( int idx = outIdxNode ; mNodes[ idx ].parent != -1 ; idx = mNodes[ idx ].parent )
+			outMoves.push_back( mNodes[ idx ].move );
+		return true;
+	}
+
+	void Solver::finishNode()
+	{
+		Mutex::Locker locker( mMutex );
+		--mNumActiveWorker;
+		//wake waiting workers to end the search , found or over limit is set before it
+		if ( mNumActiveWorker == 0 || mbFound || mbOverLimit || mbCancel )
+			mNodeCondition.notifyAll();
+	}
+
+	bool Solver::addVisitedState( uint64 key )
+	{
+		Mutex::Locker locker( mMutex );
+		return mVisitedStates.insert( key ).second;
+	}
+
+	void Solver::addNode( int parent , Move const& move , int score )
+	{
+		Mutex::Locker locker( mMutex );
+		SearchNode node;
+		node.parent = parent;
+		node.depth  = mNodes[ parent ].depth + 1;
+		node.move   = move;
+		mNodes.push_back( node );
+
+		OpenNode open;
+		open.score   = score;
+		open.depth   = node.depth;
+		open.idxNode = (int)mNodes.size() - 1;
+		mOpenNodes.push( open );
+		mNodeCondition.notify();
+	}
+
+	void Solver::reportSolution( Level& level )
+	{
+		Mutex::Locker locker( mMutex );
+		if ( mbFound )
+			return;
+		mLenSolutionCode = level.generateDCStateCode( mSolutionCode , sizeof( mSolutionCode ) - 1 );
+		mSolutionCode[ mLenSolutionCode ] = 0;
+		mbFound = true;
+	}
+
+	void Solver::validateLevels( Level* levels[] , int numLevel , ValidateResult& result , Result outResults[] )
+	{
+		result.numSolved     = 0;
+		result.numNoSolution = 0;
+		result.numOverLimit  = 0;
+
+		for( int i = 0 ; i < numLevel ; ++i )
+		{
+			Level& level = *levels[i];
+			level.restart();
+			level.updateWorld();
+
+			Result levelResult = solve( level );
+			switch( levelResult )
+			{
+			case eSolved:
+				{
+					bool bGoal = applySolution( level );
+					assert( bGoal );
+					++result.numSolved;
+				}
+				break;
+			case eNoSolution: ++result.numNoSolution; break;
+			case eOverLimit:  ++result.numOverLimit; break;
+			}
+			if ( outResults )
+				outResults[i] = levelResult;
+
+			level.restart();
+			level.updateWorld();
+		}
+	}
+
+	bool Solver::applySolution( Level& level )
+	{
+		if ( !mbFound )
+			return false;
+
+		level.restart();
+		level.loadDCStateFromCode( mSolutionCode , mLenSolutionCode );
+		level.updateWorld();
+		return level.isGoal();
+	}
+
+}//namespace Chromatron
@@ -0,0 +1,123 @@
+#ifndef CmtSolver_h__
+#define CmtSolver_h__
+
+#include "CmtBase.h"
+#include "Thread.h"
+#include "IntegerType.h"
+
+#include <vector>
+#include <queue>
+#include <set>
+
+namespace Chromatron
+{
+	class Level;
+
+	//  Best first search of user device placements that make the level goal.
+	//  Devices are only placed on lit tiles , devices of same type and color
+	//  are tried once per tile , and visited placement sets are skipped before
+	//  the light is traced. Placements making a visited light state are skipped
+	//  after it , another placement set already gave the same light.
+	//  A second level copy traces only the light no new device can cut ; if a
+	//  receiver gets a wrong color from it , the placement is dropped.
+	//  A placement is also dropped when the rays into a receiver can't bring
+	//  its color any more , or all devices are placed without the goal.
+	//  Worker threads share the open list , each one expands nodes on its own
+	//  copy of the level.
+	class Solver
+	{
+	public:
+		Solver();
+		~Solver();
+
+		enum Result
+		{
+			eSolved ,
+			eNoSolution ,
+			eOverLimit ,
+		};
+
+		static int const MaxThreadNum = 8;
+
+		struct ValidateResult
+		{
+			int numSolved;
+			int numNoSolution;
+			int numOverLimit;
+		};
+		//solve each level from its restart state , levels are restarted after it
+		//outResults can be NULL
+		void    validateLevels( Level* levels[] , int numLevel , ValidateResult& result , Result outResults[] = NULL );
+
+		//level keeps its device state
+		Result  solve( Level& level , int numThread = 4 );
+		//restart level and setup devices of found solution
+		bool    applySolution( Level& level );
+
+		//same format as Level::generateDCStateCode
+		char const* getSolutionCode() const { return mSolutionCode; }
+		int     getSearchNodeNum() const { return mNumSearchNode; }
+		int     getPruneNodeNum() const { return mNumPruneNode; }
+		void    setMaxSearchNodeNum( int num ){ mMaxSearchNode = num; }
+		//can be called from other thread , running and later solve return eOverLimit
+		void    cancel(){ mbCancel = true; }
+
+	private:
+		struct Move
+		{
+			int   idxDC;
+			Vec2D pos;
+			int   dir;
+			bool operator == ( Move const& rhs ) const
+			{
+				return idxDC == rhs.idxDC && pos == rhs.pos && dir == rhs.dir;
+			}
+		};
+		class Worker;
+		friend class Worker;
+
+		struct SearchNode
+		{
+			int  parent;
+			int  depth;
+			Move move;
+		};
+		struct OpenNode
+		{
+			int score;
+			int depth;
+			int idxNode;
+			bool operator < ( OpenNode const& rhs ) const
+			{
+				if ( score != rhs.score )
+					return score < rhs.score;
+				return depth > rhs.depth;
+			}
+		};
+
+		//wait until a node is open , return false when search ends
+		bool    fetchNode( std::vector< Move >& outMoves , int& outIdxNode );
+		void    finishNode();
+		bool    addVisitedState( uint64 key );
+		void    addNode( int parent , Move const& move , int score );
+		void    reportSolution( Level& level );
+
+		Mutex                    mMutex;
+		Condition                mNodeCondition;
+		std::vector< SearchNode > mNodes;
+		std::priority_queue< OpenNode > mOpenNodes;
+		std::set< uint64 >       mVisitedStates;
+		int                      mNumActiveWorker;
+		volatile bool            mbFound;
+		volatile bool      mbOverLimit;
+		volatile bool      mbCancel;
+		int                mMaxSearchNode;
+		int                mNumSearchNode;
+		int                mNumPruneNode;
+		int                mLenSolutionCode;
+		char               mSolutionCode[ 128 ];
+	};
+
+}//namespace Chromatron
+
+#endif // CmtSolver_h__
@@ -6,6 +6,7 @@
 #include "CmtDeviceFactory.h"
 #include "CmtDeviceID.h"
 #include "CmtLevel.h"
+#include "CmtSolver.h"
 #include "CmtDefine.h"
 
 #include <sstream>
@@ -24,6 +25,9 @@
 namespace Chromatron
 {
 	int const IdxCreateMode = -1;
+	//hint must come in a short time , validation uses more
+	int const HintSearchNodeNum     = 20000;
+	int const ValidateSearchNodeNum = 200000;
 
 	unsigned char const* GameDataPackage[] = 
 	{
@@ -39,6 +43,11 @@ namespace Chromatron
 		mIndexLevel = -1;
 		mNumLevel   = 0;
 		std::fill_n( mLevelStorage , MaxNumLevel , (Level*) 0 );
+
+		mSolveTask      = eSolveNone;
+		mbSolveTaskDone = false;
+		mHintLevel      = NULL;
+		mSolveThread.init( this , &LevelStage::runSolveTask );
 	}
 
 	bool LevelStage::onInit()
@@ -119,6 +128,7 @@ namespace Chromatron
 
 	void LevelStage::onEnd()
 	{
+		stopSolveTask();
 		Global::getSetting().setKeyValue( "LastPlayLevel" , CHROMATRON_NAME , mIndexLevel );
 		Global::getSetting().setKeyValue( "LastPlayPackage" , CHROMATRON_NAME , mIndexGamePackage );
 		saveGameLevelState();
@@ -187,6 +197,13 @@ namespace Chromatron
 		switch( key )
 		{
 		case 'R': break;
+		case 'H':
+			//show a solution of current level
+			startSolveTask( eSolveHint );
+			break;
+		case 'V':
+			startSolveTask( eSolveValidate );
+			break;
 		}
 		return false;
 	}
@@ -315,6 +332,151 @@ namespace Chromatron
 		return true;
 	}
 
+	static Level* CreateLevelCopy( Level& level )
+	{
+		std::ostringstream oss( std::ios::binary );
+		Level* levels[] = { &level };
+		if ( !Level::saveLevelData( oss , levels , 1 ) )
+			return NULL;
+
+		std::istringstream iss( oss.str() , std::ios::binary );
+		Level* result = NULL;
+		if ( Level::loadLevelData( iss , &result , 1 ) != 1 )
+			return NULL;
+		return result;
+	}
+
+	bool LevelStage::startSolveTask( SolveTask task )
+	{
+		//one task at a time
+		if ( mSolveTask != eSolveNone )
+			return false;
+
+		if ( task == eSolveHint )
+		{
+			if ( mIndexGamePackage == IdxCreateMode || getCurLevel().isGoal() )
+				return false;
+
+			mHintLevel = CreateLevelCopy( getCurLevel() );
+			if ( !mHintLevel )
+				return false;
+			mHintPackage    = mIndexGamePackage;
+			mHintLevelIndex = mIndexLevel;
+		}
+
+		mSolveTask      = task;
+		mbSolveTaskDone = false;
+		if ( !mSolveThread.start() )
+		{
+			delete mHintLevel;
+			mHintLevel = NULL;
+			mSolveTask = eSolveNone;
+			return false;
+		}
+		return true;
+	}
+
+	unsigned LevelStage::runSolveTask()
+	{
+		switch( mSolveTask )
+		{
+		case eSolveHint:
+			mSolver.setMaxSearchNodeNum( HintSearchNodeNum );
+			mHintResult = mSolver.solve( *mHintLevel );
+			break;
+		case eSolveValidate:
+			mSolver.setMaxSearchNodeNum( ValidateSearchNodeNum );
+			validateGameData();
+			break;
+		}
+		mbSolveTaskDone = true;
+		return 0;
+	}
+
+	void LevelStage::updateSolveTask()
+	{
+		if ( mSolveTask == eSolveNone || !mbSolveTaskDone )
+			return;
+
+		mSolveThread.join();
+
+		switch( mSolveTask )
+		{
+		case eSolveHint:
+			//player may change level in searching
+			if ( mHintResult == Solver::eSolved )
+			{
+				if ( mHintPackage == mIndexGamePackage && mHintLevelIndex == mIndexLevel )
+					mSolver.applySolution( getCurLevel() );
+			}
+			else
+			{
+				::Global::getGUI().showMessageBox( UI_ANY , LAN( "No hint found" ) , GMB_OK );
+			}
+			delete mHintLevel;
+			mHintLevel = NULL;
+			break;
+		case eSolveValidate:
+			{
+				Solver::ValidateResult total = { 0 , 0 , 0 };
+				for( int idxPackage = 0 ; idxPackage < (int)mPackageResults.size() ; ++idxPackage )
+				{
+					PackageResult const& packageResult = mPackageResults[ idxPackage ];
+					for( int i = 0 ; i < packageResult.numLevel ; ++i )
+					{
+						if ( packageResult.levels[i] != Solver::eSolved )
+							::DevMsg( 5 , "Chromatron %d Level %d : %s" , idxPackage + 1 , i + 1 , 
+								packageResult.levels[i] == Solver::eOverLimit ? "over limit" : "no solution" );
+					}
+
+					Solver::ValidateResult const& result = packageResult.total;
+					::Msg( "Chromatron %d : solved %d , no solution %d , over limit %d" , idxPackage + 1 ,
+						result.numSolved , result.numNoSolution , result.numOverLimit );
+					total.numSolved     += result.numSolved;
+					total.numNoSolution += result.numNoSolution;
+					total.numOverLimit  += result.numOverLimit;
+				}
+				::Msg( "All Package : solved %d , no solution %d , over limit %d" , 
+					total.numSolved , total.numNoSolution , total.numOverLimit );
+			}
+			break;
+		}
+		mSolveTask = eSolveNone;
+	}
+
+	void LevelStage::stopSolveTask()
+	{
+		if ( mSolveTask == eSolveNone )
+			return;
+
+		mSolver.cancel();
+		mSolveThread.join();
+		delete mHintLevel;
+		mHintLevel = NULL;
+		mSolveTask = eSolveNone;
+	}
+
+	void LevelStage::validateGameData()
+	{
+		mPackageResults.resize( ARRAY_SIZE( GameDataPackage ) );
+		for( int idxPackage = 0 ; idxPackage < ARRAY_SIZE( GameDataPackage ) ; ++idxPackage )
+		{
+			unsigned char const* data = GameDataPackage[ idxPackage ];
+			GameInfoHeader* header = (GameInfoHeader*) data;
+			std::string  str( (char*) data , header->totalSize );
+			std::istringstream ss( str , std::ios::binary  );
+
+			Level* levels[ MaxNumLevel ];
+			int numLevel = Level::loadLevelData( ss , levels , MaxNumLevel );
+
+			PackageResult& packageResult = mPackageResults[ idxPackage ];
+			packageResult.numLevel = numLevel;
+			mSolver.validateLevels( levels , numLevel , packageResult.total , packageResult.levels );
+			for( int i = 0 ; i < numLevel ; ++i )
+				delete levels[i];
+		}
+	}
+
 	bool LevelStage::changeLevelInternal( int level , bool haveChangeData , bool beCreateMode )
 	{
 		if ( 0 > level || level >= mNumLevel )
@@ -362,6 +524,8 @@ namespace Chromatron
 
 	void LevelStage::onUpdate( long time )
 	{
+		updateSolveTask();
+
 		int frame = time / gDefaultTickTime;
 		for( int i = 0 ; i < frame ; ++i )
 			tick();
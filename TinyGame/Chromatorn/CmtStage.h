@@ -4,6 +4,10 @@
 #include "StageBase.h"
 
 #include "CmtScene.h"
+#include "CmtSolver.h"
+#include "Thread.h"
+
+#include <vector>
 
 namespace Chromatron
 {
@@ -44,6 +48,20 @@ namespace Chromatron
 		bool   saveGameLevelState();
 		bool   loadGameLevelState();
 
+		enum SolveTask
+		{
+			eSolveNone ,
+			eSolveHint ,
+			eSolveValidate ,
+		};
+		//solver runs on worker thread , result is used by updateSolveTask
+		bool     startSolveTask( SolveTask task );
+		void     updateSolveTask();
+		void     stopSolveTask();
+		unsigned runSolveTask();
+		//solve all levels of every package , for checking level data and solver
+		void     validateGameData();
+
 		Level& getCurLevel(){ return mScene.getLevel(); }
 		bool   tryUnlockLevel();
 		bool   changeLevelInternal( int level , bool haveChangeData , bool beCreateMode = false );
@@ -73,6 +91,24 @@ namespace Chromatron
 		Level* mLevelStorage[ MaxNumLevel ];
 		State  mLevelState[ MaxNumLevel ];
 		int    mNumLevel;
+
+		struct PackageResult
+		{
+			Solver::ValidateResult total;
+			Solver::Result         levels[ MaxNumLevel ];
+			int                    numLevel;
+		};
+
+		MemberFunThread< LevelStage > mSolveThread;
+		Solver         mSolver;
+		SolveTask      mSolveTask;
+		volatile bool  mbSolveTaskDone;
+		//copy of level for hint , worker never touches the playing level
+		Level*         mHintLevel;
+		int            mHintPackage;
+		int            mHintLevelIndex;
+		Solver::Result mHintResult;
+		std::vector< PackageResult > mPackageResults;
 	};
 
 }//namespace Chromatron
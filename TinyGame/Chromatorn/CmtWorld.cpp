@@ -4,6 +4,9 @@
 #include "CmtLightTrace.h"
 #include "CmtDevice.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace Chromatron
 {
 	int const MaxTransmitLightNum = 10000;
@@ -13,6 +16,8 @@ namespace Chromatron
 		:mIsSyncMode(false)
 		,mSyncProcessor( NULL )
 		,mSyncLights( NULL )
+		,mbLightRecorded( false )
+		,mbSetupTileBlockLight( false )
 	{
 		initData( sx , sy );
 	}
@@ -25,6 +30,9 @@ namespace Chromatron
 	void World::initData( int sx , int sy )
 	{
 		mTileMap.resize( sx , sy );
+		mTileSegments.clear();
+		mTileSegments.resize( sx * sy );
+		mTileDirtyState.assign( sx * sy , 0 );
 	}
 
 	bool World::isVaildRange(Vec2D const& pos) const
@@ -99,7 +107,7 @@ namespace Chromatron
 		Tile& mapData = getMapData( light.getEndPos() );
 		*curData = &mapData;
 
-		if ( mapData.blockLight() )
+		if ( isBlockLight( mapData ) )
 			return false;
 
 		mapData.addLightPathColor( light.getDir().inverse() , light.getColor() );
@@ -120,6 +128,9 @@ namespace Chromatron
 		mSyncProcessor = &processor;
 		mSyncLights    = &transmitLights;
 
+		//sync light is not recorded
+		invalidLightRecord();
+
 		typedef std::list< LightList::iterator > IterList;
 		IterList   eraseIters;
 
@@ -211,6 +222,7 @@ SyncEnd:
 			LightTrace& light = mNormalLights.front();
 			
 			Tile* mapData = &getMapData( light.getEndPos() );
+			int   startAge = light.getAge();
 
 			for(;;)
 			{
@@ -218,6 +230,8 @@ SyncEnd:
 					break;
 			}
 
+			recordLight( light , startAge , mapData );
+
 			if ( mapData )
 			{
 				Device* dc = mapData->getDevice();
@@ -246,6 +260,9 @@ SyncEnd:
 		}
 		mNormalLights.clear();
 		mLightCount = 0;
+
+		clearLightRecord();
+		mbLightRecorded = true;
 	}
 
 	void World::clearDevice()
@@ -255,6 +272,7 @@ SyncEnd:
 		{
 			mTileMap[i].setDevice( NULL );
 		}
+		invalidLightRecord();
 	}
 
 	void World::fillMap( MapType type )
@@ -264,6 +282,234 @@ SyncEnd:
 		{
 			mTileMap[i].setType( type );
 		}
+		invalidLightRecord();
+	}
+
+	void World::clearLightRecord()
+	{
+		mSegments.clear();
+		mFreeSegments.clear();
+		for( int i = 0 ; i < (int)mTileSegments.size() ; ++i )
+			mTileSegments[i].clear();
+		for( int i = 0 ; i < (int)mDirtyTiles.size() ; ++i )
+			mTileDirtyState[ mDirtyTiles[i] ] = 0;
+		mDirtyTiles.clear();
+		mResetStack.clear();
+		mRemovedSegments.clear();
+	}
+
+	void World::recordLight( LightTrace const& light , int startAge , Tile* endData )
+	{
+		LightSegment seg;
+		seg.start      = light.getStartPos();
+		seg.dir        = light.getDir();
+		seg.color      = light.getColor();
+		seg.bRemoved   = false;
+		seg.bEndBlock  = false;
+		seg.bEndDevice = false;
+		seg.bEndDir    = false;
+
+		int numStep = light.getAge() - startAge;
+		if ( endData == NULL )
+		{
+			//went out of map after last tile
+			seg.numTile = numStep;
+			seg.bEndDir = true;
+		}
+		else
+		{
+			seg.numTile = numStep + 1;
+			if ( numStep && isBlockLight( *endData ) )
+				seg.bEndBlock = true;
+			else if ( numStep && endData->getDevice() )
+				seg.bEndDevice = true;
+			else
+				seg.bEndDir = true; //blocked by corner
+		}
+
+		int idSeg;
+		if ( !mFreeSegments.empty() )
+		{
+			idSeg = mFreeSegments.back();
+			mFreeSegments.pop_back();
+			mSegments[ idSeg ] = seg;
+		}
+		else
+		{
+			idSeg = (int)mSegments.size();
+			mSegments.push_back( seg );
+		}
+
+		Vec2D pos = seg.start;
+		Vec2D offset = LightTrace::getDirOffset( seg.dir );
+		for( int i = 0 ; i < seg.numTile ; ++i )
+		{
+			mTileSegments[ toIndex( pos ) ].push_back( idSeg );
+			pos += offset;
+		}
+	}
+
+	void World::addSegmentPathColor( Tile& tile , LightSegment const& seg , int idxTile )
+	{
+		//same colors as transmitLightStep adds
+		bool beEnd = ( idxTile == seg.numTile - 1 );
+		if ( idxTile != 0 && !( beEnd && seg.bEndBlock ) )
+			tile.addLightPathColor( seg.dir.inverse() , seg.color );
+		if ( !beEnd || seg.bEndDir || idxTile == 0 )
+			tile.addLightPathColor( seg.dir , seg.color );
+	}
+
+	void World::markDirty( Vec2D const& pos )
+	{
+		if ( !mbLightRecorded || !isVaildRange( pos ) )
+			return;
+
+		int idx = toIndex( pos );
+		//light through the tile is changed
+		IndexVec const& segs = mTileSegments[ idx ];
+		for( int i = 0 ; i < (int)segs.size() ; ++i )
+			invalidSegment( segs[i] );
+		addDirtyState( idx , TS_RESET );
+	}
+
+	void World::addDirtyState( int idx , unsigned state )
+	{
+		unsigned& curState = mTileDirtyState[ idx ];
+		if ( curState == 0 )
+			mDirtyTiles.push_back( idx );
+		if ( ( state & TS_RESET ) && !( curState & TS_RESET ) )
+			mResetStack.push_back( idx );
+		curState |= state | TS_REEMIT;
+	}
+
+	void World::invalidSegment( int idSeg )
+	{
+		LightSegment& seg = mSegments[ idSeg ];
+		if ( seg.bRemoved )
+			return;
+		seg.bRemoved = true;
+		mRemovedSegments.push_back( idSeg );
+
+		addDirtyState( toIndex( seg.start ) , TS_REEMIT );
+		if ( seg.bEndDevice )
+		{
+			Vec2D end = seg.start + ( seg.numTile - 1 ) * LightTrace::getDirOffset( seg.dir );
+			addDirtyState( toIndex( end ) , TS_RESET );
+		}
+	}
+
+	TransmitStatus World::updateDirtyLight()
+	{
+		assert( mbLightRecorded );
+		mStatus = TSS_OK;
+
+		//output of reset device is invalid , and it resets next devices
+		while( !mResetStack.empty() )
+		{
+			int idx = mResetStack.back();
+			mResetStack.pop_back();
+
+			Vec2D pos( idx % getMapSizeX() , idx / getMapSizeX() );
+			IndexVec const& segs = mTileSegments[ idx ];
+			for( int i = 0 ; i < (int)segs.size() ; ++i )
+			{
+				if ( mSegments[ segs[i] ].start == pos )
+					invalidSegment( segs[i] );
+			}
+		}
+
+		//remove invalid segments and rebuild path color of their tiles
+		IndexVec& pathTiles = mPathTiles;
+		for( int n = 0 ; n < (int)mRemovedSegments.size() ; ++n )
+		{
+			int idSeg = mRemovedSegments[n];
+			LightSegment const& seg = mSegments[ idSeg ];
+			Vec2D pos = seg.start;
+			Vec2D offset = LightTrace::getDirOffset( seg.dir );
+			for( int i = 0 ; i < seg.numTile ; ++i , pos += offset )
+			{
+				int idx = toIndex( pos );
+				IndexVec& segs = mTileSegments[ idx ];
+				IndexVec::iterator iter = std::find( segs.begin() , segs.end() , idSeg );
+				assert( iter != segs.end() );
+				*iter = segs.back();
+				segs.pop_back();
+				pathTiles.push_back( idx );
+			}
+			mFreeSegments.push_back( idSeg );
+		}
+		mRemovedSegments.clear();
+
+		for( int n = 0 ; n < (int)pathTiles.size() ; ++n )
+		{
+			int idx = pathTiles[n];
+			Tile& tile = mTileMap[ idx ];
+			Vec2D pos( idx % getMapSizeX() , idx / getMapSizeX() );
+			tile.clearLight();
+
+			IndexVec const& segs = mTileSegments[ idx ];
+			for( int i = 0 ; i < (int)segs.size() ; ++i )
+			{
+				LightSegment const& seg = mSegments[ segs[i] ];
+				Vec2D d = pos - seg.start;
+				addSegmentPathColor( tile , seg , std::max( std::abs( d.x ) , std::abs( d.y ) ) );
+			}
+		}
+		pathTiles.clear();
+
+		//rebuild device light colors from valid segments , then emit again
+		for( int n = 0 ; n < (int)mDirtyTiles.size() ; ++n )
+		{
+			int idx = mDirtyTiles[n];
+			Tile& tile = mTileMap[ idx ];
+			Device* dc = tile.getDevice();
+			if ( dc == NULL )
+				continue;
+
+			Vec2D pos( idx % getMapSizeX() , idx / getMapSizeX() );
+			tile.clearDeviceLight();
+
+			IndexVec const& segs = mTileSegments[ idx ];
+			for( int i = 0 ; i < (int)segs.size() ; ++i )
+			{
+				LightSegment const& seg = mSegments[ segs[i] ];
+				if ( seg.start == pos )
+					tile.addEmittedLightColor( seg.dir , seg.color );
+				else if ( seg.bEndDevice )
+					tile.addReceivedLightColor( seg.dir.inverse() , seg.color );
+			}
+		}
+
+		for( int n = 0 ; n < (int)mDirtyTiles.size() ; ++n )
+		{
+			int idx = mDirtyTiles[n];
+			mTileDirtyState[ idx ] = 0;
+
+			Device* dc = mTileMap[ idx ].getDevice();
+			if ( dc == NULL )
+				continue;
+
+			Vec2D pos( idx % getMapSizeX() , idx / getMapSizeX() );
+			dc->update( *this );
+
+			IndexVec const& segs = mTileSegments[ idx ];
+			for( int i = 0 ; i < (int)segs.size() ; ++i )
+			{
+				LightSegment const& seg = mSegments[ segs[i] ];
+				if ( seg.start == pos || !seg.bEndDevice )
+					continue;
+
+				LightTrace light( seg.start , seg.color , seg.dir );
+				if ( procDeviceEffect( *dc , light ) != TSS_OK )
+				{
+					mDirtyTiles.clear();
+					return mStatus;
+				}
+			}
+		}
+		mDirtyTiles.clear();
+
+		return transmitLight();
 	}
 
 
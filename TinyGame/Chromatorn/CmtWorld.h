@@ -4,6 +4,7 @@
 #include "CmtBase.h"
 #include "TGrid2D.h"
 #include <list>
+#include <vector>
 
 namespace Chromatron
 {
@@ -39,6 +40,10 @@ namespace Chromatron
 			unsigned emittedColor;
 			unsigned receivedColor;
 			unsigned lazyColor;
+			//device state of last light update , for finding changed device
+			DeviceId tracedId;
+			int      tracedDir;
+			Color    tracedColor;
 		};
 
 		MapType       getType()   const { return mType; }
@@ -53,6 +58,10 @@ namespace Chromatron
 		void    setType( MapType type ){ mType = type; }
 
 		void    clearLight();
+		bool    haveLight() const { return mLightPathColor != 0; }
+		//light colors of all dir
+		unsigned getLightPathState() const { return mLightPathColor; }
+		void    clearDeviceLight(){ assert( mDCInfo ); mDCInfo->emittedColor = 0; mDCInfo->receivedColor = 0; }
 		Color   getLightPathColor    ( Dir dir )  const {  return getLightColor( mLightPathColor , dir );  }
 		Color   getEmittedLightColor ( Dir dir )  const {  assert( mDCInfo ); return getLightColor( mDCInfo->emittedColor , dir ); }
 		Color   getReceivedLightColor( Dir dir )  const {  assert( mDCInfo ); return getLightColor( mDCInfo->receivedColor , dir ); }
@@ -131,6 +140,18 @@ namespace Chromatron
 		void           addLight( Vec2D const& pos , Color color , Dir dir );
 		void           clearLight();
 
+		//  Incremental update : every traced light is kept as a segment listed in
+		//  the tiles it crosses. Marked tiles invalidate the segments through them ,
+		//  the devices whose input changed drop their output too , and only these
+		//  devices re-emit light.
+		void           markDirty( Vec2D const& pos );
+		TransmitStatus updateDirtyLight();
+		bool           haveLightRecord() const { return mbLightRecorded; }
+		void           invalidLightRecord(){ mbLightRecorded = false; }
+
+		//empty tile that can setup device blocks light , so only light no device can cut is traced
+		void           setSetupTileBlockLight( bool beB ){ mbSetupTileBlockLight = beB; invalidLightRecord(); }
+
 		void           setSyncMode( bool beS ){ mIsSyncMode = beS; }
 		bool           isSyncMode(){ return mIsSyncMode; }
 		void           setLightParam( int param ){ mLightParam = param; }
@@ -138,6 +159,32 @@ namespace Chromatron
 
 	private:
 
+		struct LightSegment
+		{
+			Vec2D start;
+			Dir   dir;
+			Color color;
+			int   numTile;
+			bool  bEndDir;    //end tile has path color of dir
+			bool  bEndBlock;  //end tile blocks light , no path color
+			bool  bEndDevice; //light is received by device of end tile
+			bool  bRemoved;
+		};
+
+		enum
+		{
+			TS_REEMIT = BIT(0) , //device emits light again with unchanged input
+			TS_RESET  = BIT(1) , //input or device is changed , all output is invalid
+		};
+
+		int             toIndex( Vec2D const& pos ) const { return mTileMap.toIndex( pos.x , pos.y ); }
+		bool            isBlockLight( Tile const& tile ) const { return tile.blockLight() || ( mbSetupTileBlockLight && tile.canSetup() ); }
+		void            recordLight( LightTrace const& light , int startAge , Tile* endData );
+		void            invalidSegment( int idSeg );
+		void            addDirtyState( int idx , unsigned state );
+		void            addSegmentPathColor( Tile& tile , LightSegment const& seg , int idxTile );
+		void            clearLightRecord();
+
 		bool            transmitLightStep( LightTrace& light , Tile** curData );
 		void            initData( int sx , int sy );
 		TransmitStatus  procDeviceEffect( Device& dc , LightTrace const& light );
@@ -151,6 +198,18 @@ namespace Chromatron
 		int              mLightAge;
 		bool             mIsSyncMode;
 		TGrid2D< Tile >  mTileMap;
+
+		typedef std::vector< int > IndexVec;
+		bool                        mbLightRecorded;
+		bool                        mbSetupTileBlockLight;
+		std::vector< LightSegment > mSegments;
+		IndexVec                    mFreeSegments;
+		std::vector< IndexVec >     mTileSegments;
+		std::vector< unsigned >     mTileDirtyState;
+		IndexVec                    mDirtyTiles;
+		IndexVec                    mResetStack;
+		IndexVec                    mPathTiles;
+		IndexVec                    mRemovedSegments;
 	};
 
 }//namespace Chromatron
@@ -9,11 +9,15 @@ namespace Cube
 {
 	static Block* sBlockMap[ 256 ] = { 0 };
 
+	uint8 Block::sLightOpacity[ 256 ] = { 0 };
+	uint8 Block::sLightValue[ 256 ] = { 0 };
+
 
 	void Block::initList()
 	{
 		(*new Block( BLOCK_DIRT )).setSolid( true );
-		(*new LiquidBlock( BLOCK_WATER ) ).setSolid( false );
+		(*new LiquidBlock( BLOCK_WATER ) ).setSolid( false ).setLightOpacity( 2 );
+		(*new Block( BLOCK_TORCH )).setSolid( false ).setLightOpacity( 0 ).setLightValue( 14 );
 	}
 
 	Block* Block::get( BlockId id )
@@ -29,7 +33,22 @@ namespace Cube
 			delete sBlockMap[id];
 		}
 		sBlockMap[ id ] = this;
+		sLightOpacity[ id ] = 15;
+		sLightValue[ id ] = 0;
+	}
+
+	Block& Block::setLightOpacity( int value )
+	{
+		assert( 0 <= value && value <= 15 );
+		sLightOpacity[ mId ] = uint8( value );
+		return *this;
+	}
 
+	Block& Block::setLightValue( int value )
+	{
+		assert( 0 <= value && value <= 15 );
+		sLightValue[ mId ] = uint8( value );
+		return *this;
 	}
 
 	unsigned Block::calcRenderFaceMask( IBlockAccess& blockAccess , int bx , int by , int bz  )
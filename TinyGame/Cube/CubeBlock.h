@@ -29,6 +29,15 @@ namespace Cube
 		bool    isSolid(){ return mbSolid; }
 		Block&  setSolid( bool beS = true ){ mbSolid = beS; return *this; }
 
+		//light opacity in [ 0 , 15 ] , 15 stops light
+		Block&  setLightOpacity( int value );
+		//light emission in [ 0 , 15 ]
+		Block&  setLightValue( int value );
+
+		//table look up , safe to use on loader threads
+		static int getLightOpacity( BlockId id ){ return sLightOpacity[ id ]; }
+		static int getLightValue( BlockId id ){ return sLightValue[ id ]; }
+
 		virtual unsigned    calcRenderFaceMask( IBlockAccess& blockAccess , int bx , int by , int bz );
 		virtual bool        canPlaceItem( FaceSide face , ItemId itemId ){ return false; }
 		virtual void        onNeighborBlockModify( IBlockAccess& blockAccess , int bx , int by , int bz , FaceSide face ){}
@@ -36,6 +45,9 @@ namespace Cube
 	private:
 		BlockId mId;
 		bool    mbSolid;
+
+		static uint8 sLightOpacity[ 256 ];
+		static uint8 sLightValue[ 256 ];
 		
 	};
 
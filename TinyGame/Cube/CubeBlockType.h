@@ -7,6 +7,7 @@ namespace Cube
 	{
 		BLOCK_DIRT = 1 ,
 		BLOCK_WATER ,
+		BLOCK_TORCH ,
 	};
 
 
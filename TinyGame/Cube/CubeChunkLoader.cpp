@@ -0,0 +1,199 @@
+#include "CubePCH.h"
+#include "CubeChunkLoader.h"
+
+#include "CubeChunkStorage.h"
+#include "CubeLightEngine.h"
+
+#include <algorithm>
+
+namespace Cube
+{
+	ChunkLoader::ChunkLoader( TerrainGenerator& generator , ChunkStorage* storage , IChunkLoadListener* listener )
+		:mGenerator( generator )
+		,mStorage( storage )
+		,mListener( listener )
+		,mbStopping( false )
+		,mResultHead( NULL )
+	{
+
+	}
+
+	ChunkLoader::~ChunkLoader()
+	{
+		stop();
+	}
+
+	bool ChunkLoader::start( int numWorker )
+	{
+		assert( mWorkers.empty() );
+		if ( numWorker < 1 )
+			numWorker = 1;
+
+		mbStopping = false;
+		for( int i = 0 ; i < numWorker ; ++i )
+		{
+			WorkerThread* worker = new WorkerThread( this , &ChunkLoader::runWorker );
+			if ( !worker->start() )
+			{
+				delete worker;
+				break;
+			}
+			worker->setPriorityLevel( THREAD_PRIORITY_BELOW_NORMAL );
+			mWorkers.push_back( worker );
+		}
+		return !mWorkers.empty();
+	}
+
+	void ChunkLoader::stop()
+	{
+		{
+			Mutex::Locker locker( mQueueMutex );
+			mbStopping = true;
+			mQueue.clear();
+		}
+		mQueueCondition.notifyAll();
+
+		for( size_t i = 0 ; i < mWorkers.size() ; ++i )
+		{
+			mWorkers[i]->join();
+			delete mWorkers[i];
+		}
+		mWorkers.clear();
+
+		assert( mSaveQueue.empty() );
+
+		Result* result = fetchResults();
+		while( result )
+		{
+			Result* next = result->next;
+			releaseResult( result , true );
+			result = next;
+		}
+	}
+
+	void ChunkLoader::cancelRequests( std::vector< ChunkPos >& outPosList )
+	{
+		Mutex::Locker locker( mQueueMutex );
+		for( size_t i = 0 ; i < mQueue.size() ; ++i )
+			outPosList.push_back( mQueue[i].pos );
+		mQueue.clear();
+	}
+
+	void ChunkLoader::addRequest( ChunkPos const& pos , int distance )
+	{
+		Request request;
+		request.pos      = pos;
+		request.distance = distance;
+		mPendingRequests.push_back( request );
+	}
+
+	void ChunkLoader::commitRequests()
+	{
+		if ( mPendingRequests.empty() )
+			return;
+		{
+			Mutex::Locker locker( mQueueMutex );
+			mQueue.insert( mQueue.end() , mPendingRequests.begin() , mPendingRequests.end() );
+			std::make_heap( mQueue.begin() , mQueue.end() );
+		}
+		mPendingRequests.clear();
+		mQueueCondition.notifyAll();
+	}
+
+	void ChunkLoader::addSave( Chunk* chunk )
+	{
+		{
+			Mutex::Locker locker( mQueueMutex );
+			mSaveQueue.push_back( chunk );
+		}
+		mQueueCondition.notify();
+	}
+
+	unsigned ChunkLoader::runWorker()
+	{
+		for(;;)
+		{
+			Request request;
+			Chunk*  saveChunk = NULL;
+			{
+				Mutex::Locker locker( mQueueMutex );
+				while( mQueue.empty() && mSaveQueue.empty() && !mbStopping )
+					mQueueCondition.waitTime( mQueueMutex );
+
+				if ( !mSaveQueue.empty() )
+				{
+					saveChunk = mSaveQueue.back();
+					mSaveQueue.pop_back();
+				}
+				else if ( mbStopping )
+				{
+					break;
+				}
+				else
+				{
+					std::pop_heap( mQueue.begin() , mQueue.end() );
+					request = mQueue.back();
+					mQueue.pop_back();
+				}
+			}
+
+			if ( saveChunk )
+			{
+				if ( mStorage )
+					mStorage->saveChunk( *saveChunk );
+
+				Result* result = new Result;
+				result->pos        = saveChunk->getPos();
+				result->chunk      = NULL;
+				result->renderData = NULL;
+				delete saveChunk;
+				pushResult( result );
+				continue;
+			}
+
+			Chunk* chunk = ( mStorage ) ? mStorage->loadChunk( request.pos ) : NULL;
+			if ( !chunk )
+			{
+				chunk = new Chunk( request.pos );
+				Random rand;
+				rand.setSeed( request.pos.hash_value() );
+				mGenerator.generate( *chunk , rand );
+				LightEngine::lightChunk( *chunk );
+				chunk->compact();
+			}
+
+			Result* result = new Result;
+			result->pos        = request.pos;
+			result->chunk      = chunk;
+			result->renderData = ( mListener ) ? mListener->buildRenderData( *chunk ) : NULL;
+			pushResult( result );
+		}
+		return 0;
+	}
+
+	void ChunkLoader::pushResult( Result* result )
+	{
+		Result* head;
+		do
+		{
+			head = mResultHead;
+			result->next = head;
+		}
+		while( ::InterlockedCompareExchangePointer( (PVOID volatile*)&mResultHead , result , head ) != head );
+	}
+
+	ChunkLoader::Result* ChunkLoader::fetchResults()
+	{
+		return (Result*)::InterlockedExchangePointer( (PVOID volatile*)&mResultHead , NULL );
+	}
+
+	void ChunkLoader::releaseResult( Result* result , bool beDeleteChunk )
+	{
+		if ( beDeleteChunk )
+			delete result->chunk;
+		if ( result->renderData && mListener )
+			mListener->releaseRenderData( result->renderData );
+		delete result;
+	}
+
+}//namespace Cube
@@ -0,0 +1,77 @@
+#ifndef CubeChunkLoader_h__
+#define CubeChunkLoader_h__
+
+#include "CubeWorld.h"
+#include "IWorldEventListener.h"
+#include "Thread.h"
+
+#include <vector>
+
+namespace Cube
+{
+	class ChunkStorage;
+
+	//  Worker threads of the async chunk pipeline.
+	//  Requests are taken nearest first ; a worker loads the chunk from storage
+	//  or generates it , then calls IChunkLoadListener::buildRenderData , and
+	//  pushes the result to a lock-free list which the main thread takes all
+	//  at once. Saves are done before loads and are finished by stop.
+	class ChunkLoader
+	{
+	public:
+		ChunkLoader( TerrainGenerator& generator , ChunkStorage* storage , IChunkLoadListener* listener );
+		~ChunkLoader();
+
+		struct Result
+		{
+			ChunkPos         pos;
+			// NULL if this is the result of a save
+			Chunk*           chunk;
+			ChunkRenderData* renderData;
+			Result*          next;
+		};
+
+		bool    start( int numWorker );
+		void    stop();
+
+		// take out all requests not started
+		void    cancelRequests( std::vector< ChunkPos >& outPosList );
+		// distance is priority , small is first
+		void    addRequest( ChunkPos const& pos , int distance );
+		void    commitRequests();
+		// loader owns the chunk and deletes it after saving
+		void    addSave( Chunk* chunk );
+
+		// main thread , return list of result ( link with Result::next )
+		Result* fetchResults();
+		void    releaseResult( Result* result , bool beDeleteChunk );
+
+	private:
+		struct Request
+		{
+			ChunkPos pos;
+			int      distance;
+			bool operator < ( Request const& rhs ) const { return distance > rhs.distance; }
+		};
+
+		unsigned runWorker();
+		void     pushResult( Result* result );
+
+		typedef MemberFunThread< ChunkLoader > WorkerThread;
+
+		TerrainGenerator&     mGenerator;
+		ChunkStorage*         mStorage;
+		IChunkLoadListener*   mListener;
+		std::vector< WorkerThread* > mWorkers;
+		std::vector< Request > mQueue;
+		std::vector< Request > mPendingRequests;
+		std::vector< Chunk* >  mSaveQueue;
+		Mutex                 mQueueMutex;
+		Condition             mQueueCondition;
+		bool volatile         mbStopping;
+		Result* volatile      mResultHead;
+	};
+
+}//namespace Cube
+
+#endif // CubeChunkLoader_h__
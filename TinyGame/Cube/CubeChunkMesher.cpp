@@ -0,0 +1,157 @@
+#include "CubePCH.h"
+#include "CubeChunkMesher.h"
+
+#include "CubeMesh.h"
+
+namespace Cube
+{
+	void ChunkMesher::fillOpaqueMap( Chunk& chunk , int idxLayer , IBlockAccess& blockAccess )
+	{
+		int bx = chunk.getPos().x * ChunkSize;
+		int by = chunk.getPos().y * ChunkSize;
+		int bz = idxLayer * Chunk::LayerSize;
+
+		for( int i = -1 ; i <= SizeX ; ++i )
+		{
+			for( int j = -1 ; j <= SizeY ; ++j )
+			{
+				bool beInside = ( 0 <= i && i < SizeX ) && ( 0 <= j && j < SizeY );
+				for( int k = -1 ; k <= SizeZ ; ++k )
+				{
+					uint8 value;
+					if ( beInside && 0 <= k && k < SizeZ )
+						value = ( mBlockMap[ Chunk::LayerData::toIndex( i , j , k ) ] != BLOCK_NULL ) ? 1 : 0;
+					else
+						value = blockAccess.isOpaqueBlock( bx + i , by + j , bz + k ) ? 1 : 0;
+
+					mOpaqueMap[ toOpaqueIndex( i , j , k ) ] = value;
+				}
+			}
+		}
+	}
+
+	int ChunkMesher::buildSection( Chunk& chunk , int idxLayer , IBlockAccess& blockAccess , Mesh& mesh )
+	{
+		Chunk::LayerData* layer = chunk.mLayer[ idxLayer ];
+		if ( !layer )
+			return 0;
+
+		PaletteBlockArray const& blocks = layer->getBlocks();
+		if ( blocks.isUniform() && blocks.getUniformId() == BLOCK_NULL )
+			return 0;
+		blocks.unpack( mBlockMap );
+
+		fillOpaqueMap( chunk , idxLayer , blockAccess );
+
+		mesh.setVertexOffset( Vec3f( 0 , 0 , float( idxLayer * Chunk::LayerSize ) ) );
+		mesh.setColor( 0 , 255 , 0 );
+
+		int const size[3] = { SizeX , SizeY , SizeZ };
+
+		int numQuad = 0;
+		for( int face = 0 ; face < 6 ; ++face )
+		{
+			int  axis = face / 2;
+			bool beN  = ( face & 1 ) != 0;
+			int  u = ( axis + 1 ) % 3;
+			int  v = ( axis + 2 ) % 3;
+			int  sizeU = size[u];
+			int  sizeV = size[v];
+
+			for( int d = 0 ; d < size[ axis ] ; ++d )
+			{
+				//face mask of the plane
+				int pos[3];
+				int posN[3];
+				pos[ axis ]  = d;
+				posN[ axis ] = beN ? d - 1 : d + 1;
+
+				bool haveFace = false;
+				for( int j = 0 ; j < sizeV ; ++j )
+				{
+					pos[v] = posN[v] = j;
+					for( int i = 0 ; i < sizeU ; ++i )
+					{
+						pos[u] = posN[u] = i;
+						BlockId id = mBlockMap[ Chunk::LayerData::toIndex( pos[0] , pos[1] , pos[2] ) ];
+						if ( id != BLOCK_NULL && isOpaque( posN ) )
+							id = BLOCK_NULL;
+						mFaceMask[ i + j * sizeU ] = id;
+						if ( id != BLOCK_NULL )
+							haveFace = true;
+					}
+				}
+
+				if ( !haveFace )
+					continue;
+
+				//merge faces to quads
+				for( int j = 0 ; j < sizeV ; ++j )
+				{
+					BlockId* row = mFaceMask + j * sizeU;
+					for( int i = 0 ; i < sizeU ; )
+					{
+						BlockId id = row[i];
+						if ( id == BLOCK_NULL )
+						{
+							++i;
+							continue;
+						}
+
+						int w = 1;
+						while( i + w < sizeU && row[ i + w ] == id )
+							++w;
+
+						int h = 1;
+						for( ; j + h < sizeV ; ++h )
+						{
+							BlockId* rowTest = row + h * sizeU;
+							int n = 0;
+							for( ; n < w ; ++n )
+							{
+								if ( rowTest[ i + n ] != id )
+									break;
+							}
+							if ( n != w )
+								break;
+						}
+
+						for( int m = 0 ; m < h ; ++m )
+							std::fill_n( row + m * sizeU + i , w , BLOCK_NULL );
+
+						emitQuad( mesh , axis , beN , d , i , j , w , h );
+						++numQuad;
+
+						i += w;
+					}
+				}
+			}
+		}
+
+		return numQuad;
+	}
+
+	void ChunkMesher::emitQuad( Mesh& mesh , int axis , bool beN , int d , int i , int j , int w , int h )
+	{
+		int u = ( axis + 1 ) % 3;
+		int v = ( axis + 2 ) % 3;
+
+		//( u , v ) is right-handed with the face normal , so the quad is
+		//counter clockwise on positive face and reversed on negative face
+		int const cornerU[4] = { i , i + w , i + w , i };
+		int const cornerV[4] = { j , j , j + h , j + h };
+
+		mesh.setIndexBase( mesh.getVertexNum() );
+		for( int n = 0 ; n < 4 ; ++n )
+		{
+			int idx = beN ? 3 - n : n;
+			float p[3];
+			p[ axis ] = float( beN ? d : d + 1 );
+			p[ u ] = float( cornerU[ idx ] );
+			p[ v ] = float( cornerV[ idx ] );
+			mesh.addVertex( p[0] , p[1] , p[2] );
+		}
+		mesh.addQuad( 0 , 1 , 2 , 3 );
+	}
+
+}//namespace Cube
@@ -0,0 +1,43 @@
+#ifndef CubeChunkMesher_h__
+#define CubeChunkMesher_h__
+
+#include "CubeBase.h"
+#include "CubeWorld.h"
+
+namespace Cube
+{
+	class Mesh;
+
+	//  Build the mesh of one chunk section ( Chunk::LayerData ).
+	//  Faces next to an opaque block are removed and the visible faces of
+	//  the same block id in one plane are merged to big quads ( greedy mesh ).
+	//  Vertex position is local to the chunk.
+	class ChunkMesher
+	{
+	public:
+		static int const SizeX = ChunkSize;
+		static int const SizeY = ChunkSize;
+		static int const SizeZ = Chunk::LayerSize;
+
+		//return number of quad
+		int  buildSection( Chunk& chunk , int idxLayer , IBlockAccess& blockAccess , Mesh& mesh );
+
+	private:
+		void fillOpaqueMap( Chunk& chunk , int idxLayer , IBlockAccess& blockAccess );
+		void emitQuad( Mesh& mesh , int axis , bool beN , int d , int i , int j , int w , int h );
+
+		//x , y , z in [ -1 , size ]
+		static int  toOpaqueIndex( int x , int y , int z )
+		{
+			return ( ( x + 1 ) * ( SizeY + 2 ) + ( y + 1 ) ) * ( SizeZ + 2 ) + ( z + 1 );
+		}
+		bool isOpaque( int const pos[3] ) const { return mOpaqueMap[ toOpaqueIndex( pos[0] , pos[1] , pos[2] ) ] != 0; }
+
+		BlockId mBlockMap[ SizeX * SizeY * SizeZ ];
+		uint8   mOpaqueMap[ ( SizeX + 2 ) * ( SizeY + 2 ) * ( SizeZ + 2 ) ];
+		BlockId mFaceMask[ SizeZ * ChunkSize ];
+	};
+
+}//namespace Cube
+
+#endif // CubeChunkMesher_h__
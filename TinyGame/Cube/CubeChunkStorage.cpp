@@ -0,0 +1,419 @@
+#include "CubePCH.h"
+#include "CubeChunkStorage.h"
+
+#include "CubeLightEngine.h"
+
+#include "FileSystem.h"
+#include "Win32Header.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace Cube
+{
+	//PackBits : token < 128 is ( token + 1 ) literal bytes ,
+	//token >= 128 is a byte repeated ( token - 125 ) times
+	static void PackBytes( uint8 const* src , int size , std::vector< uint8 >& out )
+	{
+		int i = 0;
+		while( i < size )
+		{
+			int run = 1;
+			while( i + run < size && run < 130 && src[ i + run ] == src[i] )
+				++run;
+
+			if ( run >= 3 )
+			{
+				out.push_back( uint8( 125 + run ) );
+				out.push_back( src[i] );
+				i += run;
+				continue;
+			}
+
+			int start = i;
+			int num = 0;
+			while( i < size && num < 128 )
+			{
+				if ( i + 2 < size && src[i] == src[ i + 1 ] && src[i] == src[ i + 2 ] )
+					break;
+				++i;
+				++num;
+			}
+			out.push_back( uint8( num - 1 ) );
+			out.insert( out.end() , src + start , src + i );
+		}
+	}
+
+	//return number of read bytes , -1 if data is bad
+	static int UnpackBytes( uint8 const* data , int size , uint8* dest , int destSize )
+	{
+		int pos = 0;
+		int n = 0;
+		while( n < destSize )
+		{
+			if ( pos >= size )
+				return -1;
+
+			int token = data[ pos++ ];
+			if ( token < 128 )
+			{
+				int num = token + 1;
+				if ( pos + num > size || n + num > destSize )
+					return -1;
+				std::memcpy( dest + n , data + pos , num );
+				pos += num;
+				n += num;
+			}
+			else
+			{
+				int num = token - 125;
+				if ( pos >= size || n + num > destSize )
+					return -1;
+				std::memset( dest + n , data[ pos++ ] , num );
+				n += num;
+			}
+		}
+		return pos;
+	}
+
+	RegionFile::RegionFile()
+	{
+		std::fill_n( mOffsetTable , (int)NumChunk , 0 );
+	}
+
+	RegionFile::~RegionFile()
+	{
+		close();
+	}
+
+	bool RegionFile::open( char const* path )
+	{
+		close();
+
+		std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary;
+		mFile.open( path , mode );
+		if ( !mFile.is_open() )
+		{
+			//create new file
+			mFile.clear();
+			mFile.open( path , mode | std::ios::trunc );
+			if ( !mFile.is_open() )
+				return false;
+		}
+
+		mFile.seekg( 0 , std::ios::end );
+		std::streamoff fileSize = mFile.tellg();
+		if ( fileSize < SectorSize )
+		{
+			std::fill_n( mOffsetTable , (int)NumChunk , 0 );
+			mFile.seekp( 0 );
+			mFile.write( (char const*)mOffsetTable , sizeof( mOffsetTable ) );
+			mFile.flush();
+			fileSize = SectorSize;
+		}
+		else
+		{
+			mFile.seekg( 0 );
+			mFile.read( (char*)mOffsetTable , sizeof( mOffsetTable ) );
+		}
+
+		if ( !mFile )
+		{
+			close();
+			return false;
+		}
+
+		mUsedSector.assign( int( ( fileSize + SectorSize - 1 ) / SectorSize ) , false );
+		mUsedSector[0] = true;
+		for( int i = 0 ; i < NumChunk ; ++i )
+		{
+			uint32 entry = mOffsetTable[i];
+			if ( entry )
+				markSector( entry >> 8 , entry & 0xff , true );
+		}
+		return true;
+	}
+
+	void RegionFile::close()
+	{
+		if ( mFile.is_open() )
+			mFile.close();
+		mFile.clear();
+		mUsedSector.clear();
+	}
+
+	bool RegionFile::readChunk( int lx , int ly , std::vector< uint8 >& data )
+	{
+		uint32 entry = mOffsetTable[ toIndex( lx , ly ) ];
+		if ( entry == 0 )
+			return false;
+
+		int sector = entry >> 8;
+		int count  = entry & 0xff;
+
+		uint32 size = 0;
+		mFile.seekg( std::streamoff( sector ) * SectorSize );
+		mFile.read( (char*)&size , sizeof( size ) );
+		if ( !mFile || size > uint32( count * SectorSize - sizeof( size ) ) )
+		{
+			mFile.clear();
+			return false;
+		}
+
+		data.resize( size );
+		if ( size )
+			mFile.read( (char*)&data[0] , size );
+		if ( !mFile )
+		{
+			mFile.clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool RegionFile::writeChunk( int lx , int ly , uint8 const* data , int size )
+	{
+		int idx = toIndex( lx , ly );
+		int numSector = ( size + (int)sizeof( uint32 ) + SectorSize - 1 ) / SectorSize;
+		if ( numSector > MaxSectorCount )
+			return false;
+
+		uint32 entry = mOffsetTable[ idx ];
+		int sector = entry >> 8;
+		int count  = entry & 0xff;
+
+		if ( entry == 0 || count < numSector )
+		{
+			if ( entry )
+				markSector( sector , count , false );
+			sector = allocSector( numSector );
+		}
+		else if ( count > numSector )
+		{
+			markSector( sector + numSector , count - numSector , false );
+		}
+		markSector( sector , numSector , true );
+
+		//write whole sectors , so the file grows without hole
+		std::vector< char > buffer( numSector * SectorSize , 0 );
+		uint32 dataSize = size;
+		std::memcpy( &buffer[0] , &dataSize , sizeof( dataSize ) );
+		if ( size )
+			std::memcpy( &buffer[ sizeof( dataSize ) ] , data , size );
+
+		mFile.seekp( std::streamoff( sector ) * SectorSize );
+		mFile.write( &buffer[0] , buffer.size() );
+
+		mOffsetTable[ idx ] = ( uint32( sector ) << 8 ) | uint32( numSector );
+		mFile.seekp( idx * sizeof( uint32 ) );
+		mFile.write( (char const*)&mOffsetTable[ idx ] , sizeof( uint32 ) );
+		mFile.flush();
+
+		if ( !mFile )
+		{
+			mFile.clear();
+			return false;
+		}
+		return true;
+	}
+
+	int RegionFile::allocSector( int num )
+	{
+		int runStart = -1;
+		int runLen = 0;
+		for( int i = 1 ; i < (int)mUsedSector.size() ; ++i )
+		{
+			if ( mUsedSector[i] )
+			{
+				runLen = 0;
+				continue;
+			}
+			if ( runLen == 0 )
+				runStart = i;
+			++runLen;
+			if ( runLen == num )
+				return runStart;
+		}
+		//free run at the end of file can be extended
+		return ( runLen > 0 ) ? runStart : (int)mUsedSector.size();
+	}
+
+	void RegionFile::markSector( int start , int num , bool beUsed )
+	{
+		if ( start + num > (int)mUsedSector.size() )
+			mUsedSector.resize( start + num , false );
+		for( int i = 0 ; i < num ; ++i )
+			mUsedSector[ start + i ] = beUsed;
+	}
+
+
+	ChunkStorage::ChunkStorage()
+	{
+
+	}
+
+	ChunkStorage::~ChunkStorage()
+	{
+		flush();
+	}
+
+	bool ChunkStorage::init( char const* dir )
+	{
+		Mutex::Locker locker( mMutex );
+		mDir = dir;
+		if ( !FileSystem::isExist( dir ) && !::CreateDirectoryA( dir , NULL ) )
+			return false;
+		return true;
+	}
+
+	void ChunkStorage::flush()
+	{
+		Mutex::Locker locker( mMutex );
+		for( RegionList::iterator iter = mRegionList.begin() ; iter != mRegionList.end() ; ++iter )
+			delete iter->file;
+		mRegionList.clear();
+	}
+
+	RegionFile* ChunkStorage::getRegion( int rx , int ry , bool beCreate )
+	{
+		for( RegionList::iterator iter = mRegionList.begin() ; iter != mRegionList.end() ; ++iter )
+		{
+			if ( iter->rx == rx && iter->ry == ry )
+			{
+				mRegionList.splice( mRegionList.begin() , mRegionList , iter );
+				return mRegionList.front().file;
+			}
+		}
+
+		char path[ 512 ];
+		::sprintf_s( path , sizeof( path ) , "%s/r.%d.%d.cbr" , mDir.c_str() , rx , ry );
+		if ( !beCreate && !FileSystem::isExist( path ) )
+			return NULL;
+
+		RegionFile* file = new RegionFile;
+		if ( !file->open( path ) )
+		{
+			delete file;
+			return NULL;
+		}
+
+		if ( (int)mRegionList.size() >= MaxOpenRegionNum )
+		{
+			delete mRegionList.back().file;
+			mRegionList.pop_back();
+		}
+
+		RegionEntry entry;
+		entry.rx   = rx;
+		entry.ry   = ry;
+		entry.file = file;
+		mRegionList.push_front( entry );
+		return file;
+	}
+
+	Chunk* ChunkStorage::loadChunk( ChunkPos const& pos )
+	{
+		Mutex::Locker locker( mMutex );
+
+		RegionFile* region = getRegion( pos.x >> RegionFile::RegionBit , pos.y >> RegionFile::RegionBit , false );
+		if ( !region || !region->haveChunk( pos.x , pos.y ) )
+			return NULL;
+
+		if ( !region->readChunk( pos.x , pos.y , mBuffer ) || mBuffer.empty() )
+			return NULL;
+
+		Chunk* chunk = new Chunk( pos );
+		if ( !unserializeChunk( *chunk , &mBuffer[0] , (int)mBuffer.size() ) )
+		{
+			delete chunk;
+			return NULL;
+		}
+		return chunk;
+	}
+
+	bool ChunkStorage::saveChunk( Chunk& chunk )
+	{
+		ChunkPos const& pos = chunk.getPos();
+
+		std::vector< uint8 > data;
+		serializeChunk( chunk , data );
+
+		Mutex::Locker locker( mMutex );
+		RegionFile* region = getRegion( pos.x >> RegionFile::RegionBit , pos.y >> RegionFile::RegionBit , true );
+		if ( !region )
+			return false;
+		return region->writeChunk( pos.x , pos.y , &data[0] , (int)data.size() );
+	}
+
+	//version 1 has no light
+	static uint8 const ChunkDataVersion = 2;
+
+	void ChunkStorage::serializeChunk( Chunk& chunk , std::vector< uint8 >& data )
+	{
+		data.clear();
+		data.push_back( ChunkDataVersion );
+
+		uint8 layerMask = 0;
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
+		{
+			if ( chunk.mLayer[n] )
+				layerMask |= BIT( n );
+		}
+		data.push_back( layerMask );
+
+		//layers are saved unpacked , so the format doesn't depend on the palette
+		uint8 buffer[ Chunk::LayerData::NumCell ];
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
+		{
+			Chunk::LayerData* layer = chunk.mLayer[n];
+			if ( !layer )
+				continue;
+			layer->getBlocks().unpack( buffer );
+			PackBytes( buffer , Chunk::LayerData::NumCell , data );
+			layer->getMetaData( buffer );
+			PackBytes( buffer , Chunk::LayerData::NumCell / 2 , data );
+			layer->getLightData( buffer );
+			PackBytes( buffer , Chunk::LayerData::NumCell , data );
+		}
+	}
+
+	bool ChunkStorage::unserializeChunk( Chunk& chunk , uint8 const* data , int size )
+	{
+		if ( size < 2 || data[0] < 1 || data[0] > ChunkDataVersion )
+			return false;
+
+		uint8 layerMask = data[1];
+		int pos = 2;
+		uint8 buffer[ Chunk::LayerData::NumCell ];
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
+		{
+			if ( !( layerMask & BIT( n ) ) )
+				continue;
+
+			Chunk::LayerData* layer = new Chunk::LayerData;
+			delete chunk.mLayer[n];
+			chunk.mLayer[n] = layer;
+
+			int len;
+			len = UnpackBytes( data + pos , size - pos , buffer , Chunk::LayerData::NumCell );
+			if ( len < 0 )
+				return false;
+			layer->getBlocks().load( buffer );
+			pos += len;
+			len = UnpackBytes( data + pos , size - pos , buffer , Chunk::LayerData::NumCell / 2 );
+			if ( len < 0 )
+				return false;
+			layer->setMetaData( buffer );
+			pos += len;
+			len = UnpackBytes( data + pos , size - pos , buffer , Chunk::LayerData::NumCell );
+			if ( len < 0 )
+				return false;
+			layer->setLightData( buffer );
+			pos += len;
+		}
+		if ( data[0] < 2 )
+			LightEngine::lightChunk( chunk );
+		return true;
+	}
+
+}//namespace Cube
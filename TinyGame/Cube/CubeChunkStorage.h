@@ -0,0 +1,87 @@
+#ifndef CubeChunkStorage_h__
+#define CubeChunkStorage_h__
+
+#include "CubeWorld.h"
+#include "Thread.h"
+
+#include <fstream>
+#include <vector>
+#include <list>
+#include <string>
+
+namespace Cube
+{
+	//  One file keeps 32 x 32 chunks.
+	//  Sector 0 is the offset table , an entry is ( first sector << 8 ) | sector count.
+	//  A chunk record is uint32 data size and the data , it is written back in
+	//  place if it fits , or else moved to the first free sectors.
+	class RegionFile
+	{
+	public:
+		static int const RegionBit  = 5;
+		static int const RegionSize = 1 << RegionBit;
+		static int const RegionMask = RegionSize - 1;
+		static int const NumChunk   = RegionSize * RegionSize;
+		static int const SectorSize = 4096;
+		static int const MaxSectorCount = 255;
+
+		RegionFile();
+		~RegionFile();
+
+		bool  open( char const* path );
+		void  close();
+
+		bool  haveChunk( int lx , int ly ) const { return mOffsetTable[ toIndex( lx , ly ) ] != 0; }
+		bool  readChunk( int lx , int ly , std::vector< uint8 >& data );
+		bool  writeChunk( int lx , int ly , uint8 const* data , int size );
+
+	private:
+		static int toIndex( int lx , int ly ){ return ( lx & RegionMask ) + RegionSize * ( ly & RegionMask ); }
+		int   allocSector( int num );
+		void  markSector( int start , int num , bool beUsed );
+
+		std::fstream        mFile;
+		uint32              mOffsetTable[ NumChunk ];
+		std::vector< bool > mUsedSector;
+	};
+
+	//  Save and load chunks in region files of a directory.
+	//  Chunk data is run-length packed ; functions are thread safe ,
+	//  file access is serialized by one lock.
+	class ChunkStorage
+	{
+	public:
+		ChunkStorage();
+		~ChunkStorage();
+
+		bool   init( char const* dir );
+		void   flush();
+
+		// return NULL if the chunk isn't saved
+		Chunk* loadChunk( ChunkPos const& pos );
+		bool   saveChunk( Chunk& chunk );
+
+		static void serializeChunk( Chunk& chunk , std::vector< uint8 >& data );
+		static bool unserializeChunk( Chunk& chunk , uint8 const* data , int size );
+
+	private:
+		static int const MaxOpenRegionNum = 8;
+
+		struct RegionEntry
+		{
+			int         rx , ry;
+			RegionFile* file;
+		};
+		RegionFile* getRegion( int rx , int ry , bool beCreate );
+
+		typedef std::list< RegionEntry > RegionList;
+		// most recently used first
+		RegionList           mRegionList;
+		std::string          mDir;
+		std::vector< uint8 > mBuffer;
+		Mutex                mMutex;
+	};
+
+}//namespace Cube
+
+#endif // CubeChunkStorage_h__
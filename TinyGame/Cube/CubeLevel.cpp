@@ -3,6 +3,8 @@
 
 #include "CubeBlock.h"
 #include "CubeWorld.h"
+#include "CubeTerrainGenerator.h"
+#include "CubeChunkStorage.h"
 
 namespace Cube
 {
@@ -15,11 +17,21 @@ namespace Cube
 	Level::Level()
 	{
 		mWorld = NULL;
+		mGenerator = new NoiseTerrainGenerator;
+		mStorage   = new ChunkStorage;
+		if ( !mStorage->init( "CubeWorld" ) )
+		{
+			delete mStorage;
+			mStorage = NULL;
+		}
 	}
 
 	Level::~Level()
 	{
+		//world saves modified chunks to storage
 		delete mWorld;
+		delete mStorage;
+		delete mGenerator;
 	}
 
 	void Level::setupWorld()
@@ -28,6 +40,8 @@ namespace Cube
 			delete mWorld;
 
 		mWorld = new World;
+		mWorld->getChunkProvider().setGenerator( *mGenerator );
+		mWorld->getChunkProvider().setStorage( mStorage );
 	}
 
 }//namespace Cube
\ No newline at end of file
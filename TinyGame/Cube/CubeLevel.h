@@ -5,6 +5,9 @@
 
 namespace Cube
 {
+	class NoiseTerrainGenerator;
+	class ChunkStorage;
+
 	class Level
 	{
 	public:
@@ -15,8 +18,11 @@ namespace Cube
 		void    setupWorld();
 
 		World&   getWorld(){ return *mWorld; }
+		NoiseTerrainGenerator& getGenerator(){ return *mGenerator; }
 	private:
 		World* mWorld;
+		NoiseTerrainGenerator* mGenerator;
+		ChunkStorage*          mStorage;
 	};
 
 }//namespace Cube
@@ -0,0 +1,510 @@
+#include "CubePCH.h"
+#include "CubeLightEngine.h"
+
+#include "CubeBlock.h"
+#include "CubeBlockType.h"
+#include "CubeRandom.h"
+
+#include <algorithm>
+
+namespace Cube
+{
+	//same order as FaceSide
+	static int const gDirOffset[6][3] =
+	{
+		{ 1 , 0 , 0 } , { -1 , 0 , 0 } ,
+		{ 0 , 1 , 0 } , { 0 , -1 , 0 } ,
+		{ 0 , 0 , 1 } , { 0 , 0 , -1 } ,
+	};
+
+	static int const MaxLightLevel = 15;
+
+	static int CalcSpreadLevel( int level , int opacity , bool beSkyDown )
+	{
+		if ( beSkyDown && level == MaxLightLevel && opacity == 0 )
+			return MaxLightLevel;
+		return level - std::max( 1 , opacity );
+	}
+
+	static int const ColumnSize = ChunkBlockMaxHeight;
+	static int const NumColumnCell = ChunkSize * ChunkSize * ColumnSize;
+
+	static int ToCellIndex( int x , int y , int z ){ return ( x * ChunkSize + y ) * ColumnSize + z; }
+
+	//flood fill in columns of size x size , channel is the bit shift of the light
+	static void SpreadChunkLight( uint8 const* ids , uint8* light , std::vector< int >& queue , int channel , bool beSky , int size = ChunkSize )
+	{
+		int const offset[6] = { size * ColumnSize , -size * ColumnSize , ColumnSize , -ColumnSize , 1 , -1 };
+
+		for( size_t head = 0 ; head < queue.size() ; ++head )
+		{
+			int idx = queue[ head ];
+			int level = ( light[ idx ] >> channel ) & 0xf;
+			if ( level <= 1 )
+				continue;
+
+			int z = idx % ColumnSize;
+			int y = ( idx / ColumnSize ) % size;
+			int x = idx / ( ColumnSize * size );
+			int const pos[3] = { x , y , z };
+			int const bound[3] = { size , size , ColumnSize };
+
+			for( int dir = 0 ; dir < 6 ; ++dir )
+			{
+				int axis = dir / 2;
+				int value = pos[ axis ] + gDirOffset[ dir ][ axis ];
+				if ( value < 0 || value >= bound[ axis ] )
+					continue;
+
+				int idxN = idx + offset[ dir ];
+				int opacity = Block::getLightOpacity( ids[ idxN ] );
+				if ( opacity >= MaxLightLevel )
+					continue;
+
+				int levelN = CalcSpreadLevel( level , opacity , beSky && dir == FACE_NZ );
+				if ( levelN <= ( ( light[ idxN ] >> channel ) & 0xf ) )
+					continue;
+
+				light[ idxN ] = uint8( ( light[ idxN ] & ~( 0xf << channel ) ) | ( levelN << channel ) );
+				queue.push_back( idxN );
+			}
+		}
+		queue.clear();
+	}
+
+	LightEngine::LightEngine( ChunkProvider& provider )
+		:mProvider( provider )
+		,mCacheChunk( NULL )
+		,mStitchChunk( NULL )
+		,mUpdateCount( 0 )
+	{
+
+	}
+
+	void LightEngine::lightChunk( Chunk& chunk )
+	{
+		std::vector< uint8 > ids( NumColumnCell , BLOCK_NULL );
+		std::vector< uint8 > light( NumColumnCell , 0 );
+		std::vector< int >   queue;
+
+		BlockId blockMap[ Chunk::LayerData::NumCell ];
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
+		{
+			Chunk::LayerData* layer = chunk.mLayer[ n ];
+			if ( !layer || layer->isAir() )
+				continue;
+			layer->getBlocks().unpack( blockMap );
+			for( int i = 0 ; i < ChunkSize ; ++i )
+			{
+				for( int j = 0 ; j < ChunkSize ; ++j )
+				{
+					BlockId const* src = blockMap + Chunk::LayerData::toIndex( i , j , 0 );
+					std::copy( src , src + Chunk::LayerSize , &ids[ ToCellIndex( i , j , n * Chunk::LayerSize ) ] );
+				}
+			}
+		}
+
+		//sky light : cells above the first blocking cell of a column are full
+		int height[ ChunkSize ][ ChunkSize ];
+		for( int i = 0 ; i < ChunkSize ; ++i )
+		{
+			for( int j = 0 ; j < ChunkSize ; ++j )
+			{
+				int idx = ToCellIndex( i , j , 0 );
+				int h = ColumnSize;
+				while( h > 0 && Block::getLightOpacity( ids[ idx + h - 1 ] ) == 0 )
+					--h;
+				height[i][j] = h;
+				std::fill( light.begin() + idx + h , light.begin() + idx + ColumnSize , Chunk::FullSkyLight );
+			}
+		}
+
+		//only cells next to a higher column or over a clear block can spread
+		for( int i = 0 ; i < ChunkSize ; ++i )
+		{
+			for( int j = 0 ; j < ChunkSize ; ++j )
+			{
+				int h = height[i][j];
+				int hMax = h + 1;
+				if ( i > 0 )             hMax = std::max( hMax , height[i-1][j] );
+				if ( i < ChunkSize - 1 ) hMax = std::max( hMax , height[i+1][j] );
+				if ( j > 0 )             hMax = std::max( hMax , height[i][j-1] );
+				if ( j < ChunkSize - 1 ) hMax = std::max( hMax , height[i][j+1] );
+				hMax = std::min( hMax , ColumnSize );
+
+				int idx = ToCellIndex( i , j , 0 );
+				for( int k = h ; k < hMax ; ++k )
+					queue.push_back( idx + k );
+			}
+		}
+		SpreadChunkLight( &ids[0] , &light[0] , queue , SkyChannel , true );
+
+		for( int idx = 0 ; idx < NumColumnCell ; ++idx )
+		{
+			int value = Block::getLightValue( ids[ idx ] );
+			if ( value )
+			{
+				light[ idx ] |= uint8( value );
+				queue.push_back( idx );
+			}
+		}
+		SpreadChunkLight( &ids[0] , &light[0] , queue , BlockChannel , false );
+
+		//write back , missing layers are only created if the default light is wrong
+		int top = chunk.getTopLayerIndex();
+		uint8 buffer[ Chunk::LayerData::NumCell ];
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
+		{
+			for( int i = 0 ; i < ChunkSize ; ++i )
+			{
+				for( int j = 0 ; j < ChunkSize ; ++j )
+				{
+					uint8 const* src = &light[ ToCellIndex( i , j , n * Chunk::LayerSize ) ];
+					std::copy( src , src + Chunk::LayerSize , buffer + Chunk::LayerData::toIndex( i , j , 0 ) );
+				}
+			}
+
+			Chunk::LayerData* layer = chunk.mLayer[ n ];
+			if ( !layer )
+			{
+				uint8 fill = ( n > top ) ? Chunk::FullSkyLight : 0;
+				if ( std::count( buffer , buffer + Chunk::LayerData::NumCell , fill ) == Chunk::LayerData::NumCell )
+					continue;
+				layer = chunk.createLayer( n );
+			}
+			layer->setLightData( buffer );
+		}
+	}
+
+	Chunk* LightEngine::lookupChunk( int bx , int by )
+	{
+		ChunkPos pos;
+		pos.setBlockPos( bx , by );
+		if ( mCacheChunk && mCacheChunk->getPos().x == pos.x && mCacheChunk->getPos().y == pos.y )
+			return mCacheChunk;
+
+		Chunk* chunk = mProvider.findChunk( pos );
+		if ( chunk )
+			mCacheChunk = chunk;
+		return chunk;
+	}
+
+	void LightEngine::setLight( Chunk& chunk , int bx , int by , int bz , uint8 light )
+	{
+		chunk.setLight( bx , by , bz , light );
+		//light is saved with the chunk , so a chunk changed by its neighbor is saved again.
+		//a new chunk is lit again when it is loaded , it is only saved after a block change
+		if ( &chunk != mStitchChunk )
+			chunk.markModified();
+	}
+
+	void LightEngine::pushNode( std::vector< LightNode >& queue , int bx , int by , int bz , int level )
+	{
+		LightNode node;
+		node.x = bx;
+		node.y = by;
+		node.z = bz;
+		node.level = uint8( level );
+		queue.push_back( node );
+	}
+
+	void LightEngine::propagateAdd( int channel )
+	{
+		for( size_t head = 0 ; head < mAddQueue.size() ; ++head )
+		{
+			LightNode const node = mAddQueue[ head ];
+			Chunk* chunk = lookupChunk( node.x , node.y );
+			if ( !chunk )
+				continue;
+
+			int level = getLevel( chunk->getLight( node.x , node.y , node.z ) , channel );
+			if ( level <= 1 )
+				continue;
+
+			for( int dir = 0 ; dir < 6 ; ++dir )
+			{
+				int nx = node.x + gDirOffset[ dir ][0];
+				int ny = node.y + gDirOffset[ dir ][1];
+				int nz = node.z + gDirOffset[ dir ][2];
+				if ( nz < 0 || nz >= ChunkBlockMaxHeight )
+					continue;
+
+				Chunk* chunkN = lookupChunk( nx , ny );
+				if ( !chunkN )
+					continue;
+
+				int opacity = Block::getLightOpacity( chunkN->getBlockId( nx , ny , nz ) );
+				if ( opacity >= MaxLightLevel )
+					continue;
+
+				int   levelN = CalcSpreadLevel( level , opacity , channel == SkyChannel && dir == FACE_NZ );
+				uint8 light  = chunkN->getLight( nx , ny , nz );
+				if ( levelN <= getLevel( light , channel ) )
+					continue;
+
+				setLight( *chunkN , nx , ny , nz , setLevel( light , channel , levelN ) );
+				pushNode( mAddQueue , nx , ny , nz , levelN );
+			}
+		}
+		mUpdateCount += (int)mAddQueue.size();
+		mAddQueue.clear();
+	}
+
+	void LightEngine::propagateRemove( int channel )
+	{
+		for( size_t head = 0 ; head < mRemoveQueue.size() ; ++head )
+		{
+			LightNode const node = mRemoveQueue[ head ];
+
+			for( int dir = 0 ; dir < 6 ; ++dir )
+			{
+				int nx = node.x + gDirOffset[ dir ][0];
+				int ny = node.y + gDirOffset[ dir ][1];
+				int nz = node.z + gDirOffset[ dir ][2];
+				if ( nz < 0 || nz >= ChunkBlockMaxHeight )
+					continue;
+
+				Chunk* chunkN = lookupChunk( nx , ny );
+				if ( !chunkN )
+					continue;
+
+				uint8 light  = chunkN->getLight( nx , ny , nz );
+				int   levelN = getLevel( light , channel );
+				if ( levelN == 0 )
+					continue;
+
+				//the light of the cell may come from the removed cell
+				bool beSkyDown = ( channel == SkyChannel && dir == FACE_NZ && node.level == MaxLightLevel );
+				if ( levelN < node.level || ( beSkyDown && levelN == MaxLightLevel ) )
+				{
+					setLight( *chunkN , nx , ny , nz , setLevel( light , channel , 0 ) );
+					pushNode( mRemoveQueue , nx , ny , nz , levelN );
+
+					if ( channel == BlockChannel )
+					{
+						int value = Block::getLightValue( chunkN->getBlockId( nx , ny , nz ) );
+						if ( value )
+						{
+							setLight( *chunkN , nx , ny , nz , setLevel( light , channel , value ) );
+							pushNode( mAddQueue , nx , ny , nz , value );
+						}
+					}
+				}
+				else
+				{
+					//other light source , fill the removed cells again from it
+					pushNode( mAddQueue , nx , ny , nz , levelN );
+				}
+			}
+		}
+		mUpdateCount += (int)mRemoveQueue.size();
+		mRemoveQueue.clear();
+	}
+
+	void LightEngine::onBlockChanged( int bx , int by , int bz , BlockId oldId , BlockId newId )
+	{
+		mCacheChunk = NULL;
+		mUpdateCount = 0;
+
+		Chunk* chunk = lookupChunk( bx , by );
+		if ( !chunk || bz < 0 || bz >= ChunkBlockMaxHeight )
+			return;
+
+		int opacity = Block::getLightOpacity( newId );
+		bool beDarker = opacity > Block::getLightOpacity( oldId );
+
+		int const channels[2] = { SkyChannel , BlockChannel };
+		for( int i = 0 ; i < 2 ; ++i )
+		{
+			int channel = channels[i];
+
+			int target;
+			if ( channel == BlockChannel )
+				target = Block::getLightValue( newId );
+			else
+				target = ( bz == ChunkBlockMaxHeight - 1 && opacity == 0 ) ? MaxLightLevel : 0;
+
+			//remove the old light if the cell can be darker now
+			uint8 light = chunk->getLight( bx , by , bz );
+			int   level = getLevel( light , channel );
+			if ( level > 0 && ( beDarker || target < level ) )
+			{
+				chunk->setLight( bx , by , bz , setLevel( light , channel , 0 ) );
+				pushNode( mRemoveQueue , bx , by , bz , level );
+				propagateRemove( channel );
+				level = 0;
+			}
+
+			if ( target > level )
+			{
+				light = chunk->getLight( bx , by , bz );
+				chunk->setLight( bx , by , bz , setLevel( light , channel , target ) );
+				pushNode( mAddQueue , bx , by , bz , target );
+			}
+
+			//neighbor light can go into the cell
+			if ( opacity < MaxLightLevel )
+			{
+				for( int dir = 0 ; dir < 6 ; ++dir )
+				{
+					int nz = bz + gDirOffset[ dir ][2];
+					if ( nz < 0 || nz >= ChunkBlockMaxHeight )
+						continue;
+					pushNode( mAddQueue , bx + gDirOffset[ dir ][0] , by + gDirOffset[ dir ][1] , nz , 0 );
+				}
+			}
+			propagateAdd( channel );
+		}
+	}
+
+	void LightEngine::pushBorder( Chunk& chunk , Chunk& other , int channel , int zMax )
+	{
+		ChunkPos const& pos = chunk.getPos();
+		ChunkPos const& posOther = other.getPos();
+
+		//cell of chunk on the border and the offset to the other cell
+		int dx = posOther.x - pos.x;
+		int dy = posOther.y - pos.y;
+		int bx = pos.x * ChunkSize + ( ( dx > 0 ) ? ChunkSize - 1 : 0 );
+		int by = pos.y * ChunkSize + ( ( dy > 0 ) ? ChunkSize - 1 : 0 );
+		int sx = ( dx == 0 ) ? 1 : 0;
+		int sy = ( dy == 0 ) ? 1 : 0;
+
+		for( int i = 0 ; i < ChunkSize ; ++i )
+		{
+			int x = bx + i * sx;
+			int y = by + i * sy;
+			for( int z = 0 ; z < zMax ; ++z )
+			{
+				int level      = getLevel( chunk.getLight( x , y , z ) , channel );
+				int levelOther = getLevel( other.getLight( x + dx , y + dy , z ) , channel );
+				if ( level > levelOther + 1 )
+					pushNode( mAddQueue , x , y , z , level );
+				else if ( levelOther > level + 1 )
+					pushNode( mAddQueue , x + dx , y + dy , z , levelOther );
+			}
+		}
+	}
+
+	void LightEngine::stitchChunk( Chunk& chunk )
+	{
+		mCacheChunk = NULL;
+		mStitchChunk = &chunk;
+		mUpdateCount = 0;
+
+		ChunkPos const& pos = chunk.getPos();
+		int const neighborOffset[4][2] = { { 1 , 0 } , { -1 , 0 } , { 0 , 1 } , { 0 , -1 } };
+
+		Chunk* neighbors[4];
+		for( int i = 0 ; i < 4 ; ++i )
+		{
+			ChunkPos posN;
+			posN.x = pos.x + neighborOffset[i][0];
+			posN.y = pos.y + neighborOffset[i][1];
+			neighbors[i] = mProvider.findChunk( posN );
+		}
+
+		int const channels[2] = { SkyChannel , BlockChannel };
+		for( int c = 0 ; c < 2 ; ++c )
+		{
+			for( int i = 0 ; i < 4 ; ++i )
+			{
+				Chunk* other = neighbors[i];
+				if ( !other )
+					continue;
+
+				//cells over the top of both chunks are full sky light on both sides ,
+				//one more layer for block light going up
+				int top = std::max( chunk.getTopLayerIndex() , other->getTopLayerIndex() );
+				int zMax = std::min( ( top + 2 ) * int( Chunk::LayerSize ) , int( ChunkBlockMaxHeight ) );
+				pushBorder( chunk , *other , channels[c] , zMax );
+			}
+			propagateAdd( channels[c] );
+		}
+		mStitchChunk = NULL;
+	}
+
+	bool LightEngine::checkIncrementalLight( TerrainGenerator& generator , int numEdit )
+	{
+		World world;
+		world.getChunkProvider().setGenerator( generator );
+
+		int const AreaChunkNum = 3;
+		int const AreaSize = AreaChunkNum * ChunkSize;
+		int const AreaOrg  = -int( ChunkSize );
+		for( int i = 0 ; i < AreaChunkNum ; ++i )
+		{
+			for( int j = 0 ; j < AreaChunkNum ; ++j )
+				world.getChunk( AreaOrg + i * ChunkSize , AreaOrg + j * ChunkSize );
+		}
+
+		//edit near the surface of the center chunk and one cell over its border
+		Random rand;
+		rand.setSeed( 1234 );
+		BlockId const editIds[] = { BLOCK_NULL , BLOCK_DIRT , BLOCK_TORCH };
+		for( int n = 0 ; n < numEdit ; ++n )
+		{
+			int bx = int( rand.getInt( ChunkSize + 2 ) ) - 1;
+			int by = int( rand.getInt( ChunkSize + 2 ) ) - 1;
+			int top = ChunkBlockMaxHeight - 1;
+			while( top > 0 && world.getBlockId( bx , by , top ) == BLOCK_NULL )
+				--top;
+			int bz = std::max( 1 , top + int( rand.getInt( 8 ) ) - 4 );
+			world.setBlockNotify( bx , by , bz , editIds[ rand.getInt( 3 ) ] );
+		}
+
+		//brute force : flood fill the whole area from every source cell
+		int const numCell = AreaSize * AreaSize * ColumnSize;
+		std::vector< uint8 > ids( numCell );
+		std::vector< uint8 > light( numCell , 0 );
+		std::vector< int >   queue;
+		for( int i = 0 ; i < AreaSize ; ++i )
+		{
+			for( int j = 0 ; j < AreaSize ; ++j )
+			{
+				int idx = ( i * AreaSize + j ) * ColumnSize;
+				for( int k = 0 ; k < ColumnSize ; ++k )
+					ids[ idx + k ] = world.getBlockId( AreaOrg + i , AreaOrg + j , k );
+
+				int h = ColumnSize;
+				while( h > 0 && Block::getLightOpacity( ids[ idx + h - 1 ] ) == 0 )
+					--h;
+				for( int k = h ; k < ColumnSize ; ++k )
+				{
+					light[ idx + k ] = Chunk::FullSkyLight;
+					queue.push_back( idx + k );
+				}
+			}
+		}
+		SpreadChunkLight( &ids[0] , &light[0] , queue , SkyChannel , true , AreaSize );
+
+		for( int idx = 0 ; idx < numCell ; ++idx )
+		{
+			int value = Block::getLightValue( ids[ idx ] );
+			if ( value )
+			{
+				light[ idx ] |= uint8( value );
+				queue.push_back( idx );
+			}
+		}
+		SpreadChunkLight( &ids[0] , &light[0] , queue , BlockChannel , false , AreaSize );
+
+		for( int i = 0 ; i < AreaSize ; ++i )
+		{
+			for( int j = 0 ; j < AreaSize ; ++j )
+			{
+				int bx = AreaOrg + i;
+				int by = AreaOrg + j;
+				Chunk* chunk = world.getChunk( bx , by );
+				int idx = ( i * AreaSize + j ) * ColumnSize;
+				for( int k = 0 ; k < ColumnSize ; ++k )
+				{
+					if ( chunk->getLight( bx , by , k ) != light[ idx + k ] )
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+}//namespace Cube
@@ -0,0 +1,68 @@
+#ifndef CubeLightEngine_h__
+#define CubeLightEngine_h__
+
+#include "CubeWorld.h"
+
+#include <vector>
+
+namespace Cube
+{
+	class TerrainGenerator;
+
+	//  Sky light and block light in [ 0 , 15 ] , spread by breadth first fill.
+	//  lightChunk lights a new chunk alone ( used on loader threads ) ,
+	//  stitchChunk spreads light across the borders when the chunk is added
+	//  to the world , and onBlockChanged only updates the cells near an edited
+	//  block with a remove queue and an add queue.
+	//  Sky light 15 goes down through clear blocks without falloff.
+	class LightEngine
+	{
+	public:
+		LightEngine( ChunkProvider& provider );
+
+		static void lightChunk( Chunk& chunk );
+		void   stitchChunk( Chunk& chunk );
+		void   onBlockChanged( int bx , int by , int bz , BlockId oldId , BlockId newId );
+
+		//cells visited by the last update
+		int    getLastUpdateCount() const { return mUpdateCount; }
+
+		//relight 3 x 3 new chunks by brute force after numEdit random edits around
+		//the center one , return true if the incremental light is the same
+		static bool checkIncrementalLight( TerrainGenerator& generator , int numEdit );
+
+	private:
+		enum Channel
+		{
+			SkyChannel   = 4 ,
+			BlockChannel = 0 ,
+		};
+
+		struct LightNode
+		{
+			int   x , y , z;
+			uint8 level;
+		};
+
+		static int   getLevel( uint8 light , int channel ){ return ( light >> channel ) & 0xf; }
+		static uint8 setLevel( uint8 light , int channel , int level ){ return uint8( ( light & ~( 0xf << channel ) ) | ( level << channel ) ); }
+
+		Chunk* lookupChunk( int bx , int by );
+		void   setLight( Chunk& chunk , int bx , int by , int bz , uint8 light );
+		void   pushNode( std::vector< LightNode >& queue , int bx , int by , int bz , int level );
+		void   pushBorder( Chunk& chunk , Chunk& other , int channel , int zMax );
+		void   propagateAdd( int channel );
+		void   propagateRemove( int channel );
+
+		ChunkProvider&           mProvider;
+		Chunk*                   mCacheChunk;
+		//chunk being stitched , others changed by it are marked modified
+		Chunk*                   mStitchChunk;
+		std::vector< LightNode > mAddQueue;
+		std::vector< LightNode > mRemoveQueue;
+		int                      mUpdateCount;
+	};
+
+}//namespace Cube
+
+#endif // CubeLightEngine_h__
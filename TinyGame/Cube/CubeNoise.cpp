@@ -0,0 +1,372 @@
+#include "CubePCH.h"
+#include "CubeNoise.h"
+
+#if CUBE_NOISE_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Cube
+{
+	static float const gGradX[16] = { 1,-1, 1,-1, 1,-1, 1,-1, 0, 0, 0, 0, 1, 0,-1, 0 };
+	static float const gGradY[16] = { 1, 1,-1,-1, 0, 0, 0, 0, 1,-1, 1,-1, 1,-1, 1,-1 };
+	static float const gGradZ[16] = { 0, 0, 0, 0, 1, 1,-1,-1, 1, 1,-1,-1, 0, 1, 0,-1 };
+
+	//gradient of 2D noise : first 8 directions of the table on xy plane
+	static float const gGrad2X[8] = { 1,-1, 1,-1, 1,-1, 0, 0 };
+	static float const gGrad2Y[8] = { 1, 1,-1,-1, 0, 0, 1,-1 };
+
+	PerlinNoise::PerlinNoise()
+	{
+		for( int i = 0 ; i < 256 ; ++i )
+		{
+			mPerm[i] = uint8( i );
+			mPerm[ i + 256 ] = uint8( i );
+		}
+	}
+
+	void PerlinNoise::init( Random& rand )
+	{
+		for( int i = 0 ; i < 256 ; ++i )
+			mPerm[i] = uint8( i );
+		for( int i = 255 ; i > 0 ; --i )
+		{
+			int idx = rand.getInt( i + 1 );
+			std::swap( mPerm[i] , mPerm[ idx ] );
+		}
+		for( int i = 0 ; i < 256 ; ++i )
+			mPerm[ i + 256 ] = mPerm[i];
+	}
+
+	float PerlinNoise::getValue( float x , float y ) const
+	{
+		float vx[4] = { x , x , x , x };
+		float vy[4] = { y , y , y , y };
+		float out[4];
+		getValue4( vx , vy , out );
+		return out[0];
+	}
+
+	float PerlinNoise::getValue( float x , float y , float z ) const
+	{
+		float vx[4] = { x , x , x , x };
+		float vy[4] = { y , y , y , y };
+		float vz[4] = { z , z , z , z };
+		float out[4];
+		getValue4( vx , vy , vz , out );
+		return out[0];
+	}
+
+#if CUBE_NOISE_USE_SSE
+
+	static inline __m128 Floor4( __m128 v , int outInt[4] )
+	{
+		__m128i vi   = _mm_cvttps_epi32( v );
+		__m128  vf   = _mm_cvtepi32_ps( vi );
+		//truncate goes up for negative value
+		__m128  mask = _mm_cmpgt_ps( vf , v );
+		_mm_storeu_si128( (__m128i*)outInt , _mm_add_epi32( vi , _mm_castps_si128( mask ) ) );
+		return _mm_sub_ps( vf , _mm_and_ps( mask , _mm_set1_ps( 1.0f ) ) );
+	}
+
+	static inline __m128 Fade4( __m128 t )
+	{
+		// t * t * t * ( t * ( t * 6 - 15 ) + 10 )
+		__m128 p = _mm_add_ps( _mm_mul_ps( t , _mm_sub_ps( _mm_mul_ps( t , _mm_set1_ps( 6.0f ) ) , _mm_set1_ps( 15.0f ) ) ) , _mm_set1_ps( 10.0f ) );
+		return _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( t , t ) , t ) , p );
+	}
+
+	static inline __m128 Lerp4( __m128 t , __m128 a , __m128 b )
+	{
+		return _mm_add_ps( a , _mm_mul_ps( t , _mm_sub_ps( b , a ) ) );
+	}
+
+	void PerlinNoise::getValue4( float const x[4] , float const y[4] , float out[4] ) const
+	{
+		int xi[4] , yi[4];
+		__m128 vx = _mm_loadu_ps( x );
+		__m128 vy = _mm_loadu_ps( y );
+		vx = _mm_sub_ps( vx , Floor4( vx , xi ) );
+		vy = _mm_sub_ps( vy , Floor4( vy , yi ) );
+
+		//gradients of four corners ( 00 , 10 , 01 , 11 )
+		float gx[4][4] , gy[4][4];
+		for( int n = 0 ; n < 4 ; ++n )
+		{
+			int X = xi[n] & 255;
+			int Y = yi[n] & 255;
+			int A = mPerm[ X ] + Y;
+			int B = mPerm[ X + 1 ] + Y;
+			int h[4] = { mPerm[ A ] & 7 , mPerm[ B ] & 7 , mPerm[ A + 1 ] & 7 , mPerm[ B + 1 ] & 7 };
+			for( int c = 0 ; c < 4 ; ++c )
+			{
+				gx[c][n] = gGrad2X[ h[c] ];
+				gy[c][n] = gGrad2Y[ h[c] ];
+			}
+		}
+
+		__m128 one = _mm_set1_ps( 1.0f );
+		__m128 vx1 = _mm_sub_ps( vx , one );
+		__m128 vy1 = _mm_sub_ps( vy , one );
+
+		__m128 d00 = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( gx[0] ) , vx  ) , _mm_mul_ps( _mm_loadu_ps( gy[0] ) , vy  ) );
+		__m128 d10 = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( gx[1] ) , vx1 ) , _mm_mul_ps( _mm_loadu_ps( gy[1] ) , vy  ) );
+		__m128 d01 = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( gx[2] ) , vx  ) , _mm_mul_ps( _mm_loadu_ps( gy[2] ) , vy1 ) );
+		__m128 d11 = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( gx[3] ) , vx1 ) , _mm_mul_ps( _mm_loadu_ps( gy[3] ) , vy1 ) );
+
+		__m128 u = Fade4( vx );
+		__m128 v = Fade4( vy );
+		_mm_storeu_ps( out , Lerp4( v , Lerp4( u , d00 , d10 ) , Lerp4( u , d01 , d11 ) ) );
+	}
+
+	void PerlinNoise::getValue4( float const x[4] , float const y[4] , float const z[4] , float out[4] ) const
+	{
+		int xi[4] , yi[4] , zi[4];
+		__m128 vx = _mm_loadu_ps( x );
+		__m128 vy = _mm_loadu_ps( y );
+		__m128 vz = _mm_loadu_ps( z );
+		vx = _mm_sub_ps( vx , Floor4( vx , xi ) );
+		vy = _mm_sub_ps( vy , Floor4( vy , yi ) );
+		vz = _mm_sub_ps( vz , Floor4( vz , zi ) );
+
+		//corner c : bit 0 = x , bit 1 = y , bit 2 = z
+		float gx[8][4] , gy[8][4] , gz[8][4];
+		for( int n = 0 ; n < 4 ; ++n )
+		{
+			int X = xi[n] & 255;
+			int Y = yi[n] & 255;
+			int Z = zi[n] & 255;
+			int A  = mPerm[ X ] + Y;
+			int B  = mPerm[ X + 1 ] + Y;
+			int AA = mPerm[ A ] + Z;
+			int BA = mPerm[ B ] + Z;
+			int AB = mPerm[ A + 1 ] + Z;
+			int BB = mPerm[ B + 1 ] + Z;
+			int h[8] =
+			{
+				mPerm[ AA ] & 15 , mPerm[ BA ] & 15 , mPerm[ AB ] & 15 , mPerm[ BB ] & 15 ,
+				mPerm[ AA + 1 ] & 15 , mPerm[ BA + 1 ] & 15 , mPerm[ AB + 1 ] & 15 , mPerm[ BB + 1 ] & 15 ,
+			};
+			for( int c = 0 ; c < 8 ; ++c )
+			{
+				gx[c][n] = gGradX[ h[c] ];
+				gy[c][n] = gGradY[ h[c] ];
+				gz[c][n] = gGradZ[ h[c] ];
+			}
+		}
+
+		__m128 one = _mm_set1_ps( 1.0f );
+		__m128 px[2] = { vx , _mm_sub_ps( vx , one ) };
+		__m128 py[2] = { vy , _mm_sub_ps( vy , one ) };
+		__m128 pz[2] = { vz , _mm_sub_ps( vz , one ) };
+
+		__m128 d[8];
+		for( int c = 0 ; c < 8 ; ++c )
+		{
+			__m128 dxy = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( gx[c] ) , px[ c & 1 ] ) , _mm_mul_ps( _mm_loadu_ps( gy[c] ) , py[ ( c >> 1 ) & 1 ] ) );
+			d[c] = _mm_add_ps( dxy , _mm_mul_ps( _mm_loadu_ps( gz[c] ) , pz[ c >> 2 ] ) );
+		}
+
+		__m128 u = Fade4( vx );
+		__m128 v = Fade4( vy );
+		__m128 w = Fade4( vz );
+		__m128 z0 = Lerp4( v , Lerp4( u , d[0] , d[1] ) , Lerp4( u , d[2] , d[3] ) );
+		__m128 z1 = Lerp4( v , Lerp4( u , d[4] , d[5] ) , Lerp4( u , d[6] , d[7] ) );
+		_mm_storeu_ps( out , Lerp4( w , z0 , z1 ) );
+	}
+
+#else //CUBE_NOISE_USE_SSE
+
+	static inline float Fade( float t ){ return ( ( t * t ) * t ) * ( t * ( t * 6.0f - 15.0f ) + 10.0f ); }
+	static inline float Lerp( float t , float a , float b ){ return a + t * ( b - a ); }
+
+	void PerlinNoise::getValue4( float const x[4] , float const y[4] , float out[4] ) const
+	{
+		for( int n = 0 ; n < 4 ; ++n )
+		{
+			float fx = ::floorf( x[n] );
+			float fy = ::floorf( y[n] );
+			int X = int( fx ) & 255;
+			int Y = int( fy ) & 255;
+			float px = x[n] - fx;
+			float py = y[n] - fy;
+
+			int A = mPerm[ X ] + Y;
+			int B = mPerm[ X + 1 ] + Y;
+			int h00 = mPerm[ A ] & 7 , h10 = mPerm[ B ] & 7 , h01 = mPerm[ A + 1 ] & 7 , h11 = mPerm[ B + 1 ] & 7;
+
+			float d00 = gGrad2X[ h00 ] * px + gGrad2Y[ h00 ] * py;
+			float d10 = gGrad2X[ h10 ] * ( px - 1.0f ) + gGrad2Y[ h10 ] * py;
+			float d01 = gGrad2X[ h01 ] * px + gGrad2Y[ h01 ] * ( py - 1.0f );
+			float d11 = gGrad2X[ h11 ] * ( px - 1.0f ) + gGrad2Y[ h11 ] * ( py - 1.0f );
+
+			float u = Fade( px );
+			float v = Fade( py );
+			out[n] = Lerp( v , Lerp( u , d00 , d10 ) , Lerp( u , d01 , d11 ) );
+		}
+	}
+
+	void PerlinNoise::getValue4( float const x[4] , float const y[4] , float const z[4] , float out[4] ) const
+	{
+		for( int n = 0 ; n < 4 ; ++n )
+		{
+			float fx = ::floorf( x[n] );
+			float fy = ::floorf( y[n] );
+			float fz = ::floorf( z[n] );
+			int X = int( fx ) & 255;
+			int Y = int( fy ) & 255;
+			int Z = int( fz ) & 255;
+			float p[2][3] =
+			{
+				{ x[n] - fx , y[n] - fy , z[n] - fz } ,
+				{ x[n] - fx - 1.0f , y[n] - fy - 1.0f , z[n] - fz - 1.0f } ,
+			};
+
+			int A  = mPerm[ X ] + Y;
+			int B  = mPerm[ X + 1 ] + Y;
+			int AA = mPerm[ A ] + Z;
+			int BA = mPerm[ B ] + Z;
+			int AB = mPerm[ A + 1 ] + Z;
+			int BB = mPerm[ B + 1 ] + Z;
+			int h[8] =
+			{
+				mPerm[ AA ] & 15 , mPerm[ BA ] & 15 , mPerm[ AB ] & 15 , mPerm[ BB ] & 15 ,
+				mPerm[ AA + 1 ] & 15 , mPerm[ BA + 1 ] & 15 , mPerm[ AB + 1 ] & 15 , mPerm[ BB + 1 ] & 15 ,
+			};
+
+			float d[8];
+			for( int c = 0 ; c < 8 ; ++c )
+			{
+				d[c] = gGradX[ h[c] ] * p[ c & 1 ][0] + gGradY[ h[c] ] * p[ ( c >> 1 ) & 1 ][1] + gGradZ[ h[c] ] * p[ c >> 2 ][2];
+			}
+
+			float u = Fade( p[0][0] );
+			float v = Fade( p[0][1] );
+			float w = Fade( p[0][2] );
+			float z0 = Lerp( v , Lerp( u , d[0] , d[1] ) , Lerp( u , d[2] , d[3] ) );
+			float z1 = Lerp( v , Lerp( u , d[4] , d[5] ) , Lerp( u , d[6] , d[7] ) );
+			out[n] = Lerp( w , z0 , z1 );
+		}
+	}
+
+#endif //CUBE_NOISE_USE_SSE
+
+
+	OctaveNoise::OctaveNoise()
+	{
+		mNumOctave = 0;
+	}
+
+	void OctaveNoise::init( Random& rand , int numOctave , float frequency , float persistence )
+	{
+		assert( 0 < numOctave && numOctave <= MaxOctaveNum );
+		mNumOctave = numOctave;
+
+		float totalAmp = 0;
+		float amp  = 1.0f;
+		float freq = frequency;
+		for( int i = 0 ; i < mNumOctave ; ++i )
+		{
+			mNoise[i].init( rand );
+			mFrequency[i] = freq;
+			mAmplitude[i] = amp;
+			totalAmp += amp;
+			amp  *= persistence;
+			freq *= 2.0f;
+		}
+		for( int i = 0 ; i < mNumOctave ; ++i )
+			mAmplitude[i] /= totalAmp;
+	}
+
+	float OctaveNoise::getValue( float x , float y ) const
+	{
+		float vx[4] = { x , x , x , x };
+		float vy[4] = { y , y , y , y };
+		float out[4];
+		getValue4( vx , vy , out );
+		return out[0];
+	}
+
+	float OctaveNoise::getValue( float x , float y , float z ) const
+	{
+		float vx[4] = { x , x , x , x };
+		float vy[4] = { y , y , y , y };
+		float vz[4] = { z , z , z , z };
+		float out[4];
+		getValue4( vx , vy , vz , out );
+		return out[0];
+	}
+
+#if CUBE_NOISE_USE_SSE
+
+	void OctaveNoise::getValue4( float const x[4] , float const y[4] , float out[4] ) const
+	{
+		__m128 vx  = _mm_loadu_ps( x );
+		__m128 vy  = _mm_loadu_ps( y );
+		__m128 sum = _mm_setzero_ps();
+		for( int i = 0 ; i < mNumOctave ; ++i )
+		{
+			__m128 f = _mm_set1_ps( mFrequency[i] );
+			float px[4] , py[4] , value[4];
+			_mm_storeu_ps( px , _mm_mul_ps( vx , f ) );
+			_mm_storeu_ps( py , _mm_mul_ps( vy , f ) );
+			mNoise[i].getValue4( px , py , value );
+			sum = _mm_add_ps( sum , _mm_mul_ps( _mm_set1_ps( mAmplitude[i] ) , _mm_loadu_ps( value ) ) );
+		}
+		_mm_storeu_ps( out , sum );
+	}
+
+	void OctaveNoise::getValue4( float const x[4] , float const y[4] , float const z[4] , float out[4] ) const
+	{
+		__m128 vx  = _mm_loadu_ps( x );
+		__m128 vy  = _mm_loadu_ps( y );
+		__m128 vz  = _mm_loadu_ps( z );
+		__m128 sum = _mm_setzero_ps();
+		for( int i = 0 ; i < mNumOctave ; ++i )
+		{
+			__m128 f = _mm_set1_ps( mFrequency[i] );
+			float px[4] , py[4] , pz[4] , value[4];
+			_mm_storeu_ps( px , _mm_mul_ps( vx , f ) );
+			_mm_storeu_ps( py , _mm_mul_ps( vy , f ) );
+			_mm_storeu_ps( pz , _mm_mul_ps( vz , f ) );
+			mNoise[i].getValue4( px , py , pz , value );
+			sum = _mm_add_ps( sum , _mm_mul_ps( _mm_set1_ps( mAmplitude[i] ) , _mm_loadu_ps( value ) ) );
+		}
+		_mm_storeu_ps( out , sum );
+	}
+
+#else //CUBE_NOISE_USE_SSE
+
+	void OctaveNoise::getValue4( float const x[4] , float const y[4] , float out[4] ) const
+	{
+		out[0] = out[1] = out[2] = out[3] = 0;
+		for( int i = 0 ; i < mNumOctave ; ++i )
+		{
+			float f = mFrequency[i];
+			float px[4] = { x[0] * f , x[1] * f , x[2] * f , x[3] * f };
+			float py[4] = { y[0] * f , y[1] * f , y[2] * f , y[3] * f };
+			float value[4];
+			mNoise[i].getValue4( px , py , value );
+			for( int n = 0 ; n < 4 ; ++n )
+				out[n] += mAmplitude[i] * value[n];
+		}
+	}
+
+	void OctaveNoise::getValue4( float const x[4] , float const y[4] , float const z[4] , float out[4] ) const
+	{
+		out[0] = out[1] = out[2] = out[3] = 0;
+		for( int i = 0 ; i < mNumOctave ; ++i )
+		{
+			float f = mFrequency[i];
+			float px[4] = { x[0] * f , x[1] * f , x[2] * f , x[3] * f };
+			float py[4] = { y[0] * f , y[1] * f , y[2] * f , y[3] * f };
+			float pz[4] = { z[0] * f , z[1] * f , z[2] * f , z[3] * f };
+			float value[4];
+			mNoise[i].getValue4( px , py , pz , value );
+			for( int n = 0 ; n < 4 ; ++n )
+				out[n] += mAmplitude[i] * value[n];
+		}
+	}
+
+#endif //CUBE_NOISE_USE_SSE
+
+}//namespace Cube
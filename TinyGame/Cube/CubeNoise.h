@@ -0,0 +1,60 @@
+#ifndef CubeNoise_h__
+#define CubeNoise_h__
+
+#include "CubeBase.h"
+#include "CubeRandom.h"
+
+#if defined( _MSC_VER ) || defined( __SSE2__ )
+#define CUBE_NOISE_USE_SSE 1
+#else
+#define CUBE_NOISE_USE_SSE 0
+#endif
+
+namespace Cube
+{
+	//  Improved Perlin noise , the permutation is made from a Random seed.
+	//  Values are evaluated four at a time ( SSE lanes ) ; the single value
+	//  functions use the same code with one lane , so a build always gives
+	//  the same terrain for the same seed.
+	class PerlinNoise
+	{
+	public:
+		PerlinNoise();
+
+		void  init( Random& rand );
+
+		float getValue( float x , float y ) const;
+		float getValue( float x , float y , float z ) const;
+		void  getValue4( float const x[4] , float const y[4] , float out[4] ) const;
+		void  getValue4( float const x[4] , float const y[4] , float const z[4] , float out[4] ) const;
+
+	private:
+		uint8 mPerm[ 512 ];
+	};
+
+	//  Sum of octaves , each octave has its own permutation.
+	//  Result is about in [ -1 , 1 ].
+	class OctaveNoise
+	{
+	public:
+		static int const MaxOctaveNum = 8;
+
+		OctaveNoise();
+
+		void  init( Random& rand , int numOctave , float frequency , float persistence = 0.5f );
+
+		float getValue( float x , float y ) const;
+		float getValue( float x , float y , float z ) const;
+		void  getValue4( float const x[4] , float const y[4] , float out[4] ) const;
+		void  getValue4( float const x[4] , float const y[4] , float const z[4] , float out[4] ) const;
+
+	private:
+		PerlinNoise mNoise[ MaxOctaveNum ];
+		float mFrequency[ MaxOctaveNum ];
+		float mAmplitude[ MaxOctaveNum ];
+		int   mNumOctave;
+	};
+
+}//namespace Cube
+
+#endif // CubeNoise_h__
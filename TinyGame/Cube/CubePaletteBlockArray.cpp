@@ -0,0 +1,209 @@
+#include "CubePCH.h"
+#include "CubePaletteBlockArray.h"
+
+#include <vector>
+
+namespace Cube
+{
+	PaletteBlockArray::PaletteBlockArray( int num )
+		:mNum( num )
+		,mData( NULL )
+	{
+		assert( num % 32 == 0 );
+		fill( BLOCK_NULL );
+	}
+
+	PaletteBlockArray::~PaletteBlockArray()
+	{
+		delete [] mData;
+	}
+
+	int PaletteBlockArray::calcBit( int numId )
+	{
+		if ( numId <= 1 )
+			return 0;
+		if ( numId <= 2 )
+			return 1;
+		if ( numId <= 4 )
+			return 2;
+		if ( numId <= MaxPaletteSize )
+			return 4;
+		return DirectBit;
+	}
+
+	void PaletteBlockArray::fill( BlockId id )
+	{
+		delete [] mData;
+		mData       = NULL;
+		mBit        = 0;
+		mWordShift  = 0;
+		mWordMask   = 0;
+		mValueMask  = 0;
+		mNumPalette = 1;
+		mPalette[0] = id;
+	}
+
+	void PaletteBlockArray::set( int index , BlockId id )
+	{
+		uint32 value;
+		if ( mBit == DirectBit )
+		{
+			value = id;
+		}
+		else
+		{
+			int idx = findPalette( id );
+			if ( idx < 0 )
+			{
+				if ( mNumPalette >= ( 1 << mBit ) )
+				{
+					std::vector< BlockId > ids( mNum );
+					unpack( &ids[0] );
+
+					int bit = calcBit( mNumPalette + 1 );
+					if ( bit != DirectBit )
+						mPalette[ mNumPalette++ ] = id;
+					changeBit( bit , &ids[0] );
+
+					if ( bit == DirectBit )
+					{
+						setValue( index , id );
+						return;
+					}
+				}
+				else
+				{
+					mPalette[ mNumPalette++ ] = id;
+				}
+				idx = mNumPalette - 1;
+			}
+			if ( mBit == 0 )
+				return;
+			value = idx;
+		}
+		setValue( index , value );
+	}
+
+	void PaletteBlockArray::changeBit( int bit , BlockId const* ids )
+	{
+		delete [] mData;
+		mData = NULL;
+
+		mBit = bit;
+		if ( bit == 0 )
+		{
+			mWordShift = 0;
+			mWordMask  = 0;
+			mValueMask = 0;
+			return;
+		}
+
+		int numPerWord = 32 / bit;
+		mWordShift = 0;
+		while( ( 1 << mWordShift ) < numPerWord )
+			++mWordShift;
+		mWordMask  = numPerWord - 1;
+		mValueMask = ( 1 << bit ) - 1;
+
+		int numWord = mNum / numPerWord;
+		mData = new uint32[ numWord ];
+
+		uint8 valueMap[ 256 ];
+		if ( bit == DirectBit )
+		{
+			for( int i = 0 ; i < 256 ; ++i )
+				valueMap[i] = uint8( i );
+		}
+		else
+		{
+			for( int i = 0 ; i < mNumPalette ; ++i )
+				valueMap[ mPalette[i] ] = uint8( i );
+		}
+
+		BlockId const* src = ids;
+		for( int n = 0 ; n < numWord ; ++n )
+		{
+			uint32 word = 0;
+			for( int i = 0 ; i < numPerWord ; ++i )
+				word |= uint32( valueMap[ src[i] ] ) << ( i * bit );
+			mData[n] = word;
+			src += numPerWord;
+		}
+	}
+
+	void PaletteBlockArray::unpack( BlockId* dest ) const
+	{
+		if ( mBit == 0 )
+		{
+			std::fill_n( dest , mNum , mPalette[0] );
+			return;
+		}
+
+		int numPerWord = 32 / mBit;
+		int numWord    = mNum / numPerWord;
+		if ( mBit == DirectBit )
+		{
+			for( int n = 0 ; n < numWord ; ++n )
+			{
+				uint32 word = mData[n];
+				for( int i = 0 ; i < numPerWord ; ++i )
+					dest[i] = BlockId( ( word >> ( i * DirectBit ) ) & 0xff );
+				dest += numPerWord;
+			}
+			return;
+		}
+
+		for( int n = 0 ; n < numWord ; ++n )
+		{
+			uint32 word = mData[n];
+			for( int i = 0 ; i < numPerWord ; ++i )
+			{
+				dest[i] = mPalette[ word & mValueMask ];
+				word >>= mBit;
+			}
+			dest += numPerWord;
+		}
+	}
+
+	void PaletteBlockArray::load( BlockId const* src )
+	{
+		bool used[ 256 ];
+		std::fill_n( used , 256 , false );
+
+		BlockId palette[ MaxPaletteSize ];
+		int numId = 0;
+		for( int i = 0 ; i < mNum ; ++i )
+		{
+			BlockId id = src[i];
+			if ( used[ id ] )
+				continue;
+			used[ id ] = true;
+			if ( numId < MaxPaletteSize )
+				palette[ numId ] = id;
+			++numId;
+		}
+
+		int bit = calcBit( numId );
+		if ( bit != DirectBit )
+		{
+			mNumPalette = numId;
+			std::copy( palette , palette + numId , mPalette );
+		}
+		changeBit( bit , src );
+	}
+
+	void PaletteBlockArray::compact()
+	{
+		if ( mBit == 0 )
+			return;
+		std::vector< BlockId > ids( mNum );
+		unpack( &ids[0] );
+		load( &ids[0] );
+	}
+
+	int PaletteBlockArray::getMemoryUsage() const
+	{
+		return sizeof( *this ) + mNum * mBit / 8;
+	}
+
+}//namespace Cube
@@ -0,0 +1,75 @@
+#ifndef CubePaletteBlockArray_h__
+#define CubePaletteBlockArray_h__
+
+#include "CubeBase.h"
+
+namespace Cube
+{
+	//  Block ids of a fixed number of cells , packed with a palette.
+	//  Bits per cell is 0 , 1 , 2 or 4 by the palette size , 0 bit means
+	//  all cells are the same id. More than 16 ids use 8 bits with the id
+	//  itself. The palette grows on set , compact rebuilds it from used ids.
+	class PaletteBlockArray
+	{
+	public:
+		//num must be a multiple of 32
+		PaletteBlockArray( int num );
+		~PaletteBlockArray();
+
+		BlockId get( int index ) const
+		{
+			if ( mBit == 0 )
+				return mPalette[0];
+			uint32 value = ( mData[ index >> mWordShift ] >> ( ( index & mWordMask ) * mBit ) ) & mValueMask;
+			return ( mBit == DirectBit ) ? BlockId( value ) : mPalette[ value ];
+		}
+		void    set( int index , BlockId id );
+
+		void    fill( BlockId id );
+		void    unpack( BlockId* dest ) const;
+		void    load( BlockId const* src );
+		void    compact();
+
+		bool    isUniform() const { return mBit == 0; }
+		BlockId getUniformId() const { assert( isUniform() ); return mPalette[0]; }
+		int     getBitCount() const { return mBit; }
+		int     getMemoryUsage() const;
+
+	private:
+		static int const MaxPaletteSize = 16;
+		static int const DirectBit = 8;
+
+		int   findPalette( BlockId id ) const
+		{
+			for( int i = 0 ; i < mNumPalette ; ++i )
+			{
+				if ( mPalette[i] == id )
+					return i;
+			}
+			return -1;
+		}
+		void  setValue( int index , uint32 value )
+		{
+			uint32& word = mData[ index >> mWordShift ];
+			int     shift = ( index & mWordMask ) * mBit;
+			word = ( word & ~( mValueMask << shift ) ) | ( value << shift );
+		}
+		void  changeBit( int bit , BlockId const* ids );
+		static int calcBit( int numId );
+
+		int     mNum;
+		uint8   mBit;
+		uint8   mNumPalette;
+		uint8   mWordShift;
+		uint8   mWordMask;
+		uint32  mValueMask;
+		uint32* mData;
+		BlockId mPalette[ MaxPaletteSize ];
+
+		PaletteBlockArray( PaletteBlockArray const& );
+		PaletteBlockArray& operator = ( PaletteBlockArray const& );
+	};
+
+}//namespace Cube
+
+#endif // CubePaletteBlockArray_h__
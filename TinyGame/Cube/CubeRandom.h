@@ -21,6 +21,11 @@ namespace Cube
 		{ 
 			return uint32( 32 * uint64( next(31) ) >> 31 );
 		}
+		// [ 0 , bound )
+		uint32 getInt( uint32 bound )
+		{
+			return uint32( ( uint64( bound ) * uint64( next(31) ) ) >> 31 );
+		}
 
 	private:
 		uint32 next(int bits) 
@@ -39,6 +39,7 @@ namespace Cube
 
 		mClientWorld = &world;
 		mClientWorld->addListener( *this );
+		mClientWorld->getChunkProvider().setLoadListener( this );
 
 		mBlockRenderer->mBlockAccess = &world;
 	}
@@ -105,7 +106,7 @@ namespace Cube
 
 		ChunkPos cPos;
 		cPos.setBlockPos( bx , by );
-		int len = 1;
+		int len = world.getChunkProvider().getViewRadius();
 
 		glPolygonMode(GL_FRONT, GL_LINE);
 		for( int i = -len ; i <= len ; ++i )
@@ -116,59 +117,29 @@ namespace Cube
 				curPos.x = cPos.x + i;
 				curPos.y = cPos.y + j;
 
-				WDMap::iterator iter = mWDMap.find( curPos.hash_value() );
-				WorldData* data = NULL;
-				if ( iter == mWDMap.end() )
-				{
-					Chunk* chunk = world.getChunk( curPos );
-
-					if ( !chunk )
-						continue;
-
-					data = new WorldData;
-					data->needUpdate = true;
-					data->drawList[0] = glGenLists( WorldData::NumPass );
-					for( int i = 1 ; i < WorldData::NumPass ; ++i )
-					{
-						data->drawList[i] = data->drawList[0] + i;
-					}
-					mWDMap.insert( std::make_pair( curPos.hash_value() , data ) );
-				}
-				else
-				{
-					data = iter->second;
-				}
-
-				if ( data->needUpdate )
-				{
-					Chunk* chunk = world.getChunk( curPos );
+				Chunk* chunk = world.getChunk( curPos );
+				if ( !chunk )
+					continue;
 
-					assert( chunk );
+				WDMap::iterator iter = mWDMap.find( curPos.hash_value() );
+				WorldData* data = ( iter != mWDMap.end() ) ? iter->second : createWorldData( curPos );
 
-					glPushMatrix();
-					glLoadIdentity();
+				if ( data->dirtyMask )
+					updateChunkMesh( *data , *chunk );
 
-					for( int i = 0 ; i < WorldData::NumPass ; ++i )
-					{
-						mMesh.clearBuffer();
-						chunk->render( *mBlockRenderer );
+				if ( data->emptyMask == ( 1 << Chunk::NumLayer ) - 1 )
+					continue;
 
-						glNewList( data->drawList[i] , GL_COMPILE );
-						mMesh.render();
-						glEndList();
-					}
-					glPopMatrix();
-					data->needUpdate = false;
-				}
-				else
+				glPushMatrix();
+				int bx = ChunkSize * curPos.x;
+				int by = ChunkSize * curPos.y;
+				glTranslatef( bx , by , 0 );
+				for( int n = 0 ; n < Chunk::NumLayer ; ++n )
 				{
-					glPushMatrix();
-					int bx = ChunkSize * curPos.x;
-					int by = ChunkSize * curPos.y;
-					glTranslatef( bx , by , 0 );
-					glCallLists( WorldData::NumPass , GL_UNSIGNED_INT , data->drawList );
-					glPopMatrix();
+					if ( !( data->emptyMask & BIT( n ) ) )
+						glCallList( data->drawList + n );
 				}
+				glPopMatrix();
 			}
 		}
 
@@ -237,33 +208,151 @@ namespace Cube
 		glFlush();
 	}
 
-	void RenderEngine::onModifyBlock( int bx , int by , int bz )
+	RenderEngine::WorldData* RenderEngine::createWorldData( ChunkPos const& pos )
 	{
-		ChunkPos cPos; 
+		WorldData* data = new WorldData;
+		data->dirtyMask = ( 1 << Chunk::NumLayer ) - 1;
+		data->emptyMask = ( 1 << Chunk::NumLayer ) - 1;
+		data->drawList  = glGenLists( Chunk::NumLayer );
+		mWDMap.insert( std::make_pair( pos.hash_value() , data ) );
+		return data;
+	}
+
+	ChunkRenderData* RenderEngine::buildRenderData( Chunk& chunk )
+	{
+		//loader thread : only the chunk can be used , so faces at the chunk
+		//border are kept until a block modify rebuilds the section
+		ChunkRenderData* data = new ChunkRenderData;
+		SingleChunkAccess access( chunk );
+		ChunkMesher mesher;
+		Mesh mesh;
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
 		{
-			cPos.setBlockPos( bx + 1 , by );
-			WDMap::iterator iter = mWDMap.find( cPos.hash_value() );
-			if ( iter != mWDMap.end() )
-				iter->second->needUpdate = true;
+			mesh.clearBuffer();
+			if ( !mesher.buildSection( chunk , n , access , mesh ) )
+				continue;
+			data->vertices[n] = mesh.mVtxBuffer;
+			data->indices[n]  = mesh.mIndexBuffer;
 		}
+		return data;
+	}
+
+	void RenderEngine::onChunkLoad( Chunk& chunk , ChunkRenderData* data )
+	{
+		//loaded neighbors have border faces toward the missing chunk , the new blocks hide them
+		ChunkPos const& pos = chunk.getPos();
+		int topLayer = chunk.getTopLayerIndex();
+		for( int n = 0 ; n <= topLayer ; ++n )
 		{
-			cPos.setBlockPos( bx - 1 , by );
-			WDMap::iterator iter = mWDMap.find( cPos.hash_value() );
-			if ( iter != mWDMap.end() )
-				iter->second->needUpdate = true;
+			markSectionDirty( pos.x - 1 , pos.y , n );
+			markSectionDirty( pos.x + 1 , pos.y , n );
+			markSectionDirty( pos.x , pos.y - 1 , n );
+			markSectionDirty( pos.x , pos.y + 1 , n );
 		}
+
+		WDMap::iterator iter = mWDMap.find( pos.hash_value() );
+		WorldData* wd = ( iter != mWDMap.end() ) ? iter->second : createWorldData( pos );
+		if ( !data )
 		{
-			cPos.setBlockPos( bx , by + 1 );
-			WDMap::iterator iter = mWDMap.find( cPos.hash_value() );
-			if ( iter != mWDMap.end() )
-				iter->second->needUpdate = true;
+			wd->dirtyMask = ( 1 << Chunk::NumLayer ) - 1;
+			return;
 		}
+
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
 		{
-			cPos.setBlockPos( bx , by - 1 );
-			WDMap::iterator iter = mWDMap.find( cPos.hash_value() );
-			if ( iter != mWDMap.end() )
-				iter->second->needUpdate = true;
+			if ( data->indices[n].empty() )
+			{
+				wd->emptyMask |= BIT( n );
+				continue;
+			}
+			mMesh.mVtxBuffer.swap( data->vertices[n] );
+			mMesh.mIndexBuffer.swap( data->indices[n] );
+			glNewList( wd->drawList + n , GL_COMPILE );
+			mMesh.render();
+			glEndList();
+			wd->emptyMask &= ~BIT( n );
 		}
+		mMesh.clearBuffer();
+		wd->dirtyMask = 0;
+		releaseRenderData( data );
+	}
+
+	void RenderEngine::onChunkUnload( Chunk& chunk )
+	{
+		WDMap::iterator iter = mWDMap.find( chunk.getPos().hash_value() );
+		if ( iter == mWDMap.end() )
+			return;
+		WorldData* data = iter->second;
+		glDeleteLists( data->drawList , Chunk::NumLayer );
+		delete data;
+		mWDMap.erase( iter );
+	}
+
+	void RenderEngine::updateChunkMesh( WorldData& data , Chunk& chunk )
+	{
+		for( int n = 0 ; n < Chunk::NumLayer ; ++n )
+		{
+			if ( !( data.dirtyMask & BIT( n ) ) )
+				continue;
+
+			mMesh.clearBuffer();
+			if ( mMesher.buildSection( chunk , n , *mClientWorld , mMesh ) )
+			{
+				glNewList( data.drawList + n , GL_COMPILE );
+				mMesh.render();
+				glEndList();
+				data.emptyMask &= ~BIT( n );
+			}
+			else
+			{
+				data.emptyMask |= BIT( n );
+			}
+		}
+		data.dirtyMask = 0;
+	}
+
+	void RenderEngine::markSectionDirty( int cx , int cy , int idxLayer )
+	{
+		if ( idxLayer < 0 || idxLayer >= Chunk::NumLayer )
+			return;
+
+		ChunkPos cPos;
+		cPos.x = cx;
+		cPos.y = cy;
+		WDMap::iterator iter = mWDMap.find( cPos.hash_value() );
+		if ( iter != mWDMap.end() )
+			iter->second->dirtyMask |= BIT( idxLayer );
+	}
+
+	void RenderEngine::onModifyBlock( int bx , int by , int bz )
+	{
+		if ( bz < 0 || bz >= ChunkBlockMaxHeight )
+			return;
+
+		ChunkPos cPos; 
+		cPos.setBlockPos( bx , by );
+		int idxLayer = bz >> Chunk::LayerBit;
+
+		markSectionDirty( cPos.x , cPos.y , idxLayer );
+
+		//faces of neighbor sections touch the block
+		int lz = bz & Chunk::LayerMask;
+		if ( lz == 0 )
+			markSectionDirty( cPos.x , cPos.y , idxLayer - 1 );
+		else if ( lz == Chunk::LayerMask )
+			markSectionDirty( cPos.x , cPos.y , idxLayer + 1 );
+
+		int lx = bx & ChunkMask;
+		if ( lx == 0 )
+			markSectionDirty( cPos.x - 1 , cPos.y , idxLayer );
+		else if ( lx == ChunkMask )
+			markSectionDirty( cPos.x + 1 , cPos.y , idxLayer );
+
+		int ly = by & ChunkMask;
+		if ( ly == 0 )
+			markSectionDirty( cPos.x , cPos.y - 1 , idxLayer );
+		else if ( ly == ChunkMask )
+			markSectionDirty( cPos.x , cPos.y + 1 , idxLayer );
 	}
 
 	void RenderEngine::drawCroodAxis( float len )
@@ -3,6 +3,7 @@
 
 #include "CubeBase.h"
 #include "CubeMesh.h"
+#include "CubeChunkMesher.h"
 #include "IWorldEventListener.h"
 
 #include <unordered_map>
@@ -34,7 +35,15 @@ namespace Cube
 		Texture2D* createTexture( int w , int h , void* data );
 	};
 
+	//section meshes built on loader thread
+	struct ChunkRenderData
+	{
+		std::vector< Mesh::Vertex > vertices[ Chunk::NumLayer ];
+		std::vector< uint32 >       indices[ Chunk::NumLayer ];
+	};
+
 	class RenderEngine : public IWorldEventListener
+		               , public IChunkLoadListener
 	{
 	public:
 		RenderEngine( int w , int h );
@@ -50,17 +59,27 @@ namespace Cube
 
 		void onModifyBlock( int bx , int by , int bz );
 
+		ChunkRenderData* buildRenderData( Chunk& chunk );
+		void releaseRenderData( ChunkRenderData* data ){ delete data; }
+		void onChunkLoad( Chunk& chunk , ChunkRenderData* data );
+		void onChunkUnload( Chunk& chunk );
+
 		void setupWorld( World& world );
 	private:
 		BlockRenderer* mBlockRenderer;
 
 
+		//one display list per chunk section , only dirty sections are rebuilt
 		struct WorldData
 		{
-			static int const NumPass = 1;
-			bool     needUpdate;
-			uint32   drawList[ NumPass ];
+			uint32   dirtyMask;
+			uint32   emptyMask;
+			uint32   drawList;
 		};
+
+		WorldData* createWorldData( ChunkPos const& pos );
+		void updateChunkMesh( WorldData& data , Chunk& chunk );
+		void markSectionDirty( int cx , int cy , int idxLayer );
 		void cleanupWorldData()
 		{
 
@@ -83,6 +102,7 @@ namespace Cube
 		WDMap  mWDMap;
 		float  mAspect;
 		Mesh   mMesh;
+		ChunkMesher mMesher;
 	};
 
 
@@ -24,6 +24,10 @@ namespace Cube
 		mScene = new Scene( window.getWidth() , window.getHeight() );
 		mScene->changeWorld( mLevel->getWorld() );
 
+		ChunkProvider& provider = mLevel->getWorld().getChunkProvider();
+		provider.setViewRadius( 6 );
+		provider.startAsyncLoad( 2 );
+
 		restart();
 		return true;
 	}
@@ -6,8 +6,12 @@
 #include "Cube/CubeScene.h"
 #include "Cube/CubeLevel.h"
 #include "cube/CubeWorld.h"
+#include "Cube/CubeTerrainGenerator.h"
+#include "Cube/CubeLightEngine.h"
+#include "Cube/CubeBlockType.h"
 
 #include "WinGLPlatform.h"
+#include "DebugSystem.h"
 
 namespace Cube
 {
@@ -123,7 +127,7 @@ namespace Cube
 
 		void updateFrame( int frame )
 		{
-
+			mLevel->getWorld().update( mCamera.getPos() );
 		}
 
 		bool onMouse( MouseMsg const& msg )
@@ -144,6 +148,17 @@ namespace Cube
 					mLevel->getWorld().setBlockNotify( info.x , info.y , info.z , BLOCK_NULL );
 				}
 			}
+			else if ( msg.onRightDown() )
+			{
+				BlockPosInfo info;
+				BlockId id = mLevel->getWorld().rayBlockTest( mCamera.getPos() , mCamera.getViewDir() , 100 , &info );
+				if ( id )
+				{
+					int pos[3] = { info.x , info.y , info.z };
+					pos[ info.face / 2 ] += ( info.face & 1 ) ? -1 : 1;
+					mLevel->getWorld().setBlockNotify( pos[0] , pos[1] , pos[2] , BLOCK_TORCH );
+				}
+			}
 
 			if ( !BaseClass::onMouse( msg ) )
 				return false;
@@ -161,6 +176,15 @@ namespace Cube
 			case 'R': restart(); break;
 			case 'W': mCamera.moveFront( 0.5 ); break;
 			case 'S': mCamera.moveFront( -0.5 ); break;
+			case 'G':
+				{
+					float speed = measureGenerateSpeed( mLevel->getGenerator() , 64 );
+					::Msg( "Terrain Generate : %.1f chunk/s" , speed );
+				}
+				break;
+			case 'L':
+				::Msg( "Light engine test %s" , LightEngine::checkIncrementalLight( mLevel->getGenerator() , 500 ) ? "pass" : "fail" );
+				break;
 			case VK_UP: mCamera.setPos( mCamera.getPos() + Vec3f( 0,0,2) );break;
 			}
 			return false;
@@ -0,0 +1,151 @@
+#include "CubePCH.h"
+#include "CubeTerrainGenerator.h"
+
+#include "CubeBlockType.h"
+
+#include "Clock.h"
+
+namespace Cube
+{
+	NoiseTerrainGenerator::NoiseTerrainGenerator( uint64 seed )
+	{
+		seaLevel      = 62;
+		baseHeight    = 64;
+		caveThreshold = 0.28f;
+		setSeed( seed );
+	}
+
+	void NoiseTerrainGenerator::setSeed( uint64 seed )
+	{
+		//init order is a part of the world format , don't change it
+		Random rand;
+		rand.setSeed( seed );
+		mBiomeNoise.init( rand , 3 , 1.0f / 512.0f );
+		mHeightNoise.init( rand , 5 , 1.0f / 128.0f , 0.5f );
+		mDetailNoise.init( rand , 2 , 1.0f / 16.0f );
+		mCaveNoise.init( rand , 2 , 1.0f / 32.0f );
+	}
+
+	BiomeType NoiseTerrainGenerator::toBiome( float value )
+	{
+		if ( value < -0.15f )
+			return BIOME_OCEAN;
+		if ( value < 0.1f )
+			return BIOME_PLAINS;
+		if ( value < 0.3f )
+			return BIOME_HILLS;
+		return BIOME_MOUNTAINS;
+	}
+
+	void NoiseTerrainGenerator::calcColumn4( float const x[4] , float const y[4] , float biome[4] , int height[4] ) const
+	{
+		float h[4];
+		float detail[4];
+		mBiomeNoise.getValue4( x , y , biome );
+		mHeightNoise.getValue4( x , y , h );
+		mDetailNoise.getValue4( x , y , detail );
+
+		for( int n = 0 ; n < 4 ; ++n )
+		{
+			//biome value moves the ground and scales the roughness ,
+			//so there is no cliff at biome border
+			float b   = biome[n];
+			float rough = 6.0f + 80.0f * ( b > 0 ? b : 0 );
+			int   value = baseHeight + int( 48.0f * b + rough * h[n] + 3.0f * detail[n] );
+
+			if ( value < 1 )
+				value = 1;
+			else if ( value > int( ChunkBlockMaxHeight ) - 2 )
+				value = int( ChunkBlockMaxHeight ) - 2;
+			height[n] = value;
+		}
+	}
+
+	BiomeType NoiseTerrainGenerator::getBiome( int bx , int by ) const
+	{
+		return toBiome( mBiomeNoise.getValue( float( bx ) , float( by ) ) );
+	}
+
+	int NoiseTerrainGenerator::getHeight( int bx , int by ) const
+	{
+		float x[4] = { float( bx ) , float( bx ) , float( bx ) , float( bx ) };
+		float y[4] = { float( by ) , float( by ) , float( by ) , float( by ) };
+		float biome[4];
+		int   height[4];
+		calcColumn4( x , y , biome , height );
+		return height[0];
+	}
+
+	bool NoiseTerrainGenerator::generate( Chunk& chunk , Random& rand )
+	{
+		int bx = chunk.getPos().x * ChunkSize;
+		int by = chunk.getPos().y * ChunkSize;
+
+		for( int j = 0 ; j < ChunkSize ; ++j )
+		{
+			for( int i = 0 ; i < ChunkSize ; i += 4 )
+			{
+				float x[4] = { float( bx + i ) , float( bx + i + 1 ) , float( bx + i + 2 ) , float( bx + i + 3 ) };
+				float y[4] = { float( by + j ) , float( by + j ) , float( by + j ) , float( by + j ) };
+				float biome[4];
+				int   height[4];
+				calcColumn4( x , y , biome , height );
+
+				int maxHeight = 0;
+				for( int n = 0 ; n < 4 ; ++n )
+				{
+					for( int k = 0 ; k < height[n] ; ++k )
+						chunk.setBlockId( i + n , j , k , BLOCK_DIRT );
+					for( int k = height[n] ; k < seaLevel ; ++k )
+						chunk.setBlockId( i + n , j , k , BLOCK_WATER );
+					if ( height[n] > maxHeight )
+						maxHeight = height[n];
+				}
+
+				//caves stay under the ground surface and above the bottom
+				float z[4];
+				for( int k = 2 ; k < maxHeight - 4 ; ++k )
+				{
+					z[0] = z[1] = z[2] = z[3] = float( k );
+					float density[4];
+					mCaveNoise.getValue4( x , y , z , density );
+					for( int n = 0 ; n < 4 ; ++n )
+					{
+						if ( k < height[n] - 4 && density[n] > caveThreshold )
+							chunk.setBlockId( i + n , j , k , BLOCK_NULL );
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	float measureGenerateSpeed( TerrainGenerator& generator , int numChunk )
+	{
+		if ( numChunk <= 0 )
+			return 0;
+
+		int size = 1;
+		while( size * size < numChunk )
+			++size;
+
+		TClock clock;
+		clock.reset();
+		for( int n = 0 ; n < numChunk ; ++n )
+		{
+			ChunkPos pos;
+			pos.x = n % size - size / 2;
+			pos.y = n / size - size / 2;
+
+			Chunk chunk( pos );
+			Random rand;
+			rand.setSeed( pos.hash_value() );
+			generator.generate( chunk , rand );
+		}
+		unsigned long time = clock.getTimeMicroseconds();
+		if ( time == 0 )
+			time = 1;
+		return float( numChunk ) * 1000000.0f / float( time );
+	}
+
+}//namespace Cube
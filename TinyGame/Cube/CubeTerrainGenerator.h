@@ -0,0 +1,51 @@
+#ifndef CubeTerrainGenerator_h__
+#define CubeTerrainGenerator_h__
+
+#include "CubeWorld.h"
+#include "CubeNoise.h"
+
+namespace Cube
+{
+	enum BiomeType
+	{
+		BIOME_OCEAN ,
+		BIOME_PLAINS ,
+		BIOME_HILLS ,
+		BIOME_MOUNTAINS ,
+	};
+
+	//  Fractal height map with biomes and 3D density caves.
+	//  Every noise is made from the seed , so all machines with the same seed
+	//  generate the same chunks. Columns are evaluated four at a time.
+	//  generate is const for the noise , it can be used by many loader threads.
+	class NoiseTerrainGenerator : public TerrainGenerator
+	{
+	public:
+		NoiseTerrainGenerator( uint64 seed = 0 );
+
+		void  setSeed( uint64 seed );
+		virtual bool generate( Chunk& chunk , Random& rand );
+
+		BiomeType getBiome( int bx , int by ) const;
+		int       getHeight( int bx , int by ) const;
+
+		int   seaLevel;
+		int   baseHeight;
+		float caveThreshold;
+
+	private:
+		void  calcColumn4( float const x[4] , float const y[4] , float biome[4] , int height[4] ) const;
+		static BiomeType toBiome( float value );
+
+		OctaveNoise mBiomeNoise;
+		OctaveNoise mHeightNoise;
+		OctaveNoise mDetailNoise;
+		OctaveNoise mCaveNoise;
+	};
+
+	// generate numChunk chunks on calling thread , return chunks per second
+	float measureGenerateSpeed( TerrainGenerator& generator , int numChunk );
+
+}//namespace Cube
+
+#endif // CubeTerrainGenerator_h__
@@ -6,19 +6,161 @@
 #include "CubeBlockType.h"
 
 #include "CubeBlockRenderer.h"
+#include "CubeChunkLoader.h"
+#include "CubeChunkStorage.h"
+#include "CubeLightEngine.h"
 
 #include "IWorldEventListener.h"
 
+#include "GameGlobal.h"
+#include "FrameAllocator.h"
+
 #include <algorithm>
 
 namespace Cube
 {
 	Chunk::Chunk( ChunkPos const& pos )
 		:mPos( pos )
+		,mbModified( false )
+		,mLastUseTick( 0 )
 	{
 		std::fill_n( mLayer , NumLayer , static_cast< LayerData*>(0) );
 	}
 
+	Chunk::~Chunk()
+	{
+		for( int n = 0 ; n < NumLayer ; ++n )
+			delete mLayer[ n ];
+	}
+
+	Chunk::LayerData::LayerData()
+		:mBlocks( NumCell )
+		,mMeta( NULL )
+		,mLight( NULL )
+		,mLightFill( 0 )
+	{
+
+	}
+
+	Chunk::LayerData::~LayerData()
+	{
+		delete [] mMeta;
+		delete [] mLight;
+	}
+
+	MetaType Chunk::LayerData::getBlockMeta( int x , int y , int z ) const
+	{
+		if ( !mMeta )
+			return 0;
+		uint32 meta = mMeta[ toIndex( x , y , z ) / 2 ];
+		return ( z & 0x1 ) ? ( meta & 0xf ) : ( meta >> 4 );
+	}
+
+	void Chunk::LayerData::setBlockMeta( int x , int y , int z , MetaType meta )
+	{
+		if ( !mMeta )
+		{
+			if ( meta == 0 )
+				return;
+			mMeta = new uint8[ NumCell / 2 ];
+			std::fill_n( mMeta , NumCell / 2 , 0 );
+		}
+
+		uint8& holdMeta = mMeta[ toIndex( x , y , z ) / 2 ];
+		if ( z & 1 )
+			holdMeta = ( holdMeta & 0xf0 ) | meta;
+		else
+			holdMeta = ( meta << 4 ) | ( holdMeta & 0xf );
+	}
+
+	void Chunk::LayerData::setLight( int x , int y , int z , uint8 value )
+	{
+		if ( !mLight )
+		{
+			if ( value == mLightFill )
+				return;
+			mLight = new uint8[ NumCell ];
+			std::fill_n( mLight , NumCell , mLightFill );
+		}
+		mLight[ toIndex( x , y , z ) ] = value;
+	}
+
+	void Chunk::LayerData::fillLight( uint8 value )
+	{
+		delete [] mLight;
+		mLight = NULL;
+		mLightFill = value;
+	}
+
+	void Chunk::LayerData::getMetaData( uint8* dest ) const
+	{
+		if ( mMeta )
+			std::copy( mMeta , mMeta + NumCell / 2 , dest );
+		else
+			std::fill_n( dest , NumCell / 2 , 0 );
+	}
+
+	void Chunk::LayerData::setMetaData( uint8 const* src )
+	{
+		delete [] mMeta;
+		mMeta = NULL;
+		if ( std::count( src , src + NumCell / 2 , 0 ) == NumCell / 2 )
+			return;
+		mMeta = new uint8[ NumCell / 2 ];
+		std::copy( src , src + NumCell / 2 , mMeta );
+	}
+
+	void Chunk::LayerData::getLightData( uint8* dest ) const
+	{
+		if ( mLight )
+			std::copy( mLight , mLight + NumCell , dest );
+		else
+			std::fill_n( dest , NumCell , mLightFill );
+	}
+
+	void Chunk::LayerData::setLightData( uint8 const* src )
+	{
+		fillLight( src[0] );
+		if ( std::count( src , src + NumCell , src[0] ) == NumCell )
+			return;
+		mLight = new uint8[ NumCell ];
+		std::copy( src , src + NumCell , mLight );
+	}
+
+	bool Chunk::LayerData::isEmpty( uint8 lightFill ) const
+	{
+		return isAir() && mMeta == NULL && mLight == NULL && mLightFill == lightFill;
+	}
+
+	void Chunk::LayerData::compact()
+	{
+		mBlocks.compact();
+		if ( mMeta )
+		{
+			uint8* meta = mMeta;
+			mMeta = NULL;
+			setMetaData( meta );
+			delete [] meta;
+		}
+		if ( mLight )
+		{
+			uint8* light = mLight;
+			mLight = NULL;
+			setLightData( light );
+			delete [] light;
+		}
+	}
+
+	int Chunk::LayerData::getMemoryUsage() const
+	{
+		int result = sizeof( *this ) - sizeof( mBlocks ) + mBlocks.getMemoryUsage();
+		if ( mMeta )
+			result += NumCell / 2;
+		if ( mLight )
+			result += NumCell;
+		return result;
+	}
+
 	BlockId Chunk::getBlockId( int x , int y , int z )
 	{
 		if ( z < 0 ||z >= ChunkBlockMaxHeight )
@@ -26,11 +168,8 @@ namespace Cube
 		LayerData* layer = getLayer( z );
 		if ( !layer )
 			return BLOCK_NULL;
-		int mx = x & ChunkMask;
-		int my = y & ChunkMask;
-		int mz = z & LayerMask;
 
-		return layer->blockMap[ x & ChunkMask ][ y & ChunkMask ][ z & LayerMask ];
+		return layer->getBlockId( x , y , z );
 	}
 
 	void Chunk::setBlockId( int x , int y , int z , BlockId id )
@@ -43,11 +182,14 @@ namespace Cube
 		{
 			if ( id == BLOCK_NULL )
 				return;
-			layer = new LayerData;
-			mLayer[ z >> LayerBit ] = layer;
+			layer = createLayer( z >> LayerBit );
+		}
+		else if ( id != BLOCK_NULL && layer->isAir() )
+		{
+			fillSkyLayers( z >> LayerBit );
 		}
 
-		layer->blockMap[ x & ChunkMask ][ y & ChunkMask ][ z & LayerMask ] = id;
+		layer->setBlockId( x , y , z , id );
 	}
 
 	MetaType Chunk::getBlockMeta( int x , int y , int z )
@@ -58,8 +200,7 @@ namespace Cube
 		if ( !layer )
 			return 0;
 
-		uint32 meta = layer->meta[ x & ChunkMask ][ y & ChunkMask ][ ( z & LayerMask ) / 2 ];
-		return ( z & 0x1 ) ? ( meta & 0xf ) : ( meta >> 4 );
+		return layer->getBlockMeta( x , y , z );
 	}
 	void     Chunk::setBlockMeta( int x , int y , int z , MetaType meta )
 	{
@@ -71,34 +212,128 @@ namespace Cube
 		LayerData* layer = getLayer( z );
 		if ( !layer )
 		{
-			layer = new LayerData;
-			mLayer[ z >> LayerBit ] = layer;
+			if ( meta == 0 )
+				return;
+			layer = createLayer( z >> LayerBit );
 		}
 
-		uint8& holdMeta = layer->meta[ x & ChunkMask ][ y & ChunkMask ][ z & LayerMask ];
+		layer->setBlockMeta( x , y , z , meta );
+	}
 
-		if ( z & 1 )
-			holdMeta = ( holdMeta & 0xf0 ) | meta;
-		else
-			holdMeta = ( meta << 4 ) | ( holdMeta & 0xf);
+	uint8 Chunk::getLight( int x , int y , int z )
+	{
+		if ( z < 0 )
+			return 0;
+		if ( z >= ChunkBlockMaxHeight )
+			return FullSkyLight;
+
+		LayerData* layer = getLayer( z );
+		if ( !layer )
+			return getMissingLayerLight( z >> LayerBit );
+		return layer->getLight( x , y , z );
+	}
+
+	void Chunk::setLight( int x , int y , int z , uint8 value )
+	{
+		if ( z < 0 || z >= ChunkBlockMaxHeight )
+			return;
+
+		LayerData* layer = getLayer( z );
+		if ( !layer )
+		{
+			if ( value == getMissingLayerLight( z >> LayerBit ) )
+				return;
+			layer = createLayer( z >> LayerBit );
+		}
+		layer->setLight( x , y , z , value );
+	}
+
+	int Chunk::getTopLayerIndex() const
+	{
+		for( int n = NumLayer - 1 ; n >= 0 ; --n )
+		{
+			if ( mLayer[ n ] && !mLayer[ n ]->isAir() )
+				return n;
+		}
+		return -1;
+	}
+
+	Chunk::LayerData* Chunk::createLayer( int idxLayer )
+	{
+		assert( mLayer[ idxLayer ] == NULL );
+
+		fillSkyLayers( idxLayer );
+		LayerData* layer = new LayerData;
+		layer->fillLight( getMissingLayerLight( idxLayer ) );
+		mLayer[ idxLayer ] = layer;
+		return layer;
+	}
+
+	void Chunk::fillSkyLayers( int idxLayer )
+	{
+		//missing layers under a new top layer must keep their sky light
+		for( int n = getTopLayerIndex() + 1 ; n < idxLayer ; ++n )
+		{
+			if ( mLayer[ n ] )
+				continue;
+			mLayer[ n ] = new LayerData;
+			mLayer[ n ]->fillLight( FullSkyLight );
+		}
+	}
+
+	void Chunk::compact()
+	{
+		for( int n = 0 ; n < NumLayer ; ++n )
+		{
+			if ( mLayer[ n ] )
+				mLayer[ n ]->compact();
+		}
+
+		int top = getTopLayerIndex();
+		for( int n = 0 ; n < NumLayer ; ++n )
+		{
+			LayerData* layer = mLayer[ n ];
+			if ( layer && layer->isEmpty( ( n > top ) ? FullSkyLight : 0 ) )
+			{
+				delete layer;
+				mLayer[ n ] = NULL;
+			}
+		}
+	}
+
+	int Chunk::getMemoryUsage() const
+	{
+		int result = sizeof( *this );
+		for( int n = 0 ; n < NumLayer ; ++n )
+		{
+			if ( mLayer[ n ] )
+				result += mLayer[ n ]->getMemoryUsage();
+		}
+		return result;
 	}
 
 	void Chunk::render( BlockRenderer& renderer )
 	{
 		renderer.setBasePos( Vec3i( mPos.x * ChunkSize , mPos.y * ChunkSize , 0 ) );
 
+		BlockId blockMap[ LayerData::NumCell ];
 		for( int n = 0 ; n < NumLayer ; ++n )
 		{
 			LayerData* layer = mLayer[ n ];
 			if ( !layer )
 				continue;
 
+			PaletteBlockArray const& blocks = layer->getBlocks();
+			if ( blocks.isUniform() && blocks.getUniformId() == BLOCK_NULL )
+				continue;
+			blocks.unpack( blockMap );
+
 			int zOff = n * LayerSize;
 			for( int i = 0 ; i < ChunkSize ; ++i )
 			{
 				for ( int j = 0 ; j < ChunkSize ; ++j )
 				{
-					BlockId* pBlockMap = &layer->blockMap[i][j][0];
+					BlockId* pBlockMap = &blockMap[ LayerData::toIndex( i , j , 0 ) ];
 					for( int k = 0 ; k < LayerSize ; ++k )
 					{
 						BlockId id = pBlockMap[k];
@@ -111,6 +346,30 @@ namespace Cube
 	}
 
 
+	ChunkProvider::ChunkProvider()
+	{
+		mDefaultGenerator.height = 64;
+		mGenerator     = &mDefaultGenerator;
+		mListener      = NULL;
+		mStorage       = NULL;
+		mLightEngine   = NULL;
+		mLoader        = NULL;
+		mUseTick       = 0;
+		mMaxResidentNum = 256;
+		mViewRadius    = 2;
+		mViewCenter.x  = 0;
+		mViewCenter.y  = 0;
+		mbRequestDirty = true;
+	}
+
+	ChunkProvider::~ChunkProvider()
+	{
+		stopAsyncLoad();
+		saveAllChunks();
+		for( ChunkMap::iterator iter = mMap.begin() ; iter != mMap.end() ; ++iter )
+			delete iter->second;
+	}
+
 	Chunk* ChunkProvider::getChunk( int x , int y )
 	{
 		ChunkPos cPos;
@@ -125,24 +384,245 @@ namespace Cube
 		ChunkMap::iterator iter = mMap.find( value );
 		if ( iter == mMap.end() )
 		{
-			Chunk* chunk = new Chunk( pos );
+			if ( mLoader )
+				return NULL;
 
-			FlatPlaneGenerater gen;
-			gen.height = 64;
-			Random rand;
-			rand.setSeed( 0 );
-			gen.generate( *chunk , rand );
+			Chunk* chunk = ( mStorage ) ? mStorage->loadChunk( pos ) : NULL;
+			if ( !chunk )
+			{
+				chunk = new Chunk( pos );
+				Random rand;
+				rand.setSeed( value );
+				mGenerator->generate( *chunk , rand );
+				LightEngine::lightChunk( *chunk );
+				chunk->compact();
+			}
 
-			mMap.insert( std::make_pair( value , chunk ) );
+			chunk->mLastUseTick = mUseTick;
+			addChunk( chunk , NULL );
 			return chunk;
 		}
+		iter->second->mLastUseTick = mUseTick;
 		return iter->second;
 	}
 
+	void ChunkProvider::setGenerator( TerrainGenerator& generator )
+	{
+		assert( mLoader == NULL );
+		mGenerator = &generator;
+	}
+
+	void ChunkProvider::setLoadListener( IChunkLoadListener* listener )
+	{
+		assert( mLoader == NULL );
+		mListener = listener;
+	}
+
+	void ChunkProvider::setStorage( ChunkStorage* storage )
+	{
+		assert( mLoader == NULL );
+		mStorage = storage;
+	}
+
+	void ChunkProvider::saveAllChunks()
+	{
+		if ( !mStorage )
+			return;
+
+		for( ChunkMap::iterator iter = mMap.begin() ; iter != mMap.end() ; ++iter )
+		{
+			Chunk* chunk = iter->second;
+			if ( !chunk->isModified() )
+				continue;
+			mStorage->saveChunk( *chunk );
+			chunk->mbModified = false;
+		}
+	}
+
+	bool ChunkProvider::startAsyncLoad( int numWorker )
+	{
+		if ( mLoader )
+			return true;
+
+		mLoader = new ChunkLoader( *mGenerator , mStorage , mListener );
+		if ( !mLoader->start( numWorker ) )
+		{
+			delete mLoader;
+			mLoader = NULL;
+			return false;
+		}
+		mbRequestDirty = true;
+		return true;
+	}
+
+	void ChunkProvider::stopAsyncLoad()
+	{
+		if ( !mLoader )
+			return;
+
+		//pending saves are finished in stop
+		mLoader->stop();
+		delete mLoader;
+		mLoader = NULL;
+		mLoadingMap.clear();
+		mSavingMap.clear();
+	}
+
+	void ChunkProvider::setViewRadius( int radius )
+	{
+		if ( radius < 0 )
+			radius = 0;
+		if ( mViewRadius == radius )
+			return;
+		mViewRadius = radius;
+		mbRequestDirty = true;
+	}
+
+	void ChunkProvider::update( Vec3f const& viewPos )
+	{
+		++mUseTick;
+
+		ChunkPos center;
+		center.setBlockPos( Math::floor( viewPos.x ) , Math::floor( viewPos.y ) );
+		if ( center.x != mViewCenter.x || center.y != mViewCenter.y )
+		{
+			mViewCenter = center;
+			mbRequestDirty = true;
+		}
+
+		if ( mLoader )
+		{
+			for( ChunkLoader::Result* result = mLoader->fetchResults(); result ; )
+			{
+				ChunkLoader::Result* next = result->next;
+
+				uint64 value = result->pos.hash_value();
+				Chunk* chunk = result->chunk;
+				if ( chunk == NULL )
+				{
+					//saved , the chunk can be loaded again
+					mSavingMap.erase( value );
+					mbRequestDirty = true;
+					mLoader->releaseResult( result , true );
+				}
+				else if ( isInViewRange( result->pos , mViewRadius ) && mMap.find( value ) == mMap.end() )
+				{
+					mLoadingMap.erase( value );
+					chunk->mLastUseTick = mUseTick;
+					addChunk( chunk , result->renderData );
+					result->renderData = NULL;
+					mLoader->releaseResult( result , false );
+				}
+				else
+				{
+					mLoadingMap.erase( value );
+					mLoader->releaseResult( result , true );
+				}
+				result = next;
+			}
+		}
+
+		if ( (int)mMap.size() > mMaxResidentNum )
+			evictColdChunks();
+
+		if ( mLoader && mbRequestDirty )
+			updateRequests();
+	}
+
+	void ChunkProvider::addChunk( Chunk* chunk , ChunkRenderData* data )
+	{
+		mMap.insert( std::make_pair( chunk->getPos().hash_value() , chunk ) );
+		if ( mLightEngine )
+			mLightEngine->stitchChunk( *chunk );
+		if ( mListener )
+			mListener->onChunkLoad( *chunk , data );
+	}
+
+	void ChunkProvider::evictColdChunks()
+	{
+		typedef std::pair< uint32 , Chunk* > ColdChunk;
+		std::vector< ColdChunk , TFrameStlAllocator< ColdChunk > > coldList( ( TFrameStlAllocator< ColdChunk >( Global::getFrameAllocator() ) ) );
+		coldList.reserve( mMap.size() );
+		for( ChunkMap::iterator iter = mMap.begin() ; iter != mMap.end() ; ++iter )
+		{
+			Chunk* chunk = iter->second;
+			//keep one more ring , so chunks at edge don't load and unload again
+			if ( isInViewRange( chunk->getPos() , mViewRadius + 1 ) )
+				continue;
+			coldList.push_back( ColdChunk( chunk->mLastUseTick , chunk ) );
+		}
+
+		int numEvict = std::min( (int)mMap.size() - mMaxResidentNum , (int)coldList.size() );
+		if ( numEvict <= 0 )
+			return;
+
+		std::nth_element( coldList.begin() , coldList.begin() + numEvict , coldList.end() );
+		for( int i = 0 ; i < numEvict ; ++i )
+			unloadChunk( coldList[i].second );
+	}
+
+	void ChunkProvider::unloadChunk( Chunk* chunk )
+	{
+		uint64 value = chunk->getPos().hash_value();
+		mMap.erase( value );
+		if ( mListener )
+			mListener->onChunkUnload( *chunk );
+
+		if ( mStorage && chunk->isModified() )
+		{
+			if ( mLoader )
+			{
+				mSavingMap.insert( std::make_pair( value , chunk->getPos() ) );
+				mLoader->addSave( chunk );
+				return;
+			}
+			mStorage->saveChunk( *chunk );
+		}
+		delete chunk;
+	}
+
+	void ChunkProvider::updateRequests()
+	{
+		mbRequestDirty = false;
+
+		mCancelList.clear();
+		mLoader->cancelRequests( mCancelList );
+		for( size_t i = 0 ; i < mCancelList.size() ; ++i )
+			mLoadingMap.erase( mCancelList[i].hash_value() );
+
+		for( int j = -mViewRadius ; j <= mViewRadius ; ++j )
+		{
+			for( int i = -mViewRadius ; i <= mViewRadius ; ++i )
+			{
+				ChunkPos pos;
+				pos.x = mViewCenter.x + i;
+				pos.y = mViewCenter.y + j;
+
+				uint64 value = pos.hash_value();
+				if ( mMap.find( value ) != mMap.end() || 
+					 mLoadingMap.find( value ) != mLoadingMap.end() ||
+					 mSavingMap.find( value ) != mSavingMap.end() )
+					continue;
+
+				mLoadingMap.insert( std::make_pair( value , pos ) );
+				mLoader->addRequest( pos , i * i + j * j );
+			}
+		}
+		mLoader->commitRequests();
+	}
+
 
 	World::World()
 	{
 		mChunkProvider = new ChunkProvider;
+		mLightEngine   = new LightEngine( *mChunkProvider );
+		mChunkProvider->setLightEngine( mLightEngine );
+	}
+
+	World::~World()
+	{
+		delete mChunkProvider;
+		delete mLightEngine;
 	}
 
 	Cube::BlockId World::getBlockId( int bx , int by , int bz )
@@ -162,12 +642,29 @@ namespace Cube
 	}
 
 
+	int World::getSkyLight( int bx , int by , int bz )
+	{
+		Chunk* chunk = getChunk( bx , by );
+		if ( !chunk )
+			return 0;
+		return chunk->getLight( bx , by , bz ) >> 4;
+	}
+
+	int World::getBlockLight( int bx , int by , int bz )
+	{
+		Chunk* chunk = getChunk( bx , by );
+		if ( !chunk )
+			return 0;
+		return chunk->getLight( bx , by , bz ) & 0xf;
+	}
+
 	void World::setBlock( int bx , int by , int bz , BlockId id )
 	{
 		Chunk* chunk = getChunk( bx , by );
 		if ( !chunk )
 			return;
 		chunk->setBlockId( bx , by , bz , id );
+		chunk->markModified();
 	}
 
 	bool World::isOpaqueBlock( int x , int y , int z )
@@ -318,7 +815,15 @@ namespace Cube
 
 	void World::setBlockNotify( int bx , int by , int bz , BlockId id )
 	{
+		Chunk* chunk = getChunk( bx , by );
+		if ( !chunk )
+			return;
+		BlockId oldId = chunk->getBlockId( bx , by , bz );
+		if ( oldId == id )
+			return;
+
 		setBlock( bx , by , bz , id );
+		mLightEngine->onBlockChanged( bx , by , bz , oldId , id );
 		notifyBlockModified( bx , by , bz );
 	}
 
@@ -360,25 +865,4 @@ namespace Cube
 		return true;
 	}
 
-
-	class PerlinNoiseFun
-	{
-	
-	};
-
-	class OctaveNoiseFun
-	{
-	public:
-		void generate( float* );
-
-
-
-
-
-
-
-
-
-	};
-
 }//namespace Cube
\ No newline at end of file
@@ -3,14 +3,21 @@
 
 #include "CubeBase.h"
 #include "CubeRandom.h"
+#include "CubePaletteBlockArray.h"
 
 #include <unordered_map>
+#include <vector>
 
 namespace Cube
 {
 	class IWorldEventListener;
+	class IChunkLoadListener;
+	struct ChunkRenderData;
 	class BlockRenderer;
 	class Chunk;
+	class ChunkLoader;
+	class ChunkStorage;
+	class LightEngine;
 
 	typedef uint8 MetaType;
 
@@ -52,6 +59,7 @@ namespace Cube
 	{
 	public:
 		Chunk( ChunkPos const& pos );
+		~Chunk();
 
 		BlockId  getBlockId( int x , int y , int z );
 		void     setBlockId( int x , int y , int z , BlockId id );
@@ -59,8 +67,22 @@ namespace Cube
 		MetaType getBlockMeta( int x , int y , int z );
 		void     setBlockMeta( int x , int y , int z , MetaType meta );
 
+		//sky light in high 4 bits , block light in low 4 bits.
+		//a missing layer above all blocks is full sky light , others are dark
+		uint8    getLight( int x , int y , int z );
+		void     setLight( int x , int y , int z , uint8 value );
+
 		ChunkPos const& getPos(){ return mPos; }
 
+		// repack layers and free empty layers , called after the chunk is generated
+		void     compact();
+		int      getMemoryUsage() const;
+
+		// set when a block is changed after the chunk is loaded , only
+		// modified chunks are saved
+		void     markModified(){ mbModified = true; }
+		bool     isModified() const { return mbModified; }
+
 		static unsigned const LayerBit  = 5;
 		static unsigned const LayerSize = 1 << LayerBit;
 		static unsigned const LayerMask = ( 1 << LayerBit ) - 1;
@@ -68,42 +90,107 @@ namespace Cube
 		static unsigned const NumLayer = ChunkBlockMaxHeight >> LayerBit;
 
 
-		struct LayerData
+		//  A 16 x 16 x 32 section. Block ids are palette packed , meta and light
+		//  arrays are only allocated when a cell has a value different from
+		//  the fill value.
+		class LayerData
 		{
-			LayerData()
-			{
-				std::fill_n( &blockMap[0][0][0] , ChunkSize * ChunkSize * LayerSize , 0 );
-				std::fill_n( &lightMap[0][0][0] , ChunkSize * ChunkSize * LayerSize , 0 );
-				std::fill_n( &meta[0][0][0] , ChunkSize * ChunkSize * LayerSize / 2 , 0 );
-			}
-			BlockId  blockMap[ ChunkSize ][ ChunkSize ][ LayerSize ];
-			uint8    meta[ ChunkSize ][ ChunkSize ][ LayerSize / 2 ];
-			uint8    lightMap[ ChunkSize ][ ChunkSize ][ LayerSize ];
+		public:
+			static int const NumCell = ChunkSize * ChunkSize * LayerSize;
+
+			LayerData();
+			~LayerData();
+
+			static int toIndex( int x , int y , int z ){ return ( ( x & ChunkMask ) * ChunkSize + ( y & ChunkMask ) ) * LayerSize + ( z & LayerMask ); }
+
+			BlockId  getBlockId( int x , int y , int z ) const { return mBlocks.get( toIndex( x , y , z ) ); }
+			void     setBlockId( int x , int y , int z , BlockId id ){ mBlocks.set( toIndex( x , y , z ) , id ); }
+
+			MetaType getBlockMeta( int x , int y , int z ) const;
+			void     setBlockMeta( int x , int y , int z , MetaType meta );
+
+			uint8    getLight( int x , int y , int z ) const { return ( mLight ) ? mLight[ toIndex( x , y , z ) ] : mLightFill; }
+			void     setLight( int x , int y , int z , uint8 value );
+			void     fillLight( uint8 value );
+
+			PaletteBlockArray&       getBlocks()       { return mBlocks; }
+			PaletteBlockArray const& getBlocks() const { return mBlocks; }
+
+			// raw arrays for save : meta is 4 bits per cell , light is 1 byte per cell
+			void     getMetaData( uint8* dest ) const;
+			void     setMetaData( uint8 const* src );
+			void     getLightData( uint8* dest ) const;
+			void     setLightData( uint8 const* src );
+
+			// no block , meta or light data and all light is lightFill
+			bool     isEmpty( uint8 lightFill ) const;
+			bool     isAir() const { return mBlocks.isUniform() && mBlocks.getUniformId() == BLOCK_NULL; }
+			void     compact();
+			int      getMemoryUsage() const;
+
+		private:
+			PaletteBlockArray mBlocks;
+			uint8*            mMeta;
+			uint8*            mLight;
+			uint8             mLightFill;
+
+			LayerData( LayerData const& );
+			LayerData& operator = ( LayerData const& );
 		};
 
+		static uint8 const FullSkyLight = 0xf0;
+
 		LayerData* getLayer( int z )
 		{
 			return mLayer[ z >> LayerBit ];
 		}
+		// highest layer with any block , -1 if chunk is empty
+		int        getTopLayerIndex() const;
+		uint8      getMissingLayerLight( int idxLayer ) const { return ( idxLayer > getTopLayerIndex() ) ? FullSkyLight : 0; }
+		LayerData* createLayer( int idxLayer );
+		void       fillSkyLayers( int idxLayer );
 
 		void render( BlockRenderer& renderer );
 		LayerData* mLayer[ NumLayer ];
 		ChunkPos   mPos;
+		bool       mbModified;
+		uint32     mLastUseTick;
 	};
 
 
+	//  Access of one chunk without world , blocks out of the chunk are empty.
+	//  Used on the loader thread.
 	class SingleChunkAccess : public IBlockAccess
 	{
 	public:
+		SingleChunkAccess( Chunk& chunk ):mChunk( chunk ){}
 
-		virtual BlockId getBlockId( int x , int y , int z ){ return mChunk.getBlockId( x , y , z ); }
+		virtual BlockId getBlockId( int x , int y , int z )
+		{ 
+			if ( !isInChunk( x , y ) )
+				return BLOCK_NULL;
+			return mChunk.getBlockId( x , y , z ); 
+		}
+		virtual MetaType getBlockMeta( int x , int y , int z )
+		{
+			if ( !isInChunk( x , y ) )
+				return 0;
+			return mChunk.getBlockMeta( x , y , z );
+		}
 		virtual bool    isOpaqueBlock( int x , int y , int z )
 		{ 
-			BlockId id = mChunk.getBlockId( x , y , z );
+			if ( z < 0 )
+				return true;
+			BlockId id = getBlockId( x , y , z );
 			if ( id == BLOCK_NULL )
 				return false;
 			return true;
 		}
+		bool isInChunk( int x , int y )
+		{
+			ChunkPos const& pos = mChunk.getPos();
+			return ( x >> ChunkBit ) == pos.x && ( y >> ChunkBit ) == pos.y;
+		}
 		Chunk& mChunk;
 	};
 
@@ -126,14 +213,79 @@ namespace Cube
 	};
 
 
+	//  Without async load , getChunk loads or generates the chunk on the
+	//  calling thread. With async load , chunks in view radius are loaded by
+	//  ChunkLoader workers and added in update ; getChunk returns NULL if the
+	//  chunk is not loaded yet.
+	//  When resident chunks are more than the limit , the least recently used
+	//  chunks out of view are unloaded and saved to storage if modified.
 	class ChunkProvider
 	{
 	public:
+		ChunkProvider();
+		~ChunkProvider();
+
 		Chunk* getChunk( int x , int y );
 
 		Chunk* getChunk( ChunkPos const& pos );
+		// only return loaded chunk , never load
+		Chunk* findChunk( ChunkPos const& pos )
+		{
+			ChunkMap::iterator iter = mMap.find( pos.hash_value() );
+			return ( iter != mMap.end() ) ? iter->second : NULL;
+		}
+
+		// light of a new chunk is merged with neighbors by the engine
+		void   setLightEngine( LightEngine* engine ){ mLightEngine = engine; }
+		// provider doesn't own the generator
+		void   setGenerator( TerrainGenerator& generator );
+		void   setLoadListener( IChunkLoadListener* listener );
+		// provider doesn't own the storage
+		void   setStorage( ChunkStorage* storage );
+		void   setMaxResidentNum( int num ){ mMaxResidentNum = num; }
+		void   saveAllChunks();
+
+		bool   startAsyncLoad( int numWorker );
+		void   stopAsyncLoad();
+		bool   isAsyncLoad() const { return mLoader != NULL; }
+
+		void   setViewRadius( int radius );
+		int    getViewRadius() const { return mViewRadius; }
+		void   update( Vec3f const& viewPos );
+
 		typedef std::tr1::unordered_map< uint64 , Chunk* > ChunkMap;
 		ChunkMap mMap;
+
+	private:
+		void   addChunk( Chunk* chunk , ChunkRenderData* data );
+		void   evictColdChunks();
+		void   unloadChunk( Chunk* chunk );
+		void   updateRequests();
+		bool   isInViewRange( ChunkPos const& pos , int radius ) const
+		{
+			int dx = pos.x - mViewCenter.x;
+			int dy = pos.y - mViewCenter.y;
+			return -radius <= dx && dx <= radius && -radius <= dy && dy <= radius;
+		}
+
+		typedef std::tr1::unordered_map< uint64 , ChunkPos > LoadingMap;
+
+		FlatPlaneGenerater  mDefaultGenerator;
+		TerrainGenerator*   mGenerator;
+		IChunkLoadListener* mListener;
+		ChunkStorage*       mStorage;
+		LightEngine*        mLightEngine;
+		ChunkLoader*        mLoader;
+		LoadingMap          mLoadingMap;
+		// chunks given to loader for saving
+		LoadingMap          mSavingMap;
+		uint32              mUseTick;
+		int                 mMaxResidentNum;
+		ChunkPos            mViewCenter;
+		int                 mViewRadius;
+		bool                mbRequestDirty;
+		// reused by updateRequests
+		std::vector< ChunkPos > mCancelList;
 	};
 
 
@@ -149,11 +301,15 @@ namespace Cube
 	public:
 
 		World();
+		~World();
 
 		BlockId  getBlockId( int bx , int by , int bz ) final;
 		MetaType getBlockMeta( int bx , int by , int bz ) final;
 		bool     isOpaqueBlock( int x , int y , int z ) final;
 
+		int      getSkyLight( int bx , int by , int bz );
+		int      getBlockLight( int bx , int by , int bz );
+
 		void     setBlock( int bx , int by , int bz , BlockId id );
 		void     setBlockNotify( int bx , int by , int bz , BlockId id );
 
@@ -163,6 +319,10 @@ namespace Cube
 			return mChunkProvider->getChunk( cPos ); 
 		}
 		Chunk*  getChunk( ChunkPos const& pos ){ return mChunkProvider->getChunk( pos ); }
+		ChunkProvider& getChunkProvider(){ return *mChunkProvider; }
+		LightEngine&   getLightEngine(){ return *mLightEngine; }
+
+		void    update( Vec3f const& viewPos ){ mChunkProvider->update( viewPos ); }
 
 
 		BlockId rayBlockTest( Vec3f const& pos , Vec3f const& dir , float maxDist ,  BlockPosInfo* info );
@@ -176,6 +336,7 @@ namespace Cube
 		typedef std::list< IWorldEventListener* > ListenerList;
 		ListenerList   mListeners;
 		ChunkProvider* mChunkProvider;
+		LightEngine*   mLightEngine;
 		Random         mRandom;
 	};
 
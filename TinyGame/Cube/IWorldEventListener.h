@@ -12,6 +12,20 @@ public:
 	virtual void onModifyBlock( int bx , int by , int bz ) = 0;
 };
 
+class Chunk;
+struct ChunkRenderData;
+
+class IChunkLoadListener
+{
+public:
+	//call on loader thread , chunk is not in world yet
+	virtual ChunkRenderData* buildRenderData( Chunk& chunk ) = 0;
+	virtual void releaseRenderData( ChunkRenderData* data ) = 0;
+	//call on main thread , listener takes the data ( data may be NULL )
+	virtual void onChunkLoad( Chunk& chunk , ChunkRenderData* data ) = 0;
+	virtual void onChunkUnload( Chunk& chunk ) = 0;
+};
+
 }//namespace Cube
 
 #endif // IWorldEventListener_h__
\ No newline at end of file
@@ -0,0 +1,885 @@
+#include "TinyGamePCH.h"
+#include "G2DGeometry.h"
+
+#include "Thread.h"
+
+#include <algorithm>
+#include <limits>
+#include <cfloat>
+
+namespace G2D
+{
+	//  Exact arithmetic of Shewchuk's robust predicates :
+	//  an expansion is a sum of doubles without overlapping bits , sorted by
+	//  increasing magnitude , so its sign is the sign of the last component.
+	static double const Epsilon  = DBL_EPSILON / 2;
+	static double const Splitter = 134217729.0; // 2^27 + 1
+	static double const OrientErrorBound = ( 3.0 + 16.0 * Epsilon ) * Epsilon;
+
+	static inline void TwoSum( double a , double b , double& x , double& y )
+	{
+		x = a + b;
+		double bv = x - a;
+		double av = x - bv;
+		y = ( a - av ) + ( b - bv );
+	}
+
+	static inline void TwoDiff( double a , double b , double& x , double& y )
+	{
+		x = a - b;
+		double bv = a - x;
+		double av = x + bv;
+		y = ( a - av ) + ( bv - b );
+	}
+
+	static inline void Split( double a , double& hi , double& lo )
+	{
+		double c = Splitter * a;
+		double big = c - a;
+		hi = c - big;
+		lo = a - hi;
+	}
+
+	static inline void TwoProduct( double a , double b , double& x , double& y )
+	{
+		x = a * b;
+		double ahi , alo , bhi , blo;
+		Split( a , ahi , alo );
+		Split( b , bhi , blo );
+		double err1 = x - ahi * bhi;
+		double err2 = err1 - alo * bhi;
+		double err3 = err2 - ahi * blo;
+		y = alo * blo - err3;
+	}
+
+	//e += b , can work in place
+	static int GrowExpansion( int num , double e[] , double b )
+	{
+		double q = b;
+		int n = 0;
+		for( int i = 0 ; i < num ; ++i )
+		{
+			double h;
+			TwoSum( q , e[i] , q , h );
+			if ( h != 0 )
+				e[ n++ ] = h;
+		}
+		if ( q != 0 || n == 0 )
+			e[ n++ ] = q;
+		return n;
+	}
+
+	static double OrientExact( double ax , double ay , double bx , double by , double cx , double cy )
+	{
+		double acx[2] , acy[2] , bcx[2] , bcy[2];
+		TwoDiff( ax , cx , acx[1] , acx[0] );
+		TwoDiff( ay , cy , acy[1] , acy[0] );
+		TwoDiff( bx , cx , bcx[1] , bcx[0] );
+		TwoDiff( by , cy , bcy[1] , bcy[0] );
+
+		double e[ 40 ];
+		int num = 0;
+		for( int i = 0 ; i < 2 ; ++i )
+		{
+			for( int j = 0 ; j < 2 ; ++j )
+			{
+				double x , y;
+				TwoProduct( acx[i] , bcy[j] , x , y );
+				num = GrowExpansion( num , e , y );
+				num = GrowExpansion( num , e , x );
+				TwoProduct( -acy[i] , bcx[j] , x , y );
+				num = GrowExpansion( num , e , y );
+				num = GrowExpansion( num , e , x );
+			}
+		}
+		return e[ num - 1 ];
+	}
+
+	double Orient( Vec2f const& a , Vec2f const& b , Vec2f const& c )
+	{
+		double detLeft  = ( double( a.x ) - c.x ) * ( double( b.y ) - c.y );
+		double detRight = ( double( a.y ) - c.y ) * ( double( b.x ) - c.x );
+		double det = detLeft - detRight;
+
+		double detSum;
+		if ( detLeft > 0 )
+		{
+			if ( detRight <= 0 )
+				return det;
+			detSum = detLeft + detRight;
+		}
+		else if ( detLeft < 0 )
+		{
+			if ( detRight >= 0 )
+				return det;
+			detSum = -detLeft - detRight;
+		}
+		else
+		{
+			return det;
+		}
+
+		double bound = OrientErrorBound * detSum;
+		if ( det >= bound || -det >= bound )
+			return det;
+
+		return OrientExact( a.x , a.y , b.x , b.y , c.x , c.y );
+	}
+
+	float CalcArea( Vec2f const v[] , int num )
+	{
+		float area = 0;
+		for( int i = 0 , prev = num - 1 ; i < num ; prev = i++ )
+			area += v[ prev ].cross( v[i] );
+		return 0.5f * area;
+	}
+
+	bool TestInPolygon( Vec2f const v[] , int num , Vec2f const& p )
+	{
+		bool result = false;
+		for( int i = 0 , prev = num - 1 ; i < num ; prev = i++ )
+		{
+			Vec2f const& a = v[ prev ];
+			Vec2f const& b = v[i];
+			if ( a.y <= p.y )
+			{
+				if ( b.y > p.y && Orient( a , b , p ) > 0 )
+					result = !result;
+			}
+			else
+			{
+				if ( b.y <= p.y && Orient( a , b , p ) < 0 )
+					result = !result;
+			}
+		}
+		return result;
+	}
+
+
+	struct QHullSolver::Task
+	{
+		QHullSolver solver;
+		int*        pIdx;
+		int         nV;
+		int         i1;
+		int         i2;
+		int*        out;
+		int         numOut;
+
+		unsigned run()
+		{
+			solver.mOut = out;
+			*solver.mOut++ = i1;
+			if ( nV )
+				solver.constuct_R( pIdx , nV , i1 , i2 );
+			numOut = int( solver.mOut - out );
+			return 0;
+		}
+	};
+
+	QHullSolver::QHullSolver()
+	{
+		mV   = NULL;
+		mOut = NULL;
+	}
+
+	void QHullSolver::findExtremePoints( Vec2f const v[] , int numV , int idxQuad[5] )
+	{
+		float xP[2] = { v[0].x , v[0].x };
+		float yP[2] = { v[0].y , v[0].y };
+		int xI[2] = { 0 , 0 };
+		int yI[2] = { 0 , 0 };
+		for( int i = 1 ; i < numV ; ++i )
+		{
+			float x = v[i].x;
+			float y = v[i].y;
+			if ( xP[0] > x ){ xI[0] = i; xP[0] = x; }
+			else if ( xP[1] < x ){ xI[1] = i; xP[1] = x; }
+			if ( yP[0] > y ){ yI[0] = i; yP[0] = y; }
+			else if ( yP[1] < y ){ yI[1] = i; yP[1] = y; }
+		}
+
+		//an extreme point can be two corners , keep each one once and fill the rest
+		//with the first corner , so regions after the distinct corners are empty
+		int corner[4] = { xI[0] , yI[0] , xI[1] , yI[1] };
+		int num = 0;
+		for( int k = 0 ; k < 4 ; ++k )
+		{
+			if ( std::find( idxQuad , idxQuad + num , corner[k] ) == idxQuad + num )
+				idxQuad[ num++ ] = corner[k];
+		}
+		for( int k = num ; k < 5 ; ++k )
+			idxQuad[k] = idxQuad[0];
+	}
+
+	int QHullSolver::solve( Vec2f const v[] , int numV , int outIndex[] )
+	{
+		if ( (int)mIdxBuffer.size() < numV )
+			mIdxBuffer.resize( numV );
+		return solve( v , numV , outIndex , numV ? &mIdxBuffer[0] : NULL );
+	}
+
+	int QHullSolver::solve( Vec2f const v[] , int numV , int outIndex[] , int workIndex[] )
+	{
+		if ( numV <= 3 )
+		{
+			for( int i = 0 ; i < numV ; ++i )
+				outIndex[i] = i;
+			return numV;
+		}
+
+		int idxQuad[5];
+		findExtremePoints( v , numV , idxQuad );
+
+		int* pIdx = workIndex;
+		int nV = 0;
+		for( int i = 0 ; i < numV ; ++i )
+		{
+			if ( i != idxQuad[0] && i != idxQuad[1] && i != idxQuad[2] && i != idxQuad[3] )
+			{
+				pIdx[ nV ] = i;
+				++nV;
+			}
+		}
+
+		mV   = v;
+		mOut = outIndex;
+		for( int i = 0 ; i < 4 ; ++i )
+		{
+			int i1 = idxQuad[i];
+			int i2 = idxQuad[i+1];
+			if ( i1 != i2 )
+			{
+				*mOut++ = i1;
+				if ( nV )
+				{
+					int num = constuct_R( pIdx , nV , i1 , i2 );
+					pIdx += num;
+					nV -= num;
+				}
+			}
+		}
+		return int( mOut - outIndex );
+	}
+
+	//region outside the extreme point quad of each point , -1 if inside
+	struct QHullSolver::RegionTask
+	{
+		Vec2f const* v;
+		int const*   idxQuad;
+		int          start;
+		int          end;
+		int*         outRegion;
+		int          count[4];
+
+		unsigned run()
+		{
+			std::fill_n( count , 4 , 0 );
+			for( int i = start ; i < end ; ++i )
+			{
+				int region = -1;
+				if ( i != idxQuad[0] && i != idxQuad[1] && i != idxQuad[2] && i != idxQuad[3] )
+				{
+					for( int k = 0 ; k < 4 ; ++k )
+					{
+						int i1 = idxQuad[k];
+						int i2 = idxQuad[k+1];
+						if ( i1 != i2 && Orient( v[i2] , v[i1] , v[i] ) > 0 )
+						{
+							region = k;
+							break;
+						}
+					}
+				}
+				outRegion[i] = region;
+				if ( region != -1 )
+					++count[ region ];
+			}
+			return 0;
+		}
+	};
+
+	int QHullSolver::solveParallel( Vec2f const v[] , int numV , int outIndex[] , int workIndex[] )
+	{
+		if ( numV < ParallelMinPointNum )
+			return solve( v , numV , outIndex , workIndex );
+
+		int idxQuad[5];
+		findExtremePoints( v , numV , idxQuad );
+
+		//outIndex keeps the regions , it is free until the hull tasks run
+		RegionTask regionTasks[ NumWorker ];
+		{
+			MemberFunThread< RegionTask > workers[ NumWorker ];
+			for( int n = 0 ; n < NumWorker ; ++n )
+			{
+				RegionTask& task = regionTasks[n];
+				task.v         = v;
+				task.idxQuad   = idxQuad;
+				task.start     = int( (long long)numV * n / NumWorker );
+				task.end       = int( (long long)numV * ( n + 1 ) / NumWorker );
+				task.outRegion = outIndex;
+				if ( n )
+				{
+					workers[n].init( &task , &RegionTask::run );
+					workers[n].start();
+				}
+			}
+			regionTasks[0].run();
+			for( int n = 1 ; n < NumWorker ; ++n )
+				workers[n].join();
+		}
+
+		int count[4] = { 0 , 0 , 0 , 0 };
+		for( int n = 0 ; n < NumWorker ; ++n )
+		{
+			for( int k = 0 ; k < 4 ; ++k )
+				count[k] += regionTasks[n].count[k];
+		}
+
+		int start[4];
+		int pos[4];
+		start[0] = pos[0] = 0;
+		for( int k = 1 ; k < 4 ; ++k )
+			start[k] = pos[k] = start[k-1] + count[k-1];
+		for( int i = 0 ; i < numV ; ++i )
+		{
+			if ( outIndex[i] != -1 )
+				workIndex[ pos[ outIndex[i] ]++ ] = i;
+		}
+
+		//output of region k starts after the outputs of previous regions ,
+		//each of them also writes its corner and corners are distinct
+		Task tasks[4];
+		for( int k = 0 ; k < 4 ; ++k )
+		{
+			Task& task = tasks[k];
+			task.solver.mV = v;
+			task.pIdx   = workIndex + start[k];
+			task.nV     = count[k];
+			task.i1     = idxQuad[k];
+			task.i2     = idxQuad[k+1];
+			task.out    = outIndex + start[k] + k;
+			task.numOut = 0;
+		}
+
+		{
+			MemberFunThread< Task > workers[4];
+			for( int k = 1 ; k < 4 ; ++k )
+			{
+				if ( tasks[k].i1 == tasks[k].i2 )
+					continue;
+				workers[k].init( &tasks[k] , &Task::run );
+				workers[k].start();
+			}
+			if ( tasks[0].i1 != tasks[0].i2 )
+				tasks[0].run();
+			for( int k = 1 ; k < 4 ; ++k )
+			{
+				if ( tasks[k].i1 != tasks[k].i2 )
+					workers[k].join();
+			}
+		}
+
+		int* out = outIndex;
+		for( int k = 0 ; k < 4 ; ++k )
+			out = std::copy( tasks[k].out , tasks[k].out + tasks[k].numOut , out );
+		return int( out - outIndex );
+	}
+
+	int QHullSolver::constuct_R( int pIdx[] , int nV , int i1 , int i2 )
+	{
+		assert( nV > 0 );
+
+		int num = clip( pIdx , nV , i1 , i2 );
+
+		switch( num )
+		{
+		case 0: return 0;
+		case 1: *mOut++ = pIdx[0]; return 1;
+		default:
+			{
+				int iMax = pIdx[0];
+				int n = num - 1;
+				int* pTemp = pIdx + 1;
+				int temp = constuct_R( pTemp  , n , i1 , iMax );
+				n -= temp;
+				*mOut++ = iMax;
+				if ( n )
+				{
+					pTemp += temp;
+					constuct_R( pTemp  , n , iMax , i2 );
+				}
+			}
+		}
+		return num;
+	}
+
+	//move points outside i1 -> i2 to the front , the farthest one first
+	int QHullSolver::clip( int pIdx[] , int nV , int i1 , int i2 )
+	{
+		assert( i1 != i2 );
+
+		Vec2f const* v = mV;
+		Vec2f const& v1 = v[i1];
+		Vec2f const& v2 = v[i2];
+
+		double valMax = 0;
+		int*   itMax = 0;
+
+		int*  iter = pIdx;
+		int*  itEnd = pIdx + nV;
+		while( iter != itEnd )
+		{
+			int idx = *iter;
+			assert( idx != i1 && idx != i2 );
+			double val = Orient( v2 , v1 , v[ idx ] );
+
+			if ( val <= 0 )
+			{
+				--itEnd;
+				std::swap( *iter , *itEnd );
+			}
+			else
+			{
+				if ( val > valMax )
+				{
+					itMax = iter;
+					valMax = val;
+				}
+				++iter;
+			}
+		}
+		if ( itMax && itMax != pIdx )
+			std::swap( *itMax , *pIdx );
+
+		return int( iter - pIdx );
+	}
+
+
+	bool SATSolver::test( Vec2f const& pA , Vec2f const vA[] , int nA , Vec2f const& pB , float radius )
+	{
+		Vec2f posRel = pA - pB;
+		float rangeB[2] = { -radius , radius };
+		float depthMin = std::numeric_limits< float >::max();
+		for( int i = 0 , prev = nA - 1 ; i < nA; prev = i++ )
+		{
+			//edge normal and vertex to circle center axis
+			for( int n = 0 ; n < 2 ; ++n )
+			{
+				Vec2f axis;
+				if ( n == 0 )
+				{
+					Vec2f edge = vA[i] - vA[ prev ];
+					axis = Vec2f( edge.y , -edge.x );
+				}
+				else
+				{
+					axis = vA[i] + posRel;
+				}
+
+				float len = sqrt( axis.length2() );
+				if ( len < FLT_EPSILON )
+					continue;
+				axis /= len;
+
+				float rangeA[2];
+				calcRange( rangeA , axis , vA , nA );
+				float offset = axis.dot( posRel );
+				rangeA[0] += offset;
+				rangeA[1] += offset;
+
+				if ( !isOverlap( rangeA , rangeB ) )
+				{
+					fResult = calcDistance( rangeA , rangeB );
+					vResult = axis;
+					return haveSA = true;
+				}
+
+				float depth = calcOverlapDepth( rangeA , rangeB );
+				if ( depth < depthMin )
+					depthMin = depth;
+			}
+		}
+
+		fResult = depthMin;
+		return haveSA = false;
+	}
+
+	bool SATSolver::test( Vec2f const& pA , Vec2f const vA[] , int nA , Vec2f const& pB , Vec2f const vB[] , int nB )
+	{
+		Vec2f posRel = pB - pA;
+
+		float depthMin = std::numeric_limits< float >::max();
+		for( int n = 0 ; n < 2 ; ++n )
+		{
+			Vec2f const* v   = ( n == 0 ) ? vA : vB;
+			int          num = ( n == 0 ) ? nA : nB;
+			for( int i = 0 , prev = num - 1 ; i < num ; prev = i++ )
+			{
+				Vec2f edge = v[i] - v[ prev ];
+				Vec2f axis = Vec2f( edge.y , -edge.x );
+
+				float rangeA[2];
+				calcRange( rangeA , axis , vA , nA );
+				float rangeB[2];
+				calcRange( rangeB , axis , vB , nB );
+
+				float offset = axis.dot( posRel );
+				rangeB[0] += offset;
+				rangeB[1] += offset;
+
+				if ( !isOverlap( rangeA , rangeB ) )
+				{
+					fResult = calcDistance( rangeA , rangeB );
+					vResult = axis;
+					return haveSA = true;
+				}
+
+				float depth = calcOverlapDepth( rangeA , rangeB ) / sqrt( axis.length2() );
+				if ( depth < depthMin )
+					depthMin = depth;
+			}
+		}
+
+		fResult = depthMin;
+		return haveSA = false;
+	}
+
+	float SATSolver::calcOverlapDepth( float const rangeA[] , float const rangeB[] )
+	{
+		assert( isOverlap( rangeA , rangeB ) );
+		float vMin = std::max( rangeA[0] , rangeB[0] );
+		float vMax = std::min( rangeA[1] , rangeB[1] );
+		return vMax - vMin;
+	}
+
+	float SATSolver::calcDistance( float const rangeA[] , float const rangeB[] )
+	{
+		assert( !isOverlap( rangeA , rangeB ) );
+		float vMin = std::max( rangeA[0] , rangeB[0] );
+		float vMax = std::min( rangeA[1] , rangeB[1] );
+		return vMin - vMax;
+	}
+
+	void SATSolver::calcRange( float range[] , Vec2f const& axis , Vec2f const v[] , int num )
+	{
+		float vMax , vMin;
+		vMax = vMin = axis.dot( v[0] );
+		for( int i = 1 ; i < num ; ++i )
+		{
+			float value = axis.dot( v[i] );
+			if ( value < vMin )
+				vMin = value;
+			else if ( value > vMax )
+				vMax = value;
+		}
+		range[0] = vMin;
+		range[1] = vMax;
+	}
+
+
+	int ClipPolygonByLine( Vec2f const poly[] , int num , Vec2f const& p0 , Vec2f const& p1 , Vec2f out[] )
+	{
+		if ( num == 0 )
+			return 0;
+
+		int n = 0;
+		Vec2f const* prev = &poly[ num - 1 ];
+		double dPrev = Orient( p0 , p1 , *prev );
+		for( int i = 0 ; i < num ; ++i )
+		{
+			Vec2f const& cur = poly[i];
+			double dCur = Orient( p0 , p1 , cur );
+
+			if ( dCur >= 0 )
+			{
+				if ( dPrev < 0 )
+					out[ n++ ] = *prev + float( dPrev / ( dPrev - dCur ) ) * ( cur - *prev );
+				out[ n++ ] = cur;
+			}
+			else if ( dPrev > 0 )
+			{
+				out[ n++ ] = *prev + float( dPrev / ( dPrev - dCur ) ) * ( cur - *prev );
+			}
+
+			prev  = &cur;
+			dPrev = dCur;
+		}
+		return n;
+	}
+
+	int ClipPolygon( Vec2f const subject[] , int numSubject , Vec2f const clip[] , int numClip , Vec2f out[] , Vec2f temp[] )
+	{
+		if ( numClip < 3 )
+			return 0;
+
+		bool beReverse = CalcArea( clip , numClip ) < 0;
+
+		//ping-pong buffers , so the last pass writes to out
+		Vec2f* dest = ( numClip % 2 ) ? out : temp;
+		Vec2f* other = ( numClip % 2 ) ? temp : out;
+		Vec2f const* src = subject;
+		int num = numSubject;
+		for( int i = 0 , prev = numClip - 1 ; i < numClip && num ; prev = i++ )
+		{
+			if ( beReverse )
+				num = ClipPolygonByLine( src , num , clip[i] , clip[ prev ] , dest );
+			else
+				num = ClipPolygonByLine( src , num , clip[ prev ] , clip[i] , dest );
+			src = dest;
+			std::swap( dest , other );
+		}
+		return num;
+	}
+
+
+	void PolyBoolean::addNodeList( Vec2f const poly[] , int num )
+	{
+		int base = (int)mNodes.size();
+		for( int i = 0 ; i < num ; ++i )
+		{
+			Node node;
+			node.pos      = poly[i];
+			node.next     = base + ( i + 1 ) % num;
+			node.prev     = base + ( i + num - 1 ) % num;
+			node.neighbor = -1;
+			node.alpha    = 0;
+			node.beIntersection = false;
+			node.beEntry   = false;
+			node.beVisited = false;
+			mNodes.push_back( node );
+		}
+	}
+
+	//insert intersection node to the edge , sorted by alpha
+	void PolyBoolean::insertNode( int idxEdge , int idxEdgeEnd , int idx )
+	{
+		float alpha = mNodes[ idx ].alpha;
+		int cur = idxEdge;
+		while( mNodes[ cur ].next != idxEdgeEnd && mNodes[ mNodes[ cur ].next ].alpha < alpha )
+			cur = mNodes[ cur ].next;
+
+		int next = mNodes[ cur ].next;
+		mNodes[ idx ].prev  = cur;
+		mNodes[ idx ].next  = next;
+		mNodes[ cur ].next  = idx;
+		mNodes[ next ].prev = idx;
+	}
+
+	static int ToSign( double value ){ return ( value > 0 ) ? 1 : ( ( value < 0 ) ? -1 : 0 ); }
+
+	//return false if a vertex touches other polygon boundary
+	bool PolyBoolean::findIntersections( int numA , int numB )
+	{
+		bool beDegenerate = false;
+		for( int i = 0 ; i < numA ; ++i )
+		{
+			int iNext = ( i + 1 ) % numA;
+			Vec2f a0 = mNodes[ i ].pos;
+			Vec2f a1 = mNodes[ iNext ].pos;
+			for( int j = 0 ; j < numB ; ++j )
+			{
+				int jNext = ( j + 1 ) % numB;
+				Vec2f b0 = mNodes[ numA + j ].pos;
+				Vec2f b1 = mNodes[ numA + jNext ].pos;
+
+				double oa0 = Orient( b0 , b1 , a0 );
+				double oa1 = Orient( b0 , b1 , a1 );
+				int sa0 = ToSign( oa0 );
+				int sa1 = ToSign( oa1 );
+				if ( sa0 * sa1 > 0 )
+					continue;
+				double ob0 = Orient( a0 , a1 , b0 );
+				double ob1 = Orient( a0 , a1 , b1 );
+				int sb0 = ToSign( ob0 );
+				int sb1 = ToSign( ob1 );
+				if ( sb0 * sb1 > 0 )
+					continue;
+
+				if ( sa0 == 0 || sa1 == 0 || sb0 == 0 || sb1 == 0 )
+				{
+					beDegenerate = true;
+					continue;
+				}
+
+				float alphaA = float( oa0 / ( oa0 - oa1 ) );
+				float alphaB = float( ob0 / ( ob0 - ob1 ) );
+				Vec2f pos = a0 + alphaA * ( a1 - a0 );
+
+				int idxA = (int)mNodes.size();
+				int idxB = idxA + 1;
+				Node node;
+				node.pos       = pos;
+				node.beIntersection = true;
+				node.beEntry   = false;
+				node.beVisited = false;
+				node.alpha     = alphaA;
+				node.neighbor  = idxB;
+				mNodes.push_back( node );
+				node.alpha     = alphaB;
+				node.neighbor  = idxA;
+				mNodes.push_back( node );
+
+				insertNode( i , iNext , idxA );
+				insertNode( numA + j , numA + jNext , idxB );
+			}
+		}
+		return !beDegenerate;
+	}
+
+	int PolyBoolean::compute( Vec2f const polyA[] , int numA , Vec2f const polyB[] , int numB , Operation op , std::vector< Vertices >& outPolys )
+	{
+		if ( numA < 3 || numB < 3 )
+		{
+			if ( op == eIntersect )
+				return 0;
+			if ( numA >= 3 )
+				outPolys.push_back( Vertices( polyA , polyA + numA ) );
+			else if ( numB >= 3 && op == eUnion )
+				outPolys.push_back( Vertices( polyB , polyB + numB ) );
+			else
+				return 0;
+			return 1;
+		}
+
+		mPolyB.assign( polyB , polyB + numB );
+		//same winding , so traced contours have known winding
+		if ( ( CalcArea( polyA , numA ) > 0 ) != ( CalcArea( polyB , numB ) > 0 ) )
+			std::reverse( mPolyB.begin() , mPolyB.end() );
+
+		Vec2f bMin = polyB[0];
+		Vec2f bMax = polyB[0];
+		for( int i = 1 ; i < numB ; ++i )
+		{
+			bMin.x = std::min( bMin.x , polyB[i].x ); bMin.y = std::min( bMin.y , polyB[i].y );
+			bMax.x = std::max( bMax.x , polyB[i].x ); bMax.y = std::max( bMax.y , polyB[i].y );
+		}
+		float perturbLen = 1e-5f * std::max( bMax.x - bMin.x , bMax.y - bMin.y );
+
+		int const MaxPerturbNum = 4;
+		for( int n = 0 ; ; ++n )
+		{
+			mNodes.clear();
+			addNodeList( polyA , numA );
+			addNodeList( &mPolyB[0] , numB );
+			if ( findIntersections( numA , numB ) || n == MaxPerturbNum )
+				break;
+
+			//move B along a direction unlikely parallel to edges
+			Vec2f offset = ( perturbLen * ( n + 1 ) ) * Vec2f( 0.7548777f , 0.5698403f );
+			for( int i = 0 ; i < numB ; ++i )
+				mPolyB[i] += offset;
+		}
+		Vec2f const* pB = &mPolyB[0];
+
+		int idxFirst = numA + numB;
+		if ( (int)mNodes.size() == idxFirst )
+		{
+			//no intersection : one contains the other or they are apart
+			bool aInB = TestInPolygon( pB , numB , polyA[0] );
+			bool bInA = !aInB && TestInPolygon( polyA , numA , pB[0] );
+			switch( op )
+			{
+			case eIntersect:
+				if ( aInB )
+					outPolys.push_back( Vertices( polyA , polyA + numA ) );
+				else if ( bInA )
+					outPolys.push_back( Vertices( pB , pB + numB ) );
+				else
+					return 0;
+				return 1;
+			case eUnion:
+				if ( aInB )
+					outPolys.push_back( Vertices( pB , pB + numB ) );
+				else if ( bInA )
+					outPolys.push_back( Vertices( polyA , polyA + numA ) );
+				else
+				{
+					outPolys.push_back( Vertices( polyA , polyA + numA ) );
+					outPolys.push_back( Vertices( pB , pB + numB ) );
+					return 2;
+				}
+				return 1;
+			case eDifference:
+				if ( aInB )
+					return 0;
+				outPolys.push_back( Vertices( polyA , polyA + numA ) );
+				if ( bInA )
+				{
+					outPolys.push_back( Vertices( pB , pB + numB ) );
+					std::reverse( outPolys.back().begin() , outPolys.back().end() );
+					return 2;
+				}
+				return 1;
+			}
+			return 0;
+		}
+
+		//mark intersections as entry or exit of the traced path
+		bool forwardA = ( op == eIntersect );
+		bool forwardB = ( op != eUnion );
+		forwardA ^= TestInPolygon( pB , numB , polyA[0] );
+		forwardB ^= TestInPolygon( polyA , numA , pB[0] );
+
+		int cur = 0;
+		do
+		{
+			Node& node = mNodes[ cur ];
+			if ( node.beIntersection )
+			{
+				node.beEntry = forwardA;
+				forwardA = !forwardA;
+			}
+			cur = node.next;
+		}
+		while( cur != 0 );
+
+		cur = numA;
+		do
+		{
+			Node& node = mNodes[ cur ];
+			if ( node.beIntersection )
+			{
+				node.beEntry = forwardB;
+				forwardB = !forwardB;
+			}
+			cur = node.next;
+		}
+		while( cur != numA );
+
+		//intersection nodes of A are the even ones.
+		//start where A is walked forward , so contours have winding of A
+		int numResult = 0;
+		for( int idx = idxFirst ; idx < (int)mNodes.size() ; idx += 2 )
+		{
+			if ( mNodes[ idx ].beVisited || !mNodes[ idx ].beEntry )
+				continue;
+
+			outPolys.push_back( Vertices() );
+			Vertices& poly = outPolys.back();
+
+			cur = idx;
+			for(;;)
+			{
+				mNodes[ cur ].beVisited = true;
+				mNodes[ mNodes[ cur ].neighbor ].beVisited = true;
+
+				bool beForward = mNodes[ cur ].beEntry;
+				do
+				{
+					cur = ( beForward ) ? mNodes[ cur ].next : mNodes[ cur ].prev;
+					poly.push_back( mNodes[ cur ].pos );
+				}
+				while( !mNodes[ cur ].beIntersection );
+
+				cur = mNodes[ cur ].neighbor;
+				if ( mNodes[ cur ].beVisited )
+					break;
+			}
+			++numResult;
+		}
+		return numResult;
+	}
+
+}//namespace G2D
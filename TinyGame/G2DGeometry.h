@@ -0,0 +1,158 @@
+#ifndef G2DGeometry_h__
+#define G2DGeometry_h__
+
+#include "TVector2.h"
+
+#include <vector>
+#include <cmath>
+
+namespace G2D
+{
+	typedef TVector2< float > Vec2f;
+	typedef std::vector< Vec2f > Vertices;
+
+	inline Vec2f normalize( Vec2f const& v )
+	{
+		float len = sqrt( v.length2() );
+		if ( len < 1e-5 )
+			return Vec2f::Zero();
+		return ( 1 / len ) * v;
+	}
+
+	//  ( b - a ).cross( c - a ) with exact sign : a filtered double evaluation ,
+	//  falling back to exact expansion arithmetic when rounding can flip the sign.
+	//  > 0 : c is on the left of a -> b in y up space
+	double Orient( Vec2f const& a , Vec2f const& b , Vec2f const& c );
+	inline int OrientSign( Vec2f const& a , Vec2f const& b , Vec2f const& c )
+	{
+		double value = Orient( a , b , c );
+		return ( value > 0 ) ? 1 : ( ( value < 0 ) ? -1 : 0 );
+	}
+
+	//signed area , > 0 for counter clockwise in y up space
+	float CalcArea( Vec2f const v[] , int num );
+	//even odd rule
+	bool  TestInPolygon( Vec2f const v[] , int num , Vec2f const& p );
+
+
+	//  Quick hull of point set , output is the index of hull vertices.
+	//  A solver object reuses its work buffer , or the caller passes one with
+	//  numV ints , so repeated solves don't allocate.
+	class QHullSolver
+	{
+	public:
+		QHullSolver();
+
+		int  solve( Vec2f const v[] , int numV , int outIndex[] );
+		int  solve( Vec2f const v[] , int numV , int outIndex[] , int workIndex[] );
+		//the four regions outside the extreme point quad are solved on worker threads
+		int  solveParallel( Vec2f const v[] , int numV , int outIndex[] , int workIndex[] );
+
+		//solveParallel falls back to one thread under this point num
+		static int const ParallelMinPointNum = 50000;
+
+	private:
+		struct Task;
+		struct RegionTask;
+		static int const NumWorker = 4;
+
+		static void findExtremePoints( Vec2f const v[] , int numV , int idxQuad[5] );
+		int  constuct_R( int pIdx[] , int nV , int i1 , int i2 );
+		int  clip( int pIdx[] , int nV , int i1 , int i2 );
+
+		Vec2f const*       mV;
+		int*               mOut;
+		std::vector< int > mIdxBuffer;
+	};
+
+	inline int QuickHull( Vec2f const v[] , int nV , int outIndex[] )
+	{
+		QHullSolver solver;
+		return solver.solve( v , nV , outIndex );
+	}
+
+
+	struct PolyShape
+	{
+		int    numEdge;
+		Vec2f* normal;
+		Vec2f* vertex;
+	};
+	struct CircleShape
+	{
+		float radius;
+	};
+
+	//  Separating axis test of convex polygons ( vertices relative to position ).
+	//  If a separating axis is found , vResult is the axis and fResult the gap ,
+	//  else fResult is the min penetration depth.
+	class SATSolver
+	{
+	public:
+		bool  haveSA;
+		Vec2f vResult;
+		float fResult;
+
+		bool test( Vec2f const& pA , Vec2f const vA[] , int nA , Vec2f const& pB , float radius );
+		bool test( Vec2f const& pA , Vec2f const vA[] , int nA , Vec2f const& pB , Vec2f const vB[] , int nB );
+
+		static bool isOverlap( float const rangeA[] , float const rangeB[] )
+		{
+			return ( rangeA[0] <= rangeB[1] ) &&
+			       ( rangeB[0] <= rangeA[1] );
+		}
+		static float calcOverlapDepth( float const rangeA[] , float const rangeB[] );
+		static float calcDistance( float const rangeA[] , float const rangeB[] );
+		static void  calcRange( float range[] , Vec2f const& axis , Vec2f const v[] , int num );
+	};
+
+
+	//  Sutherland-Hodgman clipping.
+	//keep the part on the left of p0 -> p1 , return vertex num
+	//out needs num + 1 vertices for convex polygon , 2 * num for concave
+	int ClipPolygonByLine( Vec2f const poly[] , int num , Vec2f const& p0 , Vec2f const& p1 , Vec2f out[] );
+	//both polygons convex ( any winding ) , out and temp need numSubject + numClip vertices
+	int ClipPolygon( Vec2f const subject[] , int numSubject , Vec2f const clip[] , int numClip , Vec2f out[] , Vec2f temp[] );
+
+
+	//  Boolean operation of two simple polygons ( any winding , may be concave )
+	//  by Greiner-Hormann clipping. Vertices touching the other boundary are
+	//  removed by moving polygon B a tiny distance. Result contours have the
+	//  winding of A , holes have reversed winding.
+	class PolyBoolean
+	{
+	public:
+		enum Operation
+		{
+			eIntersect ,
+			eUnion ,
+			eDifference , // A - B
+		};
+
+		//result polygons are appended to outPolys , return num of result polygons
+		int compute( Vec2f const polyA[] , int numA , Vec2f const polyB[] , int numB , Operation op , std::vector< Vertices >& outPolys );
+
+	private:
+		struct Node
+		{
+			Vec2f pos;
+			int   next;
+			int   prev;
+			int   neighbor;
+			float alpha;
+			bool  beIntersection;
+			bool  beEntry;
+			bool  beVisited;
+		};
+
+		void addNodeList( Vec2f const poly[] , int num );
+		void insertNode( int idxEdge , int idxEdgeEnd , int idx );
+		bool findIntersections( int numA , int numB );
+
+		std::vector< Node >  mNodes;
+		std::vector< Vec2f > mPolyB;
+	};
+
+}//namespace G2D
+
+#endif // G2DGeometry_h__
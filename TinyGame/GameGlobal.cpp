@@ -6,6 +6,7 @@
 #include "Random.h"
 #include "GamePackageManager.h"
 #include "GameGUISystem.h"
+#include "FrameAllocator.h"
 
 #include <cstdlib>
 
@@ -99,3 +100,9 @@ IGraphics2D& Global::getIGraphics2D()
 {
 	return getDrawEngine()->getIGraphics();
 }
+
+FrameAllocator& Global::getFrameAllocator()
+{
+	static FrameAllocator allocator( 64 * 1024 );
+	return allocator;
+}
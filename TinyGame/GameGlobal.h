@@ -61,6 +61,7 @@ class GLGraphics2D;
 class GamePackageManager;
 class PropertyKey;
 class GUISystem;
+class FrameAllocator;
 
 GAME_API uint64 generateRandSeed();
 
@@ -80,6 +81,8 @@ public:
 	static GAME_API Graphics2D&   getGraphics2D();
 	static GAME_API GLGraphics2D& getGLGraphics2D();
 	static GAME_API IGraphics2D&  getIGraphics2D();
+	//temporaries of game thread , cleared at end of each loop
+	static GAME_API FrameAllocator& getFrameAllocator();
 };
 
 class UnCopiable
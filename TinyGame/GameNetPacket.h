@@ -154,12 +154,16 @@ public:
 class GDPFrameStream : public GameFramePacket< GDPFrameStream , GDP_FARME_STREAM >
 {
 public:
+	GDPFrameStream(){ checkFrame = 0; checksum = 0; }
 	DataStreamBuffer buffer;
+	//last state checksum of sender
+	int              checkFrame;
+	unsigned         checksum;
 
 	template < class BufferOP >
 	void  operateBuffer( BufferOP& op )
 	{
-		op  & buffer;
+		op  & buffer & checkFrame & checksum;
 	}
 };
 
@@ -96,6 +96,7 @@ public:
 
 	//Multi-Player
 	virtual bool setupNetwork( NetWorker* worker , INetEngine** engine ){ return true; }
+	virtual unsigned calcFrameChecksum(){ return 0; }
 	virtual void setupServerLevel(){}
 
 	virtual void setupLocalGame( LocalPlayerManager& playerManager ){}
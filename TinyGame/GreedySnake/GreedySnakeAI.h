@@ -5,6 +5,7 @@
 
 #include "TGrid2D.h"
 #include "GreedySnakeScene.h"
+#include "GreedySnakePlanner.h"
 
 namespace GreedySnake
 {
@@ -23,9 +24,6 @@ namespace GreedySnake
 
 		DirType mMoveDir;
 
-		int   calcBoundedCount( Vec2i const& pos , DirType dir );
-		void  incTestCount();
-
 		static unsigned const ColMask = Level::eTERRAIN_MASK | Level::eSNAKE_MASK;
 
 		bool testCollision( Vec2i const& pos , DirType dir , Vec2i& resultPos );
@@ -0,0 +1,302 @@
+#include "GreedySnakePCH.h"
+#include "GreedySnakePlanner.h"
+
+namespace GreedySnake
+{
+	struct FoodSeedVisitor
+	{
+		FoodSeedVisitor( SnakePlanner& planner ):planner( planner ){}
+		void visit( FoodInfo const& info )
+		{
+			int idx = planner.toIndex( info.pos );
+			if ( planner.mBlockMap.test( idx ) || planner.mFoodDist[ idx ] == 0 )
+				return;
+			planner.mFoodDist[ idx ] = 0;
+			planner.mQueue.push_back( idx );
+		}
+		SnakePlanner& planner;
+	};
+
+	SnakePlanner::SnakePlanner()
+	{
+		mSizeX = mSizeY = 0;
+		mbWarpX = mbWarpY = false;
+	}
+
+	void SnakePlanner::setup( Level& level )
+	{
+		Vec2i size = level.getMapSize();
+		mSizeX = size.x;
+		mSizeY = size.y;
+
+		int numCell = mSizeX * mSizeY;
+		mBlockMap.resize( numCell );
+		mTestMap.resize( numCell );
+		mVisited.resize( numCell );
+		mFoodDist.resize( numCell );
+		mQueue.reserve( numCell );
+		mFillStack.reserve( mSizeY * 2 + 16 );
+	}
+
+	DirType SnakePlanner::decideMoveDir( Level& level , SnakeInfo& info , int lookAhead )
+	{
+		if ( mSizeX * mSizeY != (int)mFoodDist.size() || level.getMapSize() != Vec2i( mSizeX , mSizeY ) )
+			setup( level );
+
+		Level::MapType mapType = level.getMapType();
+		mbWarpX = ( mapType == Level::eMAP_WARP_XY || mapType == Level::eMAP_WARP_X );
+		mbWarpY = ( mapType == Level::eMAP_WARP_XY || mapType == Level::eMAP_WARP_Y );
+
+		//the head always takes one more step along its direction ,
+		//the decided direction is used by the step after it
+		Snake::Body const& head = info.snake->getHead();
+		if ( !level.getMapPos( head.pos , head.dir , mHeadPos ) || !level.isVaildMapRange( mHeadPos ) )
+			return -1;
+		mHeadDir = head.dir;
+
+		buildBlockMap( level , info );
+		calcFoodDist( level );
+
+		DirType   bestDir = -1;
+		MoveScore bestScore;
+		for( int i = 0 ; i < 3 ; ++i )
+		{
+			//front , left , right
+			DirType const dirOffset[] = { 0 , 3 , 1 };
+			DirType dir = ( mHeadDir + dirOffset[i] ) % 4;
+
+			MoveScore score;
+			if ( !evalMove( level , dir , score , lookAhead ) )
+				continue;
+
+			if ( bestDir == -1 || score.isBetterThan( bestScore ) )
+			{
+				bestDir   = dir;
+				bestScore = score;
+			}
+		}
+		return bestDir;
+	}
+
+	void SnakePlanner::buildBlockMap( Level& level , SnakeInfo& info )
+	{
+		mBlockMap.clear();
+		for( int j = 0 ; j < mSizeY ; ++j )
+		{
+			for( int i = 0 ; i < mSizeX ; ++i )
+			{
+				Vec2i pos( i , j );
+				int hitResult = 0;
+				switch( level.hitTest( pos , Level::eTERRAIN_MASK | Level::eSNAKE_MASK , hitResult ) )
+				{
+				case Level::eSNAKE_MASK:
+					mBlockMap.set( toIndex( pos ) );
+					break;
+				case Level::eTERRAIN_MASK:
+					if ( hitResult == TT_BLOCK )
+						mBlockMap.set( toIndex( pos ) );
+					break;
+				}
+			}
+		}
+
+		mBodyIndex.clear();
+		for( Snake::Iterator iter = info.snake->getBodyIterator(); iter.haveMore(); iter.goNext() )
+		{
+			Vec2i const& pos = iter.getElement().pos;
+			if ( !level.isVaildMapRange( pos ) )
+			{
+				mBodyIndex.push_back( -1 );
+				continue;
+			}
+			int hitResult = 0;
+			level.hitTest( pos , Level::eSNAKE_MASK , hitResult );
+			mBodyIndex.push_back( ( hitResult == BIT( info.id ) ) ? toIndex( pos ) : -1 );
+		}
+		std::reverse( mBodyIndex.begin() , mBodyIndex.end() );
+
+		//pending step
+		freeTail( mBlockMap , 0 );
+		mBodyIndex.erase( mBodyIndex.begin() );
+		mBodyIndex.push_back( toIndex( mHeadPos ) );
+		mBlockMap.set( toIndex( mHeadPos ) );
+
+		//tail moves away on the decided step too
+		freeTail( mBlockMap , 0 );
+	}
+
+	void SnakePlanner::freeTail( CellBitSet& blockMap , int idxTail )
+	{
+		int idx = mBodyIndex[ idxTail ];
+		if ( idx == -1 )
+			return;
+		//grown bodies stay on the tail cell
+		if ( idxTail + 1 < (int)mBodyIndex.size() && mBodyIndex[ idxTail + 1 ] == idx )
+			return;
+		blockMap.reset( idx );
+	}
+
+	void SnakePlanner::calcFoodDist( Level& level )
+	{
+		std::fill( mFoodDist.begin() , mFoodDist.end() , (int)NoPathDist );
+		mQueue.clear();
+
+		FoodSeedVisitor visitor( *this );
+		level.visitFood( visitor );
+
+		for( size_t cur = 0 ; cur < mQueue.size() ; ++cur )
+		{
+			int   idx  = mQueue[ cur ];
+			Vec2i pos  = toPos( idx );
+			int   dist = mFoodDist[ idx ] + 1;
+			for( DirType dir = 0 ; dir < 4 ; ++dir )
+			{
+				Vec2i nPos;
+				if ( !level.getMapPos( pos , dir , nPos ) || !level.isVaildMapRange( nPos ) )
+					continue;
+				int nIdx = toIndex( nPos );
+				if ( mBlockMap.test( nIdx ) || mFoodDist[ nIdx ] <= dist )
+					continue;
+				mFoodDist[ nIdx ] = dist;
+				mQueue.push_back( nIdx );
+			}
+		}
+	}
+
+	bool SnakePlanner::evalMove( Level& level , DirType dir , MoveScore& score , int lookAhead )
+	{
+		Vec2i pos;
+		if ( !level.getMapPos( mHeadPos , dir , pos ) || !level.isVaildMapRange( pos ) )
+			return false;
+
+		int idx = toIndex( pos );
+		if ( mBlockMap.test( idx ) )
+			return false;
+
+		mTestMap.copy( mBlockMap );
+		mTestMap.set( idx );
+
+		int idxTail = 1;
+		int numBody = (int)mBodyIndex.size();
+		//snake grows when eating , so the tail stays
+		if ( mFoodDist[ idx ] == 0 && mBodyIndex[0] != -1 )
+		{
+			mTestMap.set( mBodyIndex[0] );
+			idxTail = 0;
+		}
+
+		score.foodDist = mFoodDist[ idx ];
+
+		//follow the food distance field
+		Vec2i curPos = pos;
+		for( int step = 0 ; step < lookAhead ; ++step )
+		{
+			int curDist = mFoodDist[ toIndex( curPos ) ];
+			if ( curDist == 0 || curDist == NoPathDist )
+				break;
+
+			int nextIdx = -1;
+			Vec2i nextPos;
+			for( DirType d = 0 ; d < 4 ; ++d )
+			{
+				Vec2i nPos;
+				if ( !level.getMapPos( curPos , d , nPos ) || !level.isVaildMapRange( nPos ) )
+					continue;
+				int nIdx = toIndex( nPos );
+				if ( mTestMap.test( nIdx ) || mFoodDist[ nIdx ] >= curDist )
+					continue;
+				nextIdx = nIdx;
+				nextPos = nPos;
+				break;
+			}
+			if ( nextIdx == -1 )
+				break;
+
+			curPos = nextPos;
+			mTestMap.set( nextIdx );
+
+			if ( idxTail < numBody - 1 )
+			{
+				freeTail( mTestMap , idxTail );
+				++idxTail;
+			}
+		}
+
+		//tail cell counts as reachable space
+		int tailIdx = ( idxTail < numBody ) ? mBodyIndex[ idxTail ] : -1;
+		if ( tailIdx != -1 )
+			mTestMap.reset( tailIdx );
+
+		mTestMap.reset( toIndex( curPos ) );
+		score.space  = fillSpace( mTestMap , curPos ) - 1;
+		score.beSafe = ( tailIdx != -1 && mVisited.test( tailIdx ) ) ||
+		               score.space >= numBody;
+		return true;
+	}
+
+	int SnakePlanner::fillSpace( CellBitSet const& blockMap , Vec2i const& start )
+	{
+		mVisited.clear();
+		mFillStack.clear();
+		mFillStack.push_back( start );
+
+		int count = 0;
+		while( !mFillStack.empty() )
+		{
+			Vec2i pos = mFillStack.back();
+			mFillStack.pop_back();
+
+			int row = pos.y * mSizeX;
+			if ( !canFill( blockMap , row + pos.x ) )
+				continue;
+
+			int xMin = pos.x;
+			while( xMin > 0 && canFill( blockMap , row + xMin - 1 ) )
+				--xMin;
+			int xMax = pos.x;
+			while( xMax < mSizeX - 1 && canFill( blockMap , row + xMax + 1 ) )
+				++xMax;
+
+			for( int x = xMin ; x <= xMax ; ++x )
+				mVisited.set( row + x );
+			count += xMax - xMin + 1;
+
+			if ( mbWarpX )
+			{
+				if ( xMin == 0 )
+					mFillStack.push_back( Vec2i( mSizeX - 1 , pos.y ) );
+				if ( xMax == mSizeX - 1 )
+					mFillStack.push_back( Vec2i( 0 , pos.y ) );
+			}
+
+			for( int dy = -1 ; dy <= 1 ; dy += 2 )
+			{
+				int y = pos.y + dy;
+				if ( y < 0 || y >= mSizeY )
+				{
+					if ( !mbWarpY )
+						continue;
+					y = ( y < 0 ) ? mSizeY - 1 : 0;
+				}
+
+				int  rowN = y * mSizeX;
+				bool bInSpan = false;
+				for( int x = xMin ; x <= xMax ; ++x )
+				{
+					if ( canFill( blockMap , rowN + x ) )
+					{
+						if ( !bInSpan )
+							mFillStack.push_back( Vec2i( x , y ) );
+						bInSpan = true;
+					}
+					else
+					{
+						bInSpan = false;
+					}
+				}
+			}
+		}
+		return count;
+	}
+
+}//namespace GreedySnake
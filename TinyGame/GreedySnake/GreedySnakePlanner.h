@@ -0,0 +1,106 @@
+#ifndef GreedySnakePlanner_h__
+#define GreedySnakePlanner_h__
+
+#include "GreedySnakeLevel.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace GreedySnake
+{
+	class CellBitSet
+	{
+	public:
+		CellBitSet(){ mNumCell = 0; }
+
+		void resize( int numCell )
+		{
+			mNumCell = numCell;
+			mBits.resize( ( numCell + 31 ) / 32 );
+		}
+		void clear(){ std::fill( mBits.begin() , mBits.end() , 0 ); }
+		void copy( CellBitSet const& rhs ){ mBits.assign( rhs.mBits.begin() , rhs.mBits.end() ); mNumCell = rhs.mNumCell; }
+
+		bool test( int idx ) const { return ( mBits[ idx >> 5 ] & ( 1u << ( idx & 31 ) ) ) != 0; }
+		void set( int idx )  { mBits[ idx >> 5 ] |= ( 1u << ( idx & 31 ) ); }
+		void reset( int idx ){ mBits[ idx >> 5 ] &= ~( 1u << ( idx & 31 ) ); }
+
+	private:
+		std::vector< unsigned > mBits;
+		int  mNumCell;
+	};
+
+	//  Move planner for AI snakes. Buffers are kept between calls, so one
+	//  planner can serve every AI snake of the level without allocation.
+	//
+	//  Each candidate direction is checked with a few steps of look-ahead :
+	//  the head follows the food distance field ( BFS from all foods ) while
+	//  the tail frees its cells , then a scanline fill from the last head
+	//  position measures the free space and tests if the tail is reachable.
+	class SnakePlanner
+	{
+	public:
+		SnakePlanner();
+
+		static int const DefaultLookAhead = 8;
+		static int const NoPathDist = 0x7fffffff;
+
+		void    setup( Level& level );
+		// return -1 if every direction hits something
+		DirType decideMoveDir( Level& level , SnakeInfo& info , int lookAhead = DefaultLookAhead );
+
+		int     getFoodDist( Vec2i const& pos ) const { return mFoodDist[ toIndex( pos ) ]; }
+
+	private:
+
+		struct MoveScore
+		{
+			bool beSafe;
+			int  foodDist;
+			int  space;
+
+			bool isBetterThan( MoveScore const& rhs ) const
+			{
+				if ( beSafe != rhs.beSafe )
+					return beSafe;
+				if ( beSafe && foodDist != rhs.foodDist )
+					return foodDist < rhs.foodDist;
+				return space > rhs.space;
+			}
+		};
+
+		void buildBlockMap( Level& level , SnakeInfo& info );
+		void calcFoodDist( Level& level );
+		void freeTail( CellBitSet& blockMap , int idxTail );
+		bool evalMove( Level& level , DirType dir , MoveScore& score , int lookAhead );
+		int  fillSpace( CellBitSet const& blockMap , Vec2i const& start );
+		bool canFill( CellBitSet const& blockMap , int idx ) const
+		{
+			return !blockMap.test( idx ) && !mVisited.test( idx );
+		}
+
+		int   toIndex( Vec2i const& pos ) const { return pos.x + mSizeX * pos.y; }
+		Vec2i toPos( int idx ) const { return Vec2i( idx % mSizeX , idx / mSizeX ); }
+
+		friend struct FoodSeedVisitor;
+
+		int        mSizeX;
+		int        mSizeY;
+		bool       mbWarpX;
+		bool       mbWarpY;
+		Vec2i      mHeadPos;
+		DirType    mHeadDir;
+
+		CellBitSet mBlockMap;
+		CellBitSet mTestMap;
+		CellBitSet mVisited;
+		std::vector< int >   mFoodDist;
+		std::vector< int >   mQueue;
+		std::vector< Vec2i > mFillStack;
+		// cell index of the snake bodies , tail first ; -1 if the cell is shared
+		std::vector< int >   mBodyIndex;
+	};
+
+}//namespace GreedySnake
+
+#endif // GreedySnakePlanner_h__
@@ -13,6 +13,11 @@ class IFrameUpdater
 public:
 	virtual void tick() = 0;
 	virtual void updateFrame( int frame ) = 0;
+	//hash of simulation state after tick , lockstep peers compare it to find desync
+	//0 : game doesn't support
+	virtual unsigned calcFrameChecksum(){ return 0; }
+	//called once when checksum of frame is not same as remote , frames are not updated after it
+	virtual void     onFrameDesync( long frame ){}
 };
 
 
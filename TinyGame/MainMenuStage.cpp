@@ -28,6 +28,7 @@
 #include "AStarStage.h"
 #include "FBirdStage.h"
 #include "PlanetStage.h"
+#include "VoronoiStage.h"
 
 #include "EasingFun.h"
 
@@ -73,6 +74,7 @@ StageInfo gTestGroup[] =
 	INFO( "A-Star Test" , AStar::TestStage ) ,
 	INFO( "Col2D Test"    , G2D::TestStage ) ,
 	INFO( "QHull Test"   , G2D::QHullTestStage ) ,
+	INFO( "Voronoi Test" , Voronoi::TestStage ) ,
 	INFO( "Tween Test"  , TweenTestStage ) ,
 	INFO( "Tree Test"   , TreeTestStage )  ,
 	INFO( "Corontine Test" , CoroutineTestStage ) ,
@@ -12,6 +12,18 @@ namespace MV
 			flag |= eStatic;
 			other.flag|= eStatic;
 		}
+		getSurface()->block->bNavDirty = true;
+		other.getSurface()->block->bNavDirty = true;
+	}
+
+	void NavNode::disconnect()
+	{
+		assert( link );
+		getSurface()->block->bNavDirty = true;
+		link->getSurface()->block->bNavDirty = true;
+		link->link = NULL;
+		link = NULL;
+		flag = 0;
 	}
 
 }//namespace MV
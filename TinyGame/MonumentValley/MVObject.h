@@ -89,15 +89,9 @@ namespace MV
 		NavSurfInfo*  surfInfo;
 		NavNode*      link;
 
+		//both blocks are flagged nav dirty
 		void connect( NavNode& other );
-
-		void disconnect()
-		{
-			assert( link );
-			link->link = NULL;
-			link = NULL;
-			flag = 0;
-		}
+		void disconnect();
 
 	};
 
@@ -138,6 +132,7 @@ namespace MV
 		{
 			for( int i = 0 ; i < NUM_BLOCK_FACE; ++i )
 				surfaces[i].block = this;
+			bNavDirty = true;
 		}
 		int          id;
 		int          idMesh;
@@ -147,6 +142,8 @@ namespace MV
 		BlockSurface surfaces[ NUM_BLOCK_FACE ];
 		HookNode     mapHook;
 		uint32       updateCount;
+		//nav links or rotation changed after last NavGraph update
+		bool         bNavDirty;
 
 		BlockSurface& getLocalFace( Dir dir )
 		{
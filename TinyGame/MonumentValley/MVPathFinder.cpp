@@ -2,6 +2,8 @@
 
 #include "AStar.h"
 
+#include <algorithm>
+
 namespace MV
 {
 	struct AStarNode : AStar::NodeBaseT< AStarNode , FindState , int >
@@ -104,11 +106,170 @@ namespace MV
 
 	AStarFinder gFinderImpl;
 
-	bool PathFinder::find(FindState const& from , FindState const& to )
+	NavGraph::NavGraph()
+	{
+		mNextComp = 1;
+	}
+
+	void NavGraph::clear()
+	{
+		mSurfaceComps.clear();
+	}
+
+	void NavGraph::update( World& world )
+	{
+		int numBlock = world.mBlocks.size();
+		int numSurface = numBlock * NUM_BLOCK_FACE;
+		bool haveChange = false;
+		if ( mSurfaceComps.size() != numSurface )
+		{
+			mSurfaceComps.resize( numSurface , 0 );
+			haveChange = true;
+		}
+
+		mInvalidComps.clear();
+		for( int i = 1 ; i < numBlock ; ++i )
+		{
+			Block* block = world.mBlocks[i];
+			if ( !block->bNavDirty )
+				continue;
+
+			block->bNavDirty = false;
+			haveChange = true;
+			for( int face = 0 ; face < NUM_BLOCK_FACE ; ++face )
+			{
+				int& comp = mSurfaceComps[ i * NUM_BLOCK_FACE + face ];
+				if ( comp > 0 )
+					mInvalidComps.push_back( comp );
+				comp = 0;
+			}
+		}
+
+		if ( !haveChange )
+			return;
+
+		std::sort( mInvalidComps.begin() , mInvalidComps.end() );
+		mInvalidComps.erase( std::unique( mInvalidComps.begin() , mInvalidComps.end() ) , mInvalidComps.end() );
+		if ( !mInvalidComps.empty() )
+		{
+			for( int idx = 0 ; idx < numSurface ; ++idx )
+			{
+				int& comp = mSurfaceComps[ idx ];
+				if ( comp > 0 && std::binary_search( mInvalidComps.begin() , mInvalidComps.end() , comp ) )
+					comp = 0;
+			}
+		}
+
+		for( int idx = NUM_BLOCK_FACE ; idx < numSurface ; ++idx )
+		{
+			if ( mSurfaceComps[ idx ] != 0 )
+				continue;
+
+			int id = idx / NUM_BLOCK_FACE;
+			//destroyed block is in free list
+			if ( world.mBlocks[ id ]->id != id )
+			{
+				mSurfaceComps[ idx ] = -1;
+				continue;
+			}
+			floodComponent( world , idx , mNextComp++ );
+		}
+	}
+
+	void NavGraph::floodComponent( World& world , int idxSurface , int comp )
+	{
+		mSurfaceComps[ idxSurface ] = comp;
+		mStack.push_back( idxSurface );
+		while( !mStack.empty() )
+		{
+			int idx = mStack.back();
+			mStack.pop_back();
+
+			Block* block = world.mBlocks[ idx / NUM_BLOCK_FACE ];
+			BlockSurface& surface = block->surfaces[ idx % NUM_BLOCK_FACE ];
+			for( int type = 0 ; type < NUM_NODE_TYPE ; ++type )
+			{
+				for( int n = 0 ; n < NUM_FACE_NAV_LINK ; ++n )
+				{
+					NavNode* link = surface.nodes[ type ][ n ].link;
+					if ( link == NULL )
+						continue;
+
+					BlockSurface* destSurface = link->getSurface();
+					int idxDest = destSurface->block->id * NUM_BLOCK_FACE + Block::getLocalDir( *destSurface );
+					if ( mSurfaceComps[ idxDest ] != 0 )
+						continue;
+
+					mSurfaceComps[ idxDest ] = comp;
+					mStack.push_back( idxDest );
+				}
+			}
+		}
+	}
+
+	PathFinder::PathFinder()
+	{
+		mIdxNextCache = 0;
+		mIdxPath = -1;
+	}
+
+	void PathFinder::clearCache()
 	{
+		mCachedPaths.clear();
+		mIdxNextCache = 0;
+		mIdxPath = -1;
+	}
+
+	bool PathFinder::find( World& world , FindState const& from , FindState const& to )
+	{
+		mIdxPath = -1;
+		mGraph.update( world );
+
+		//different components can't have a path , no A* is needed
+		int comp = mGraph.getComponent( *from.block , from.faceDirL );
+		if ( comp != mGraph.getComponent( *to.block , to.faceDirL ) )
+			return false;
+
+		for( int i = 0 ; i < mCachedPaths.size() ; ++i )
+		{
+			CachedPath& cache = mCachedPaths[i];
+			if ( cache.comp == comp &&
+				 cache.fromId == from.block->id && cache.fromFaceDirL == from.faceDirL && cache.fromUpDir == from.upDir &&
+				 cache.toId == to.block->id && cache.toFaceDirL == to.faceDirL )
+			{
+				if ( !cache.bFound )
+					return false;
+				mIdxPath = i;
+				return true;
+			}
+		}
+
+		if ( mCachedPaths.size() < MaxCachedPathNum )
+		{
+			mCachedPaths.push_back( CachedPath() );
+			mIdxNextCache = mCachedPaths.size() - 1;
+		}
+		CachedPath& cache = mCachedPaths[ mIdxNextCache ];
+		int idxCache = mIdxNextCache;
+		mIdxNextCache = ( mIdxNextCache + 1 ) % MaxCachedPathNum;
+
+		cache.fromId       = from.block->id;
+		cache.fromFaceDirL = from.faceDirL;
+		cache.fromUpDir    = from.upDir;
+		cache.toId         = to.block->id;
+		cache.toFaceDirL   = to.faceDirL;
+		cache.comp         = comp;
+		cache.states.clear();
+
 		gFinderImpl.mGoal = to;
-		if ( !gFinderImpl.sreach( from ) )
+		cache.bFound = gFinderImpl.sreach( from );
+		if ( !cache.bFound )
 			return false;
+
+		for( AStarFinder::NodeType* aNode = gFinderImpl.getPath() ; aNode ; aNode = aNode->child )
+			cache.states.push_back( aNode->state );
+
+		mIdxPath = idxCache;
 		return true;
 	}
 
@@ -187,24 +348,23 @@ namespace MV
 	{
 		path.mNodes.clear();
 
-		AStarFinder::NodeType* aNode = gFinderImpl.getPath();
-		AStarFinder::NodeType* aNodeNext; 
+		assert( mIdxPath != -1 );
+		std::vector< FindState >& states = mCachedPaths[ mIdxPath ].states;
+		int numState = states.size();
 
 		Block*   prevBlock = NULL;
 		Dir      prevDir;
 		Dir      dir;
 		Block*   block;
-		FindState* state;
 		FindState* nextState;
 
 		{
-			FindState& state = aNode->state;
+			FindState& state = states[0];
 			block = state.block;
 
-			aNodeNext = aNode->child;
-			if ( aNodeNext )
+			if ( numState > 1 )
 			{
-				nextState = ( aNodeNext ) ? &aNodeNext->state : NULL;
+				nextState = &states[1];
 				dir =  block->rotation.toWorld( FDir::Neighbor( state.faceDirL , nextState->prevBlockNode->getDirIndex() ) );
 			}
 			else
@@ -216,16 +376,14 @@ namespace MV
 			
 		}
 
-		while( aNodeNext )
+		for( int i = 1 ; i < numState ; ++i )
 		{
 			prevDir = dir;
 			prevBlock = block;
 
-			aNode = aNodeNext;
-			FindState& state = aNode->state;
+			FindState& state = states[i];
 			block = state.block;
-			aNodeNext = aNode->child;
-			nextState = ( aNodeNext ) ? &aNodeNext->state : NULL;
+			nextState = ( i + 1 < numState ) ? &states[ i + 1 ] : NULL;
 
 			bool needAddNode = true;
 
@@ -318,7 +476,6 @@ namespace MV
 		if ( mState != eFinish && mState != eDisconnect )
 			return;
 
-		PathFinder pathFinder;
 		FindState from , to;
 		to.block     = block;
 		to.faceDirL  = to.block->rotation.toLocal( faceDir );
@@ -327,11 +484,11 @@ namespace MV
 		from.block = mWorld->getBlock( mHost->actBlockId );
 		from.faceDirL = from.block->rotation.toLocal( mHost->actFaceDir );
 
-		if ( !pathFinder.find( from , to ) )
+		if ( !mPathFinder.find( *mWorld , from , to ) )
 			return;
 
 		mMovePoints.clear();
-		pathFinder.contructPath( mPath , mMovePoints , *mWorld );
+		mPathFinder.contructPath( mPath , mMovePoints , *mWorld );
 		fixPathParallaxPosition( 0 );
 
 		mState = eRun;
@@ -47,11 +47,61 @@ namespace MV
 
 	typedef std::vector< Vec3f > PointVec;
 
+	//  Connected components of block surfaces over nav links.
+	//  Only components that had a dirty block ( Block::bNavDirty ) are flooded
+	//  again , other surfaces keep their component id.
+	class NavGraph
+	{
+	public:
+		NavGraph();
+
+		void update( World& world );
+		void clear();
+		//ids are never reused , same id means links of the component didn't change
+		int  getComponent( Block const& block , Dir faceDirL ) const
+		{
+			return mSurfaceComps[ block.id * NUM_BLOCK_FACE + faceDirL ];
+		}
+
+	private:
+		void floodComponent( World& world , int idxSurface , int comp );
+
+		std::vector< int > mSurfaceComps;
+		std::vector< int > mInvalidComps;
+		std::vector< int > mStack;
+		int                mNextComp;
+	};
+
 	class PathFinder
 	{
 	public:
-		bool find( FindState const& from , FindState const& to );
+		PathFinder();
+
+		bool find( World& world , FindState const& from , FindState const& to );
 		void contructPath( Path& path , PointVec& points , World const& world );
+		void clearCache();
+
+		NavGraph& getGraph(){ return mGraph; }
+
+	private:
+		//result of A* , kept while the component of the start surface is same
+		struct CachedPath
+		{
+			int  fromId;
+			Dir  fromFaceDirL;
+			Dir  fromUpDir;
+			int  toId;
+			Dir  toFaceDirL;
+			int  comp;
+			bool bFound;
+			std::vector< FindState > states;
+		};
+		static int const MaxCachedPathNum = 16;
+
+		NavGraph                  mGraph;
+		std::vector< CachedPath > mCachedPaths;
+		int                       mIdxNextCache;
+		int                       mIdxPath;
 	};
 
 	class Navigator
@@ -81,8 +131,9 @@ namespace MV
 		void fixPathParallaxPosition( int idxStart );
 
 
-		PointVec mMovePoints;
-		Path     mPath;
+		PointVec   mMovePoints;
+		Path       mPath;
+		PathFinder mPathFinder;
 		State    mState;
 
 		Actor* mHost;
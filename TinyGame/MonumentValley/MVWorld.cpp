@@ -181,6 +181,7 @@ namespace MV
 		}
 		block->idMesh = idMesh;
 		block->updateCount = 0;
+		block->bNavDirty = true;
 		if ( group == NULL )
 			group = &mRootGroup;
 
@@ -236,6 +237,7 @@ namespace MV
 		mFreeBlockId = -id;
 
 		removeNavNode( *block );
+		block->bNavDirty = true;
 
 		increaseUpdateCount();
 		updateNeighborNavNode( block->pos );
@@ -866,6 +868,8 @@ namespace MV
 			iter != itEnd ; ++iter )
 		{
 			Block* block = *iter;
+			//group will be moved , static links keep but world dir of surfaces changes
+			block->bNavDirty = true;
 
 			for( int i = 0 ; i < NUM_BLOCK_FACE ; ++i )
 			{
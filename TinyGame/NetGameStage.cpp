@@ -881,6 +881,20 @@ void GameNetLevelStage::updateFrame( int frame )
 	getSubStage()->updateFrame( frame );
 }
 
+unsigned GameNetLevelStage::calcFrameChecksum()
+{
+	return getSubStage()->calcFrameChecksum();
+}
+
+void GameNetLevelStage::onFrameDesync( long frame )
+{
+	changeState( GS_PAUSE );
+
+	FixString< 256 > str;
+	str.format( "Game Desync at Frame %d" , (int)frame );
+	::Global::getGUI().showMessageBox( UI_ANY , str , GMB_OK );
+}
+
 
 
 void GameNetLevelStage::onUpdate( long time )
@@ -194,6 +194,8 @@ public:
 	//FrameUpdater
 	void  updateFrame( int frame );
 	void  tick();
+	unsigned calcFrameChecksum();
+	void     onFrameDesync( long frame );
 
 	void setupServerProcFun( ComEvaluator& evaluator );
 	void setupWorkerProcFun( ComEvaluator& evaluator );
@@ -0,0 +1,76 @@
+#ifndef MMANN_FC_ATOMIC_H
+#define MMANN_FC_ATOMIC_H
+
+////////////////////////////////////////////////
+///\file FCAtomic.h
+///\brief This file contains the atomic primitives used by the thread safe solver classes
+////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#include <windows.h>
+///64-bit integer usable with the atomic functions
+typedef __int64 FCAtomic64;
+#elif defined(__GNUC__)
+///64-bit integer usable with the atomic functions
+typedef long long FCAtomic64;
+#endif
+
+///\brief Atomically replace Destination with Exchange if it equals Comparand
+///
+///\return The value of Destination before the operation
+inline FCAtomic64 FCAtomicCompareExchange64(volatile FCAtomic64* Destination, FCAtomic64 Exchange, FCAtomic64 Comparand)
+{
+#ifdef _MSC_VER
+	return InterlockedCompareExchange64(Destination, Exchange, Comparand);
+#else
+	return __sync_val_compare_and_swap(Destination, Comparand, Exchange);
+#endif
+}
+
+///\brief Atomically replace Destination with Exchange if it equals Comparand
+///
+///\return The value of Destination before the operation
+inline void* FCAtomicCompareExchangePointer(void* volatile* Destination, void* Exchange, void* Comparand)
+{
+#ifdef _MSC_VER
+	return InterlockedCompareExchangePointer(Destination, Exchange, Comparand);
+#else
+	return __sync_val_compare_and_swap(Destination, Comparand, Exchange);
+#endif
+}
+
+///\brief Atomically increment Value
+///
+///\return The incremented value
+inline long FCAtomicIncrement(volatile long* Value)
+{
+#ifdef _MSC_VER
+	return InterlockedIncrement(Value);
+#else
+	return __sync_add_and_fetch(Value, 1);
+#endif
+}
+
+///\brief Atomically add Amount to Value
+///
+///\return The value before the addition
+inline long FCAtomicExchangeAdd(volatile long* Value, long Amount)
+{
+#ifdef _MSC_VER
+	return InterlockedExchangeAdd(Value, Amount);
+#else
+	return __sync_fetch_and_add(Value, Amount);
+#endif
+}
+
+///\brief Full memory barrier, used before publishing data to other threads
+inline void FCAtomicMemoryBarrier()
+{
+#ifdef _MSC_VER
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+#endif
@@ -63,7 +63,7 @@ FCCommandLineArguments::~FCCommandLineArguments()
 {
 }
 
-bool FCCommandLineArguments::Parse(int argc, char**argv)
+bool FCCommandLineArguments::Parse(int argc, char**argv, const char* UserState)
 {
 	int arg;
 
@@ -248,6 +248,12 @@ bool FCCommandLineArguments::Parse(int argc, char**argv)
 		}
  	}
 
+	if (UserState != NULL)
+	{
+		strncpy(m_UserState, UserState, sizeof(m_UserState)/sizeof(char) - 1);
+		m_UserState[sizeof(m_UserState)/sizeof(char) - 1] = NULL;
+		return true;
+	}
 	
 	FILE * file;
 
@@ -698,6 +704,10 @@ bool FCCommandLineArguments::Verify()
 		{
 			m_StateStorageType = FC_INTERNAL_HASH;
 		}
+		else if (!strcmp(m_StateStorage, "lockfree"))
+		{
+			m_StateStorageType = FC_LOCK_FREE_HASH;
+		}
 		else if (!strcmp(m_StateStorage, "indirect"))
 		{
 			if ((m_StateType != FC_INDIRECT_STATE) && (m_StateType != FC_TALON_INDIRECT_STATE))
@@ -1059,7 +1069,8 @@ void DisplayHelp()
 		 << "\t\t\"red_black\" - a red-black tree" << endl
 		 << "\t\t\"glib_tree\" - a glib tree" << endl
 		 << "\t\t\"glib_hash\" - a glib hash" << endl
-		 << "\t\t\"internal\" - internal storage" << endl << endl
+		 << "\t\t\"internal\" - internal storage" << endl
+		 << "\t\t\"lockfree\" - a lock-free fingerprint hash (thread safe)" << endl << endl
 		 << "-sksr --stack-storage-type" << endl
 		 << "\tSpecify a storage method for the stacks.  Available methods are:" << endl
 		 << "\t\t\"avl\" - an avl tree" << endl
@@ -54,8 +54,10 @@ public:
 	///
 	///\param argc is the number of arguments
 	///\param argv is an array of null-terminated strings
+	///\param UserState is the board to solve; if NULL it's read from the file named
+	///after the options (or standard input)
 	///\return Return true for successful parse, false otherwise
-	bool Parse(int argc, char **argv);
+	bool Parse(int argc, char **argv, const char* UserState = NULL);
 
 	///\brief Verify the validity of the command line arguments
 	///
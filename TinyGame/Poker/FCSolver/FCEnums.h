@@ -69,7 +69,8 @@ enum FCStorageType {FC_AVL_TREE = 1,
 					FC_GLIB_TREE,
 					FC_GLIB_HASH,
 					FC_INTERNAL_HASH,
-					FC_INDIRECT_HASH};
+					FC_INDIRECT_HASH,
+					FC_LOCK_FREE_HASH};
 
 ///Solving functions return codes
 enum FCSStateSolvingReturnCodes
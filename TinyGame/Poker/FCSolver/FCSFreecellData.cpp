@@ -37,6 +37,7 @@ void FCSFreecellData::InitFCSFreecellData()
 
 	m_SolutionMoves = NULL;
 	m_ProtoSolutionMoves = NULL;
+	m_FinalState = NULL;
 
 	m_NumberOfStatesInCollection = 0;
 	m_MaxNumberOfStatesInCollection = -1;
@@ -127,6 +128,10 @@ FCSFreecellData::FCSFreecellData(FCCommandLineArguments* CommandLine)
 	case FC_INDIRECT_HASH:
 		m_StateStorage = new FCIndirectStateStorage();
 			break;
+	case FC_LOCK_FREE_HASH:
+		m_StateStorage = new FCLockFreeHashStateStorage(LOCK_FREE_HASH_TABLE_SIZE, &m_CompareFunction,
+						CommandLine->GetNumberOfFreecells(), CommandLine->GetNumberOfStacks(), CommandLine->GetNumberOfDecks());
+		break;
 	default:
 		m_StateStorage = NULL;
 	}
@@ -374,6 +379,50 @@ void FCSFreecellData::IncreaseMaxNumberOfCheckedStates()
 	m_MaxNumberOfCheckedStates += 10;
 }
 
+void FCSFreecellData::SetMaxNumberOfCheckedStates(int MaxNumberOfCheckedStates)
+{
+	m_MaxNumberOfCheckedStates = MaxNumberOfCheckedStates;
+}
+
+int FCSFreecellData::GetSolutionLength()
+{
+	if (m_FinalState == NULL)
+		return 0;
+
+	int Length = 0;
+	FCSMove* Move = FCSMove::Create();
+
+	for (FCSStateWithLocations* State = m_FinalState;State->m_Parent != NULL;State = State->m_Parent)
+	{
+		if (State->m_MovesToParent == NULL)
+			continue;
+
+		//popping empties the stack, so count on a copy
+		FCSMoveStack* Moves = State->m_MovesToParent->Copy();
+		while (Moves->Pop(&Move) == 0)
+		{
+			switch(Move->GetType())
+			{
+			case FCS_MOVE_TYPE_CANONIZE:
+			case FCS_MOVE_TYPE_SEPARATOR:
+			case FCS_MOVE_TYPE_NULL:
+				break;
+			default:
+				Length++;
+			}
+		}
+		delete Moves;
+	}
+
+	delete Move;
+	return Length;
+}
+
+int FCSFreecellData::GetStateMemorySize()
+{
+	return m_NumberOfStatePacks * m_StatePackLength * GetFCSStateWithLocationsClassSize();
+}
+
 int FCSFreecellData::GetNextMove(FCSStateWithLocations* StateWithLocations, FCSMove* Move)
 {
 	int ReturnValue = m_SolutionMoves->Pop(&Move);
@@ -49,6 +49,21 @@ public:
 	///\brief Increase the max number of checked states allowed
 	void IncreaseMaxNumberOfCheckedStates();
 
+	///\brief Set the max number of checked states allowed before the solve is suspended
+	///
+	///\param MaxNumberOfCheckedStates is the new limit, negative for no limit
+	void SetMaxNumberOfCheckedStates(int MaxNumberOfCheckedStates);
+
+	///\brief Get the number of card moves from the initial state to the final state
+	///
+	///\return Number of moves, 0 if the game hasn't been solved
+	int GetSolutionLength();
+
+	///\brief Get the memory held by the state packs
+	///
+	///\return Size in bytes
+	int GetStateMemorySize();
+
 	///\brief Delete the current solution states to create room for
 	///an optimized solution
 	void CleanData();
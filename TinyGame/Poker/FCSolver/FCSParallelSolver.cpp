@@ -0,0 +1,275 @@
+////////////////////////////////////////////////
+///\file FCSParallelSolver.cpp
+///\brief This file contains the implementation of the FCSParallelDealSolver class
+////////////////////////////////////////////////
+
+#include <string.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+#include "FCSParallelSolver.h"
+#include "FCSFreecellSolvingAlgorithm.h"
+#include "FCCommandLineArguments.h"
+#include "FCPresets.h"
+
+#include "Thread.h"
+
+unsigned long FCSGetWallTime()
+{
+#ifdef _MSC_VER
+	return GetTickCount();
+#else
+	timeval Time;
+	gettimeofday(&Time, NULL);
+	return (unsigned long)Time.tv_sec * 1000 + Time.tv_usec / 1000;
+#endif
+}
+
+const char* FCSGetBoardPresetName(const char* BoardName)
+{
+	//board generators of other programs deal the same game as the preset
+	//without their prefix, "microsoft_freecell" is "freecell"
+	static const char * const Prefixes[] = { "pysol_", "microsoft_", "gnome_" };
+
+	for (int a = 0;a<(int)(sizeof(Prefixes)/sizeof(char*));a++)
+	{
+		int Length = strlen(Prefixes[a]);
+		if (!strncmp(BoardName, Prefixes[a], Length))
+		{
+			BoardName += Length;
+			break;
+		}
+	}
+
+	if (FCSPresetName::GetPresetID(BoardName) < 0)
+		return NULL;
+	return BoardName;
+}
+
+FCSParallelDealSolver::FCSParallelDealSolver(const char* BoardName, int NumberOfOptions, const char* const* Options, int NumberOfThreads)
+{
+	strncpy(m_BoardName, BoardName, GAME_NAME_LENGTH - 1);
+	m_BoardName[GAME_NAME_LENGTH - 1] = NULL;
+
+	if (NumberOfOptions > MAX_NUM_SOLVER_OPTIONS)
+		NumberOfOptions = MAX_NUM_SOLVER_OPTIONS;
+
+	//Parse() skips the first argument like a program name
+	m_NumberOfOptions = 0;
+	m_Options[m_NumberOfOptions] = new char[1];
+	m_Options[m_NumberOfOptions++][0] = NULL;
+
+	bool HaveStorage = false;
+	m_HavePreset = false;
+	for (int a = 0;a<NumberOfOptions;a++)
+	{
+		if ((!strcmp(Options[a], "-stsr")) || (!strcmp(Options[a], "--state-storage-type")))
+			HaveStorage = true;
+		if ((!strcmp(Options[a], "-g")) || (!strcmp(Options[a], "--game")) || (!strcmp(Options[a], "--preset")))
+			m_HavePreset = true;
+
+		m_Options[m_NumberOfOptions] = new char[strlen(Options[a])+1];
+		strcpy(m_Options[m_NumberOfOptions++], Options[a]);
+	}
+
+	if (!HaveStorage)
+	{
+		m_Options[m_NumberOfOptions] = new char[sizeof("-stsr")];
+		strcpy(m_Options[m_NumberOfOptions++], "-stsr");
+		m_Options[m_NumberOfOptions] = new char[sizeof("lockfree")];
+		strcpy(m_Options[m_NumberOfOptions++], "lockfree");
+	}
+
+	//without a preset the solver plays Freecell rules whatever the board is
+	const char* PresetName = FCSGetBoardPresetName(m_BoardName);
+	if ((!m_HavePreset) && (PresetName != NULL))
+	{
+		m_Options[m_NumberOfOptions] = new char[sizeof("-g")];
+		strcpy(m_Options[m_NumberOfOptions++], "-g");
+		m_Options[m_NumberOfOptions] = new char[strlen(PresetName)+1];
+		strcpy(m_Options[m_NumberOfOptions++], PresetName);
+		m_HavePreset = true;
+	}
+	m_Options[m_NumberOfOptions] = NULL;
+
+	if (NumberOfThreads < 1)
+		NumberOfThreads = 1;
+	if (NumberOfThreads > MAX_NUM_SOLVER_THREADS)
+		NumberOfThreads = MAX_NUM_SOLVER_THREADS;
+	m_NumberOfThreads = NumberOfThreads;
+
+	m_MaxNumberOfCheckedStates = -1;
+	m_MaxSolveTime = -1;
+
+	m_NextDeal = 0;
+	m_FirstDeal = 0;
+	m_LastDeal = -1;
+	m_Results = NULL;
+	m_HaveError = 0;
+}
+
+FCSParallelDealSolver::~FCSParallelDealSolver()
+{
+	for (int a = 0;a<m_NumberOfOptions;a++)
+		delete [] m_Options[a];
+}
+
+void FCSParallelDealSolver::SetBudget(int MaxNumberOfCheckedStates, int MaxSolveTime)
+{
+	m_MaxNumberOfCheckedStates = MaxNumberOfCheckedStates;
+	m_MaxSolveTime = MaxSolveTime;
+}
+
+bool FCSParallelDealSolver::Solve(int FirstDeal, int LastDeal, FCSDealResult* Results)
+{
+	if (!m_HavePreset)
+		return false;
+	if (LastDeal < FirstDeal)
+		return true;
+
+	m_FirstDeal = FirstDeal;
+	m_LastDeal = LastDeal;
+	m_NextDeal = FirstDeal;
+	m_Results = Results;
+	m_HaveError = 0;
+
+	int NumberOfThreads = m_NumberOfThreads;
+	if (NumberOfThreads > LastDeal - FirstDeal + 1)
+		NumberOfThreads = LastDeal - FirstDeal + 1;
+
+	typedef MemberFunThread< FCSParallelDealSolver > WorkerThread;
+	WorkerThread* Workers = new WorkerThread[NumberOfThreads];
+
+	//the calling thread works too, so one thread less is started
+	int a;
+	for (a = 1;a<NumberOfThreads;a++)
+	{
+		Workers[a].init(this, &FCSParallelDealSolver::WorkerRun);
+		Workers[a].start();
+	}
+
+	WorkerRun();
+
+	for (a = 1;a<NumberOfThreads;a++)
+		Workers[a].join();
+
+	delete [] Workers;
+	m_Results = NULL;
+
+	return (m_HaveError == 0);
+}
+
+unsigned FCSParallelDealSolver::WorkerRun()
+{
+	for(;;)
+	{
+		int Deal = (int)FCAtomicExchangeAdd(&m_NextDeal, 1);
+		if ((Deal > m_LastDeal) || (m_HaveError != 0))
+			break;
+
+		if (!SolveDeal(Deal, &m_Results[Deal - m_FirstDeal]))
+		{
+			FCAtomicIncrement(&m_HaveError);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+bool FCSParallelDealSolver::SolveDeal(int Deal, FCSDealResult* Result)
+{
+	Result->m_Deal = Deal;
+	Result->m_ReturnCode = FCS_STATE_INVALID_STATE;
+	Result->m_NumberOfCheckedStates = 0;
+	Result->m_NumberOfStatesInCollection = 0;
+	Result->m_SolutionLength = 0;
+	Result->m_SolveTime = 0;
+	Result->m_MemorySize = 0;
+	Result->m_IsOverBudget = false;
+
+	if (!m_HavePreset)
+		return false;
+
+	unsigned long StartTime = FCSGetWallTime();
+
+	AFreecellGameBoard* GameBoard = CreateAFreecellGameBoard(m_BoardName, false);
+	if (GameBoard == NULL)
+		return false;
+
+	char* GameBoardString = new char[GameBoard->GetGameBoardSize()+1];
+	GameBoardString[0] = NULL;
+	GameBoard->Shuffle(Deal);
+	GameBoard->Deal(GameBoardString);
+	delete GameBoard;
+
+	//Every algorithm takes ownership of the debug info of its command line,
+	//so each deal needs its own command line object
+	FCCommandLineArguments* CommandLine = new FCCommandLineArguments();
+	bool IsValid = CommandLine->Parse(m_NumberOfOptions, m_Options, GameBoardString) &&
+				   CommandLine->Verify();
+	delete [] GameBoardString;
+
+	if (!IsValid)
+	{
+		delete CommandLine;
+		return false;
+	}
+
+	FCSFreecellSolvingAlgorithm* SolvingAlgorithm = FCSFreecellSolvingAlgorithm::Create(CommandLine);
+	FCSStateWithLocations* InitialState = CommandLine->GetInitialState();
+	if ((SolvingAlgorithm == NULL) || (InitialState == NULL))
+	{
+		delete InitialState;
+		delete SolvingAlgorithm;
+		delete CommandLine;
+		return false;
+	}
+
+	InitialState->CanonizeState(CommandLine->GetNumberOfFreecells(), CommandLine->GetNumberOfStacks());
+
+	//Without a budget the "-mi" option is the only limit.  With a time budget the
+	//search is suspended every SOLVER_TIME_SLICE_STATES states to look at the clock.
+	int MaxNumberOfCheckedStates = m_MaxNumberOfCheckedStates;
+	if (m_MaxSolveTime >= 0)
+		MaxNumberOfCheckedStates = SOLVER_TIME_SLICE_STATES;
+	if ((m_MaxNumberOfCheckedStates >= 0) && (MaxNumberOfCheckedStates > m_MaxNumberOfCheckedStates))
+		MaxNumberOfCheckedStates = m_MaxNumberOfCheckedStates;
+	if ((m_MaxSolveTime >= 0) || (m_MaxNumberOfCheckedStates >= 0))
+		SolvingAlgorithm->SetMaxNumberOfCheckedStates(MaxNumberOfCheckedStates);
+
+	FCSStateSolvingReturnCodes ReturnCode = SolvingAlgorithm->Solve(InitialState, 0);
+	while (ReturnCode == FCS_STATE_SUSPEND_PROCESS)
+	{
+		int CheckedStates = SolvingAlgorithm->GetNumberOfCheckedStates();
+		if ((m_MaxNumberOfCheckedStates >= 0) && (CheckedStates >= m_MaxNumberOfCheckedStates))
+			break;
+		if ((m_MaxSolveTime < 0) || 
+			((int)(FCSGetWallTime() - StartTime) >= m_MaxSolveTime))
+			break;
+
+		MaxNumberOfCheckedStates = CheckedStates + SOLVER_TIME_SLICE_STATES;
+		if ((m_MaxNumberOfCheckedStates >= 0) && (MaxNumberOfCheckedStates > m_MaxNumberOfCheckedStates))
+			MaxNumberOfCheckedStates = m_MaxNumberOfCheckedStates;
+		SolvingAlgorithm->SetMaxNumberOfCheckedStates(MaxNumberOfCheckedStates);
+
+		ReturnCode = SolvingAlgorithm->Resume(0);
+	}
+
+	Result->m_ReturnCode = ReturnCode;
+	Result->m_IsOverBudget = (ReturnCode == FCS_STATE_SUSPEND_PROCESS);
+	Result->m_NumberOfCheckedStates = SolvingAlgorithm->GetNumberOfCheckedStates();
+	Result->m_NumberOfStatesInCollection = SolvingAlgorithm->GetNumberOfStatesInCollection();
+	Result->m_MemorySize = SolvingAlgorithm->GetStateMemorySize();
+	if (ReturnCode == FCS_STATE_WAS_SOLVED)
+		Result->m_SolutionLength = SolvingAlgorithm->GetSolutionLength();
+	Result->m_SolveTime = (int)(FCSGetWallTime() - StartTime);
+
+	delete InitialState;
+	delete SolvingAlgorithm;
+	delete CommandLine;
+
+	return true;
+}
@@ -0,0 +1,133 @@
+#ifndef MMANN_FCS_PARALLEL_SOLVER_H
+#define MMANN_FCS_PARALLEL_SOLVER_H
+
+////////////////////////////////////////////////
+///\file FCSParallelSolver.h
+///\brief This file contains the FCSParallelDealSolver class, which solves a range of
+///deals on several worker threads
+////////////////////////////////////////////////
+
+#include "FCEnums.h"
+#include "FCAtomic.h"
+#include "AFreecellGameBoard.h"
+
+///Maximum number of worker threads of a FCSParallelDealSolver
+#define MAX_NUM_SOLVER_THREADS		32
+///Maximum number of options passed to each worker's solving algorithm
+#define MAX_NUM_SOLVER_OPTIONS		32
+///Number of checked states between two checks of the time budget
+#define SOLVER_TIME_SLICE_STATES	2000
+
+///\brief Result of solving one deal
+struct FCSDealResult
+{
+	///Deal number (shuffle seed)
+	int m_Deal;
+	///Return code of the solving algorithm
+	FCSStateSolvingReturnCodes m_ReturnCode;
+	///Number of states the algorithm checked
+	int m_NumberOfCheckedStates;
+	///Number of states kept in the state storage
+	int m_NumberOfStatesInCollection;
+	///Number of card moves in the solution, 0 if not solved
+	int m_SolutionLength;
+	///Time spent on the deal in milliseconds
+	int m_SolveTime;
+	///Memory held by the states of the deal in bytes
+	int m_MemorySize;
+	///Set when the deal ran out of its node or time budget
+	bool m_IsOverBudget;
+};
+
+///\brief Wall clock in milliseconds, only differences are meaningful.
+///clock() can't be used for it, it counts the CPU time of all threads on POSIX.
+unsigned long FCSGetWallTime();
+
+///\brief Name of the solver preset with the rules of a board generator
+///
+///\param BoardName is the name of the board generator (e.g. "pysol_seahaven")
+///\return the preset name, or NULL if no preset has the rules of the game
+const char* FCSGetBoardPresetName(const char* BoardName);
+
+template <class T>
+class MemberFunThread;
+
+///\brief Solves a range of deals in parallel
+///
+///Deal numbers are handed out to the workers through an atomic counter, so a hard
+///deal only holds up the thread solving it.  Every deal gets its own solving algorithm
+///created from the same options; the options default to the lock-free state storage
+///("-stsr lockfree"), which needs no rebalancing while the search grows, and to the
+///preset of the board generator ("-g"), so the deals are solved with their own rules.
+class FCSParallelDealSolver
+{
+public:
+	///\brief Constructor
+	///
+	///\param BoardName is the name of the board generator (e.g. "microsoft_freecell")
+	///\param NumberOfOptions is the number of solver options
+	///\param Options are the solver options, in command line form, without the board file.
+	///They need a "-g" preset if FCSGetBoardPresetName doesn't know the board.
+	///\param NumberOfThreads is the number of worker threads (clamped to MAX_NUM_SOLVER_THREADS)
+	FCSParallelDealSolver(const char* BoardName, int NumberOfOptions, const char* const* Options, int NumberOfThreads);
+
+	///Destructor
+	~FCSParallelDealSolver();
+
+	///\brief Set the budget of each deal.  A deal that exceeds it is reported
+	///with FCS_STATE_SUSPEND_PROCESS.
+	///
+	///\param MaxNumberOfCheckedStates is the node budget, negative for none
+	///\param MaxSolveTime is the time budget in milliseconds, negative for none
+	void SetBudget(int MaxNumberOfCheckedStates, int MaxSolveTime);
+
+	///\brief Solve the deals FirstDeal to LastDeal (inclusive)
+	///
+	///\param FirstDeal is the first deal number
+	///\param LastDeal is the last deal number
+	///\param Results receives one result per deal, in deal order
+	///\return false if the board generator or the options are invalid, or there is
+	///no preset for the board
+	bool Solve(int FirstDeal, int LastDeal, FCSDealResult* Results);
+
+	///\brief Solve a single deal on the calling thread
+	///
+	///\param Deal is the deal number
+	///\param Result receives the result
+	///\return false if the board generator or the options are invalid, or there is
+	///no preset for the board
+	bool SolveDeal(int Deal, FCSDealResult* Result);
+
+protected:
+	///\brief Worker thread entry, solves deals until the range is exhausted
+	unsigned WorkerRun();
+
+	///Name of the board generator
+	char m_BoardName[GAME_NAME_LENGTH];
+	///Solver options, m_Options[0] is the program name slot, then the options,
+	///the storage and preset defaults and a NULL
+	char* m_Options[MAX_NUM_SOLVER_OPTIONS+6];
+	///Number of entries in m_Options
+	int m_NumberOfOptions;
+	///Set when the options have the rules of the board (a "-g" preset)
+	bool m_HavePreset;
+	///Number of worker threads
+	int m_NumberOfThreads;
+	///Node budget of a deal
+	int m_MaxNumberOfCheckedStates;
+	///Time budget of a deal in milliseconds
+	int m_MaxSolveTime;
+
+	///Next deal to hand out
+	volatile long m_NextDeal;
+	///Last deal of the current range
+	int m_LastDeal;
+	///First deal of the current range
+	int m_FirstDeal;
+	///Results of the current range
+	FCSDealResult* m_Results;
+	///Set when a worker failed to set up a deal
+	volatile long m_HaveError;
+};
+
+#endif
@@ -272,3 +272,175 @@ bool FCIndirectStateStorage::CheckAndInsert(FCSStateWithLocations** ExistingStat
 	return false;
 }
 
+
+FCAtomic64 FCSStateFingerprint(FCSStateWithLocations* State, int NumberOfFreecells, int NumberOfStacks, int NumberOfDecks)
+{
+	//FNV-1a over the canonized cards, followed by a 64-bit finalizer
+	unsigned long long Hash = 0xcbf29ce484222325ULL;
+	int a, b, Length;
+	FCSCard* Card;
+
+#define FC_FINGERPRINT_BYTE(Byte) Hash = (Hash ^ (unsigned char)(Byte)) * 0x100000001b3ULL
+
+	for (a = 0;a<NumberOfStacks;a++)
+	{
+		Length = State->GetStackLength(a);
+		FC_FINGERPRINT_BYTE(Length | 0x80);
+		for (b = 0;b<Length;b++)
+		{
+			Card = State->GetStackCard(a, b);
+			FC_FINGERPRINT_BYTE(Card->GetCardNumber() | (Card->GetSuit() << 4) | (Card->GetFlipped() << 6));
+		}
+	}
+
+	for (a = 0;a<NumberOfFreecells;a++)
+		FC_FINGERPRINT_BYTE(State->GetFreecellCardNumber(a) | (State->GetFreecellCardSuit(a) << 4));
+
+	for (a = 0;a<4*NumberOfDecks;a++)
+		FC_FINGERPRINT_BYTE(State->GetFoundation(a));
+
+#undef FC_FINGERPRINT_BYTE
+
+	Hash ^= Hash >> 33;
+	Hash *= 0xff51afd7ed558ccdULL;
+	Hash ^= Hash >> 33;
+	Hash *= 0xc4ceb9fe1a85ec53ULL;
+	Hash ^= Hash >> 33;
+
+	//0 marks an empty slot
+	return (Hash == 0) ? 1 : (FCAtomic64)Hash;
+}
+
+FCLockFreeHashStateStorage::FCLockFreeHashStateStorage(int SizeWanted, ACompareNodesAlgorithm<FCSStateWithLocations, void>* Compare,
+													   int NumberOfFreecells, int NumberOfStacks, int NumberOfDecks)
+{
+	int Size = 16;
+	while (Size < SizeWanted)
+		Size <<= 1;
+
+	m_Compare = Compare;
+	m_NumberOfFreecells = NumberOfFreecells;
+	m_NumberOfStacks = NumberOfStacks;
+	m_NumberOfDecks = NumberOfDecks;
+	m_Segments = CreateSegment(Size);
+}
+
+FCLockFreeHashStateStorage::~FCLockFreeHashStateStorage()
+{
+	//the states belong to the state packs, only the tables are freed
+	Segment* Seg = m_Segments;
+	while (Seg != NULL)
+	{
+		Segment* Next = Seg->m_Next;
+		delete [] Seg->m_Keys;
+		delete [] Seg->m_States;
+		delete Seg;
+		Seg = Next;
+	}
+}
+
+FCLockFreeHashStateStorage::Segment* FCLockFreeHashStateStorage::CreateSegment(int Size)
+{
+	Segment* Seg = new Segment;
+	Seg->m_Keys = new FCAtomic64[Size];
+	Seg->m_States = new FCSStateWithLocations*[Size];
+	memset((void*)Seg->m_Keys, 0, sizeof(FCAtomic64)*Size);
+	memset((void*)Seg->m_States, 0, sizeof(FCSStateWithLocations*)*Size);
+	Seg->m_Mask = Size - 1;
+	Seg->m_Count = 0;
+	Seg->m_Next = NULL;
+	return Seg;
+}
+
+FCSStateWithLocations* FCLockFreeHashStateStorage::Probe(Segment* Seg, FCAtomic64 Key, FCSStateWithLocations* NewState, bool Insert)
+{
+	int Index = (int)(Key ^ (Key >> 32)) & Seg->m_Mask;
+
+	for (int Step = 0;Step <= Seg->m_Mask;Step++)
+	{
+		FCAtomic64 SlotKey = Seg->m_Keys[Index];
+
+		if (SlotKey == 0)
+		{
+			//states are never removed, so an empty slot ends the probe sequence
+			if (!Insert)
+				return NULL;
+
+			if ((long long)Seg->m_Count * 100 >= (long long)(Seg->m_Mask + 1) * LOCK_FREE_HASH_MAX_LOAD)
+				return NULL;
+
+			SlotKey = FCAtomicCompareExchange64(&Seg->m_Keys[Index], Key, 0);
+			if (SlotKey == 0)
+			{
+				FCAtomicMemoryBarrier();
+				Seg->m_States[Index] = NewState;
+				FCAtomicIncrement(&Seg->m_Count);
+				return NewState;
+			}
+			//another thread claimed the slot first, check what it put there
+		}
+
+		if (SlotKey == Key)
+		{
+			FCSStateWithLocations* State;
+			//the owner of the slot may not have published its state yet
+			while ((State = Seg->m_States[Index]) == NULL)
+				FCAtomicMemoryBarrier();
+
+			if (m_Compare->Compare(State, NewState, NULL) == 0)
+				return State;
+		}
+
+		Index = (Index + 1) & Seg->m_Mask;
+	}
+
+	return NULL;
+}
+
+bool FCLockFreeHashStateStorage::CheckAndInsert(FCSStateWithLocations** ExistingState, FCSStateWithLocations* NewState)
+{
+	FCAtomic64 Key = FCSStateFingerprint(NewState, m_NumberOfFreecells, m_NumberOfStacks, m_NumberOfDecks);
+	Segment* Seg = m_Segments;
+
+	for(;;)
+	{
+		//only the newest segment takes insertions, older ones are just searched
+		FCSStateWithLocations* Found = Probe(Seg, Key, NewState, Seg->m_Next == NULL);
+		if (Found != NULL)
+		{
+			*ExistingState = Found;
+			return (Found == NewState);
+		}
+
+		if (Seg->m_Next == NULL)
+		{
+			//The segment is full.  Two threads inserting the same state right at this
+			//moment can both succeed; that only costs one redundant expansion.
+			Segment* Next = CreateSegment((Seg->m_Mask + 1) * 2);
+			if (FCAtomicCompareExchangePointer((void* volatile*)&Seg->m_Next, Next, NULL) != NULL)
+			{
+				delete [] Next->m_Keys;
+				delete [] Next->m_States;
+				delete Next;
+			}
+		}
+
+		Seg = Seg->m_Next;
+	}
+}
+
+int FCLockFreeHashStateStorage::GetNumberOfStates()
+{
+	int Count = 0;
+	for (Segment* Seg = m_Segments;Seg != NULL;Seg = Seg->m_Next)
+		Count += Seg->m_Count;
+	return Count;
+}
+
+int FCLockFreeHashStateStorage::GetMemorySize()
+{
+	int Size = 0;
+	for (Segment* Seg = m_Segments;Seg != NULL;Seg = Seg->m_Next)
+		Size += sizeof(Segment) + (Seg->m_Mask + 1) * (sizeof(FCAtomic64) + sizeof(FCSStateWithLocations*));
+	return Size;
+}
@@ -18,6 +18,7 @@
 #include "FCSIndirectStateWithLocations.h"
 #include "FCSIndirectStateCompareAlgorithm.h"
 #include "FCState.h"
+#include "FCAtomic.h"
 
 ///The sort margin size for the previous states array.
 #define PREV_STATES_SORT_MARGIN		32
@@ -27,6 +28,10 @@
 #define HASH_TABLE_SIZE				2048
 ///How big to make the talon cache
 #define TALON_CACHE_SIZE			512
+///How big to make the first lock-free hash segment (rounded up to a power of 2)
+#define LOCK_FREE_HASH_TABLE_SIZE	0x10000
+///Percent of a lock-free hash segment that may be used before a new segment is chained
+#define LOCK_FREE_HASH_MAX_LOAD		70
 
 ///\brief Abstract, generic state storage class
 class AFCSGenericStateStorage
@@ -191,6 +196,96 @@ protected:
 	FCSIndirectStatesCompareAlgorithm<FCSIndirectStateWithLocations<FCSStateWithLocations>*> m_Compare;
 };
 
+///\brief Compute a 64-bit fingerprint of a canonized state
+///
+///The stacks are already sorted by CanonizeState, so two states that only differ
+///in the order of their stacks or freecells get the same fingerprint.
+///\param State is the canonized state
+///\param NumberOfFreecells is the number of freecells in the card game
+///\param NumberOfStacks is the number of stacks in the card game
+///\param NumberOfDecks is the number of decks in the card game
+///\return Fingerprint of the state, never 0
+FCAtomic64 FCSStateFingerprint(FCSStateWithLocations* State, int NumberOfFreecells, int NumberOfStacks, int NumberOfDecks);
+
+///\brief Lock-free fingerprint hash state storage class
+///
+///Slots are claimed with a compare-exchange on the fingerprint, so any number of
+///solving threads can share one storage without locking.  States with equal
+///fingerprints are still told apart with the compare algorithm.  A full segment
+///is never rehashed; a segment twice as large is chained after it instead.
+class FCLockFreeHashStateStorage : public AFCSGenericStateStorage
+{
+public:
+	///Constructor
+	FCLockFreeHashStateStorage(int SizeWanted, ACompareNodesAlgorithm<FCSStateWithLocations, void>* Compare,
+								int NumberOfFreecells = MAX_NUM_FREECELLS, int NumberOfStacks = MAX_NUM_STACKS,
+								int NumberOfDecks = MAX_NUM_DECKS);
+
+	///Destructor
+	virtual ~FCLockFreeHashStateStorage();
+
+	///\brief Insert a state into storage.  Safe to call from several threads at once.
+	///
+	///\param ExistingState is the found or recently inserted state
+	///\param NewState is the state to try to insert (must be canonized)
+	///\return Return true if state was inserted, else false
+	virtual bool CheckAndInsert(FCSStateWithLocations** ExistingState, FCSStateWithLocations* NewState);
+
+	///\brief Get the number of states stored
+	///
+	///\return Number of states in all segments
+	int GetNumberOfStates();
+
+	///\brief Get the memory used by the slot tables
+	///
+	///\return Size in bytes
+	int GetMemorySize();
+
+protected:
+	///\brief One open-addressing table of the storage
+	struct Segment
+	{
+		///Fingerprints, 0 marks an empty slot
+		volatile FCAtomic64* m_Keys;
+		///States, published after their fingerprint
+		FCSStateWithLocations* volatile* m_States;
+		///Number of slots - 1
+		int m_Mask;
+		///Number of slots in use
+		volatile long m_Count;
+		///Next (larger) segment, or NULL
+		Segment* volatile m_Next;
+	};
+
+	///\brief Allocate an empty segment
+	///
+	///\param Size is the number of slots, a power of 2
+	///\return The new segment
+	Segment* CreateSegment(int Size);
+
+	///\brief Look for a state in a segment, claiming a slot for it if it isn't there
+	///
+	///\param Seg is the segment to search
+	///\param Key is the fingerprint of the state
+	///\param NewState is the state to insert
+	///\param Insert determines whether an empty slot is claimed for NewState
+	///\return The state found or inserted, NULL if it isn't in the segment (or the segment is full)
+	FCSStateWithLocations* Probe(Segment* Seg, FCAtomic64 Key, FCSStateWithLocations* NewState, bool Insert);
+
+	///First segment of the chain
+	Segment* m_Segments;
+
+	///Compares two states with the same fingerprint
+	ACompareNodesAlgorithm<FCSStateWithLocations, void>* m_Compare;
+
+	///Number of freecells hashed into the fingerprint
+	int m_NumberOfFreecells;
+	///Number of stacks hashed into the fingerprint
+	int m_NumberOfStacks;
+	///Number of decks hashed into the fingerprint
+	int m_NumberOfDecks;
+};
+
 /****************************
 Add talon class that is similar to above
 *****************************/
@@ -0,0 +1,198 @@
+////////////////////////////////////////////////
+///\file MainBatchSolver.cpp
+///\brief This is a program to solve a range of deals headless and compare the solving
+///methods.  Its output is the regression benchmark for solver changes.
+////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "FCSParallelSolver.h"
+
+///Solving methods compared by default
+static const char * const AllMethods[] = { "dfs", "soft-dfs", "bfs", "a-star" };
+
+///Maximum number of methods given with -me
+#define MAX_NUM_BATCH_METHODS		8
+
+///\brief Print the statistics of one solving method
+///
+///\param Method is the name of the method
+///\param Results are the deal results
+///\param NumberOfDeals is the number of results
+///\param WallTime is the time the whole range took in milliseconds
+///\param Verbose prints one line per deal too
+void PrintMethodStats(const char* Method, FCSDealResult* Results, int NumberOfDeals, int WallTime, bool Verbose)
+{
+	int Solved = 0, Unsolvable = 0, OverBudget = 0;
+	double TotalLength = 0, TotalCheckedStates = 0, TotalTime = 0;
+	int MaxMemory = 0;
+
+	for (int a = 0;a<NumberOfDeals;a++)
+	{
+		FCSDealResult& Result = Results[a];
+
+		if (Verbose)
+		{
+			printf("%-10s deal %8d  code %2d  length %4d  checked %9d  stored %9d  time %7dms  memory %9d\n",
+					Method, Result.m_Deal, Result.m_ReturnCode, Result.m_SolutionLength,
+					Result.m_NumberOfCheckedStates, Result.m_NumberOfStatesInCollection,
+					Result.m_SolveTime, Result.m_MemorySize);
+		}
+
+		if (Result.m_ReturnCode == FCS_STATE_WAS_SOLVED)
+		{
+			Solved++;
+			TotalLength += Result.m_SolutionLength;
+		}
+		else if (Result.m_IsOverBudget)
+		{
+			OverBudget++;
+		}
+		else
+		{
+			Unsolvable++;
+		}
+
+		TotalCheckedStates += Result.m_NumberOfCheckedStates;
+		TotalTime += Result.m_SolveTime;
+		if (Result.m_MemorySize > MaxMemory)
+			MaxMemory = Result.m_MemorySize;
+	}
+
+	printf("%-10s solved %6d  unsolvable %6d  over budget %6d  avg length %7.1f  avg checked %10.0f  avg time %8.1fms  peak memory %10d  deals/min %9.1f\n",
+			Method, Solved, Unsolvable, OverBudget,
+			(Solved > 0) ? TotalLength / Solved : 0.0,
+			TotalCheckedStates / NumberOfDeals,
+			TotalTime / NumberOfDeals,
+			MaxMemory,
+			(WallTime > 0) ? NumberOfDeals * 60000.0 / WallTime : 0.0);
+}
+
+///\brief The batch solver main function
+///
+///Usage: BatchSolver [-g board] [-from deal] [-to deal] [-t threads] [-nodes max] [-time ms]
+///                   [-me method]... [-v] [-- solver options]
+///
+///The deals are solved with the preset of the board ("pysol_seahaven" uses "seahaven").
+///Boards without a matching preset need one in the solver options ("-- -g game").
+int main(int argc, char **argv)
+{
+	const char* BoardName = "microsoft_freecell";
+	int FirstDeal = 1;
+	int LastDeal = 1000;
+	int NumberOfThreads = 4;
+	int MaxNumberOfCheckedStates = 100000;
+	int MaxSolveTime = -1;
+	bool Verbose = false;
+
+	const char* Methods[MAX_NUM_BATCH_METHODS];
+	int NumberOfMethods = 0;
+
+	const char* Options[MAX_NUM_SOLVER_OPTIONS];
+	int NumberOfOptions = 0;
+
+	//parse the command line
+	int arg;
+	for (arg = 1;arg<argc;arg++)
+	{
+		if ((!strcmp(argv[arg], "-g")) && (arg+1 < argc))
+		{
+			BoardName = argv[++arg];
+		}
+		else if ((!strcmp(argv[arg], "-from")) && (arg+1 < argc))
+		{
+			FirstDeal = atoi(argv[++arg]);
+		}
+		else if ((!strcmp(argv[arg], "-to")) && (arg+1 < argc))
+		{
+			LastDeal = atoi(argv[++arg]);
+		}
+		else if ((!strcmp(argv[arg], "-t")) && (arg+1 < argc))
+		{
+			NumberOfThreads = atoi(argv[++arg]);
+		}
+		else if ((!strcmp(argv[arg], "-nodes")) && (arg+1 < argc))
+		{
+			MaxNumberOfCheckedStates = atoi(argv[++arg]);
+		}
+		else if ((!strcmp(argv[arg], "-time")) && (arg+1 < argc))
+		{
+			MaxSolveTime = atoi(argv[++arg]);
+		}
+		else if ((!strcmp(argv[arg], "-me")) && (arg+1 < argc))
+		{
+			if (NumberOfMethods < MAX_NUM_BATCH_METHODS)
+				Methods[NumberOfMethods++] = argv[++arg];
+		}
+		else if (!strcmp(argv[arg], "-v"))
+		{
+			Verbose = true;
+		}
+		else if (!strcmp(argv[arg], "--"))
+		{
+			//everything after this goes to the solving algorithm
+			for (arg++;(arg<argc) && (NumberOfOptions < MAX_NUM_SOLVER_OPTIONS - 4);arg++)
+				Options[NumberOfOptions++] = argv[arg];
+			break;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'\n", argv[arg]);
+			return -1;
+		}
+	}
+
+	if (NumberOfMethods == 0)
+	{
+		for (int a = 0;a<(int)(sizeof(AllMethods)/sizeof(char*));a++)
+			Methods[NumberOfMethods++] = AllMethods[a];
+	}
+
+	if (LastDeal < FirstDeal)
+	{
+		fprintf(stderr, "Empty deal range\n");
+		return -1;
+	}
+
+	bool HavePreset = (FCSGetBoardPresetName(BoardName) != NULL);
+	for (int a = 0;a<NumberOfOptions;a++)
+	{
+		if ((!strcmp(Options[a], "-g")) || (!strcmp(Options[a], "--game")) || (!strcmp(Options[a], "--preset")))
+			HavePreset = true;
+	}
+	if (!HavePreset)
+	{
+		fprintf(stderr, "No solver preset for board '%s'; give the rules with \"-- -g game\"\n", BoardName);
+		return -1;
+	}
+
+	int NumberOfDeals = LastDeal - FirstDeal + 1;
+	FCSDealResult* Results = new FCSDealResult[NumberOfDeals];
+
+	printf("Board %s, deals %d-%d, %d threads, node budget %d, time budget %dms\n",
+			BoardName, FirstDeal, LastDeal, NumberOfThreads, MaxNumberOfCheckedStates, MaxSolveTime);
+
+	for (int m = 0;m<NumberOfMethods;m++)
+	{
+		//the method goes last so it overrides any "-me" in the user options
+		Options[NumberOfOptions] = "-me";
+		Options[NumberOfOptions+1] = Methods[m];
+
+		FCSParallelDealSolver Solver(BoardName, NumberOfOptions + 2, Options, NumberOfThreads);
+		Solver.SetBudget(MaxNumberOfCheckedStates, MaxSolveTime);
+
+		unsigned long StartTime = FCSGetWallTime();
+		if (!Solver.Solve(FirstDeal, LastDeal, Results))
+		{
+			fprintf(stderr, "Couldn't solve with method '%s'; check the board name and options\n", Methods[m]);
+			continue;
+		}
+		int WallTime = (int)(FCSGetWallTime() - StartTime);
+
+		PrintMethodStats(Methods[m], Results, NumberOfDeals, WallTime, Verbose);
+	}
+
+	delete [] Results;
+	return 0;
+}
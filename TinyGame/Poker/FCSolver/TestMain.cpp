@@ -50,6 +50,9 @@ int main(int argc, char **argv)
 	//test each game
 	TestEachGame();
 
+	//test the parallel deal solver
+	int ExitCode = TestParallelSolver();
+
 #ifdef _DEBUG
 	newMemState.Checkpoint();
 	if( diffMemState.Difference( oldMemState, newMemState ) )
@@ -61,5 +64,5 @@ int main(int argc, char **argv)
 	}
 #endif
 
-	return 0;
+	return ExitCode;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "TestSolvingAlgorithms.h"
 #include "MainGameFunctions.h"
 #include "AFreecellGameBoard.h"
+#include "FCSParallelSolver.h"
 
 #include <iostream>
 using std::endl;
@@ -916,4 +917,44 @@ void TestEachGame()
 		delete [] GameParameters[i];
 	delete [] GameParameters;
 
-}
\ No newline at end of file
+}
+///number of deals solved by TestParallelSolver
+#define TEST_PARALLEL_DEALS						64
+///number of worker threads used by TestParallelSolver
+#define TEST_PARALLEL_THREADS					4
+
+int TestParallelSolver()
+{
+	static const char * const Options[] = { "-st", "compact", "-me", "bfs", "-g", "freecell", "-mi", "20000" };
+	const int NumberOfOptions = sizeof(Options)/sizeof(char*);
+
+	FCSDealResult SerialResults[TEST_PARALLEL_DEALS];
+	FCSDealResult ParallelResults[TEST_PARALLEL_DEALS];
+
+	//the single threaded run keeps the old tree storage as the reference
+	static const char * const TreeOptions[] = { "-st", "compact", "-me", "bfs", "-g", "freecell", "-mi", "20000", "-stsr", "avl" };
+	FCSParallelDealSolver SerialSolver("freecell", sizeof(TreeOptions)/sizeof(char*), TreeOptions, 1);
+	FCSParallelDealSolver ParallelSolver("freecell", NumberOfOptions, Options, TEST_PARALLEL_THREADS);
+
+	if (!SerialSolver.Solve(1, TEST_PARALLEL_DEALS, SerialResults) ||
+		!ParallelSolver.Solve(1, TEST_PARALLEL_DEALS, ParallelResults))
+	{
+		cerr << "TestParallelSolver: couldn't set up the deals" << endl;
+		return 1;
+	}
+
+	int NumberOfMismatches = 0;
+	for (int a = 0;a<TEST_PARALLEL_DEALS;a++)
+	{
+		//bfs visits the same states whatever the storage, so the outcome must match
+		if ((SerialResults[a].m_ReturnCode != ParallelResults[a].m_ReturnCode) ||
+			(SerialResults[a].m_NumberOfStatesInCollection != ParallelResults[a].m_NumberOfStatesInCollection))
+		{
+			cerr << "TestParallelSolver: deal " << SerialResults[a].m_Deal << " differs" << endl;
+			NumberOfMismatches++;
+		}
+	}
+
+	cout << "TestParallelSolver: " << NumberOfMismatches << " mismatches in " << TEST_PARALLEL_DEALS << " deals" << endl;
+	return (NumberOfMismatches != 0) ? 1 : 0;
+}
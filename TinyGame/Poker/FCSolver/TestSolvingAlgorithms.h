@@ -15,4 +15,9 @@ void TestAllSolvingAlgorithms();
 ///\brief Test each game type
 void TestEachGame();
 
+///\brief Test that solving deals on several threads with the lock-free storage
+///gives the same results as the single threaded tree storage
+///\return 0 if all deals match, 1 otherwise
+int TestParallelSolver();
+
 #endif
\ No newline at end of file
@@ -1,76 +1,390 @@
 #include "TinyGamePCH.h"
 #include "QixLevel.h"
 
+#include <algorithm>
 
 namespace Qix
 {
 	Region::Region( Vec2i const& from , Vec2i const& to )
 	{
 		assert( from.x < to.x && from.y < to.y );
-		CLine* lines[4];
-		for ( int i = 0 ; i < 4 ; ++i )
-			lines[i] = new CLine;
-
-		//ccw
-		lines[0]->conFront( *lines[1] , from );
-		lines[1]->conFront( *lines[2] , Vec2i( from.y , to.x ) );
-		lines[2]->conFront( *lines[3] , to );
-		lines[3]->conFront( *lines[0] , Vec2i( to.x , from.y ) );
-
-		mBounds = lines[0];
+		Vec2i v[4] = { from , Vec2i( from.x , to.y ) , to , Vec2i( to.x , from.y ) };
+		mBounds = NULL;
+		buildBounds( v , 4 );
 		Vec2i dif = to - from;
 		mArea = dif.x * dif.y;
 	}
 
 	Region::~Region()
 	{
+		destroyBounds();
+	}
+
+	void Region::buildBounds( Vec2i const v[] , int num )
+	{
+		destroyBounds();
+
+		CLine* lines = new CLine;
+		CLine* cur = lines;
+		for ( int i = 1 ; i < num ; ++i )
+		{
+			CLine* con = new CLine;
+			cur->conFront( *con , v[i-1] );
+			cur = con;
+		}
+		cur->conFront( *lines , v[ num - 1 ] );
+		mBounds = lines;
+	}
+
+	void Region::destroyBounds()
+	{
+		if ( !mBounds )
+			return;
+
 		CLine* cur = mBounds;
-		do 
+		do
 		{
 			CLine* nt = cur->next();
 			delete cur;
 			cur = nt;
 		} while ( cur != mBounds );
+		mBounds = NULL;
 	}
 
-	int Region::addAreaSide( Vec2i pts[] , int num , CLine& sideTouch )
+	void Region::getVertices( PointVec& outV ) const
 	{
-		int area = pts[ num ].x * pts[ 0 ].y - pts[ num ].y * pts[ 0 ].x;
+		outV.clear();
+		CLine* cur = mBounds;
+		do
+		{
+			outV.push_back( cur->getTo() );
+			cur = cur->next();
+		} while ( cur != mBounds );
+	}
+
+	int Region::CalcArea( Vec2i const v[] , int num )
+	{
+		int area = v[ num - 1 ].x * v[ 0 ].y - v[ num - 1 ].y * v[ 0 ].x;
 		for ( int i = 1 ; i < num; ++i )
 		{
-			area += pts[i-1].x * pts[i].y - pts[i-1].y * pts[i].x;
+			area += v[i-1].x * v[i].y - v[i-1].y * v[i].x;
 		}
-		area /= 2;
+		return area / 2;
+	}
 
-		CLine* incBound[2];
-		if ( area < 0 )
+	bool Region::TestInPolygon( Vec2i const v[] , int num , Vec2i const& cell )
+	{
+		//even odd test of cell center , only vertical edges cross the horizontal ray
+		bool result = false;
+		Vec2i const* prev = &v[ num - 1 ];
+		for( int i = 0 ; i < num ; prev = &v[i++] )
 		{
-			area = -area;
-			CLine* cur = new CLine;
-			incBound[0] = cur;
-			for ( int i = 1 ; i < num ; ++i )
+			Vec2i const& cur = v[i];
+			if ( cur.x != prev->x || cur.x <= cell.x )
+				continue;
+			int yMin = std::min( cur.y , prev->y );
+			int yMax = std::max( cur.y , prev->y );
+			if ( yMin <= cell.y && cell.y < yMax )
+				result = !result;
+		}
+		return result;
+	}
+
+	bool Region::testInside( Vec2i const& cell ) const
+	{
+		PointVec vertices;
+		getVertices( vertices );
+		return TestInPolygon( &vertices[0] , vertices.size() , cell );
+	}
+
+	static bool IsOnSegment( Vec2i const& from , Vec2i const& to , Vec2i const& pos )
+	{
+		if ( from.x == to.x )
+			return pos.x == from.x && std::min( from.y , to.y ) <= pos.y && pos.y <= std::max( from.y , to.y );
+		return pos.y == from.y && std::min( from.x , to.x ) <= pos.x && pos.x <= std::max( from.x , to.x );
+	}
+
+	static int CalcDistance( Vec2i const& a , Vec2i const& b )
+	{
+		return abs( a.x - b.x ) + abs( a.y - b.y );
+	}
+
+	//remove repeated and collinear vertices
+	static void SimplifyPolygon( PointVec& v )
+	{
+		int num = v.size();
+		int numOut = 0;
+		for( int i = 0 ; i < num ; ++i )
+		{
+			if ( numOut && v[ numOut - 1 ] == v[i] )
+				continue;
+			v[ numOut++ ] = v[i];
+		}
+		while( numOut > 1 && v[ numOut - 1 ] == v[0] )
+			--numOut;
+		v.resize( numOut );
+
+		bool bRemoved = true;
+		while( bRemoved && v.size() > 2 )
+		{
+			bRemoved = false;
+			num = v.size();
+			for( int i = 0 ; i < num ; ++i )
 			{
-				CLine* con = new CLine;
-				cur->conFront( *con , pts[i] );
-				cur = con;
+				Vec2i const& prev = v[ ( i + num - 1 ) % num ];
+				Vec2i const& next = v[ ( i + 1 ) % num ];
+				if ( ( prev.x == v[i].x && v[i].x == next.x ) ||
+					 ( prev.y == v[i].y && v[i].y == next.y ) )
+				{
+					v.erase( v.begin() + i );
+					bRemoved = true;
+					break;
+				}
 			}
-			incBound[1] = cur;
 		}
-		else
+	}
+
+	int Region::findTouchLine( PointVec const& vertices , Vec2i const& pos ) const
+	{
+		//line i is vertices[i-1] -> vertices[i] , a corner belongs to the line it ends
+		int num = vertices.size();
+		for( int i = 0 ; i < num ; ++i )
+		{
+			Vec2i const& from = vertices[ ( i + num - 1 ) % num ];
+			if ( from != pos && IsOnSegment( from , vertices[i] , pos ) )
+				return i;
+		}
+		return -1;
+	}
+
+	bool Region::split( Vec2i const pts[] , int num , Vec2i const& keepCell , PointVec& outCut )
+	{
+		assert( num >= 2 );
+		Vec2i const& start = pts[0];
+		Vec2i const& end   = pts[ num - 1 ];
+		if ( start == end )
+			return false;
+
+		PointVec vertices;
+		getVertices( vertices );
+		int numV = vertices.size();
+		int idxStart = findTouchLine( vertices , start );
+		int idxEnd   = findTouchLine( vertices , end );
+		if ( idxStart == -1 || idxEnd == -1 )
+			return false;
+
+		bool bSameLine = ( idxStart == idxEnd );
+		bool bStartFirst = false;
+		if ( bSameLine )
 		{
+			Vec2i const& from = vertices[ ( idxStart + numV - 1 ) % numV ];
+			bStartFirst = CalcDistance( from , start ) < CalcDistance( from , end );
+		}
 
-			CLine* cur = new CLine;
-			incBound[1] = cur;
-			for ( int i = 1 ; i < num ; ++i )
+		//trail then bounds from end to start
+		PointVec polyA( pts , pts + num );
+		if ( !bSameLine || bStartFirst )
+		{
+			int idx = idxEnd;
+			do
 			{
-				CLine* con = new CLine;
-				cur->conBack( *con , pts[i] );
-				cur = con;
+				polyA.push_back( vertices[ idx ] );
+				idx = ( idx + 1 ) % numV;
 			}
-			incBound[0] = cur;
+			while( idx != idxStart );
 		}
 
-		return area;
+		//reversed trail then bounds from start to end
+		PointVec polyB;
+		for( int i = num - 1 ; i >= 0 ; --i )
+			polyB.push_back( pts[i] );
+		if ( !bSameLine || !bStartFirst )
+		{
+			int idx = idxStart;
+			do
+			{
+				polyB.push_back( vertices[ idx ] );
+				idx = ( idx + 1 ) % numV;
+			}
+			while( idx != idxEnd );
+		}
+
+		SimplifyPolygon( polyA );
+		SimplifyPolygon( polyB );
+		if ( polyA.size() < 4 || polyB.size() < 4 )
+			return false;
+
+		PointVec* keep = &polyA;
+		PointVec* cut  = &polyB;
+		if ( !TestInPolygon( &polyA[0] , polyA.size() , keepCell ) )
+			std::swap( keep , cut );
+
+		buildBounds( &(*keep)[0] , keep->size() );
+		mArea = abs( CalcArea( &(*keep)[0] , keep->size() ) );
+		outCut.swap( *cut );
+		return true;
+	}
+
+	static int CountBits( uint32 value )
+	{
+		value = value - ( ( value >> 1 ) & 0x55555555 );
+		value = ( value & 0x33333333 ) + ( ( value >> 2 ) & 0x33333333 );
+		value = ( value + ( value >> 4 ) ) & 0x0f0f0f0f;
+		return ( value * 0x01010101 ) >> 24;
+	}
+
+	Level::Level()
+	{
+		mSize = Vec2i( 0 , 0 );
+		mRegion = NULL;
+		mNumRowWord = 0;
+		mClaimedArea = 0;
+	}
+
+	Level::~Level()
+	{
+		cleanup();
+	}
+
+	void Level::init( Vec2i const& size )
+	{
+		cleanup();
+
+		mSize = size;
+		mNumRowWord = ( size.x + 31 ) / 32;
+		mBits.assign( mNumRowWord * size.y , 0 );
+		mWordCounts.assign( ( mNumRowWord + 1 ) * size.y , 0 );
+		mClaimedArea = 0;
+		mRegion = new Region( Vec2i( 0 , 0 ) , size );
+	}
+
+	void Level::cleanup()
+	{
+		delete mRegion;
+		mRegion = NULL;
+		mBits.clear();
+		mWordCounts.clear();
+		mClaimedArea = 0;
+	}
+
+	int Level::capture( Vec2i const pts[] , int num , Vec2i const& qixCell )
+	{
+		assert( mRegion );
+		if ( !mRegion->split( pts , num , qixCell , mCutVertices ) )
+			return 0;
+
+		int prevArea = mClaimedArea;
+		fillPolygon( &mCutVertices[0] , mCutVertices.size() );
+		return mClaimedArea - prevArea;
+	}
+
+	void Level::fillPolygon( Vec2i const v[] , int num )
+	{
+		mEdges.clear();
+		Vec2i const* prev = &v[ num - 1 ];
+		for( int i = 0 ; i < num ; prev = &v[i++] )
+		{
+			if ( v[i].x != prev->x )
+				continue;
+			Edge edge;
+			edge.x    = v[i].x;
+			edge.yMin = std::min( v[i].y , prev->y );
+			edge.yMax = std::max( v[i].y , prev->y );
+			mEdges.push_back( edge );
+		}
+		if ( mEdges.empty() )
+			return;
+
+		std::sort( mEdges.begin() , mEdges.end() );
+		int yEnd = 0;
+		for( int i = 0 ; i < mEdges.size() ; ++i )
+			yEnd = std::max( yEnd , mEdges[i].yMax );
+
+		mActiveEdges.clear();
+		int idxEdge = 0;
+		for( int y = mEdges[0].yMin ; y < yEnd ; ++y )
+		{
+			while( idxEdge < mEdges.size() && mEdges[ idxEdge ].yMin <= y )
+				mActiveEdges.push_back( mEdges[ idxEdge++ ] );
+
+			mCrossX.clear();
+			for( int i = 0 ; i < mActiveEdges.size() ; )
+			{
+				if ( mActiveEdges[i].yMax <= y )
+				{
+					mActiveEdges[i] = mActiveEdges.back();
+					mActiveEdges.pop_back();
+					continue;
+				}
+				mCrossX.push_back( mActiveEdges[i].x );
+				++i;
+			}
+			std::sort( mCrossX.begin() , mCrossX.end() );
+
+			for( int i = 0 ; i + 1 < mCrossX.size() ; i += 2 )
+				fillSpan( y , mCrossX[i] , mCrossX[i+1] );
+			updateRowCount( y );
+		}
+	}
+
+	void Level::fillSpan( int y , int x0 , int x1 )
+	{
+		if ( x0 >= x1 )
+			return;
+
+		uint32* row = &mBits[ y * mNumRowWord ];
+		int w0 = x0 >> 5;
+		int w1 = ( x1 - 1 ) >> 5;
+		uint32 mask0 = ~0u << ( x0 & 31 );
+		uint32 mask1 = ~0u >> ( 31 - ( ( x1 - 1 ) & 31 ) );
+		if ( w0 == w1 )
+		{
+			row[ w0 ] |= mask0 & mask1;
+			return;
+		}
+		row[ w0 ] |= mask0;
+		for( int w = w0 + 1 ; w < w1 ; ++w )
+			row[ w ] = ~0u;
+		row[ w1 ] |= mask1;
+	}
+
+	void Level::updateRowCount( int y )
+	{
+		uint32 const* row = &mBits[ y * mNumRowWord ];
+		int* counts = &mWordCounts[ y * ( mNumRowWord + 1 ) ];
+		int prevCount = counts[ mNumRowWord ];
+		for( int w = 0 ; w < mNumRowWord ; ++w )
+			counts[ w + 1 ] = counts[ w ] + CountBits( row[ w ] );
+		mClaimedArea += counts[ mNumRowWord ] - prevCount;
+	}
+
+	int Level::countRow( int y , int x0 , int x1 ) const
+	{
+		uint32 const* row = &mBits[ y * mNumRowWord ];
+		int const* counts = &mWordCounts[ y * ( mNumRowWord + 1 ) ];
+		//claimed cells before x1 minus cells before x0
+		int result = counts[ x1 >> 5 ];
+		if ( x1 & 31 )
+			result += CountBits( row[ x1 >> 5 ] & ( ( 1u << ( x1 & 31 ) ) - 1 ) );
+		result -= counts[ x0 >> 5 ];
+		if ( x0 & 31 )
+			result -= CountBits( row[ x0 >> 5 ] & ( ( 1u << ( x0 & 31 ) ) - 1 ) );
+		return result;
+	}
+
+	int Level::countClaimed( Vec2i const& min , Vec2i const& max ) const
+	{
+		int x0 = std::max( min.x , 0 );
+		int x1 = std::min( max.x , mSize.x );
+		int y0 = std::max( min.y , 0 );
+		int y1 = std::min( max.y , mSize.y );
+		if ( x0 >= x1 )
+			return 0;
+
+		int result = 0;
+		for( int y = y0 ; y < y1 ; ++y )
+			result += countRow( y , x0 , x1 );
+		return result;
 	}
 
-}//namespace Qix
\ No newline at end of file
+}//namespace Qix
@@ -2,6 +2,9 @@
 #define QixLevel_h__
 
 #include "TVector2.h"
+#include "IntegerType.h"
+
+#include <vector>
 
 namespace Qix
 {
@@ -48,7 +51,9 @@ namespace Qix
 	};
 
 
+	typedef std::vector< Vec2i > PointVec;
 
+	//  Free part of the field , bounds are on grid lines ( cell corners ).
 	class Region
 	{
 	public:
@@ -56,32 +61,77 @@ namespace Qix
 		Region( Vec2i const& from , Vec2i const& to );
 		~Region();
 		int  getArea() const { return mArea; }
-		int  addArea( Vec2i pts[] , int num , CLine& startTouch , CLine& endTouch )
-		{
-			if ( &startTouch == &endTouch )
-			{
-				return addAreaSide( pts , num , startTouch );
-			}
-			return 0;
-		}
+
+		//  Trail pts[0] -> pts[num-1] is on grid lines and both ends are on the bounds.
+		//  Region keeps the side with keepCell , outCut gets bound of the other side.
+		bool split( Vec2i const pts[] , int num , Vec2i const& keepCell , PointVec& outCut );
+		bool testInside( Vec2i const& cell ) const;
+		void getVertices( PointVec& outV ) const;
+
+		static int  CalcArea( Vec2i const v[] , int num );
+		static bool TestInPolygon( Vec2i const v[] , int num , Vec2i const& cell );
+
 	private:
-		int addAreaSide( Vec2i pts[] , int num , CLine& sideTouch );
-	
+		void   buildBounds( Vec2i const v[] , int num );
+		void   destroyBounds();
+		int    findTouchLine( PointVec const& vertices , Vec2i const& pos ) const;
+
 		int    mArea;
 		CLine* mBounds;
 	};
 
-
+	//  Claimed cells are kept in bit rows , each row has prefix counts of
+	//  its words , so claimed count of a rect is O(rows) and a cell test O(1).
 	class Level
 	{
+	public:
+		Level();
+		~Level();
 
+		void   init( Vec2i const& size );
+		void   cleanup();
 
+		//  Close the trail , the side without qix is filled by scanline.
+		//  return captured area , 0 if the trail doesn't cut the region
+		int    capture( Vec2i const pts[] , int num , Vec2i const& qixCell );
 
+		Vec2i const& getSize() const { return mSize; }
+		Region*      getRegion(){ return mRegion; }
 
+		bool   isClaimed( Vec2i const& cell ) const
+		{
+			return ( mBits[ cell.y * mNumRowWord + ( cell.x >> 5 ) ] & ( 1u << ( cell.x & 31 ) ) ) != 0;
+		}
+		int    getClaimedArea() const { return mClaimedArea; }
+		int    getClaimedPercent() const { return ( mSize.x * mSize.y ) ? 100 * mClaimedArea / ( mSize.x * mSize.y ) : 0; }
+		//cells in [ min , max )
+		int    countClaimed( Vec2i const& min , Vec2i const& max ) const;
 
+	private:
+		void   fillPolygon( Vec2i const v[] , int num );
+		void   fillSpan( int y , int x0 , int x1 );
+		void   updateRowCount( int y );
+		int    countRow( int y , int x0 , int x1 ) const;
 
-
-
+		struct Edge
+		{
+			int x;
+			int yMin;
+			int yMax;
+			bool operator < ( Edge const& rhs ) const { return yMin < rhs.yMin; }
+		};
+
+		Vec2i    mSize;
+		Region*  mRegion;
+		int      mNumRowWord;
+		int      mClaimedArea;
+		std::vector< uint32 > mBits;
+		//claimed count before each word of row , NumRowWord + 1 per row
+		std::vector< int >    mWordCounts;
+		std::vector< Edge >   mEdges;
+		std::vector< Edge >   mActiveEdges;
+		std::vector< int >    mCrossX;
+		PointVec              mCutVertices;
 	};
 
 }//namespace Qix
@@ -6,123 +6,389 @@
 
 #include <vector>
 #include <list>
-#include <map>
-#include <boost/pool/object_pool.hpp>
+#include <algorithm>
+#include <cassert>
 
-#define USE_TWO_AXIS 0
+#define USE_TWO_AXIS 1
 
 
 namespace Shoot2D
 {
-
-	template< class T >
-	class Node
-	{
-		Node(){ prev = next = NULL; }
-		T* prev;
-		T* next;
-	};
-
-	template< class T , Node< T > T::*Member >
-	class List
+	//  Incremental sweep and prune on NumAxis axes.
+	//  Each axis keeps a sorted array of the min / max end points of all proxies.
+	//  update() insertion sorts the arrays ( objects move a little per frame , so
+	//  it is near linear ) and the swaps of end points add or remove overlap pairs,
+	//  so the pair list persists between frames.
+	//  Removed proxies are dropped from the arrays in one pass at next update.
+	template< int NumAxis >
+	class TAxisSweepBroadphase
 	{
 	public:
-		typedef Node< T > NodeType;
-		NodeType& getNode( T& v ){ return ( v.*Member ); }
-		void pushFront( T& v )
+		typedef bool (*PairFilterFun)( void* userDataA , void* userDataB );
+
+		struct ColPair
+		{
+			int proxyA;
+			int proxyB;
+		};
+
+		TAxisSweepBroadphase()
 		{
-			if ( mFirst )
+			mFilterFun  = NULL;
+			mNumProxy   = 0;
+			mNumRemoved = 0;
+			mNeedUpdate = false;
+		}
+
+		void    setPairFilter( PairFilterFun fun ){ mFilterFun = fun; }
+
+		int     addProxy( float const min[] , float const max[] , void* userData )
+		{
+			int handle;
+			if ( !mFreeProxy.empty() )
 			{
-				getNode( v ).prev = mFirst;
-				getNode( v ).next = getNode( *mFirst ).next;
-				getNode( *mFirst ).next = &v;
+				handle = mFreeProxy.back();
+				mFreeProxy.pop_back();
 			}
 			else
 			{
-				mFirst = mLast = &v;
+				handle = (int)mProxies.size();
+				mProxies.push_back( Proxy() );
+			}
+
+			Proxy& proxy = mProxies[ handle ];
+			proxy.userData  = userData;
+			proxy.beRemoved = false;
+
+			//new end points start at the end of axis , so it overlaps nothing
+			//and sorting it down makes its pairs
+			for( int i = 0 ; i < NumAxis ; ++i )
+			{
+				proxy.min[i] = min[i];
+				proxy.max[i] = max[i];
+
+				EndPoint ep;
+				ep.val = min[i];
+				ep.id  = 2 * handle;
+				mAxis[i].push_back( ep );
+				ep.val = max[i];
+				ep.id  = 2 * handle + 1;
+				mAxis[i].push_back( ep );
 			}
+			++mNumProxy;
+			mNeedUpdate = true;
+			return handle;
 		}
 
-		void insertFront( T& pos , T& v )
+		void    removeProxy( int handle )
 		{
+			Proxy& proxy = mProxies[ handle ];
+			assert( proxy.userData && !proxy.beRemoved );
+			proxy.beRemoved = true;
+			++mNumRemoved;
+			--mNumProxy;
+			mNeedUpdate = true;
+		}
 
+		void    setBound( int handle , float const min[] , float const max[] )
+		{
+			Proxy& proxy = mProxies[ handle ];
+			for( int i = 0 ; i < NumAxis ; ++i )
+			{
+				proxy.min[i] = min[i];
+				proxy.max[i] = max[i];
+			}
+			mNeedUpdate = true;
 		}
 
+		void    update()
+		{
+			if ( !mNeedUpdate )
+				return;
 
-		T* mFirst;
-		T* mLast;
-	};
+			if ( mNumRemoved )
+				purgeRemovedProxy();
 
-	class AxisSweepDetector : public CollisionSystem
-	{
-	public:
-		AxisSweepDetector( Rect_t const& rect );
+			for( int i = 0 ; i < NumAxis ; ++i )
+				sortAxis( i );
 
-		struct ColData;
-		struct Node
+			mNeedUpdate = false;
+		}
+
+		int     getProxySlotNum() const { return (int)mProxies.size(); }
+		int     getProxyNum() const { return mNumProxy; }
+		//NULL if slot is not used or proxy is removed
+		void*   getUserData( int handle ) const
 		{
-			Node(ColData* d = NULL):data(d),val(0){}
-			ColData* data;
-			float    val;
+			Proxy const& proxy = mProxies[ handle ];
+			return ( proxy.beRemoved ) ? NULL : proxy.userData;
+		}
+
+		int            getPairNum() const { return (int)mPairs.size(); }
+		ColPair const& getPair( int idx ) const { return mPairs[ idx ]; }
+
+	private:
+
+		struct Proxy
+		{
+			void* userData;
+			bool  beRemoved;
+			float min[ NumAxis ];
+			float max[ NumAxis ];
 		};
 
-		typedef std::list<Node>       NodeList;
-		typedef NodeList::iterator    NodeIter;
-		typedef std::vector<ColData*> ColDataVec;
-		typedef std::list<Object*>    ObjList;
+		//id = 2 * handle + ( is max point )
+		struct EndPoint
+		{
+			float val;
+			int   id;
+		};
+
+		typedef std::vector< EndPoint > EndPointVec;
 
-		struct ColData
+		static bool isMax( EndPoint const& ep ){ return ( ep.id & 1 ) != 0; }
+		//min point is before max point at same value , so bound is closed
+		static bool isLess( EndPoint const& a , EndPoint const& b )
 		{
-			Object* obj;
-#if USE_TWO_AXIS
-			NodeIter max[2];
-			NodeIter min[2];
+			if ( a.val != b.val )
+				return a.val < b.val;
+			return ( a.id & 1 ) < ( b.id & 1 );
+		}
 
-			float getMax(int i){ return (*max[i]).val; }
-			float getMin(int i){ return (*min[i]).val; }
-#else
-			NodeIter max;
-			NodeIter min;
+		bool    testOverlap( int a , int b ) const
+		{
+			Proxy const& pa = mProxies[a];
+			Proxy const& pb = mProxies[b];
+			for( int i = 0 ; i < NumAxis ; ++i )
+			{
+				if ( pa.max[i] < pb.min[i] || pb.max[i] < pa.min[i] )
+					return false;
+			}
+			return true;
+		}
 
-			float getMax(){ return (*max).val; }
-			float getMin(){ return (*min).val; }
+		void    sortAxis( int axis )
+		{
+			EndPointVec& points = mAxis[ axis ];
+			int num = (int)points.size();
+
+			//load new bound values
+			for( int i = 0 ; i < num ; ++i )
+			{
+				Proxy const& proxy = mProxies[ points[i].id >> 1 ];
+				points[i].val = isMax( points[i] ) ? proxy.max[ axis ] : proxy.min[ axis ];
+			}
+
+			for( int i = 1 ; i < num ; ++i )
+			{
+				EndPoint ep = points[i];
+				if ( !isLess( ep , points[ i - 1 ] ) )
+					continue;
+
+				int pos = i;
+				do
+				{
+					EndPoint const& prev = points[ pos - 1 ];
+					if ( isMax( ep ) != isMax( prev ) )
+					{
+						int a = ep.id >> 1;
+						int b = prev.id >> 1;
+						if ( isMax( prev ) )
+						{
+							//min passes a max : start to overlap on this axis
+							if ( testOverlap( a , b ) )
+								addPair( a , b );
+						}
+						else
+						{
+							//max passes a min : leave on this axis
+							removePair( a , b );
+						}
+					}
+					points[ pos ] = prev;
+					--pos;
+				}
+				while( pos > 0 && isLess( ep , points[ pos - 1 ] ) );
+
+				points[ pos ] = ep;
+			}
+		}
+
+		void    purgeRemovedProxy()
+		{
+			for( int i = 0 ; i < NumAxis ; ++i )
+			{
+				EndPointVec& points = mAxis[i];
+				int num = 0;
+				for( int n = 0 ; n < (int)points.size() ; ++n )
+				{
+					if ( mProxies[ points[n].id >> 1 ].beRemoved )
+						continue;
+					points[ num++ ] = points[n];
+				}
+				points.resize( num );
+			}
+
+			int numPair = 0;
+			for( int n = 0 ; n < (int)mPairs.size() ; ++n )
+			{
+				ColPair const& pair = mPairs[n];
+				if ( mProxies[ pair.proxyA ].beRemoved || mProxies[ pair.proxyB ].beRemoved )
+					continue;
+				mPairs[ numPair++ ] = pair;
+			}
+			mPairs.resize( numPair );
+			rehashPair( (int)mPairTable.size() );
+
+			for( int n = 0 ; n < (int)mProxies.size() ; ++n )
+			{
+				Proxy& proxy = mProxies[n];
+				if ( !proxy.beRemoved )
+					continue;
+				proxy.beRemoved = false;
+				proxy.userData  = NULL;
+				mFreeProxy.push_back( n );
+			}
+			mNumRemoved = 0;
+		}
+
+		static unsigned hashPair( int a , int b )
+		{
+			unsigned value = unsigned( a ) * 2654435761u ^ unsigned( b ) * 2246822519u;
+			return value ^ ( value >> 15 );
+		}
+
+		int     findPair( int a , int b ) const
+		{
+			if ( mPairTable.empty() )
+				return -1;
+			int idx = mPairTable[ hashPair( a , b ) & ( mPairTable.size() - 1 ) ];
+			while( idx != -1 )
+			{
+				ColPair const& pair = mPairs[ idx ];
+				if ( pair.proxyA == a && pair.proxyB == b )
+					return idx;
+				idx = mPairNext[ idx ];
+			}
+			return -1;
+		}
+
+		void    addPair( int a , int b )
+		{
+			if ( a > b )
+				std::swap( a , b );
+			if ( findPair( a , b ) != -1 )
+				return;
+			if ( mFilterFun && !(*mFilterFun)( mProxies[a].userData , mProxies[b].userData ) )
+				return;
+
+			if ( mPairs.size() >= mPairTable.size() )
+				rehashPair( std::max< int >( 256 , 2 * (int)mPairTable.size() ) );
+
+			int idx = (int)mPairs.size();
+			ColPair pair;
+			pair.proxyA = a;
+			pair.proxyB = b;
+			mPairs.push_back( pair );
+
+			int& head = mPairTable[ hashPair( a , b ) & ( mPairTable.size() - 1 ) ];
+			mPairNext.push_back( head );
+			head = idx;
+		}
+
+		int*    findPairLink( int idx )
+		{
+			ColPair const& pair = mPairs[ idx ];
+			int* link = &mPairTable[ hashPair( pair.proxyA , pair.proxyB ) & ( mPairTable.size() - 1 ) ];
+			while( *link != idx )
+				link = &mPairNext[ *link ];
+			return link;
+		}
+
+		void    removePair( int a , int b )
+		{
+			if ( a > b )
+				std::swap( a , b );
+			int idx = findPair( a , b );
+			if ( idx == -1 )
+				return;
+
+			*findPairLink( idx ) = mPairNext[ idx ];
+
+			//move last pair to the hole
+			int last = (int)mPairs.size() - 1;
+			if ( idx != last )
+			{
+				int* link = findPairLink( last );
+				*link = idx;
+				mPairs[ idx ]    = mPairs[ last ];
+				mPairNext[ idx ] = mPairNext[ last ];
+			}
+			mPairs.pop_back();
+			mPairNext.pop_back();
+		}
+
+		void    rehashPair( int tableSize )
+		{
+			mPairTable.assign( tableSize , -1 );
+			mPairNext.resize( mPairs.size() );
+			if ( tableSize == 0 )
+				return;
+			for( int i = 0 ; i < (int)mPairs.size() ; ++i )
+			{
+				int& head = mPairTable[ hashPair( mPairs[i].proxyA , mPairs[i].proxyB ) & ( tableSize - 1 ) ];
+				mPairNext[i] = head;
+				head = i;
+			}
+		}
+
+		typedef std::vector< Proxy >   ProxyVec;
+		typedef std::vector< ColPair > PairVec;
+
+		EndPointVec        mAxis[ NumAxis ];
+		ProxyVec           mProxies;
+		std::vector< int > mFreeProxy;
+		int                mNumProxy;
+		int                mNumRemoved;
+		bool               mNeedUpdate;
+		PairFilterFun      mFilterFun;
+
+		PairVec            mPairs;
+		std::vector< int > mPairNext;
+		std::vector< int > mPairTable;
+	};
+
+	class AxisSweepDetector : public CollisionSystem
+	{
+	public:
+		AxisSweepDetector( Rect_t const& rect );
+
+#if USE_TWO_AXIS
+		static int const NumAxis = 2;
+#else
+		static int const NumAxis = 1;
 #endif
-		};
+		typedef TAxisSweepBroadphase< NumAxis > Broadphase;
+		typedef std::list<Object*>    ObjList;
 
 		template <class FunType>
 		void visit(FunType fun);
 
-		static void updatColData(ColData& data);
+		static void calcBound( Object& obj , float min[] , float max[] );
 
-		size_t getObjNum(){ return NumColObj; }
+		size_t getObjNum(){ return mBroadphase.getProxyNum(); }
+		size_t getPairNum(){ return mBroadphase.getPairNum(); }
 		void removeColData( Object* obj );
 		void update(long time);
 		void testCollision();
-		void checkCollision( ColData& data);
 		void addObj( Object* obj );
 		void removeObj( Object* obj );
 
 	protected:
+		static bool filterPair( void* userDataA , void* userDataB );
 
-#if USE_TWO_AXIS
-		void sortList( int axis , NodeIter from );
-		void sortList( int axis );
-#else
-		void sortList( NodeIter from );
-		void sortList( );
-#endif
-
-
-#if USE_TWO_AXIS
-		NodeList nodes[2];
-		std::vector< bool > ColMap;
-#else
-		NodeList nodes;
-#endif
-		size_t     NumColObj;
+		Broadphase mBroadphase;
 		ObjList    noCol;
-		ColDataVec colVec;
-		boost::object_pool<ColData> m_pool;
 		Rect_t m_LiveRange;
 	};
 
@@ -130,10 +396,11 @@ namespace Shoot2D
 	template <class FunType>
 	void AxisSweepDetector::visit( FunType fun )
 	{
-		for(size_t i=0; i < NumColObj ; ++i )
+		for( int i = 0 ; i < mBroadphase.getProxySlotNum() ; ++i )
 		{
-			ColData* data = colVec[i];
-			fun( data->obj );
+			Object* obj = static_cast< Object* >( mBroadphase.getUserData( i ) );
+			if ( obj )
+				fun( obj );
 		}
 
 		for( ObjList::iterator iter = noCol.begin();
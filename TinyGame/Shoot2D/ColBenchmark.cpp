@@ -0,0 +1,197 @@
+#include "ColBenchmark.h"
+
+#include "AxisSweepDetector.h"
+#include "GridManger.h"
+#include "Common.h"
+
+#include "Clock.h"
+
+#include <vector>
+
+namespace Shoot2D
+{
+	struct BenchBullet
+	{
+		Vec2D pos;
+		Vec2D vel;
+		float r;
+	};
+
+	static Rect_t const BenchRect = { Vec2D( 400 , 600 ) , Vec2D( 0 , 0 ) };
+
+	static void MoveBullets( std::vector< BenchBullet >& bullets )
+	{
+		for( size_t i = 0 ; i < bullets.size() ; ++i )
+		{
+			BenchBullet& b = bullets[i];
+			b.pos += b.vel;
+			if ( b.pos.x < BenchRect.Min.x || b.pos.x > BenchRect.Max.x )
+				b.vel.x = -b.vel.x;
+			if ( b.pos.y < BenchRect.Min.y || b.pos.y > BenchRect.Max.y )
+				b.vel.y = -b.vel.y;
+		}
+	}
+
+	static bool IsOverlap( BenchBullet const& a , BenchBullet const& b )
+	{
+		float r = a.r + b.r;
+		return fabs( a.pos.x - b.pos.x ) <= r && fabs( a.pos.y - b.pos.y ) <= r;
+	}
+
+	static int TestBruteForce( std::vector< BenchBullet > const& bullets )
+	{
+		int numPair = 0;
+		for( size_t i = 0 ; i < bullets.size() ; ++i )
+		{
+			for( size_t j = i + 1 ; j < bullets.size() ; ++j )
+			{
+				if ( IsOverlap( bullets[i] , bullets[j] ) )
+					++numPair;
+			}
+		}
+		return numPair;
+	}
+
+	typedef GridManager< int , 8 , 12 > BenchGrid;
+
+	static int TestGrid( BenchGrid& grid , std::vector< BenchBullet > const& bullets )
+	{
+		grid.clear();
+		for( size_t i = 0 ; i < bullets.size() ; ++i )
+		{
+			BenchBullet const& b = bullets[i];
+			int min[2] , max[2];
+			grid.getCellPos( b.pos - Vec2D( b.r , b.r ) , min );
+			grid.getCellPos( b.pos + Vec2D( b.r , b.r ) , max );
+			for( int y = min[1] ; y <= max[1] ; ++y )
+			for( int x = min[0] ; x <= max[0] ; ++x )
+			{
+				BenchGrid::Cell* cell = grid.getCell( x , y );
+				if ( cell )
+					cell->push_back( (int)i );
+			}
+		}
+
+		int numPair = 0;
+		for( int y = 0 ; y < BenchGrid::NumCellY ; ++y )
+		for( int x = 0 ; x < BenchGrid::NumCellX ; ++x )
+		{
+			BenchGrid::Cell* cell = grid.getCell( x , y );
+			for( BenchGrid::Cell::iterator iter1 = cell->begin() ; iter1 != cell->end() ; ++iter1 )
+			{
+				BenchGrid::Cell::iterator iter2 = iter1;
+				for( ++iter2 ; iter2 != cell->end() ; ++iter2 )
+				{
+					BenchBullet const& b1 = bullets[ *iter1 ];
+					BenchBullet const& b2 = bullets[ *iter2 ];
+					if ( !IsOverlap( b1 , b2 ) )
+						continue;
+
+					//count the pair only in the cell of the overlap min corner
+					Vec2D corner( std::max( b1.pos.x - b1.r , b2.pos.x - b2.r ) , std::max( b1.pos.y - b1.r , b2.pos.y - b2.r ) );
+					int pos[2];
+					grid.getCellPos( corner , pos );
+					pos[0] = std::max( 0 , std::min( pos[0] , BenchGrid::NumCellX - 1 ) );
+					pos[1] = std::max( 0 , std::min( pos[1] , BenchGrid::NumCellY - 1 ) );
+					if ( pos[0] == x && pos[1] == y )
+						++numPair;
+				}
+			}
+		}
+		return numPair;
+	}
+
+	template< int NumAxis >
+	static void SetSweepBound( TAxisSweepBroadphase< NumAxis >& sweep , BenchBullet const& b , int handle , bool beAdd )
+	{
+		float min[2] , max[2];
+		if ( NumAxis == 2 )
+		{
+			min[0] = b.pos.x - b.r;  max[0] = b.pos.x + b.r;
+			min[1] = b.pos.y - b.r;  max[1] = b.pos.y + b.r;
+		}
+		else
+		{
+			min[0] = b.pos.y - b.r;  max[0] = b.pos.y + b.r;
+		}
+		if ( beAdd )
+			sweep.addProxy( min , max , NULL );
+		else
+			sweep.setBound( handle , min , max );
+	}
+
+	template< int NumAxis >
+	static int TestSweep( TAxisSweepBroadphase< NumAxis >& sweep , std::vector< BenchBullet > const& bullets )
+	{
+		for( size_t i = 0 ; i < bullets.size() ; ++i )
+			SetSweepBound( sweep , bullets[i] , (int)i , false );
+		sweep.update();
+
+		if ( NumAxis == 2 )
+			return sweep.getPairNum();
+
+		//one axis pairs need the test on the other axis
+		int numPair = 0;
+		for( int i = 0 ; i < sweep.getPairNum() ; ++i )
+		{
+			typename TAxisSweepBroadphase< NumAxis >::ColPair const& pair = sweep.getPair( i );
+			if ( IsOverlap( bullets[ pair.proxyA ] , bullets[ pair.proxyB ] ) )
+				++numPair;
+		}
+		return numPair;
+	}
+
+	void runColBenchmark( int numBullet , int numFrame , ColBenchResult result[] )
+	{
+		std::vector< BenchBullet > bullets( numBullet );
+		for( int i = 0 ; i < numBullet ; ++i )
+		{
+			BenchBullet& b = bullets[i];
+			b.pos = Vec2D( Random( BenchRect.Min.x , BenchRect.Max.x ) , Random( BenchRect.Min.y , BenchRect.Max.y ) );
+			b.vel = Vec2D( Random( -3 , 3 ) , Random( -3 , 3 ) );
+			b.r   = 3;
+		}
+
+		BenchGrid grid( BenchRect );
+		TAxisSweepBroadphase< 1 > sweep1;
+		TAxisSweepBroadphase< 2 > sweep2;
+		for( int i = 0 ; i < numBullet ; ++i )
+		{
+			SetSweepBound( sweep1 , bullets[i] , i , true );
+			SetSweepBound( sweep2 , bullets[i] , i , true );
+		}
+		sweep1.update();
+		sweep2.update();
+
+		char const* methodName[ NumColBenchMethod ] = { "BruteForce" , "Grid" , "Sweep1Axis" , "Sweep2Axis" };
+		unsigned long totalTime[ NumColBenchMethod ] = { 0 };
+
+		TClock clock;
+		for( int frame = 0 ; frame < numFrame ; ++frame )
+		{
+			MoveBullets( bullets );
+
+			for( int n = 0 ; n < NumColBenchMethod ; ++n )
+			{
+				clock.reset();
+				int numPair = 0;
+				switch( n )
+				{
+				case 0: numPair = TestBruteForce( bullets ); break;
+				case 1: numPair = TestGrid( grid , bullets ); break;
+				case 2: numPair = TestSweep( sweep1 , bullets ); break;
+				case 3: numPair = TestSweep( sweep2 , bullets ); break;
+				}
+				totalTime[n] += clock.getTimeMicroseconds();
+				result[n].numPair = numPair;
+			}
+		}
+
+		for( int n = 0 ; n < NumColBenchMethod ; ++n )
+		{
+			result[n].name   = methodName[n];
+			result[n].timeUs = float( totalTime[n] ) / std::max( numFrame , 1 );
+		}
+	}
+
+}//namespace Shoot2D
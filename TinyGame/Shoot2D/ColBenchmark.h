@@ -0,0 +1,24 @@
+#ifndef ColBenchmark_h__
+#define ColBenchmark_h__
+
+namespace Shoot2D
+{
+	struct ColBenchResult
+	{
+		char const* name;
+		//average broadphase time per frame
+		float       timeUs;
+		//overlap pairs of last frame , must be same for all methods
+		int         numPair;
+	};
+
+	int const NumColBenchMethod = 4;
+
+	//  Moves numBullet circle bullets in the play field for numFrame frames and
+	//  finds their overlap pairs with brute force , the fixed grid and the
+	//  axis sweep on one and two axes.
+	void runColBenchmark( int numBullet , int numFrame , ColBenchResult result[] );
+
+}//namespace Shoot2D
+
+#endif // ColBenchmark_h__
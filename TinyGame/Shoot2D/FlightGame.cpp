@@ -32,6 +32,7 @@ namespace Shoot2D
 
 		m_frameCount = 0;
 		m_fps   = 0;
+		mHaveBenchResult = false;
 		GameWindow& window = ::Global::getDrawEngine()->getWindow();
 
 		ResourcesLoader::getInstance().setDC( window.getHDC() );
@@ -124,6 +125,16 @@ namespace Shoot2D
 		buf.format( "ObjNum = %d   fps = %.1f" , objManger->getObjNum() , m_fps );
 
 		de->drawText( 10 , 10 , buf );
+
+		if ( mHaveBenchResult )
+		{
+			for( int i = 0 ; i < NumColBenchMethod ; ++i )
+			{
+				FixString< 64 > str;
+				str.format( "%s : %.0f us  pair = %d" , mBenchResult[i].name , mBenchResult[i].timeUs , mBenchResult[i].numPair );
+				de->drawText( 10 , 30 + 16 * i , str );
+			}
+		}
 		de->endRender();
 
 		++m_frameCount;
@@ -136,6 +147,21 @@ namespace Shoot2D
 		}
 	}
 
+	bool TestStage::onKey( unsigned key , bool isDown )
+	{
+		if ( !isDown )
+			return false;
+
+		switch( key )
+		{
+		case 'B':
+			runColBenchmark( 3000 , 100 , mBenchResult );
+			mHaveBenchResult = true;
+			break;
+		}
+		return false;
+	}
+
 	void TestStage::produceFlight()
 	{
 		Vehicle* fly =  new Vehicle( MD_BASE , Vec2D(200,200) );
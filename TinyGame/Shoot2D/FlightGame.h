@@ -3,6 +3,7 @@
 
 #include "StageBase.h"
 #include "CommonFwd.h"
+#include "ColBenchmark.h"
 
 namespace Shoot2D
 {
@@ -17,6 +18,7 @@ namespace Shoot2D
 		void onEnd();
 		void onUpdate( long time );
 		void onRender( float dFrame );
+		bool onKey( unsigned key , bool isDown );
 
 	public:
 		void produceFlight();
@@ -30,6 +32,9 @@ namespace Shoot2D
 		static RenderEngine* de;
 		static AxisSweepDetector* objManger;
 		PlayerFlight* m_player;
+
+		bool           mHaveBenchResult;
+		ColBenchResult mBenchResult[ NumColBenchMethod ];
 	};
 
 }//namespace Shoot2D
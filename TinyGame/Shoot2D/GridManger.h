@@ -20,6 +20,8 @@ namespace Shoot2D
 			: m_rect( rect )
 		{
 			dif = rect.Max - rect.Min;
+			dif.x /= NumCellX;
+			dif.y /= NumCellY;
 		}
 
 		static bool isInRange(int x,int y)
@@ -48,6 +50,13 @@ namespace Shoot2D
 			n[1] = int( ( pos.y - m_rect.Min.y ) / dif.y );
 		}
 
+		void clear()
+		{
+			for( int j = 0 ; j < NumCellY ; ++j )
+			for( int i = 0 ; i < NumCellX ; ++i )
+				cell[j][i].clear();
+		}
+
 		bool push(T obj , Vec2D const& pos)
 		{
 			Cell* cell = getCell(pos);
@@ -6,7 +6,7 @@
 #include <cassert>
 #include <new>
 #include "Singleton.h"
-#include "CacheAllocator.h"
+#include "PoolAllocator.h"
 
 namespace Shoot2D
 {
@@ -14,52 +14,61 @@ namespace Shoot2D
 	class ObjectCreator
 	{
 	public:
-		static size_t const MAX_CACHE_NUM = 128;
-
 		template<class T >
 		inline static void destroy(T* ptr)
 		{
 			ptr->~T();
-			getAllocator().dealloc( ptr );
+			dealloc( ptr );
 		}
 		template<class T >
 		inline static T* create()
 		{ 
-			T* ptr = ( T* ) getAllocator().alloc( sizeof(T) );
-			new ptr T();
-			return ptr;
+			void* ptr = alloc( sizeof(T) );
+			return new (ptr) T();
 		}
 
 		template<class T , typename P1>
 		inline static T* create( P1& p1 )
 		{ 
-			void* ptr = getAllocator().alloc( sizeof(T) );
+			void* ptr = alloc( sizeof(T) );
 			return new (ptr) T(p1);
 		}
 		template<class T , typename P1 , typename P2>
 		inline static T* create( P1& p1, P2& p2 )
 		{ 
-			void* ptr = getAllocator().alloc( sizeof(T) );
+			void* ptr = alloc( sizeof(T) );
 			return new (ptr) T(p1,p2);
 		}
 		template<class T , typename P1 , typename P2 , typename P3>
 		inline static T* create( P1& p1, P2& p2, P3& p3 )
 		{ 
-			void* ptr = getAllocator().alloc( sizeof(T) );
+			void* ptr = alloc( sizeof(T) );
 			return new (ptr) T(p1,p2,p3);
 		}
 		template<class T , typename P1 , typename P2 , typename P3 , typename P4 >
 		inline static T* create( P1& p1, P2& p2, P3& p3, P4& p4)
 		{ 
-			void* ptr = getAllocator().alloc( sizeof(T) );
+			void* ptr = alloc( sizeof(T) );
 			return new (ptr) T(p1,p2,p3,p4);
 		}
 
 	protected:
-		static CacheAllocator& getAllocator()
+		//objects are destroyed by base pointer , so keep the size before them
+		union SizeHeader
+		{
+			size_t size;
+			double align;
+		};
+		static void* alloc( size_t size )
+		{
+			SizeHeader* header = static_cast< SizeHeader* >( PoolAllocator::Alloc( size + sizeof( SizeHeader ) ) );
+			header->size = size + sizeof( SizeHeader );
+			return header + 1;
+		}
+		static void dealloc( void* ptr )
 		{
-			static CacheAllocator allocator( MAX_CACHE_NUM );
-			return allocator;
+			SizeHeader* header = static_cast< SizeHeader* >( ptr ) - 1;
+			PoolAllocator::Free( header , header->size );
 		}
 	};
 
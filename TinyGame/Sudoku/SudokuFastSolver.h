@@ -0,0 +1,105 @@
+#ifndef SudokuFastSolver_h__
+#define SudokuFastSolver_h__
+
+#include "SudokuSolver.h"
+#include "Random.h"
+
+#include <algorithm>
+
+//  Backtracking solver for counting solutions and generating puzzles.
+//  The candidates of a cell are the AND of the group masks, so all numbers of
+//  a cell are checked at once; hidden singles are found with the once/twice
+//  masks of a group, which tests every number of the group in one pass.
+//  Each node propagates naked and hidden singles and branches on the cell with
+//  the fewest candidates. Works for any BS with NumberNum <= 32.
+template < int BS = 3 >
+class TSudokuFastSolver : public SudokuSolverBase
+{
+public:
+	static int const BoxSize    = BS;
+	static int const NumberNum  = BS * BS;
+	static int const MaxIndex   = NumberNum * NumberNum;
+	static unsigned const NumberBitFill = unsigned( ( 1ULL << NumberNum ) - 1 );
+
+	TSudokuFastSolver();
+
+	// prob : MaxIndex numbers , 0 is empty cell
+	// return number of solution found , stop when maxSolution is reached
+	int  solve( int const* prob , int maxSolution = 1 );
+	int  countSolution( int const* prob , int limit ){ return solve( prob , limit ); }
+	bool isUniqueSolution( int const* prob ){ return solve( prob , 2 ) == 1; }
+
+	int  getNumSolution() const { return mNumSolution; }
+	long getNumNode() const { return mNumNode; }
+	// number of first solution ( 1 - NumberNum )
+	int  getSolution( int idx ) const { return mSolution[ idx ]; }
+	int const* getSolution() const { return mSolution; }
+
+	// branch on candidates in random order , used by the generator
+	void setRandom( Random::Well512* rand ){ mRand = rand; }
+
+protected:
+
+	struct State
+	{
+		unsigned  groupPosible[3][ NumberNum ];
+		unsigned char number[ MaxIndex ];
+		int       numEmpty;
+	};
+
+	static int getBox( int col , int row ){ return ( col / BoxSize ) + BoxSize * ( row / BoxSize ); }
+	static int getCol( int idx ){ return idx % NumberNum; }
+	static int getRow( int idx ){ return idx / NumberNum; }
+
+	unsigned getPosible( State const& state , int idx ) const
+	{
+		int const* group = sIndexGroup[ idx ];
+		return state.groupPosible[COL][ group[COL] ] &
+			   state.groupPosible[ROW][ group[ROW] ] &
+			   state.groupPosible[BOX][ group[BOX] ];
+	}
+	bool fillNumber( State& state , int idx , unsigned numBit );
+	bool propagate( State& state );
+	void doSolve( State& state );
+
+	static void constructTable();
+
+	int  mMaxSolution;
+	int  mNumSolution;
+	long mNumNode;
+	int  mSolution[ MaxIndex ];
+	Random::Well512* mRand;
+
+	static bool sTableConstructed;
+	static int  sIndexGroup[ MaxIndex ][3];
+	static int  sGroupIndex[3][ NumberNum ][ NumberNum ];
+};
+
+
+//  Generate puzzles with one solution : a random full grid is solved from the
+//  empty board , then clues are removed in random order as long as the puzzle
+//  stays unique.
+template < int BS = 3 >
+class TSudokuGenerator
+{
+public:
+	typedef TSudokuFastSolver< BS > Solver;
+	static int const MaxIndex = Solver::MaxIndex;
+
+	TSudokuGenerator( unsigned seed = 0 ){ setSeed( seed ); }
+
+	void setSeed( unsigned seed );
+	// prob : output puzzle , numClueMin : stop removing when reach this number
+	// return number of clue
+	int  generate( int* prob , int numClueMin = 0 );
+	int  getSolution( int idx ) const { return mAnswer[ idx ]; }
+
+private:
+	Random::Well512 mRand;
+	Solver  mSolver;
+	int     mAnswer[ MaxIndex ];
+};
+
+#include "SudokuFastSolver.hpp"
+
+#endif // SudokuFastSolver_h__
@@ -0,0 +1,264 @@
+template < int N >
+bool TSudokuFastSolver<N>::sTableConstructed = false;
+template < int N >
+int  TSudokuFastSolver<N>::sIndexGroup[ MaxIndex ][3];
+template < int N >
+int  TSudokuFastSolver<N>::sGroupIndex[3][ NumberNum ][ NumberNum ];
+
+template < int N >
+TSudokuFastSolver<N>::TSudokuFastSolver()
+	:mMaxSolution( 1 )
+	,mNumSolution( 0 )
+	,mNumNode( 0 )
+	,mRand( 0 )
+{
+	if ( !sTableConstructed )
+		constructTable();
+}
+
+template < int N >
+void TSudokuFastSolver<N>::constructTable()
+{
+	int count[3][ NumberNum ] = { 0 };
+	for( int idx = 0 ; idx < MaxIndex ; ++idx )
+	{
+		int col = getCol( idx );
+		int row = getRow( idx );
+		int* group = sIndexGroup[ idx ];
+		group[COL] = col;
+		group[ROW] = row;
+		group[BOX] = getBox( col , row );
+
+		for( int g = 0 ; g < 3 ; ++g )
+			sGroupIndex[g][ group[g] ][ count[g][ group[g] ]++ ] = idx;
+	}
+	sTableConstructed = true;
+}
+
+template < int N >
+int TSudokuFastSolver<N>::solve( int const* prob , int maxSolution )
+{
+	mMaxSolution = maxSolution;
+	mNumSolution = 0;
+	mNumNode     = 0;
+
+	State state;
+	for( int n = 0; n < NumberNum ; ++n )
+	{
+		state.groupPosible[COL][n] = NumberBitFill;
+		state.groupPosible[ROW][n] = NumberBitFill;
+		state.groupPosible[BOX][n] = NumberBitFill;
+	}
+	state.numEmpty = MaxIndex;
+	for( int i = 0 ; i < MaxIndex ; ++i )
+		state.number[i] = 0;
+
+	for( int i = 0 ; i < MaxIndex ; ++i )
+	{
+		int num = prob[i];
+		if ( num == 0 )
+			continue;
+		if ( num < 0 || num > NumberNum || !fillNumber( state , i , 1 << ( num - 1 ) ) )
+			return 0;
+	}
+
+	doSolve( state );
+	return mNumSolution;
+}
+
+template < int N >
+bool TSudokuFastSolver<N>::fillNumber( State& state , int idx , unsigned numBit )
+{
+	if ( !( getPosible( state , idx ) & numBit ) )
+		return false;
+
+	int const* group = sIndexGroup[ idx ];
+	state.groupPosible[COL][ group[COL] ] &= ~numBit;
+	state.groupPosible[ROW][ group[ROW] ] &= ~numBit;
+	state.groupPosible[BOX][ group[BOX] ] &= ~numBit;
+	state.number[ idx ] = (unsigned char)Bit2Num( numBit );
+	--state.numEmpty;
+	return true;
+}
+
+template < int N >
+bool TSudokuFastSolver<N>::propagate( State& state )
+{
+	bool bChanged = true;
+	while( bChanged && state.numEmpty )
+	{
+		bChanged = false;
+
+		//naked single
+		for( int idx = 0 ; idx < MaxIndex ; ++idx )
+		{
+			if ( state.number[ idx ] )
+				continue;
+
+			unsigned posible = getPosible( state , idx );
+			if ( posible == 0 )
+				return false;
+			if ( ( posible & ( posible - 1 ) ) == 0 )
+			{
+				fillNumber( state , idx , posible );
+				bChanged = true;
+			}
+		}
+
+		//hidden single
+		for( int g = 0 ; g < 3 ; ++g )
+		{
+			for( int at = 0 ; at < NumberNum ; ++at )
+			{
+				int const* groupIndex = sGroupIndex[g][at];
+
+				unsigned once  = 0;
+				unsigned twice = 0;
+				for( int i = 0 ; i < NumberNum ; ++i )
+				{
+					int idx = groupIndex[i];
+					if ( state.number[ idx ] )
+						continue;
+					unsigned posible = getPosible( state , idx );
+					twice |= once & posible;
+					once  |= posible;
+				}
+
+				unsigned groupPosible = state.groupPosible[g][at];
+				if ( ( once & groupPosible ) != groupPosible )
+					return false;
+
+				unsigned single = once & ~twice;
+				while( single )
+				{
+					unsigned numBit = single & -single;
+					single -= numBit;
+
+					int i = 0;
+					for( ; i < NumberNum ; ++i )
+					{
+						int idx = groupIndex[i];
+						if ( state.number[ idx ] == 0 && ( getPosible( state , idx ) & numBit ) )
+							break;
+					}
+					if ( i == NumberNum || !fillNumber( state , groupIndex[i] , numBit ) )
+						return false;
+					bChanged = true;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template < int N >
+void TSudokuFastSolver<N>::doSolve( State& state )
+{
+	++mNumNode;
+
+	if ( !propagate( state ) )
+		return;
+
+	if ( state.numEmpty == 0 )
+	{
+		if ( mNumSolution == 0 )
+		{
+			for( int i = 0 ; i < MaxIndex ; ++i )
+				mSolution[i] = state.number[i];
+		}
+		++mNumSolution;
+		return;
+	}
+
+	int      bestIdx = -1;
+	int      bestCount = NumberNum + 1;
+	unsigned bestPosible = 0;
+	for( int idx = 0 ; idx < MaxIndex ; ++idx )
+	{
+		if ( state.number[ idx ] )
+			continue;
+		unsigned posible = getPosible( state , idx );
+		int count = bitCount( posible );
+		if ( count < bestCount )
+		{
+			bestIdx = idx;
+			bestCount = count;
+			bestPosible = posible;
+			if ( count == 2 )
+				break;
+		}
+	}
+
+	unsigned numBits[ NumberNum ];
+	int numBranch = 0;
+	while( bestPosible )
+	{
+		unsigned numBit = bestPosible & -bestPosible;
+		bestPosible -= numBit;
+		numBits[ numBranch++ ] = numBit;
+	}
+
+	if ( mRand )
+	{
+		for( int i = numBranch - 1 ; i > 0 ; --i )
+			std::swap( numBits[i] , numBits[ mRand->rand() % ( i + 1 ) ] );
+	}
+
+	for( int i = 0 ; i < numBranch ; ++i )
+	{
+		State nextState = state;
+		fillNumber( nextState , bestIdx , numBits[i] );
+		doSolve( nextState );
+		if ( mNumSolution >= mMaxSolution )
+			return;
+	}
+}
+
+template < int N >
+void TSudokuGenerator<N>::setSeed( unsigned seed )
+{
+	Random::Well512::uint32 s[16];
+	for( int i = 0 ; i < 16 ; ++i )
+	{
+		seed = seed * 1664525 + 1013904223;
+		s[i] = seed;
+	}
+	mRand.init( s );
+}
+
+template < int N >
+int TSudokuGenerator<N>::generate( int* prob , int numClueMin )
+{
+	//random full grid
+	for( int i = 0 ; i < MaxIndex ; ++i )
+		prob[i] = 0;
+
+	mSolver.setRandom( &mRand );
+	mSolver.solve( prob , 1 );
+	mSolver.setRandom( 0 );
+
+	for( int i = 0 ; i < MaxIndex ; ++i )
+	{
+		mAnswer[i] = mSolver.getSolution( i );
+		prob[i] = mAnswer[i];
+	}
+
+	int order[ MaxIndex ];
+	for( int i = 0 ; i < MaxIndex ; ++i )
+		order[i] = i;
+	for( int i = MaxIndex - 1 ; i > 0 ; --i )
+		std::swap( order[i] , order[ mRand.rand() % ( i + 1 ) ] );
+
+	int numClue = MaxIndex;
+	for( int i = 0 ; i < MaxIndex && numClue > numClueMin ; ++i )
+	{
+		int idx = order[i];
+		int num = prob[ idx ];
+		prob[ idx ] = 0;
+		if ( mSolver.isUniqueSolution( prob ) )
+			--numClue;
+		else
+			prob[ idx ] = num;
+	}
+	return numClue;
+}
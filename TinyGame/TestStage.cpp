@@ -11,6 +11,7 @@
 #include "GameReplay.h"
 
 #include "RenderUtility.h"
+#include "Clock.h"
 
 #if 1
 
@@ -123,6 +124,8 @@ namespace Bsp2D
 		mDrawTree = false;
 		mActor.pos = Vec2f( 10 , 10 );
 		mActor.size = Vec2f( 5 , 5 );
+		mLightPos = Vec2f( 10 , 10 );
+		mLightTime = 0;
 	}
 
 	bool TestStage::onInit()
@@ -136,6 +139,7 @@ namespace Bsp2D
 		frame->addButton( UI_ADD_POLYAREA , "Add PolyArea" );
 		frame->addButton( UI_TEST_INTERATION , "Test Collision" );
 		frame->addButton( UI_ACTOR_MOVE , "Actor Move" );
+		frame->addButton( UI_LIGHT_TEST , "Light Test" );
 		restart();
 		return true;
 	}
@@ -156,6 +160,33 @@ namespace Bsp2D
 		}
 		mPolyAreaMap.clear();
 		mTree.clear();
+		mLightHits.clear();
+	}
+
+	void TestStage::updateLight()
+	{
+		mLightHits.clear();
+		if ( !mTree.getRoot() )
+			return;
+
+		//all rays go in one batch
+		float const rayLength = 200.0f;
+		std::vector< Vec2f > starts( NumLightRay , mLightPos );
+		std::vector< Vec2f > ends( NumLightRay );
+		std::vector< Tree::ColInfo > infos( NumLightRay );
+		for( int i = 0 ; i < NumLightRay ; ++i )
+		{
+			float angle = 2 * 3.1415926f * i / NumLightRay;
+			ends[i] = mLightPos + rayLength * Vec2f( cos( angle ) , sin( angle ) );
+		}
+
+		TClock clock;
+		mTree.segmentTest( &starts[0] , &ends[0] , NumLightRay , &infos[0] );
+		mLightTime = clock.getTimeMicroseconds();
+
+		mLightHits.resize( NumLightRay );
+		for( int i = 0 ; i < NumLightRay ; ++i )
+			mLightHits[i] = mLightPos + infos[i].frac * ( ends[i] - mLightPos );
 	}
 
 
@@ -308,6 +339,19 @@ namespace Bsp2D
 				::Msg( str );
 			}
 			break;
+		case CMOD_LIGHT_TEST:
+			if ( !mLightHits.empty() )
+			{
+				RenderUtility::setPen( g , Color::eYellow );
+				for( int i = 0 , prev = (int)mLightHits.size() - 1 ; i < (int)mLightHits.size() ; prev = i++ )
+					drawLine( g , mLightHits[ prev ] , mLightHits[i] );
+
+				FixString< 128 > str;
+				str.format( "%d rays : %ld us" , NumLightRay , mLightTime );
+				g.setTextColor( 255 , 255 , 0 );
+				g.drawText( Vec2i( 20 , 20 ) , str );
+			}
+			break;
 		}
 
 	}
@@ -412,6 +456,7 @@ namespace Bsp2D
 				Vec2i size = ::Global::getDrawEngine()->getScreenSize();
 				mTree.build( &mPolyAreaMap[0] , (int)mPolyAreaMap.size() , 
 					Vec2f( 1 , 1 ) , Vec2f( size.x / 10 - 1, size.y / 10 - 1 ));
+				updateLight();
 			}
 			return false;
 		case UI_TEST_INTERATION:
@@ -420,6 +465,10 @@ namespace Bsp2D
 		case UI_ACTOR_MOVE:
 			mCtrlMode = CMOD_ACTOR_MOVE;
 			return false;
+		case UI_LIGHT_TEST:
+			mCtrlMode = CMOD_LIGHT_TEST;
+			updateLight();
+			return false;
 		}
 		return BaseClass::onEvent( event , id , ui );
 	}
@@ -481,6 +530,14 @@ namespace Bsp2D
 			{
 				mActor.pos = convertToWorld( msg.getPos() );
 			}
+			break;
+		case CMOD_LIGHT_TEST:
+			if ( msg.onLeftDown() || ( msg.isLeftDown() && msg.isDraging() ) )
+			{
+				mLightPos = convertToWorld( msg.getPos() );
+				updateLight();
+			}
+			break;
 		}
 		return false;
 	}
@@ -944,6 +944,7 @@ namespace Bsp2D
 			UI_BUILD_TREE ,
 			UI_TEST_INTERATION ,
 			UI_ACTOR_MOVE ,
+			UI_LIGHT_TEST ,
 
 		};
 
@@ -953,6 +954,7 @@ namespace Bsp2D
 			CMOD_CREATE_POLYAREA ,
 			CMOD_TEST_INTERACTION ,
 			CMOD_ACTOR_MOVE ,
+			CMOD_LIGHT_TEST ,
 		};
 
 		ControlMode mCtrlMode;
@@ -965,6 +967,11 @@ namespace Bsp2D
 		bool     mHaveCol;
 		Vec2f    mPosCol;
 
+		static int const NumLightRay = 2048;
+		Vec2f    mLightPos;
+		std::vector< Vec2f > mLightHits;
+		long     mLightTime;
+
 
 		struct Actor
 		{
@@ -977,6 +984,7 @@ namespace Bsp2D
 
 
 		void moveActor( Actor& actor , Vec2f const& offset );
+		void updateLight();
 
 		void testPlane()
 		{
@@ -1034,23 +1042,9 @@ namespace Bsp2D
 }
 
 
-#include "TVector2.h"
-#include <limits>
+#include "G2DGeometry.h"
 #include "Geometry2d.h"
 
-namespace G2D
-{
-	typedef TVector2< float > Vec2f;
-	typedef std::vector< Vec2f > Vertices;
-	inline Vec2f normalize( Vec2f const& v )
-	{
-		float len = sqrt( v.length2() );
-		if ( len < 1e-5 )
-			return Vec2f::Zero();
-		return ( 1 / len ) * v;
-
-	}
-}
 namespace Geom2d
 {
 	template<>
@@ -1066,155 +1060,6 @@ namespace Geom2d
 namespace G2D
 {
 
-	class QHullSolver
-	{
-	private:
-		Vec2f const* mV;
-		int*   mOut;
-	public:
-		int solve( Vec2f const v[] , int numV , int outIndex[] )
-		{
-			if ( numV <= 3 )
-			{
-				for( int i = 0 ; i < numV ; ++i )
-					outIndex[i] = i;
-				return numV;
-			}
-
-			assert( numV > 3 );
-			float xP[2] = { v[0].x , v[0].x };
-			float yP[2] = { v[0].y , v[0].y };
-			int xI[2] = { 0 , 0 };
-			int yI[2] = { 0 , 0 };
-			for( int i = 1 ; i < numV ; ++i )
-			{
-				float x = v[i].x;
-				float y = v[i].y;
-				if ( xP[0] > x ){ xI[0] = i; xP[0] = x; }
-				else if ( xP[1] < x ){ xI[1] = i; xP[1] = x; }
-				if ( yP[0] > y ){ yI[0] = i; yP[0] = y; }
-				else if ( yP[1] < y ){ yI[1] = i; yP[1] = y; }
-			}
-
-
-			std::vector< int > idxBuf( numV );
-			int* pIdx = &idxBuf[0];
-			int nV = 0;
-			for( int i = 0 ; i < numV ; ++i )
-			{
-				if ( i != xI[0] && i != xI[1] && i != yI[0] && i != yI[1] )
-				{
-					pIdx[ nV ] = i;
-					++nV;
-				}
-			}
-
-			mV   = v;
-			mOut = outIndex;
-			int num;
-			int idxQuad[5] = { xI[0] , yI[0] , xI[1] , yI[1] , xI[0] };
-
-			for( int i = 0 ; i < 4 ; ++i )
-			{
-				int i1 = idxQuad[i];
-				int i2 = idxQuad[i+1];
-				if ( i1 != i2 )
-				{
-					*mOut++ = i1;
-					if ( nV )
-					{
-						num = constuct_R( pIdx , nV , i1 , i2 );
-						pIdx += num;
-						nV -= num;
-					}
-				}
-			}
-			return mOut - outIndex;
-		}
-		int  constuct_R( int pIdx[] , int nV , int i1 , int i2 )
-		{
-			assert( nV > 0 );
-
-			int num = clip( pIdx , nV , i1 , i2 );
-
-			switch( num )
-			{
-			case 0: return 0;
-			case 1: *mOut++ = pIdx[0]; return 1;
-			default:
-				{
-					int iMax = pIdx[0];
-					int n = num - 1;
-					int* pTemp = pIdx + 1;
-					int temp = constuct_R( pTemp  , n , i1 , iMax );
-					n -= temp;
-					*mOut++ = iMax;
-					if ( n )
-					{
-						pTemp += temp;
-						constuct_R( pTemp  , n , iMax , i2 );
-					}
-				}
-			}
-			return num;
-		}
-
-		int clip( int pIdx[] , int nV , int i1 , int i2 )
-		{
-			assert( i1 != i2 );
-
-			Vec2f const* v = mV;
-			Vec2f const& v2 = v[i2]; 
-			Vec2f d = v[i1] - v2;
-
-			float valMax = 0;
-			int*  itMax = 0;
-
-			int*  iter = pIdx;
-			int*  itEnd = pIdx + nV;
-			while( iter != itEnd )
-			{
-				int idx = *iter;
-				assert( idx != i1 && idx != i2 );
-				float val = d.cross( v[ idx ] - v2 );
-
-				if ( val <= 0 )
-				{
-					--itEnd;
-					if ( iter != itEnd )
-					{
-						int temp = *iter;
-						*iter = *itEnd;
-						*itEnd = temp;
-					}
-				}
-				else 
-				{
-					if ( val > valMax )
-					{
-						itMax = iter;
-						valMax = val;
-					}
-					++iter;
-				}
-			}
-			if ( itMax && itMax != pIdx )
-			{
-				int temp = *itMax;
-				*itMax = *pIdx;
-				*pIdx = temp;
-			}
-			return iter - pIdx;
-		}
-
-	};
-	
-	inline int QuickHull( Vec2f const v[] , int nV , int outIndex[] )
-	{
-		QHullSolver solver;
-		return solver.solve( v , nV , outIndex );
-	}
-
 	class QHullTestStage : public StageBase
 	{
 		typedef StageBase BaseClass;
@@ -1341,216 +1186,62 @@ namespace G2D
 			switch( key )
 			{
 			case 'R': restart(); break;
+			case 'T':
+				::Msg( "Parallel hull test %s" , runParallelTest() ? "pass" : "fail" );
+				break;
 			}
 			return false;
 		}
 
-	protected:
-
-	};
-
-
-	struct PolyShape
-	{
-		int    numEdge;
-		Vec2f* normal;
-		Vec2f* vertex;
-	};
-	struct CircleShape
-	{
-		float radius;
-	};
-
-	class Solver
-	{
-	public:
-		bool  haveSA;
-		Vec2f vResult;
-		float fResult;
-
-		bool test( Vec2f const& pA , Vec2f vA[] , int nA , Vec2f const& pB , float radius )
+		//parallel hull must give the same hull as one thread ,
+		//also when extreme points coincide and the regions hold all other points
+		static bool runParallelTest()
 		{
-			Vec2f posRel = pA - pB;
-			float rangeB[2] = { -radius , radius };
-			float depthMin = std::numeric_limits< float >::max();
-			int   idx = -1;
-			for( int i = 0 , prev = nA - 1 ; i < nA; ++i )
-			{
-				{
-					Vec2f edge = vA[i] - vA[ prev ];
-					Vec2f axis = Vec2f( edge.y , -edge.x );
-
-					float len = sqrt( axis.length2() );
-					axis /= len;
-
-					float rangeA[2];
-					calcRange( rangeA , axis , vA , nA );
-					float offset = axis.dot( posRel );
-					rangeA[0] += offset;
-					rangeA[1] += offset;
-
-					if ( !isOverlap( rangeA , rangeB ) )
-					{
-						fResult = calcDistance( rangeA , rangeB );
-						vResult = axis;
-						return haveSA = true;
-					}
-
-					float depth = calcOverlapDepth( rangeA , rangeB );
-					if ( depth < depthMin )
-					{
-						depthMin = depth;
-						idx = i;
-					}
-				}
+			int const numPoint = 60003;
+			std::vector< Vec2f > vertices( numPoint );
+			std::vector< int >   outSerial( numPoint );
+			std::vector< int >   outParallel( numPoint );
+			std::vector< int >   workIndex( numPoint );
 
+			for( int n = 0 ; n < 2 ; ++n )
+			{
+				unsigned seed = 1234;
+				for( int i = 0 ; i < numPoint ; ++i )
 				{
-					Vec2f axis = vA[i] + posRel;
-
-					float len = sqrt( axis.length2() );
-					axis /= len;
-
-					float rangeA[2];
-					calcRange( rangeA , axis , vA , nA );
-					float offset = axis.dot( posRel );
-					rangeA[0] += offset;
-					rangeA[1] += offset;
-
-					if ( !isOverlap( rangeA , rangeB ) )
+					float x , y;
+					do
 					{
-						fResult = calcDistance( rangeA , rangeB );
-						vResult = axis;
-						return haveSA = true;
+						seed = seed * 1664525u + 1013904223u;
+						x = float( seed >> 16 ) * 1000 / 65536;
+						seed = seed * 1664525u + 1013904223u;
+						y = float( seed >> 16 ) * 1000 / 65536;
 					}
-
-					float depth = calcOverlapDepth( rangeA , rangeB );
-					if ( depth < depthMin )
-					{
-						depthMin = depth;
-						idx = i;
-					}
-				}
-				prev = i;
-			}
-
-			fResult = depthMin;
-			return haveSA = false;
-		}
-
-
-		bool test( Vec2f const& pA , Vec2f vA[] , int nA , Vec2f const& pB , Vec2f vB[] , int nB )
-		{
-			Vec2f posRel = pB - pA;
-
-			float depthMin = std::numeric_limits< float >::max();
-			int   idx = -1;
-			for( int i = 0 , prev = nA - 1 ; i < nA; ++i )
-			{
-				Vec2f edge = vA[i] - vA[ prev ];
-				Vec2f axis = Vec2f( edge.y , -edge.x );
-
-				float rangeA[2];
-				calcRange( rangeA , axis , vA , nA );
-				float rangeB[2];
-				calcRange( rangeB , axis , vB , nB );
-
-				float offset = axis.dot( posRel );
-				rangeB[0] += offset;
-				rangeB[1] += offset;
-
-				if ( !isOverlap( rangeA , rangeB ) )
-				{
-					fResult = calcDistance( rangeA , rangeB );
-					vResult = axis;
-					return haveSA = true;
-				}
-
-				float depth = calcOverlapDepth( rangeA , rangeB ) / sqrt( axis.length2() );
-				if ( depth < depthMin )
-				{
-					depthMin = depth;
-					idx = i;
+					//min x point is also min y point , the others are outside the quad
+					while( n == 1 && x + y <= 1001 );
+					vertices[i] = Vec2f( x , y );
 				}
-				prev = i;
-			}
-
-			for( int i = 0 , prev = nB - 1 ; i < nB; ++i )
-			{
-				Vec2f edge = vB[i] - vB[ prev ];
-				Vec2f axis = Vec2f( edge.y , -edge.x );
-
-				float rangeA[2];
-				calcRange( rangeA , axis , vA , nA );
-				float rangeB[2];
-				calcRange( rangeB , axis , vB , nB );
-
-
-				float offset = axis.dot( posRel );
-				rangeB[0] += offset;
-				rangeB[1] += offset;
-
-				if ( !isOverlap( rangeA , rangeB ) )
+				if ( n == 1 )
 				{
-					fResult = calcDistance( rangeA , rangeB );
-					vResult = axis;
-					return haveSA = true;
+					vertices[0] = Vec2f( 0 , 0 );
+					vertices[1] = Vec2f( 1000 , 0 );
+					vertices[2] = Vec2f( 0 , 1000 );
 				}
 
-				float depth = calcOverlapDepth( rangeA , rangeB ) / sqrt( axis.length2() );
-				if ( depth < depthMin )
-				{
-					depthMin = depth;
-					idx = -i;
-				}
-				prev = i;
+				QHullSolver solver;
+				int numSerial = solver.solve( &vertices[0] , numPoint , &outSerial[0] , &workIndex[0] );
+				int numParallel = solver.solveParallel( &vertices[0] , numPoint , &outParallel[0] , &workIndex[0] );
+				if ( numSerial != numParallel ||
+					 !std::equal( outSerial.begin() , outSerial.begin() + numSerial , outParallel.begin() ) )
+					return false;
 			}
-
-			fResult = depthMin;
-			return haveSA = false;
-		}
-
-		static bool isOverlap( float rangeA[] , float rangeB[] )
-		{
-			return ( rangeA[0] <= rangeB[1] ) && 
-				   ( rangeB[0] <= rangeA[1] );
-		}
-
-		static float calcOverlapDepth( float rangeA[] , float rangeB[] )
-		{
-			assert( isOverlap( rangeA , rangeB ) );
-			float vMin = std::max( rangeA[0] , rangeB[0] );
-			float vMax = std::min( rangeA[1] , rangeB[1] );
-			return vMax - vMin;
-		}
-
-		static float calcDistance( float rangeA[] , float rangeB[] )
-		{
-			assert( !isOverlap( rangeA , rangeB ) );
-			float vMin = std::max( rangeA[0] , rangeB[0] );
-			float vMax = std::min( rangeA[1] , rangeB[1] );
-			return vMin - vMax;
+			return true;
 		}
 
-		static void calcRange( float range[] , Vec2f const& axis , Vec2f v[] , int num )
-		{
-			float vMax , vMin;
-			vMax = vMin = axis.dot( v[0] );
-			for( int i = 1 ; i < num ; ++i )
-			{
-				float value = axis.dot( v[i] );
-				if ( value < range[0] )
-					vMin = value;
-				else if ( value > range[1] )
-					vMax = value;
-			}
-			range[0] = vMin;
-			range[1] = vMax;
-		}
+	protected:
 
 	};
 
 
-
 	static float const gRenderScale = 10.0f;
 
 	class TestStage : public StageBase
@@ -1745,7 +1436,7 @@ namespace G2D
 	protected:
 		
 
-		Solver      mSAT;
+		SATSolver mSAT;
 		Vertices mVA;
 		float    mR;
 		Vec2f    mPA;
@@ -157,6 +157,8 @@ namespace Tetris
 		{
 			mConMap[i] = cons + i * mSizeX;
 		}
+		mConIndex.resize( mSizeX * mSizeY );
+		mConnector.reserve( mSizeX * mSizeY );
 	}
 
 	void BlockStorage::cleanupData()
@@ -321,6 +323,27 @@ namespace Tetris
 		return hit;
 	}
 
+	struct ConnectLinker : public GridLinker4
+	{
+		ConnectLinker( BlockStorage& storage , int* conMap , short color )
+			:GridLinker4( storage.getSizeX() , storage.getSizeY() )
+			,storage( storage ),conMap( conMap ),color( color ){}
+
+		bool visit( int idx )
+		{
+			if ( conMap[ idx ] )
+				return false;
+			if ( Piece::getColor( storage.getBlock( idx % mSizeX , idx / mSizeX ) ) != color )
+				return false;
+			conMap[ idx ] = 1;
+			return true;
+		}
+
+		BlockStorage& storage;
+		int*          conMap;
+		short         color;
+	};
+
 	int BlockStorage::scanConnect( int cx , int cy  )
 	{
 		int* temp = mConMap[0];
@@ -330,45 +353,28 @@ namespace Tetris
 		if ( !isInRange( cx , cy ) )
 			return 0;
 
-		BlockType color = Piece::getColor( getBlock( cx , cy ) );
-		return scanConnectRecursive( cx , cy , color );
-	}
+		short color = Piece::getColor( getBlock( cx , cy ) );
 
-	int BlockStorage::scanConnectRecursive( int cx , int cy , short color  )
-	{
-		assert( isInRange( cx , cy ) );
-
-		if ( mConMap[cy][cx] )
-			return 0;
+		ConnectLinker linker( *this , temp , color );
+		int numCon = mConnector.collect( cx + cy * mSizeX , linker , &mConIndex[0] );
 
-		if ( Piece::getColor( getBlock( cx , cy ) )!= color )
-			return 0;
-
-		int num = 0;
-		int total = 0;
-
-		mConMap[cy][cx] = 1;
-
-#define CHECK_CON_NUM( PX , PY )\
-		{\
-			int nx = ( PX );\
-			int ny = ( PY );\
-			if ( isInRange( nx , ny ) )\
-			{\
-				total += scanConnectRecursive( nx , ny, color );\
-				if ( Piece::getColor( getBlock( nx , ny ) ) == color )\
-				++num;\
-			}\
+		//count blocks with less than three neighbors of the same color
+		int result = 0;
+		for( int n = 0 ; n < numCon ; ++n )
+		{
+			int idx = mConIndex[n];
+			int num = 0;
+			for( int dir = 0 ; dir < linker.getLinkNum() ; ++dir )
+			{
+				int idxLink = linker.getLinkIndex( idx , dir );
+				if ( idxLink != -1 && 
+					 Piece::getColor( getBlock( idxLink % mSizeX , idxLink / mSizeX ) ) == color )
+					++num;
+			}
+			if ( num <= 2 )
+				++result;
 		}
-
-		CHECK_CON_NUM( cx + 1 , cy );
-		CHECK_CON_NUM( cx - 1 , cy );
-		CHECK_CON_NUM( cx , cy + 1 );
-		CHECK_CON_NUM( cx , cy - 1 );
-
-#undef CHECK_CON_NUM
-
-		return total + (( num <= 2 ) ? 1 : 0 );
+		return result;
 	}
 
 	int BlockStorage::removeConnect()
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <vector>
 #include "IntegerType.h"
+#include "GridConnector.h"
 
 namespace Tetris
 {
@@ -147,7 +148,6 @@ namespace Tetris
 		int              removeConnect();
 		int              scanConnect( int cx , int cy );
 
-		int              scanConnectRecursive( int cx , int cy , short color );
 		int              scanFilledLayer( int yMax , int yMin , int removeLayer[] );
 
 		inline bool isInExtendRange(int cx,int cy)
@@ -179,6 +179,8 @@ namespace Tetris
 		Layer*  mLayerStorage;
 		std::vector< Layer* >  mLayerMap;
 		std::vector< int* >    mConMap;
+		std::vector< int >     mConIndex;
+		GridConnector          mConnector;
 
 	};
 
@@ -27,9 +27,25 @@
 #include "ReplayStage.h"
 
 #include "GLUtility.h"
+#include "FrameAllocator.h"
+
+#ifdef _DEBUG
+#include <crtdbg.h>
+#endif
 
 #define GAME_SETTING_PATH "Game.ini"
 
+#ifdef _DEBUG
+//heap allocs of one game loop , games share the dll crt in debug , so all modules are counted
+static long gLoopAllocCount = 0;
+static int  CountAllocHook( int allocType , void* , size_t , int , long , unsigned char const* , int )
+{
+	if ( allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC )
+		++gLoopAllocCount;
+	return TRUE;
+}
+#endif
+
 int g_DevMsgLevel = 10;
 
 class GMsgListener : public IMsgListener
@@ -135,6 +151,11 @@ bool TinyGameApp::onInit()
 
 	mFPSCalc.init( getMillionSecond() );
 
+#ifdef _DEBUG
+	mLastLoopAllocCount = 0;
+	_CrtSetAllocHook( CountAllocHook );
+#endif
+
 	return true;
 }
 
@@ -193,6 +214,15 @@ void TinyGameApp::onRender()
 	render( 0.0f );
 }
 
+void TinyGameApp::onEndTick()
+{
+	Global::getFrameAllocator().clearFrame();
+#ifdef _DEBUG
+	mLastLoopAllocCount = gLoopAllocCount;
+	gLoopAllocCount = 0;
+#endif
+}
+
 void TinyGameApp::loadGamePackage()
 {
 	FileIterator fileIter;
@@ -448,6 +478,9 @@ void TinyGameApp::render( float dframe )
 	FixString< 256 > str;
 	g.setTextColor( 255 , 255 , 0 );
 	g.drawText( Vec2i(5,5) , str.format( "FPS = %f" , mFPSCalc.getFPS() ) );
+#ifdef _DEBUG
+	g.drawText( Vec2i(5,20) , str.format( "Alloc/Loop = %d" , mLastLoopAllocCount ) );
+#endif
 
 	if ( ::Global::getDrawEngine()->isEnableOpenGL() )
 		::Global::getGLGraphics2D().endRender();
@@ -128,6 +128,7 @@ public:
 	long  onUpdate( long shouldTime );
 	void  onRender();
 	void  onIdle( long time );
+	void  onEndTick();
 
 	//SysMsgHandler< TinyGameApp >
 	bool  onMouse( MouseMsg const& msg );
@@ -154,6 +155,9 @@ private:
 	NetWorker*         mNetWorker;
 	bool               mShowErrorMsg;
 	FPSCalculator      mFPSCalc;
+#ifdef _DEBUG
+	long               mLastLoopAllocCount;
+#endif
 };
 
 #endif // TinyGameApp_h__
@@ -3,18 +3,26 @@
 
 #include "TDEntity.h"
 
+#include <algorithm>
+
 namespace TowerDefend
 {
 	ColObject::ColObject( Entity& entity ) 
 		:mOwner( entity )
-		,mHaveTested( false )
+		,mQueryStamp( 0 )
 	{
+		for( int i = 0 ; i < 4 ; ++i )
+		{
+			mColHashValue[i] = INVALID_HASH_VALUE;
+			mColCell[i] = -1;
+		}
 
 	}
 
 	CollisionManager::CollisionManager()
 	{
 		mNumColObject = 0;
+		mQueryStamp   = 0;
 	}
 
 
@@ -119,36 +127,19 @@ namespace TowerDefend
 		else
 			min.y += offset.y;
 
-		unsigned hashValue[4];
-
-		calcHashValue( min , max , hashValue );
+		collectObjects( min , max );
 
 		ColObject* colObj = NULL;
-
-		clearTestedObj();
-
-		for( int i = 0 ; i < 4 ; ++i )
+		for( ColObjVec::iterator iter = mQueryList.begin();
+			iter != mQueryList.end() ; ++iter )
 		{
-			if ( hashValue[i] == INVALID_HASH_VALUE )
+			ColObject* testObj = *iter;
+			if ( testObj == skip )
 				continue;
 
-			Grid& grid = mGrids[ hashValue[i] ];
-
-			for( ColObjList::iterator iter = grid.objs.begin();
-				iter != grid.objs.end() ; ++iter )
+			if ( TowerDefend::testCollision( testObj->getOwner().getPos() , testObj->getBoundRadius() , pos , radius , offset ) )
 			{
-				ColObject* testObj = (*iter);
-
-				if ( testObj == skip )
-					continue;
-
-				if ( !addTestedObj( *iter ) )
-					continue;
-
-				if ( TowerDefend::testCollision( testObj->getOwner().getPos() , testObj->getBoundRadius() , pos , radius , offset ) )
-				{
-					colObj = (*iter);
-				}
+				colObj = testObj;
 			}
 		}
 
@@ -162,54 +153,45 @@ namespace TowerDefend
 
 	void CollisionManager::testCollision( Vec2f const& min , Vec2f const& max , CollisionCallback const& callback )
 	{
-		unsigned hashValue[4];
-		calcHashValue( min , max , hashValue );
+		collectObjects( min , max );
 
-		clearTestedObj();
+		//callback may move objects , so don't use the cells here
+		ColObjVec objList;
+		objList.swap( mQueryList );
 
-		for( int i = 0 ; i < 4 ; ++i )
+		for( ColObjVec::iterator iter = objList.begin();
+			iter != objList.end() ; ++iter )
 		{
-			if ( hashValue[i] == INVALID_HASH_VALUE )
-				continue;
+			ColObject* tObj = *iter;
 
-			Grid& grid = mGrids[ hashValue[i] ];
+			Vec2f const& pos = tObj->getOwner().getPos();
+			float radius = tObj->getBoundRadius();
 
-			for( ColObjList::iterator iter = grid.objs.begin();
-				iter != grid.objs.end() ; ++iter )
-			{
-				if ( !addTestedObj( *iter ) )
-					continue;
-
-				ColObject* tObj = *iter;
-
-				Vec2f const& pos = tObj->getOwner().getPos();
-				float radius = tObj->getBoundRadius();
-
-				if ( pos.x + radius < min.x || pos.x - radius > max.x || 
-					pos.y + radius < min.y || pos.y - radius > max.y )
-					continue;
+			if ( pos.x + radius < min.x || pos.x - radius > max.x || 
+				pos.y + radius < min.y || pos.y - radius > max.y )
+				continue;
 
-				if ( !callback( *tObj ) )
-				{	
-					return;
-				}
-			}
+			if ( !callback( *tObj ) )
+				break;
 		}
+
+		objList.clear();
+		if ( mQueryList.empty() )
+			mQueryList.swap( objList );
 	}
 
 	ColObject* CollisionManager::getObject( Vec2f const& pos )
 	{
-		unsigned hashValue = getHash( pos.x , pos.y );
-
-		clearTestedObj();
+		int idx = findCell( getHash( pos.x , pos.y ) );
+		if ( idx == -1 )
+			return NULL;
 
-		Grid& grid = mGrids[ hashValue ];
-
-		for( ColObjList::iterator iter = grid.objs.begin();
-			iter != grid.objs.end() ; ++iter )
+		ColObjVec& objs = mCells[ idx ].objs;
+		for( ColObjVec::iterator iter = objs.begin();
+			iter != objs.end() ; ++iter )
 		{
 			ColObject* obj = *iter;
-			if ( !addTestedObj( obj ) )
+			if ( obj->getOwner().checkFlag( EF_DEAD | EF_DESTROY ) )
 				continue;
 
 			Vec2f dif = obj->getOwner().getPos() - pos;
@@ -223,37 +205,24 @@ namespace TowerDefend
 	{
 		Vec2f min = pos;
 		Vec2f max = pos + Vec2f( gColCellLength , gColCellLength );
-		unsigned hashValue[4];
-		calcHashValue( min , max , hashValue );
-
-		clearTestedObj();
+		collectObjects( min , max );
 
 		totalOffset = 0;
 
-		for( int i = 0 ; i < 4 ; ++i )
+		for( ColObjVec::iterator iter = mQueryList.begin();
+			iter != mQueryList.end() ; ++iter )
 		{
-			if ( hashValue[i] == INVALID_HASH_VALUE )
-				continue;
-
-			Grid& grid = mGrids[ hashValue[i] ];
-
-			for( ColObjList::iterator iter = grid.objs.begin();
-				iter != grid.objs.end() ; ++iter )
+			ColObject* obj = *iter;
+			float offset[2];
+			if ( testCollisionOffset( 
+				obj->getOwner().getPos() , obj->getBoundRadius() ,
+				pos , obj->getBoundRadius() , offsetDir , offset ) )
 			{
-				ColObject* obj = *iter;
-				if ( !addTestedObj( obj ) )
-					continue;
-				float offset[2];
-				if ( testCollisionOffset( 
-					obj->getOwner().getPos() , obj->getBoundRadius() ,
-					pos , obj->getBoundRadius() , offsetDir , offset ) )
-				{
-					assert( offset[1] >= 0 ); 
-					totalOffset += offset[1];
-					if ( totalOffset > gColCellLength )
-						return false;
-					pos += offset[1] * offsetDir;
-				}
+				assert( offset[1] >= 0 ); 
+				totalOffset += offset[1];
+				if ( totalOffset > gColCellLength )
+					return false;
+				pos += offset[1] * offsetDir;
 			}
 		}
 		return true;
@@ -263,17 +232,14 @@ namespace TowerDefend
 	{
 		for( int i = 0 ; i < 4 ; ++i )
 		{
-			unsigned hashVal = obj.mColHashValue[ i ];
-			if ( hashVal == INVALID_HASH_VALUE )
+			if ( obj.mColCell[i] == -1 )
 				continue;
-
-			mGrids[ hashVal ].objs.remove( &obj );
+			removeCellObj( obj , i );
+			obj.mColHashValue[i] = INVALID_HASH_VALUE;
 		}
 		--mNumColObject;
 	}
 
-
-
 	void CollisionManager::addObject( ColObject& obj )
 	{
 		Vec2f const& pos = obj.getOwner().getPos();
@@ -285,8 +251,11 @@ namespace TowerDefend
 		{
 			unsigned hashVal = obj.mColHashValue[ i ];
 			if ( hashVal == INVALID_HASH_VALUE )
+			{
+				obj.mColCell[i] = -1;
 				continue;
-			mGrids[ hashVal ].objs.push_back( &obj );
+			}
+			insertCellObj( obj , i );
 		}
 
 		++mNumColObject;
@@ -302,23 +271,179 @@ namespace TowerDefend
 
 		for( int i = 0 ; i < 4 ; ++i )
 		{
-			unsigned hashVal = obj.mColHashValue[ i ];
-			if ( hashVal != newHash[i] )
+			if ( obj.mColHashValue[i] != newHash[i] && obj.mColCell[i] != -1 )
+				removeCellObj( obj , i );
+		}
+
+		for( int i = 0 ; i < 4 ; ++i )
+		{
+			if ( obj.mColHashValue[i] == newHash[i] )
+				continue;
+
+			obj.mColHashValue[i] = newHash[i];
+			if ( newHash[i] != INVALID_HASH_VALUE )
+				insertCellObj( obj , i );
+		}
+	}
+
+	void CollisionManager::insertCellObj( ColObject& obj , int idx )
+	{
+		int cellIdx = fetchCell( obj.mColHashValue[ idx ] );
+		ColObjVec& objs = mCells[ cellIdx ].objs;
+
+		obj.mColCell[ idx ]    = cellIdx;
+		obj.mColCellPos[ idx ] = (int)objs.size();
+		objs.push_back( &obj );
+	}
+
+	void CollisionManager::removeCellObj( ColObject& obj , int idx )
+	{
+		int cellIdx = obj.mColCell[ idx ];
+		ColObjVec& objs = mCells[ cellIdx ].objs;
+
+		int pos = obj.mColCellPos[ idx ];
+		assert( objs[ pos ] == &obj );
+
+		//move the last object to the hole
+		ColObject* last = objs.back();
+		objs[ pos ] = last;
+		objs.pop_back();
+		if ( last != &obj )
+		{
+			for( int i = 0 ; i < 4 ; ++i )
 			{
-				if ( hashVal != INVALID_HASH_VALUE )
-					mGrids[ hashVal ].objs.remove( &obj );
+				if ( last->mColCell[i] == cellIdx )
+				{
+					last->mColCellPos[i] = pos;
+					break;
+				}
 			}
 		}
+		obj.mColCell[ idx ] = -1;
+	}
 
-		for( int i = 0 ; i < 4 ; ++i )
+	static unsigned MixHash( unsigned value )
+	{
+		value *= 2654435761u;
+		return value ^ ( value >> 16 );
+	}
+
+	int CollisionManager::findCell( unsigned hashValue ) const
+	{
+		if ( mCellTable.empty() )
+			return -1;
+
+		unsigned mask = unsigned( mCellTable.size() - 1 );
+		for( unsigned pos = MixHash( hashValue ) & mask ; ; pos = ( pos + 1 ) & mask )
 		{
-			unsigned hashVal = obj.mColHashValue[ i ];
-			if ( hashVal != newHash[i] )
+			int idx = mCellTable[ pos ];
+			if ( idx == -1 )
+				return -1;
+			if ( mCells[ idx ].hashValue == hashValue )
+				return idx;
+		}
+	}
+
+	int CollisionManager::fetchCell( unsigned hashValue )
+	{
+		int idx = findCell( hashValue );
+		if ( idx != -1 )
+			return idx;
+
+		//keep load factor under 0.5
+		if ( 2 * ( mCells.size() + 1 ) > mCellTable.size() )
+			rehashCell( std::max< int >( 64 , 2 * (int)mCellTable.size() ) );
+
+		idx = (int)mCells.size();
+		mCells.push_back( Cell() );
+		mCells.back().hashValue = hashValue;
+
+		unsigned mask = unsigned( mCellTable.size() - 1 );
+		unsigned pos = MixHash( hashValue ) & mask;
+		while( mCellTable[ pos ] != -1 )
+			pos = ( pos + 1 ) & mask;
+		mCellTable[ pos ] = idx;
+		return idx;
+	}
+
+	void CollisionManager::rehashCell( int tableSize )
+	{
+		mCellTable.assign( tableSize , -1 );
+
+		unsigned mask = unsigned( tableSize - 1 );
+		for( int i = 0 ; i < (int)mCells.size() ; ++i )
+		{
+			unsigned pos = MixHash( mCells[i].hashValue ) & mask;
+			while( mCellTable[ pos ] != -1 )
+				pos = ( pos + 1 ) & mask;
+			mCellTable[ pos ] = i;
+		}
+	}
+
+	void CollisionManager::beginQuery()
+	{
+		mQueryList.clear();
+
+		++mQueryStamp;
+		if ( mQueryStamp == 0 )
+		{
+			//stamp wrap around , clear old stamp
+			for( CellVec::iterator iter = mCells.begin() ; iter != mCells.end() ; ++iter )
 			{
-				if ( newHash[i] != INVALID_HASH_VALUE )
-					mGrids[ newHash[i] ].objs.push_back( &obj );
+				for( ColObjVec::iterator objIter = iter->objs.begin() ; objIter != iter->objs.end() ; ++objIter )
+					(*objIter)->mQueryStamp = 0;
 			}
-			obj.mColHashValue[i] = newHash[i];
+			mQueryStamp = 1;
+		}
+	}
+
+	void CollisionManager::collectObjects( Vec2f const& min , Vec2f const& max )
+	{
+		beginQuery();
+
+		int xMin , yMin , xMax , yMax;
+		clampGrid( min.x , min.y , xMin , yMin );
+		clampGrid( max.x , max.y , xMax , yMax );
+
+		int numRange = ( xMax - xMin + 1 ) * ( yMax - yMin + 1 );
+		if ( numRange > (int)mCells.size() )
+		{
+			//large range , scan used cells
+			for( CellVec::iterator iter = mCells.begin() ; iter != mCells.end() ; ++iter )
+			{
+				int gx = int( iter->hashValue % mGridSize.x );
+				int gy = int( iter->hashValue / mGridSize.x );
+				if ( xMin <= gx && gx <= xMax && yMin <= gy && gy <= yMax )
+					collectCell( *iter );
+			}
+		}
+		else
+		{
+			for( int gy = yMin ; gy <= yMax ; ++gy )
+			{
+				for( int gx = xMin ; gx <= xMax ; ++gx )
+				{
+					int idx = findCell( unsigned( gx + gy * mGridSize.x ) );
+					if ( idx != -1 )
+						collectCell( mCells[ idx ] );
+				}
+			}
+		}
+	}
+
+	void CollisionManager::collectCell( Cell& cell )
+	{
+		for( ColObjVec::iterator iter = cell.objs.begin() ; iter != cell.objs.end() ; ++iter )
+		{
+			ColObject* obj = *iter;
+			if ( obj->mQueryStamp == mQueryStamp )
+				continue;
+			obj->mQueryStamp = mQueryStamp;
+
+			if ( obj->getOwner().checkFlag( EF_DEAD | EF_DESTROY ) )
+				continue;
+
+			mQueryList.push_back( obj );
 		}
 	}
 
@@ -356,44 +481,27 @@ namespace TowerDefend
 		if ( size.y & gColCellScale )
 			mGridSize.y += 1;
 
-		mGrids.resize( mGridSize.x * mGridSize.y );
-	}
-
-	bool CollisionManager::addTestedObj( ColObject* obj )
-	{
-		if ( obj->getOwner().checkFlag( EF_DEAD | EF_DESTROY ) )
-			return false;
-
-		if ( obj->mHaveTested )
-			return false;
-
-		mTestedUnit.push_back( obj );
-		obj->mHaveTested = true;
-		return true;
-	}
-
-	void CollisionManager::clearTestedObj()
-	{
-		for( ColObjVec::iterator iter = mTestedUnit.begin();
-			iter != mTestedUnit.end() ; ++iter )
-		{
-			(*iter)->mHaveTested = false;
-		}
-
-		mTestedUnit.clear();
+		mCells.clear();
+		mCellTable.clear();
+		mQueryList.clear();
 	}
 
-	unsigned CollisionManager::getHash( float x , float y )
+	void CollisionManager::clampGrid( float x , float y , int& gx , int& gy )
 	{
-		int gx = int( x / gColCellLength );
-		int gy = int( y / gColCellLength );
+		gx = int( x / gColCellLength );
+		gy = int( y / gColCellLength );
 
 		if ( gx < 0 ) gx = 0;
 		else if ( gx >= mGridSize.x ) gx = mGridSize.x - 1;
 
 		if ( gy < 0 ) gy = 0;
 		else if ( gy >= mGridSize.y ) gy = mGridSize.y - 1;
+	}
 
+	unsigned CollisionManager::getHash( float x , float y )
+	{
+		int gx , gy;
+		clampGrid( x , y , gx , gy );
 		return (unsigned)( gx + gy * mGridSize.x );
 	}
 
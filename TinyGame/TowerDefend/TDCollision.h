@@ -2,7 +2,6 @@
 #define TDCollision_h__
 
 #include "TDDefine.h"
-#include <list>
 #include <vector>
 
 namespace TowerDefend
@@ -27,14 +26,21 @@ namespace TowerDefend
 		void      render( Renderer& renderer );
 		//private:
 		friend class CollisionManager;
-		bool       mHaveTested;
+		unsigned   mQueryStamp;
 		unsigned   mColHashValue[4];
+		int        mColCell[4];
+		int        mColCellPos[4];
 		Entity&    mOwner;
 		float      mBoundRadius;
 	};
 
 	typedef fastdelegate::FastDelegate< bool ( ColObject& ) > CollisionCallback;
 
+	//  Objects are hashed to the cells their bound touches ( at most 4 ).
+	//  Used cells are packed in one array with a contiguous object array each ,
+	//  and found by an open addressing table of the cell hash value.
+	//  A query collects objects into one list first , deduped by a query stamp ,
+	//  so callbacks may move objects safely.
 	class CollisionManager
 	{
 	public:
@@ -56,23 +62,33 @@ namespace TowerDefend
 
 		void         calcHashValue( Vec2f const& min , Vec2f const& max , unsigned value[] );
 		unsigned     getHash( float x , float y );
+		void         clampGrid( float x , float y , int& gx , int& gy );
 
-		typedef std::list< ColObject* > ColObjList;
-		struct Grid 
+		typedef std::vector< ColObject* > ColObjVec;
+		struct Cell
 		{
-			ColObjList objs;
+			unsigned  hashValue;
+			ColObjVec objs;
 		};
 
-		typedef std::vector< Grid > GridVec;
+		int          findCell( unsigned hashValue ) const;
+		int          fetchCell( unsigned hashValue );
+		void         rehashCell( int tableSize );
+		void         insertCellObj( ColObject& obj , int idx );
+		void         removeCellObj( ColObject& obj , int idx );
+
+		void         beginQuery();
+		void         collectObjects( Vec2f const& min , Vec2f const& max );
+		void         collectCell( Cell& cell );
+
+		typedef std::vector< Cell > CellVec;
 		Vec2i   mGridSize;
-		GridVec mGrids;
+		CellVec mCells;
+		std::vector< int > mCellTable;
 		int     mNumColObject;
 
-		bool addTestedObj( ColObject* obj );
-		void clearTestedObj();
-
-		typedef std::vector< ColObject* > ColObjVec;
-		ColObjVec mTestedUnit;
+		unsigned  mQueryStamp;
+		ColObjVec mQueryList;
 	};
 
 }//namespace TowerDefend
@@ -207,6 +207,17 @@ namespace TowerDefend
 		if ( dist < MinDistance )
 			return false;
 
+		WorldMap& map = actor->getWorld()->getMap();
+
+		//go around buildings with the flow field of the goal cell
+		Vec2f wayPos;
+		bool  useFlowField = map.getFlowWayPoint( destPos , unit->getPos() , CL_WALK , wayPos );
+		if ( useFlowField )
+		{
+			dir = wayPos - unit->getPos();
+			normalize( dir );
+		}
+
 		static int count = 0; 
 
 
@@ -248,8 +259,6 @@ namespace TowerDefend
 
 		Vec2f mapPos = unit->getPos() / gMapCellLength;
 
-
-		WorldMap& map = actor->getWorld()->getMap();
 		bool xCol = false;
 		bool yCol = false;
 
@@ -294,7 +303,7 @@ namespace TowerDefend
 		float minError = 1.f;
 		if ( xCol )
 		{
-			if ( fabs( delta.y + offset.y ) < minError )
+			if ( !useFlowField && fabs( delta.y + offset.y ) < minError )
 				return false;
 
 			float temp =  maxOffsetSqure - offset.x * offset.x;
@@ -313,7 +322,7 @@ namespace TowerDefend
 		}
 		else if ( yCol )
 		{
-			if ( fabs( delta.x + offset.x ) < minError )
+			if ( !useFlowField && fabs( delta.x + offset.x ) < minError )
 				return false;
 
 			float temp =  maxOffsetSqure - offset.y * offset.y;
@@ -0,0 +1,315 @@
+#include "TDPCH.h"
+#include "TDFlowField.h"
+
+#include "TDWorld.h"
+
+#include <algorithm>
+
+namespace TowerDefend
+{
+	//0 - 3 straight , 4 - 7 diagonal
+	static int const DirOffsetX[] = { 1 , 0 , -1 ,  0 , 1 , -1 , -1 ,  1 };
+	static int const DirOffsetY[] = { 0 , 1 ,  0 , -1 , 1 ,  1 , -1 , -1 };
+	static int const StepCost[]   = { 10 , 10 , 10 , 10 , 14 , 14 , 14 , 14 };
+
+	static int InverseDir( int dir )
+	{
+		if ( dir < 4 )
+			return ( dir + 2 ) % 4;
+		return 4 + ( dir - 2 ) % 4;
+	}
+
+	FlowField::FlowField( Vec2i const& goal , int layer )
+		:mGoal( goal )
+		,mLayer( layer )
+		,mSizeX( 0 )
+		,mSizeY( 0 )
+		,mUpdateCount( 0 )
+	{
+
+	}
+
+	bool FlowField::isBlocked( WorldMap& map , int x , int y ) const
+	{
+		return map.mMapData.getData( x , y ).blockMask[ mLayer ] != 0;
+	}
+
+	bool FlowField::canStep( WorldMap& map , int x , int y , int dir ) const
+	{
+		int nx = x + DirOffsetX[ dir ];
+		int ny = y + DirOffsetY[ dir ];
+		if ( nx < 0 || nx >= mSizeX || ny < 0 || ny >= mSizeY )
+			return false;
+		if ( isBlocked( map , nx , ny ) )
+			return false;
+		//don't cut the corner of blocked cells
+		if ( dir >= 4 && ( isBlocked( map , nx , y ) || isBlocked( map , x , ny ) ) )
+			return false;
+		return true;
+	}
+
+	void FlowField::pushNode( int index , int cost )
+	{
+		Node node;
+		node.cost  = cost;
+		node.index = index;
+		mHeap.push_back( node );
+		std::push_heap( mHeap.begin() , mHeap.end() );
+	}
+
+	void FlowField::build( WorldMap& map )
+	{
+		mSizeX = map.mMapData.getSizeX();
+		mSizeY = map.mMapData.getSizeY();
+		mCost.assign( mSizeX * mSizeY , Unreachable );
+		mNextDir.assign( mSizeX * mSizeY , -1 );
+		mHeap.clear();
+		mUpdateCount = 0;
+
+		if ( !map.mMapData.checkRange( mGoal.x , mGoal.y ) || isBlocked( map , mGoal.x , mGoal.y ) )
+			return;
+
+		int index = toIndex( mGoal.x , mGoal.y );
+		mCost[ index ] = 0;
+		pushNode( index , 0 );
+		propagate( map );
+	}
+
+	void FlowField::propagate( WorldMap& map )
+	{
+		while( !mHeap.empty() )
+		{
+			std::pop_heap( mHeap.begin() , mHeap.end() );
+			Node node = mHeap.back();
+			mHeap.pop_back();
+
+			//skip old entry of a cell which got lower cost
+			if ( node.cost != mCost[ node.index ] )
+				continue;
+
+			++mUpdateCount;
+
+			int x = node.index % mSizeX;
+			int y = node.index / mSizeX;
+			for( int dir = 0 ; dir < 8 ; ++dir )
+			{
+				if ( !canStep( map , x , y , dir ) )
+					continue;
+
+				int nIndex = toIndex( x + DirOffsetX[ dir ] , y + DirOffsetY[ dir ] );
+				int cost = node.cost + StepCost[ dir ];
+				if ( cost >= mCost[ nIndex ] )
+					continue;
+
+				mCost[ nIndex ]    = cost;
+				mNextDir[ nIndex ] = char( InverseDir( dir ) );
+				pushNode( nIndex , cost );
+			}
+		}
+	}
+
+	void FlowField::relaxCell( WorldMap& map , int x , int y )
+	{
+		if ( isBlocked( map , x , y ) )
+			return;
+
+		int index = toIndex( x , y );
+		if ( x == mGoal.x && y == mGoal.y )
+		{
+			if ( mCost[ index ] != 0 )
+			{
+				mCost[ index ]    = 0;
+				mNextDir[ index ] = -1;
+				pushNode( index , 0 );
+			}
+			return;
+		}
+
+		int bestCost = mCost[ index ];
+		int bestDir  = -1;
+		for( int dir = 0 ; dir < 8 ; ++dir )
+		{
+			if ( !canStep( map , x , y , dir ) )
+				continue;
+
+			int nCost = mCost[ toIndex( x + DirOffsetX[ dir ] , y + DirOffsetY[ dir ] ) ];
+			if ( nCost == Unreachable )
+				continue;
+
+			int cost = nCost + StepCost[ dir ];
+			if ( cost < bestCost )
+			{
+				bestCost = cost;
+				bestDir  = dir;
+			}
+		}
+
+		if ( bestDir != -1 )
+		{
+			mCost[ index ]    = bestCost;
+			mNextDir[ index ] = char( bestDir );
+			pushNode( index , bestCost );
+		}
+	}
+
+	void FlowField::updateRegion( WorldMap& map , Vec2i const& start , Vec2i const& end )
+	{
+		if ( mCost.empty() )
+			return;
+
+		mUpdateCount = 0;
+		mHeap.clear();
+		mResetList.clear();
+
+		//steps of cells next to the rect can be broken too
+		int xMin = std::max( start.x - 1 , 0 );
+		int yMin = std::max( start.y - 1 , 0 );
+		int xMax = std::min( end.x + 1 , mSizeX );
+		int yMax = std::min( end.y + 1 , mSizeY );
+
+		for( int y = yMin ; y < yMax ; ++y )
+		{
+			for( int x = xMin ; x < xMax ; ++x )
+			{
+				int index = toIndex( x , y );
+				if ( mCost[ index ] == Unreachable )
+					continue;
+
+				bool beReset;
+				if ( isBlocked( map , x , y ) )
+					beReset = true;
+				else if ( mNextDir[ index ] != -1 )
+					beReset = !canStep( map , x , y , mNextDir[ index ] );
+				else
+					beReset = false;
+
+				if ( beReset )
+				{
+					mCost[ index ]    = Unreachable;
+					mNextDir[ index ] = -1;
+					mResetList.push_back( index );
+				}
+			}
+		}
+
+		//reset all cells moving through the reset cells
+		for( size_t i = 0 ; i < mResetList.size() ; ++i )
+		{
+			int x = mResetList[i] % mSizeX;
+			int y = mResetList[i] / mSizeX;
+			for( int dir = 0 ; dir < 8 ; ++dir )
+			{
+				int nx = x + DirOffsetX[ dir ];
+				int ny = y + DirOffsetY[ dir ];
+				if ( nx < 0 || nx >= mSizeX || ny < 0 || ny >= mSizeY )
+					continue;
+
+				int nIndex = toIndex( nx , ny );
+				if ( mCost[ nIndex ] == Unreachable || mNextDir[ nIndex ] != InverseDir( dir ) )
+					continue;
+
+				mCost[ nIndex ]    = Unreachable;
+				mNextDir[ nIndex ] = -1;
+				mResetList.push_back( nIndex );
+			}
+		}
+
+		//refill from the cells keeping their cost , and from new open cells
+		for( size_t i = 0 ; i < mResetList.size() ; ++i )
+			relaxCell( map , mResetList[i] % mSizeX , mResetList[i] / mSizeX );
+
+		for( int y = yMin ; y < yMax ; ++y )
+		{
+			for( int x = xMin ; x < xMax ; ++x )
+				relaxCell( map , x , y );
+		}
+
+		propagate( map );
+	}
+
+	bool FlowField::isReachable( Vec2i const& cell ) const
+	{
+		if ( cell.x < 0 || cell.x >= mSizeX || cell.y < 0 || cell.y >= mSizeY )
+			return false;
+		return mCost[ toIndex( cell.x , cell.y ) ] != Unreachable;
+	}
+
+	bool FlowField::getNextCell( Vec2i const& cell , Vec2i& next ) const
+	{
+		if ( !isReachable( cell ) )
+			return false;
+
+		int dir = mNextDir[ toIndex( cell.x , cell.y ) ];
+		if ( dir == -1 )
+			return false;
+
+		next.setValue( cell.x + DirOffsetX[ dir ] , cell.y + DirOffsetY[ dir ] );
+		return true;
+	}
+
+
+	FlowFieldCache::FlowFieldCache()
+	{
+		mFrame = 0;
+	}
+
+	FlowFieldCache::~FlowFieldCache()
+	{
+		clear();
+	}
+
+	FlowField* FlowFieldCache::getField( WorldMap& map , Vec2i const& goal , int layer )
+	{
+		for( FieldList::iterator iter = mFields.begin() ; iter != mFields.end() ; ++iter )
+		{
+			FlowField* field = iter->field;
+			if ( field->getLayer() == layer && field->getGoal() == goal )
+			{
+				iter->useFrame = mFrame;
+				//move to front
+				std::rotate( mFields.begin() , iter , iter + 1 );
+				return field;
+			}
+		}
+
+		FlowField* field = new FlowField( goal , layer );
+		field->build( map );
+
+		evictIdleFields( MaxIdleFieldNum - 1 );
+		FieldEntry entry;
+		entry.field    = field;
+		entry.useFrame = mFrame;
+		mFields.insert( mFields.begin() , entry );
+		return field;
+	}
+
+	void FlowFieldCache::evictIdleFields( int maxNum )
+	{
+		//list is in use order , stop at the first field still in use
+		while( (int)mFields.size() > maxNum && mFields.back().useFrame < mFrame - 1 )
+		{
+			delete mFields.back().field;
+			mFields.pop_back();
+		}
+	}
+
+	void FlowFieldCache::nextFrame()
+	{
+		++mFrame;
+		evictIdleFields( MaxIdleFieldNum );
+	}
+
+	void FlowFieldCache::updateRegion( WorldMap& map , Vec2i const& start , Vec2i const& end )
+	{
+		for( FieldList::iterator iter = mFields.begin() ; iter != mFields.end() ; ++iter )
+			iter->field->updateRegion( map , start , end );
+	}
+
+	void FlowFieldCache::clear()
+	{
+		for( FieldList::iterator iter = mFields.begin() ; iter != mFields.end() ; ++iter )
+			delete iter->field;
+		mFields.clear();
+	}
+
+}//namespace TowerDefend
@@ -0,0 +1,99 @@
+#ifndef TDFlowField_h__
+#define TDFlowField_h__
+
+#include "TDDefine.h"
+
+#include <vector>
+
+namespace TowerDefend
+{
+	class WorldMap;
+
+	//  Integration field of one goal cell on one collision layer.
+	//  Every open cell keeps the path cost to the goal and the neighbour to
+	//  move to , so all units going to the same goal share one Dijkstra build.
+	//  updateRegion repairs the field after cells in a rect changed block state :
+	//  cells whose path passes a changed cell are reset and refilled from the
+	//  border , new open cells are relaxed from their neighbours.
+	class FlowField
+	{
+	public:
+		FlowField( Vec2i const& goal , int layer );
+
+		Vec2i const& getGoal() const { return mGoal; }
+		int          getLayer() const { return mLayer; }
+
+		void  build( WorldMap& map );
+		void  updateRegion( WorldMap& map , Vec2i const& start , Vec2i const& end );
+
+		bool  isReachable( Vec2i const& cell ) const;
+		bool  getNextCell( Vec2i const& cell , Vec2i& next ) const;
+		int   getCost( Vec2i const& cell ) const { return mCost[ toIndex( cell.x , cell.y ) ]; }
+
+		//cells visited by the last build or update
+		int   getLastUpdateCount() const { return mUpdateCount; }
+
+		enum { Unreachable = 0x7fffffff };
+	private:
+
+		struct Node
+		{
+			int cost;
+			int index;
+			bool operator < ( Node const& rhs ) const { return cost > rhs.cost; }
+		};
+
+		int   toIndex( int x , int y ) const { return x + mSizeX * y; }
+		bool  isBlocked( WorldMap& map , int x , int y ) const;
+		bool  canStep( WorldMap& map , int x , int y , int dir ) const;
+		void  pushNode( int index , int cost );
+		void  propagate( WorldMap& map );
+		void  relaxCell( WorldMap& map , int x , int y );
+
+		Vec2i               mGoal;
+		int                 mLayer;
+		int                 mSizeX;
+		int                 mSizeY;
+		int                 mUpdateCount;
+		std::vector< int >  mCost;
+		std::vector< char > mNextDir;
+		std::vector< Node > mHeap;
+		std::vector< int >  mResetList;
+	};
+
+	//  Recently used flow fields , shared by all units of the map.
+	//  A field used in this or the last frame is never evicted , so the cache
+	//  grows to the number of goals units are moving to.
+	class FlowFieldCache
+	{
+	public:
+		FlowFieldCache();
+		~FlowFieldCache();
+
+		FlowField* getField( WorldMap& map , Vec2i const& goal , int layer );
+		void       updateRegion( WorldMap& map , Vec2i const& start , Vec2i const& end );
+		void       clear();
+		//call once per game tick , releases idle fields over the limit
+		void       nextFrame();
+
+	private:
+		void       evictIdleFields( int maxNum );
+
+		//fields kept when they are not used
+		static int const MaxIdleFieldNum = 16;
+		struct FieldEntry
+		{
+			FlowField* field;
+			int        useFrame;
+		};
+		typedef std::vector< FieldEntry > FieldList;
+		FieldList mFields;
+		int       mFrame;
+
+		FlowFieldCache( FlowFieldCache const& );
+		FlowFieldCache& operator = ( FlowFieldCache const& );
+	};
+
+}//namespace TowerDefend
+
+#endif // TDFlowField_h__
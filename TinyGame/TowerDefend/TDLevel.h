@@ -251,6 +251,7 @@ namespace TowerDefend
 		void tick()
 		{
 			mEntityMgr.tick();
+			mMap.mFlowFieldCache.nextFrame();
 
 			testOffset.setValue( -10 , 0 );
 			testHaveCol = testCollision( testPos , testR , mBuiler->getPos() , mBuiler->getColRadius() , testOffset );
@@ -401,6 +401,7 @@ namespace TowerDefend
 				data.building = building;
 			}
 		}
+		mFlowFieldCache.updateRegion( *this , start , end );
 	}
 
 	void WorldMap::removeBuilding( Building* building )
@@ -427,6 +428,7 @@ namespace TowerDefend
 				data.building = NULL;
 			}
 		}
+		mFlowFieldCache.updateRegion( *this , start , end );
 	}
 
 	bool WorldMap::checkCollision( Unit* unit )
@@ -468,10 +470,31 @@ namespace TowerDefend
 		return mMapData.getData( mapPos.x , mapPos.y ).building;
 	}
 
+	bool WorldMap::getFlowWayPoint( Vec2f const& destPos , Vec2f const& pos , CollisionLayer layer , Vec2f& wayPos )
+	{
+		Vec2i goal = Vec2i( destPos / gMapCellLength );
+		Vec2i cell = Vec2i( pos / gMapCellLength );
+		if ( goal == cell )
+			return false;
+		if ( !mMapData.checkRange( goal.x , goal.y ) || !mMapData.checkRange( cell.x , cell.y ) )
+			return false;
+
+		//units with the same goal share the field
+		FlowField* field = mFlowFieldCache.getField( *this , goal , layer );
+
+		Vec2i next;
+		if ( !field->getNextCell( cell , next ) || next == goal )
+			return false;
+
+		wayPos = gMapCellLength * ( Vec2f( next ) + Vec2f( 0.5f , 0.5f ) );
+		return true;
+	}
+
 	void WorldMap::setup( int cx , int cy )
 	{
 		mMapData.resize( cx , cy );
 		memset( mMapData.getRawData() , 0 , cx * cy * sizeof( TileData ) );
+		mFlowFieldCache.clear();
 	}
 
 }//namespace TowerDefend
@@ -4,6 +4,7 @@
 #include "TDDefine.h"
 #include "TDCollision.h"
 #include "TDEntity.h"
+#include "TDFlowField.h"
 
 #include "TGrid2D.h"
 
@@ -52,7 +53,11 @@ namespace TowerDefend
 		bool        testCollisionY( Vec2f const& mapPos , float colRadius , CollisionLayer layer , float& offset );
 		bool        checkCollision( Unit* unit );
 		bool        checkCollision( Vec2f const& pos , float radius , CollisionLayer layer );
+
+		//next position on the flow field to destPos , false if moving to destPos directly
+		bool        getFlowWayPoint( Vec2f const& destPos , Vec2f const& pos , CollisionLayer layer , Vec2f& wayPos );
 		TGrid2D< TileData > mMapData;
+		FlowFieldCache      mFlowFieldCache;
 	};
 
 	enum EntityEvent
@@ -17,6 +17,106 @@ namespace TripleTown
 
 	int const RELINK = -99999999;
 
+	struct TileLinker : public GridLinker4
+	{
+		TileLinker( TileMap& map ):GridLinker4( map.getSizeX() , map.getSizeY() ),map( map ){}
+		TilePos toPos( int idx ) const { return TilePos( idx % mSizeX , idx / mSizeX ); }
+		TileMap& map;
+	};
+
+	struct TilePosOutput
+	{
+		TilePosOutput( TilePos* ptr , int sizeX ):ptr( ptr ),sizeX( sizeX ){}
+		TilePosOutput& operator * (){ return *this; }
+		TilePosOutput& operator ++ (){ ++ptr; return *this; }
+		TilePosOutput& operator = ( int idx ){ *ptr = TilePos( idx % sizeX , idx / sizeX ); return *this; }
+		TilePos* ptr;
+		int      sizeX;
+	};
+
+	struct ConnectObjectLinker : public TileLinker
+	{
+		ConnectObjectLinker( TileMap& map , ObjectId id , unsigned checkCount )
+			:TileLinker( map ),id( id ),checkCount( checkCount ){}
+
+		bool visit( int idx )
+		{
+			Tile& tile = map[ idx ];
+			if ( tile.id != id || tile.checkCount == checkCount )
+				return false;
+			tile.checkCount = checkCount;
+			return true;
+		}
+		ObjectId id;
+		unsigned checkCount;
+	};
+
+	struct RemoveObjectLinker : public TileLinker
+	{
+		RemoveObjectLinker( Level& level , TileMap& map , ObjectId id )
+			:TileLinker( map ),level( level ),id( id ){}
+
+		bool visit( int idx )
+		{
+			Tile& tile = map[ idx ];
+			if ( tile.id != id )
+				return false;
+			tile.id   = OBJ_NULL;
+			tile.meta = 0;
+			++level.mNumEmptyTile;
+			level.getAnimManager().removeObject( toPos( idx ) , id );
+			return true;
+		}
+		Level&   level;
+		ObjectId id;
+	};
+
+	struct RelinkLinker : public TileLinker
+	{
+		RelinkLinker( TileMap& map , GridVisitMap& linkMark , ObjectId id , int idxRoot )
+			:TileLinker( map ),linkMark( linkMark ),id( id ),idxRoot( idxRoot ){}
+
+		bool visit( int idx )
+		{
+			Tile& tile = map[ idx ];
+			if ( tile.id != id || !linkMark.testAndMark( idx ) )
+				return false;
+			tile.link = idxRoot;
+			return true;
+		}
+		GridVisitMap& linkMark;
+		ObjectId      id;
+		int           idxRoot;
+	};
+
+	struct KillActorLinker : public TileLinker
+	{
+		KillActorLinker( Level& level , TileMap& map , unsigned bitMask , Level::KillInfo& info )
+			:TileLinker( map ),level( level ),bitMask( bitMask ),info( info ){}
+
+		bool visit( int idx )
+		{
+			Tile& tile = map[ idx ];
+			if ( !tile.haveActor() )
+				return false;
+
+			ActorData& e = level.getActor( tile );
+			if ( ( bitMask & ACTOR_MASK( e.id ) ) == 0 )
+				return false;
+
+			if ( e.stepBorn > info.step )
+			{
+				info.pos = e.pos;
+				info.step = e.stepBorn;
+			}
+			level.killActor( tile , e );
+			return true;
+		}
+		Level&           level;
+		unsigned         bitMask;
+		Level::KillInfo& info;
+	};
+
 	extern ObjectInfo gObjectInfo[];
 	
 
@@ -602,6 +702,8 @@ namespace TripleTown
 
 		mMap.fillValue( eTile );
 		mNumEmptyTile = mMap.getSizeX() * mMap.getSizeY();
+		mLinkMark.resize( mNumEmptyTile );
+		mConnector.reserve( mNumEmptyTile );
 
 		mCheckCount = 0;
 		mStep = 0;
@@ -817,29 +919,8 @@ namespace TripleTown
 
 	void Level::removeConnectObject( Tile& tile , TilePos const& pos )
 	{
-		removeConnectObjectImpl_R( tile , pos , tile.id );
-	}
-
-	void Level::removeConnectObject_R( TilePos const& pos , ObjectId id )
-	{
-		if ( !isVaildMapRange( pos ) )
-			return;
-		Tile& tile = getTile( pos );
-		if ( tile.id != id )
-			return;
-
-		removeConnectObjectImpl_R( tile , pos , id );
-	}
-
-	inline void Level::removeConnectObjectImpl_R( Tile& tile , TilePos const& pos , ObjectId id )
-	{
-		tile.id   = OBJ_NULL;
-		tile.meta = 0;
-		++mNumEmptyTile;
-		getAnimManager().removeObject( pos , id );
-
-		for ( int i = 0 ; i < DirNum ; ++i )
-			removeConnectObject_R( getNeighborPos( pos , i ) , id );
+		RemoveObjectLinker linker( *this , mMap , tile.id );
+		mConnector.collect( mMap.toIndex( pos.x , pos.y ) , linker );
 	}
 
 	void Level::markObject( Tile& tile , TilePos const& pos , ObjectId id )
@@ -1016,9 +1097,10 @@ namespace TripleTown
 			return;
 
 		int idxRoot = mMap.toIndex( pos.x , pos.y );
-		int num = 1;
-		for ( int i = 0 ; i < DirNum ; ++i )
-			num += relink_R( getNeighborPos( pos , i ) , id , idxRoot );
+
+		mLinkMark.clear();
+		RelinkLinker linker( mMap , mLinkMark , id , idxRoot );
+		int num = mConnector.collect( idxRoot , linker );
 
 		tile.link = -num;
 	}
@@ -1031,25 +1113,6 @@ namespace TripleTown
 		return -mMap[ idx ].link;
 	}
 
-	int Level::relink_R( TilePos const& pos , ObjectId id , int idxRoot )
-	{
-		if ( !isVaildMapRange( pos ) )
-			return 0;
-
-		Tile& tile = getTile( pos );
-		if ( tile.id != id )
-			return 0;
-
-		tile.link = idxRoot;
-
-		int num = 1;
-
-		for ( int dir = 0 ; dir < DirNum ; ++dir )
-			num += relink_R( getNeighborPos( pos , dir ) , id , idxRoot );
-
-		return num;
-	}
-
 	int Level::getUpgradeNum( ObjectId id )
 	{
 		return getInfo( id ).numUpgrade;
@@ -1089,44 +1152,10 @@ namespace TripleTown
 	int Level::getConnectObjectPos( TilePos const& pos , ObjectId id , TilePos posConnect[] )
 	{
 		assert( isVaildMapRange( pos ) );
+		assert( getTile( pos ).id == id );
 
-		Tile& tile = getTile( pos );
-
-		assert( tile.id == id );
-
-		if ( !testCheckCount( tile ) )
-			return 0;
-
-		posConnect[0] = pos;
-
-		int num = 1;
-		for ( int dir = 0 ; dir < DirNum ; ++dir )
-		{
-			num += getConnectObjectPos_R( getNeighborPos( pos , dir ) , id , posConnect + num );
-		}
-		return num;
-	}
-
-	int Level::getConnectObjectPos_R( TilePos const& pos , ObjectId id , TilePos posConnect[] )
-	{
-		if ( !isVaildMapRange( pos ) )
-			return 0;
-
-		Tile& tile = getTile( pos );
-		if ( tile.id != id )
-			return 0;
-
-		if ( !testCheckCount( tile ) )
-			return 0;
-
-		posConnect[0] = pos;
-
-		int num = 1;
-		for ( int dir = 0 ; dir < DirNum ; ++dir )
-		{
-			num += getConnectObjectPos_R( getNeighborPos( pos , dir ) , id , posConnect + num );
-		}
-		return num;
+		ConnectObjectLinker linker( mMap , id , mCheckCount );
+		return mConnector.collect( mMap.toIndex( pos.x , pos.y ) , linker , TilePosOutput( posConnect , mMap.getSizeX() ) );
 	}
 
 	int Level::addActor( Tile& tile , TilePos const& pos , ObjectId id )
@@ -1249,45 +1278,14 @@ namespace TripleTown
 		KillInfo info;
 		info.pos = e.pos;
 		info.step  = e.stepBorn;
-		killActor( tile , e );
 
-		int num = 1;
-		for( int dir = 0 ; dir < DirNum ; ++dir )
-			num += killConnectActor_R( getNeighborPos( pos , dir ) , bitMask , info );
+		KillActorLinker linker( *this , mMap , bitMask , info );
+		int num = mConnector.collect( mMap.toIndex( pos.x , pos.y ) , linker );
 
 		posNew = info.pos;
 		return num;
 	}
 
-	int Level::killConnectActor_R( TilePos const& pos , unsigned bitMask , KillInfo& info )
-	{
-		if ( !isVaildMapRange( pos ) )
-			return 0;
-		Tile& tile = getTile( pos );
-
-		if ( !tile.haveActor() )
-			return 0;
-
-		ActorData& e = getActor( tile );
-		if ( ( bitMask & ACTOR_MASK( e.id ) ) == 0 )
-			return 0;
-
-		if ( e.stepBorn > info.step )
-		{
-			info.pos = e.pos;
-			info.step = e.stepBorn;
-		}
-
-		killActor( tile , e );
-
-		int num = 1;
-		for( int dir = 0 ; dir < DirNum ; ++dir )
-			num += killConnectActor_R( getNeighborPos( pos , dir ) , bitMask , info );
-
-		
-		return num;
-	}
-
 	void Level::killActor( Tile& tile , ActorData& e )
 	{
 		removeActor( tile );
@@ -2,6 +2,7 @@
 #define TTLevel_h__
 
 #include "TGrid2D.h"
+#include "GridConnector.h"
 #include "TVector2.h"
 #include "TTable.h"
 #include "IntrList.h"
@@ -250,18 +251,14 @@ namespace TripleTown
 		void    relinkNeighborTile( TilePos const& pos , ObjectId id );
 
 		void    rebuildLink( TilePos const& pos , ObjectId id );
-		int     relink_R( TilePos const& pos , ObjectId id , int idxRoot );
 		
 
 		bool   testCheckCount( Tile& tile );
 		void   checkActor( Tile& tile , TilePos const& pos );
 
 		int    getConnectObjectPos( TilePos const& pos , ObjectId id , TilePos posConnect[] );
-		int    getConnectObjectPos_R( TilePos const& pos , ObjectId id , TilePos posConnect[] );
 
 		void   removeConnectObject( Tile& tile , TilePos const& pos );
-		void   removeConnectObject_R( TilePos const& pos , ObjectId id );
-		void   removeConnectObjectImpl_R( Tile& tile , TilePos const& pos , ObjectId id );
 
 		int    markObjectWithLink( Tile& tile , TilePos const& pos , ObjectId id );
 		void   markObject( Tile& tile , TilePos const& pos , ObjectId id );
@@ -281,7 +278,6 @@ namespace TripleTown
 			TilePos pos;
 			int step;
 		};
-		int     killConnectActor_R( TilePos const& pos , unsigned bitMask , KillInfo& info );
 		void    killActor( Tile& tile , ActorData& e );
 
 		
@@ -290,6 +286,8 @@ namespace TripleTown
 		int         mStep;
 		int         mNumEmptyTile;
 		TileMap     mMap;
+		GridConnector mConnector;
+		GridVisitMap  mLinkMark;
 		
 		Tile*   getConnectTile( TilePos const& pos , int dir );
 
@@ -341,6 +339,9 @@ namespace TripleTown
 		friend class ECTool;
 		friend class ECCrystal;
 		friend class ECBear;
+
+		friend struct RemoveObjectLinker;
+		friend struct KillActorLinker;
 	};
 
 }
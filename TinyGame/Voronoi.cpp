@@ -1,1427 +1,659 @@
+#include "TinyGamePCH.h"
 #include "Voronoi.h"
 
+#include "Clock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace Voronoi
 {
+	static double const PointEpsilon = 1e-9;
 
-	/*
-	Constructors
-	*/
-
-	VParabola::VParabola()
+	//true if r is on the left of p -> q in y up space
+	static bool IsLeft( Vec2d const& p , Vec2d const& q , Vec2d const& r )
 	{
-		site	= 0;
-		isLeaf	= false;
-		cEvent	= 0;
-		edge	= 0;
-		parent	= 0;
+		return ( q.y - p.y ) * ( r.x - q.x ) - ( q.x - p.x ) * ( r.y - q.y ) < 0;
 	}
 
-	VParabola::VParabola(VPoint * s)
+	//true if p is inside the circumcircle of a , b , c
+	static bool InCircle( Vec2d const& a , Vec2d const& b , Vec2d const& c , Vec2d const& p )
 	{
-		site	= s; 
-		isLeaf	= true;
-		cEvent	= 0;
-		edge	= 0;
-		parent	= 0;
+		Vec2d d = a - p;
+		Vec2d e = b - p;
+		Vec2d f = c - p;
+		double ap = d.length2();
+		double bp = e.length2();
+		double cp = f.length2();
+		return d.x * ( e.y * cp - bp * f.y ) -
+		       d.y * ( e.x * cp - bp * f.x ) +
+		       ap  * ( e.x * f.y - e.y * f.x ) < 0;
 	}
 
-	/*
-	Tree operations (described in the header file)
-	*/
-
-	VParabola * VParabola::GetLeft			(VParabola * p)
+	//circumcenter relative to a
+	static Vec2d CircumOffset( Vec2d const& a , Vec2d const& b , Vec2d const& c )
 	{
-		return GetLeftChild(GetLeftParent(p));
+		Vec2d d = b - a;
+		Vec2d e = c - a;
+		double bl = d.length2();
+		double cl = e.length2();
+		double div = d.x * e.y - d.y * e.x;
+		if ( div == 0 )
+			return Vec2d( std::numeric_limits< double >::max() , std::numeric_limits< double >::max() );
+		double s = 0.5 / div;
+		return Vec2d( ( e.y * bl - d.y * cl ) * s , ( d.x * cl - e.x * bl ) * s );
 	}
 
-
-	VParabola * VParabola::GetRight			(VParabola * p)
+	static double CircumRadius2( Vec2d const& a , Vec2d const& b , Vec2d const& c )
 	{
-		return GetRightChild(GetRightParent(p));
+		Vec2d offset = CircumOffset( a , b , c );
+		if ( offset.x == std::numeric_limits< double >::max() )
+			return std::numeric_limits< double >::max();
+		return offset.length2();
 	}
 
-	VParabola * VParabola::GetLeftParent	(VParabola * p)
+	//monotonic in the angle of ( dx , dy ) , range [ 0 , 1 )
+	static double PseudoAngle( double dx , double dy )
 	{
-		VParabola * par		= p->parent;
-		VParabola * pLast	= p;
-		while(par->Left() == pLast) 
-		{ 
-			if(!par->parent) return 0;
-			pLast = par; 
-			par = par->parent; 
-		}
-		return par;
+		double p = dx / ( std::fabs( dx ) + std::fabs( dy ) );
+		return ( dy > 0 ? 3 - p : 1 + p ) / 4;
 	}
 
-	VParabola * VParabola::GetRightParent	(VParabola * p)
+	DelaunayBuilder::DelaunayBuilder()
 	{
-		VParabola * par		= p->parent;
-		VParabola * pLast	= p;
-		while(par->Right() == pLast) 
-		{ 
-			if(!par->parent) return 0;
-			pLast = par; par = par->parent; 
-		}
-		return par;
+		mPoints    = NULL;
+		mMesh      = NULL;
+		mHullStart = 0;
+		mHashSize  = 0;
+		mNumEdge   = 0;
 	}
 
-	VParabola * VParabola::GetLeftChild		(VParabola * p)
+	int DelaunayBuilder::hashKey( Vec2d const& p ) const
 	{
-		if(!p) return 0;
-		VParabola * par = p->Left();
-		while(!par->isLeaf) par = par->Right();
-		return par;
+		double angle = PseudoAngle( p.x - mCenter.x , p.y - mCenter.y );
+		return int( std::floor( angle * mHashSize ) ) % mHashSize;
 	}
 
-	VParabola * VParabola::GetRightChild	(VParabola * p)
+	void DelaunayBuilder::link( int a , int b )
 	{
-		if(!p) return 0;
-		VParabola * par = p->Right();
-		while(!par->isLeaf) par = par->Left();
-		return par;
+		std::vector< int >& halfedges = mMesh->halfedges;
+		halfedges[a] = b;
+		if ( b != -1 )
+			halfedges[b] = a;
 	}
 
-	Solver::Solver()
+	int DelaunayBuilder::addTriangle( int i0 , int i1 , int i2 , int a , int b , int c )
 	{
-		mEdges = 0;
+		//mesh buffers are sized for the max triangle num in build
+		std::vector< int >& triangles = mMesh->triangles;
+		int t = mNumEdge;
+		triangles[ t ] = i0;
+		triangles[ t + 1 ] = i1;
+		triangles[ t + 2 ] = i2;
+		mNumEdge += 3;
+		link( t , a );
+		link( t + 1 , b );
+		link( t + 2 , c );
+		return t;
 	}
 
-	Edges * Solver::GetEdges(Vertices * v, int w, int h)
+	int DelaunayBuilder::legalize( int a )
 	{
-		mPlaces = v;
-		width = w;
-		height = h;
-		mRoot = 0;
+		std::vector< int >& triangles = mMesh->triangles;
+		std::vector< int >& halfedges = mMesh->halfedges;
 
-		if(!mEdges)
+		mEdgeStack.clear();
+		int ar;
+		for(;;)
 		{
-			mEdges = new Edges();
-		}
-		else 
-		{
-			for( std::vector< VPoint* >::iterator	i = points.begin(); i != points.end(); ++i) 
-				mPointFactory.destroy(*i);
-			points.clear();
-
-			for(Edges::iterator	i = mEdges->begin(); i != mEdges->end(); ++i) 
-				mEdgeFactory.destroy(*i);
-			mEdges->clear();
-		}
-
-		for(Vertices::iterator i = mPlaces->begin(); i!=mPlaces->end(); ++i)
-		{
-			queue.push( mEventFactory.create( *i , true ) );
-		}
+			int b  = halfedges[a];
+			int a0 = a - a % 3;
+			ar = a0 + ( a + 2 ) % 3;
 
-		VEvent * e;
-		while(!queue.empty())
-		{
-			e = queue.top();
-			queue.pop();
-			mSweepY = e->point->y;
-
-			if ( e->isVaild() )
+			if ( b == -1 )
 			{
-				if(e->pe) 
-					InsertParabola(e->point);
-				else 
-					RemoveParabola(e);
+				if ( mEdgeStack.empty() )
+					break;
+				a = mEdgeStack.back();
+				mEdgeStack.pop_back();
+				continue;
 			}
 
-			mEventFactory.destroy( e );
-		}
+			//flip shared edge pr - pl to p0 - p1 if p1 is in the circumcircle of p0 , pr , pl
+			int b0 = b - b % 3;
+			int al = a0 + ( a + 1 ) % 3;
+			int bl = b0 + ( b + 2 ) % 3;
 
-		FinishEdge( mRoot );
+			int p0 = triangles[ ar ];
+			int pr = triangles[ a ];
+			int pl = triangles[ al ];
+			int p1 = triangles[ bl ];
 
-		for(Edges::iterator i = mEdges->begin(); i != mEdges->end(); ++i)
-		{
-			if( (*i)->neighbour) 
+			if ( !InCircle( mPoints[ p0 ] , mPoints[ pr ] , mPoints[ pl ] , mPoints[ p1 ] ) )
 			{
-				(*i)->start = (*i)->neighbour->end;
-				mEdgeFactory.destroy( (*i)->neighbour );
+				if ( mEdgeStack.empty() )
+					break;
+				a = mEdgeStack.back();
+				mEdgeStack.pop_back();
+				continue;
 			}
-		}
-
-		return mEdges;
-	}
-
-	void	Solver::InsertParabola(VPoint * p)
-	{
-		if( !mRoot )
-		{
-			mRoot = mParabolaFactory.create(p); 
-			return;
-		}
-
-		if(mRoot->isLeaf && mRoot->site->y - p->y < 1) // degenerovan?ppad - ob?spodn?msta ve stejn?v?ce
-		{
-			VPoint * fp = mRoot->site;
-			mRoot->isLeaf = false;
-			mRoot->SetLeft( mParabolaFactory.create(fp) );
-			mRoot->SetRight( mParabolaFactory.create(p)  );
-			
-			VPoint * s = createPoint((p->x + fp->x)/2, height); // zatek hrany uprosted mst
-
-			if(p->x > fp->x)
-				mRoot->edge = mEdgeFactory.create(s, fp, p); // rozhodnu, kter?vlevo, kter?vpravo
-			else 
-				mRoot->edge = mEdgeFactory.create(s, p, fp);
-			
-			mEdges->push_back(mRoot->edge);
-			return;
-		}
-
-		VParabola * par = GetParabolaByX(p->x);
-
-		if(par->cEvent)
-		{
-			par->cEvent->invaildate();
-			par->cEvent = 0;
-		}
-
-		VPoint * start = createPoint(p->x, GetY(par->site, p->x));
-
-		VEdge * el = mEdgeFactory.create(start, par->site, p);
-		VEdge * er = mEdgeFactory.create(start, p, par->site);
-
-		el->neighbour = er;
-		mEdges->push_back(el);
-
-		// pestavuju strom .. vkldm novou parabolu
-		par->edge = er;
-		par->isLeaf = false;
-
-		VParabola * pOA = mParabolaFactory.create(par->site);
-		VParabola * p1 = mParabolaFactory.create(p);
-		VParabola * pOB = mParabolaFactory.create(par->site);
-
-		VParabola* left = mParabolaFactory.create();
-		left->edge = el;
-		left->SetLeft(pOA);
-		left->SetRight(p1);
-
-		par->SetRight(pOB);
-		par->SetLeft( left );
-		
-		CheckCircle(pOA);
-		CheckCircle(pOB);
-	}
-
-	void	Solver::RemoveParabola(VEvent * e)
-	{
-		VParabola * p1 = e->arch;
-
-		VParabola * xl = VParabola::GetLeftParent(p1);
-		VParabola * xr = VParabola::GetRightParent(p1);
-
-		VParabola * pCL = VParabola::GetLeftChild(xl);
-		VParabola * pCR = VParabola::GetRightChild(xr);
-
-		// 	if(p0 == p2) std::cout << "chyba - prav?a lev?parabola m?stejn?ohnisko!\n";
-
-		if(pCL->cEvent){ pCL->cEvent->invaildate(); pCL->cEvent = 0; }
-		if(pCR->cEvent){ pCR->cEvent->invaildate(); pCR->cEvent = 0; }
-
-		VPoint * p = createPoint(e->point->x, GetY(p1->site, e->point->x));
-	
-		xl->edge->end = p;
-		xr->edge->end = p;
-
-		VParabola * higher;
-		VParabola * par = p1;
-		while(par != mRoot)
-		{
-			par = par->parent;
-			if(par == xl) higher = xl;
-			if(par == xr) higher = xr;
-		}
-		higher->edge = mEdgeFactory.create(p, pCL->site, pCR->site);
-		mEdges->push_back(higher->edge);
-
-		VParabola * gparent = p1->parent->parent;
-		if(p1->parent->Left() == p1)
-		{
-			if(gparent->Left()  == p1->parent) gparent->SetLeft ( p1->parent->Right() );
-			if(gparent->Right() == p1->parent) gparent->SetRight( p1->parent->Right() );
-		}
-		else
-		{
-			if(gparent->Left()  == p1->parent) gparent->SetLeft ( p1->parent->Left()  );
-			if(gparent->Right() == p1->parent) gparent->SetRight( p1->parent->Left()  );
-		}
-
-		mParabolaFactory.destroy( p1->parent );
-		mParabolaFactory.destroy( p1 );
-
-		CheckCircle(pCL);
-		CheckCircle(pCR);
-	}
-
-	void	Solver::CheckCircle(VParabola * b)
-	{
-		VParabola * lp = VParabola::GetLeftParent (b);
-		VParabola * rp = VParabola::GetRightParent(b);
-
-		VParabola * a  = VParabola::GetLeftChild (lp);
-		VParabola * c  = VParabola::GetRightChild(rp);
-
-		if(!a || !c || a->site == c->site) 
-			return;
-
-		VPoint s;
-		if ( !GetEdgeIntersection(lp->edge, rp->edge , s ) )
-			return;
-
-		double dx = a->site->x - s.x;
-		double dy = a->site->y - s.y;
-
-		double d = std::sqrt( (dx * dx) + (dy * dy) );
-
-		if(s.y - d >= mSweepY )
-			return;
-
-		VEvent * e = mEventFactory.create( createPoint(s.x, s.y - d) , false );
-		b->cEvent = e;
-		e->arch = b;
-		queue.push(e);
-	}
-
-
-	void	Solver::FinishEdge(VParabola * n)
-	{
-		if( !n->isLeaf ) 
-		{ 
-			double mx;
-			if(n->edge->direction.x > 0.0)	mx = std::max(width,	n->edge->start->x + 10 );
-			else							mx = std::min(0.0,		n->edge->start->x - 10);
-
-			n->edge->end = createPoint( mx, mx * n->edge->f + n->edge->g );
-
-			FinishEdge(n->Left() );
-			FinishEdge(n->Right());
-		}
-		mParabolaFactory.destroy( n );
-	}
-
-	double	Solver::GetXOfEdge(VParabola * par, double y)
-	{
-		VParabola * left = VParabola::GetLeftChild(par);
-		VParabola * right= VParabola::GetRightChild(par);
-
-		VPoint * p = left->site;
-		VPoint * r = right->site;
-
-		double dp = 2.0 * (p->y - y);
-		double a1 = 1.0 / dp;
-		double b1 = -p->x / dp;
-		double c1 = y + dp / 4 + p->x * p->x / dp;
-
-		dp = 2.0 * (r->y - y);
-		double a2 = 1.0 / dp;
-		double b2 = -r->x/dp;
-		double c2 = mSweepY + dp / 4 + r->x * r->x / dp;
 
-		double a = a1 - a2;
-		double b = b1 - b2;
-		double c = c1 - c2;
+			triangles[a] = p1;
+			triangles[b] = p0;
 
-		double disc = b*b - a * c;
-		double x1 = (-b + std::sqrt(disc)) / (a);
-		double x2 = (-b - std::sqrt(disc)) / (a);
-
-		double ry;
-		if(p->y < r->y ) ry =  std::max(x1, x2);
-		else ry = std::min(x1, x2);
-
-		return ry;
-	}
-
-	VParabola * Solver::GetParabolaByX(double xx)
-	{
-		VParabola * par = mRoot;
-		double x = 0.0;
+			//edge swapped on the other side of the hull , fix the hull triangle
+			int hbl = halfedges[ bl ];
+			if ( hbl == -1 )
+			{
+				int e = mHullStart;
+				do
+				{
+					if ( mHullTri[e] == bl )
+					{
+						mHullTri[e] = a;
+						break;
+					}
+					e = mHullPrev[e];
+				}
+				while( e != mHullStart );
+			}
+			link( a , hbl );
+			link( b , halfedges[ ar ] );
+			link( ar , bl );
 
-		while(!par->isLeaf) // projdu stromem dokud nenarazm na vhodn?list
-		{
-			x = GetXOfEdge(par, mSweepY);
-			if(x>xx) par = par->Left();
-			else par = par->Right();				
+			int br = b0 + ( b + 1 ) % 3;
+			mEdgeStack.push_back( br );
 		}
-		return par;
-	}
-
-	double	Solver::GetY(VPoint * p, double x) // ohnisko, x-souadnice
-	{
-		double dp = 2 * (p->y - mSweepY);
-		double a1 = 1 / dp;
-		double b1 = -2 * p->x / dp;
-		double c1 = mSweepY + dp / 4 + p->x * p->x / dp;
-
-		return(a1*x*x + b1*x + c1);
+		return ar;
 	}
 
-	bool Solver::GetEdgeIntersection(VEdge * a, VEdge * b , VPoint& result )
+	bool DelaunayBuilder::build( Vec2d const* points , int numPoint , DelaunayMesh& mesh )
 	{
-		double x = (b->g-a->g) / (a->f - b->f);
-		double y = a->f * x + a->g;
-
-		if ( ((x - a->start->x)/a->direction.x < 0) ||
-			 ((y - a->start->y)/a->direction.y < 0) ||
-		     ((x - b->start->x)/b->direction.x < 0) ||
-		     ((y - b->start->y)/b->direction.y < 0) )
+		mesh.clear();
+		if ( numPoint < 3 )
 			return false;
 
-		result.x = x;
-		result.y = y;
-		return true;
-	}
-
+		mMesh   = &mesh;
 
-}//namespace Voronoi
-
-namespace Vor2
-{
-
-	int ntry, totalsearch ;
-
-	void EdgeList::initialize(void)
-	{
-		int i ;
-
-		freeinit(&hfl, sizeof(Halfedge)) ;
-		ELhashsize = 2 * sqrt_nsites ;
-		ELhash = (Halfedge **)myalloc( sizeof(*ELhash) * ELhashsize) ;
-		for (i = 0  ; i < ELhashsize  ; i++)
+		Vec2d minPos = points[0];
+		Vec2d maxPos = points[0];
+		for( int i = 0 ; i < numPoint ; ++i )
 		{
-			ELhash[i] = (Halfedge *)NULL ;
+			Vec2d const& p = points[i];
+			minPos.x = std::min( minPos.x , p.x );
+			minPos.y = std::min( minPos.y , p.y );
+			maxPos.x = std::max( maxPos.x , p.x );
+			maxPos.y = std::max( maxPos.y , p.y );
 		}
-		ELleftend = create((Edge *)NULL, 0) ;
-		ELrightend = create((Edge *)NULL, 0) ;
-		ELleftend->ELleft = (Halfedge *)NULL ;
-		ELleftend->ELright = ELrightend ;
-		ELrightend->ELleft = ELleftend ;
-		ELrightend->ELright = (Halfedge *)NULL ;
-		ELhash[0] = ELleftend ;
-		ELhash[ELhashsize-1] = ELrightend ;
-	}
-
-	Halfedge* EdgeList::create(Edge * e, int pm)
-	{
-		Halfedge * answer ;
-
-		answer = (Halfedge *)getfree(&hfl) ;
-		answer->ELedge = e ;
-		answer->ELpm = pm ;
-		answer->PQnext = (Halfedge *)NULL ;
-		answer->vertex = (Site *)NULL ;
-		answer->ELrefcnt = 0 ;
-		return (answer) ;
-	}
-
-	void EdgeList::insert(Halfedge * lb, Halfedge * newE )
-	{ 
-		newE->ELleft = lb ;
-		newE->ELright = lb->ELright ;
-		(lb->ELright)->ELleft = newE ;
-		lb->ELright = newE ;
-	}
+		Vec2d boundCenter = 0.5 * ( minPos + maxPos );
 
-	/* Get entry from hash table, pruning any deleted nodes */
-
-	Halfedge* EdgeList::gethash(int b)
-	{
-		Halfedge * he ;
-
-		if ((b < 0) || (b >= ELhashsize))
-		{
-			return ((Halfedge *)NULL) ;
-		}
-		he = ELhash[b] ;
-		if ((he == (Halfedge *)NULL) || (he->ELedge != (Edge *)DELETED))
-		{
-			return (he) ;
-		}
-		/* Hash table points to deleted half edge.  Patch as necessary. */
-		ELhash[b] = (Halfedge *)NULL ;
-		if ((--(he->ELrefcnt)) == 0)
+		//seed triangle : point closest to the center , its nearest point ,
+		//and the point making the smallest circumcircle with them
+		double const MaxValue = std::numeric_limits< double >::max();
+		int    i0 = 0 , i1 = -1 , i2 = -1;
+		double minDist = MaxValue;
+		for( int i = 0 ; i < numPoint ; ++i )
 		{
-			makefree((Freenode *)he, (Freelist *)&hfl) ;
-		}
-		return ((Halfedge *)NULL) ;
-	}
-
-	Halfedge* EdgeList::leftbnd(Point * p)
-	{
-		int i, bucket ;
-		Halfedge * he ;
-
-		/* Use hash table to get close to desired halfedge */
-		bucket = (p->x - xmin) / deltax * ELhashsize ;
-		if (bucket < 0)
-		{
-			bucket = 0 ;
-		}
-		if (bucket >= ELhashsize)
-		{
-			bucket = ELhashsize - 1 ;
-		}
-		he = mEL.gethash(bucket) ;
-		if  (he == (Halfedge *)NULL)
-		{
-			for (i = 1 ; 1 ; i++)
+			double d = ( points[i] - boundCenter ).length2();
+			if ( d < minDist )
 			{
-				if ((he = mEL.gethash(bucket-i)) != (Halfedge *)NULL)
-				{
-					break ;
-				}
-				if ((he = mEL.gethash(bucket+i)) != (Halfedge *)NULL)
-				{
-					break ;
-				}
+				i0 = i;
+				minDist = d;
 			}
-			totalsearch += i ;
-		}
-		ntry++ ;
-		/* Now search linear list of halfedges for the corect one */
-		if (he == ELleftend || (he != ELrightend && right_of(he,p)))
-		{
-			do  {
-				he = he->ELright ;
-			} while (he != ELrightend && right_of(he,p)) ;
-			he = he->ELleft ;
 		}
-		else
-		{
-			do  {
-				he = he->ELleft ;
-			} while (he != ELleftend && !right_of(he,p)) ;
-		}
-		/*** Update hash table and reference counts ***/
-		if ((bucket > 0) && (bucket < ELhashsize-1))
+
+		minDist = MaxValue;
+		for( int i = 0 ; i < numPoint ; ++i )
 		{
-			if (ELhash[bucket] != (Halfedge *)NULL)
+			if ( i == i0 )
+				continue;
+			double d = ( points[i] - points[i0] ).length2();
+			if ( d < minDist && d > 0 )
 			{
-				(ELhash[bucket]->ELrefcnt)-- ;
+				i1 = i;
+				minDist = d;
 			}
-			ELhash[bucket] = he ;
-			(ELhash[bucket]->ELrefcnt)++ ;
-		}
-		return (he) ;
-	}
-
-	/*** This delete routine can't reclaim node, since pointers from hash
-	: table may be present.
-	***/
-
-	void EdgeList::remove(Halfedge * he)
-	{
-		(he->ELleft)->ELright = he->ELright ;
-		(he->ELright)->ELleft = he->ELleft ;
-		he->ELedge = (Edge *)DELETED ;
-	}
-
-	Halfedge *
-		ELright(Halfedge * he)
-	{
-		return (he->ELright) ;
-	}
-
-	Site * bottomsite ;
-
-	Halfedge *
-		ELleft(Halfedge * he)
-	{
-		return (he->ELleft) ;
-	}
-
-	Site * leftreg(Halfedge * he)
-	{
-		if (he->ELedge == (Edge *)NULL)
-		{
-			return(bottomsite) ;
 		}
-		return (he->ELpm == LEDGE ? he->ELedge->reg[LEDGE] :
-			he->ELedge->reg[REDGE]) ;
-	}
-
-	Site *
-		rightreg(Halfedge * he)
-	{
-		if (he->ELedge == (Edge *)NULL)
-		{
-			return(bottomsite) ;
-		}
-		return (he->ELpm == LEDGE ? he->ELedge->reg[REDGE] :
-			he->ELedge->reg[LEDGE]) ;
-	}
-
-
-	float deltax, deltay ;
-	int nedges, sqrt_nsites, nvertices ;
-	Freelist efl ;
-
-	void
-		geominit(void)
-	{
-		freeinit(&efl, sizeof(Edge)) ;
-		nvertices = nedges = 0 ;
-		sqrt_nsites = (int)sqrtf( nsites+4 ) ;
-		deltay = ymax - ymin ;
-		deltax = xmax - xmin ;
-	}
+		if ( i1 == -1 )
+			return false;
 
-	Edge *
-		bisect(Site * s1, Site * s2)
-	{
-		float dx, dy, adx, ady ;
-		Edge * newedge ;
-
-		newedge = (Edge *)getfree(&efl) ;
-		newedge->reg[0] = s1 ;
-		newedge->reg[1] = s2 ;
-		incref(s1) ;
-		incref(s2) ;
-		newedge->ep[0] = newedge->ep[1] = (Site *)NULL ;
-		dx = s2->coord.x - s1->coord.x ;
-		dy = s2->coord.y - s1->coord.y ;
-		adx = dx>0 ? dx : -dx ;
-		ady = dy>0 ? dy : -dy ;
-		newedge->c = s1->coord.x * dx + s1->coord.y * dy + (dx*dx +
-			dy*dy) * 0.5 ;
-		if (adx > ady)
-		{
-			newedge->a = 1.0 ;
-			newedge->b = dy/dx ;
-			newedge->c /= dx ;
-		}
-		else
+		double minRadius = MaxValue;
+		for( int i = 0 ; i < numPoint ; ++i )
 		{
-			newedge->b = 1.0 ;
-			newedge->a = dx/dy ;
-			newedge->c /= dy ;
+			if ( i == i0 || i == i1 )
+				continue;
+			double r = CircumRadius2( points[i0] , points[i1] , points[i] );
+			if ( r < minRadius )
+			{
+				i2 = i;
+				minRadius = r;
+			}
 		}
-		newedge->edgenbr = nedges ;
-		out_bisector(newedge) ;
-		nedges++ ;
-		return (newedge) ;
-	}
+		if ( i2 == -1 || minRadius == MaxValue )
+			return false;
 
-	Site *
-		intersect(Halfedge * el1, Halfedge * el2)
-	{
-		Edge * e1, * e2, * e ;
-		Halfedge * el ;
-		float d, xint, yint ;
-		int right_of_site ;
-		Site * v ;
-
-		e1 = el1->ELedge ;
-		e2 = el2->ELedge ;
-		if ((e1 == (Edge*)NULL) || (e2 == (Edge*)NULL))
-		{
-			return ((Site *)NULL) ;
-		}
-		if (e1->reg[1] == e2->reg[1])
-		{
-			return ((Site *)NULL) ;
-		}
-		d = (e1->a * e2->b) - (e1->b * e2->a) ;
-		if ((-1.0e-10 < d) && (d < 1.0e-10))
-		{
-			return ((Site *)NULL) ;
-		}
-		xint = (e1->c * e2->b - e2->c * e1->b) / d ;
-		yint = (e2->c * e1->a - e1->c * e2->a) / d ;
-		if ((e1->reg[1]->coord.y < e2->reg[1]->coord.y) ||
-			(e1->reg[1]->coord.y == e2->reg[1]->coord.y &&
-			e1->reg[1]->coord.x < e2->reg[1]->coord.x))
-		{
-			el = el1 ;
-			e = e1 ;
-		}
-		else
-		{
-			el = el2 ;
-			e = e2 ;
-		}
-		right_of_site = (xint >= e->reg[1]->coord.x) ;
-		if ((right_of_site && (el->ELpm == LEDGE)) ||
-			(!right_of_site && (el->ELpm == REDGE)))
-		{
-			return ((Site *)NULL) ;
-		}
-		v = (Site *)getfree(&sfl) ;
-		v->refcnt = 0 ;
-		v->coord.x = xint ;
-		v->coord.y = yint ;
-		return (v) ;
-	}
+		if ( IsLeft( points[i0] , points[i1] , points[i2] ) )
+			std::swap( i1 , i2 );
+
+		mCenter = points[i0] + CircumOffset( points[i0] , points[i1] , points[i2] );
+
+		mSortKeys.resize( numPoint );
+		for( int i = 0 ; i < numPoint ; ++i )
+		{
+			mSortKeys[i].dist = ( points[i] - mCenter ).length2();
+			mSortKeys[i].id   = i;
+		}
+		std::sort( mSortKeys.begin() , mSortKeys.end() );
+
+		//work in sorted index from here
+		int seed0 = i0 , seed1 = i1 , seed2 = i2;
+		mSortPoints.resize( numPoint );
+		for( int k = 0 ; k < numPoint ; ++k )
+		{
+			int id = mSortKeys[k].id;
+			mSortPoints[k] = points[ id ];
+			if ( id == seed0 )
+				i0 = k;
+			else if ( id == seed1 )
+				i1 = k;
+			else if ( id == seed2 )
+				i2 = k;
+		}
+		points  = &mSortPoints[0];
+		mPoints = points;
+
+		mHashSize = std::max( 1 , int( std::ceil( std::sqrt( double( numPoint ) ) ) ) );
+		mHullPrev.resize( numPoint );
+		mHullNext.resize( numPoint );
+		mHullTri.resize( numPoint );
+		mHullHash.assign( mHashSize , -1 );
+
+		mHullStart = i0;
+		int hullSize = 3;
+		mHullNext[i0] = mHullPrev[i2] = i1;
+		mHullNext[i1] = mHullPrev[i0] = i2;
+		mHullNext[i2] = mHullPrev[i1] = i0;
+		mHullTri[i0] = 0;
+		mHullTri[i1] = 1;
+		mHullTri[i2] = 2;
+		mHullHash[ hashKey( points[i0] ) ] = i0;
+		mHullHash[ hashKey( points[i1] ) ] = i1;
+		mHullHash[ hashKey( points[i2] ) ] = i2;
+
+		int maxTriangle = std::max( 2 * numPoint - 5 , 1 );
+		mesh.triangles.resize( 3 * maxTriangle );
+		mesh.halfedges.resize( 3 * maxTriangle );
+		mNumEdge = 0;
+		addTriangle( i0 , i1 , i2 , -1 , -1 , -1 );
+
+		Vec2d prevPos;
+		for( int i = 0 ; i < numPoint ; ++i )
+		{
+			Vec2d const& p = points[i];
+
+			//skip near duplicate points
+			if ( i > 0 && std::fabs( p.x - prevPos.x ) <= PointEpsilon && std::fabs( p.y - prevPos.y ) <= PointEpsilon )
+				continue;
+			prevPos = p;
+
+			if ( i == i0 || i == i1 || i == i2 )
+				continue;
+
+			//find a visible edge on the convex hull using edge hash
+			int start = 0;
+			int key = hashKey( p );
+			for( int j = 0 ; j < mHashSize ; ++j )
+			{
+				start = mHullHash[ ( key + j ) % mHashSize ];
+				if ( start != -1 && start != mHullNext[ start ] )
+					break;
+			}
+
+			start = mHullPrev[ start ];
+			int e = start;
+			int q;
+			for(;;)
+			{
+				q = mHullNext[e];
+				if ( IsLeft( p , points[e] , points[q] ) )
+					break;
+				e = q;
+				if ( e == start )
+				{
+					e = -1;
+					break;
+				}
+			}
+			//likely a near duplicate point
+			if ( e == -1 )
+				continue;
 
-	/*** returns 1 if p is to right of halfedge e ***/
+			//add the first triangle from the point
+			int t = addTriangle( e , i , mHullNext[e] , -1 , -1 , mHullTri[e] );
+			mHullTri[i] = legalize( t + 2 );
+			mHullTri[e] = t;
+			++hullSize;
 
-	int
-		right_of(Halfedge * el, Point * p)
-	{
-		Edge * e ;
-		Site * topsite ;
-		int right_of_site, above, fast ;
-		float dxp, dyp, dxs, t1, t2, t3, yl ;
-
-		e = el->ELedge ;
-		topsite = e->reg[1] ;
-		right_of_site = (p->x > topsite->coord.x) ;
-		if (right_of_site && (el->ELpm == LEDGE))
-		{
-			return (1) ;
-		}
-		if(!right_of_site && (el->ELpm == REDGE))
-		{
-			return (0) ;
-		}
-		if (e->a == 1.0)
-		{
-			dyp = p->y - topsite->coord.y ;
-			dxp = p->x - topsite->coord.x ;
-			fast = 0 ;
-			if ((!right_of_site & (e->b < 0.0)) ||
-				(right_of_site & (e->b >= 0.0)))
-			{
-				fast = above = (dyp >= e->b*dxp) ;
-			}
-			else
+			//walk forward through the hull , adding more triangles and flipping recursively
+			int n = mHullNext[e];
+			for(;;)
 			{
-				above = ((p->x + p->y * e->b) > (e->c)) ;
-				if (e->b < 0.0)
-				{
-					above = !above ;
-				}
-				if (!above)
-				{
-					fast = 1 ;
-				}
+				q = mHullNext[n];
+				if ( !IsLeft( p , points[n] , points[q] ) )
+					break;
+				t = addTriangle( n , i , q , mHullTri[i] , -1 , mHullTri[n] );
+				mHullTri[i] = legalize( t + 2 );
+				mHullNext[n] = n; //mark as removed
+				--hullSize;
+				n = q;
 			}
-			if (!fast)
+
+			//walk backward from the other side
+			if ( e == start )
 			{
-				dxs = topsite->coord.x - (e->reg[0])->coord.x ;
-				above = (e->b * (dxp*dxp - dyp*dyp))
-					<
-					(dxs * dyp * (1.0 + 2.0 * dxp /
-					dxs + e->b * e->b)) ;
-				if (e->b < 0.0)
+				for(;;)
 				{
-					above = !above ;
+					q = mHullPrev[e];
+					if ( !IsLeft( p , points[q] , points[e] ) )
+						break;
+					t = addTriangle( q , i , e , -1 , mHullTri[e] , mHullTri[q] );
+					legalize( t + 2 );
+					mHullTri[q] = t;
+					mHullNext[e] = e;
+					--hullSize;
+					e = q;
 				}
 			}
-		}
-		else  /*** e->b == 1.0 ***/
-		{
-			yl = e->c - e->a * p->x ;
-			t1 = p->y - yl ;
-			t2 = p->x - topsite->coord.x ;
-			t3 = yl - topsite->coord.y ;
-			above = ((t1*t1) > ((t2 * t2) + (t3 * t3))) ;
-		}
-		return (el->ELpm == LEDGE ? above : !above) ;
-	}
 
-	void endpoint(Edge * e, int lr, Site * s)
-	{
-		e->ep[lr] = s ;
-		incref(s) ;
-		if (e->ep[REDGE-lr] == (Site *)NULL)
-		{
-			return ;
-		}
-		out_ep(e) ;
-		decref(e->reg[LEDGE]) ;
-		decref(e->reg[REDGE]) ;
-		makefree((Freenode *)e, (Freelist *) &efl) ;
-	}
-
-	float dist(Site * s, Site * t)
-	{
-		float dx,dy ;
-
-		dx = s->coord.x - t->coord.x ;
-		dy = s->coord.y - t->coord.y ;
-		return (sqrt(dx*dx + dy*dy)) ;
-	}
-
-	void makevertex(Site * v)
-	{
-		v->sitenbr = nvertices++ ;
-		out_vertex(v) ;
-	}
+			mHullStart = mHullPrev[i] = e;
+			mHullNext[e] = mHullPrev[n] = i;
+			mHullNext[i] = n;
 
-	void decref(Site * v)
-	{
-		if (--(v->refcnt) == 0 )
-		{
-			makefree((Freenode *)v, (Freelist *)&sfl) ;
+			mHullHash[ hashKey( p ) ] = i;
+			mHullHash[ hashKey( points[e] ) ] = e;
 		}
-	}
-
-	void
-		incref(Site * v)
-	{
-		++(v->refcnt) ;
-	}
 
+		mesh.triangles.resize( mNumEdge );
+		mesh.halfedges.resize( mNumEdge );
+		for( int e = 0 ; e < mNumEdge ; ++e )
+			mesh.triangles[e] = mSortKeys[ mesh.triangles[e] ].id;
 
-
-	void PQueue::insert(Halfedge * he, Site * v, float offset)
-	{
-		Halfedge * last, * next ;
-
-		he->vertex = v ;
-		incref(v) ;
-		he->ystar = v->coord.y + offset ;
-		last = &PQhash[ bucket(he)] ;
-		while ((next = last->PQnext) != (Halfedge *)NULL &&
-			(he->ystar  > next->ystar  ||
-			(he->ystar == next->ystar &&
-			v->coord.x > next->vertex->coord.x)))
+		mesh.hull.resize( hullSize );
+		for( int i = 0 , e = mHullStart ; i < hullSize ; ++i )
 		{
-			last = next ;
+			mesh.hull[i] = mSortKeys[e].id;
+			e = mHullNext[e];
 		}
-		he->PQnext = last->PQnext ;
-		last->PQnext = he ;
-		PQcount++ ;
-	}
 
-	void  PQueue::remove(Halfedge * he)
-	{
-		Halfedge * last;
-
-		if(he ->  vertex != (Site *) NULL)
-		{
-			last = &PQhash[mQueue.bucket(he)] ;
-			while (last -> PQnext != he)
-			{
-				last = last->PQnext ;
-			}
-			last->PQnext = he->PQnext;
-			PQcount-- ;
-			decref(he->vertex) ;
-			he->vertex = (Site *)NULL ;
-		}
+		mPoints = NULL;
+		mMesh   = NULL;
+		return true;
 	}
 
-	int PQueue::bucket(Halfedge * he)
+	VoronoiBuilder::VoronoiBuilder()
 	{
-		int result ;
-
-		if	    (he->ystar < ymin)  result = 0;
-		else if (he->ystar >= ymax) result = PQhashsize-1;
-		else 			result = (he->ystar - ymin)/deltay * PQhashsize;
-		if (result < 0)
-		{
-			result = 0 ;
-		}
-		if (result >= PQhashsize)
-		{
-			result = PQhashsize-1 ;
-		}
-		if (result < PQmin)
-		{
-			PQmin = result ;
-		}
-		return (result);
+		mPoints   = NULL;
+		mNumPoint = 0;
 	}
 
-	int PQueue::empty()
+	bool VoronoiBuilder::build( Vec2d const* points , int numPoint )
 	{
-		return (PQcount == 0) ;
-	}
+		mPoints   = points;
+		mNumPoint = numPoint;
+		mVertices.clear();
+		mInEdges.assign( numPoint , -1 );
 
+		if ( !mBuilder.build( points , numPoint , mMesh ) )
+			return false;
 
-	Point PQueue::min()
-	{
-		Point answer ;
+		std::vector< int > const& triangles = mMesh.triangles;
+		std::vector< int > const& halfedges = mMesh.halfedges;
 
-		while (PQhash[PQmin].PQnext == (Halfedge *)NULL)
+		int numTri = mMesh.getTriangleNum();
+		mVertices.resize( numTri );
+		for( int t = 0 ; t < numTri ; ++t )
 		{
-			++PQmin ;
+			Vec2d const& a = points[ triangles[ 3 * t ] ];
+			mVertices[t] = a + CircumOffset( a , points[ triangles[ 3 * t + 1 ] ] , points[ triangles[ 3 * t + 2 ] ] );
 		}
-		answer.x = PQhash[PQmin].PQnext->vertex->coord.x ;
-		answer.y = PQhash[PQmin].PQnext->ystar ;
-		return (answer) ;
-	}
-
-	Halfedge* PQueue::extractmin()
-	{
-		Halfedge * curr ;
-
-		curr = PQhash[PQmin].PQnext ;
-		PQhash[PQmin].PQnext = curr->PQnext ;
-		PQcount-- ;
-		return (curr) ;
-	}
-
-	void  PQueue::initialize()
-	{
-		int i ;
 
-		PQcount = PQmin = 0 ;
-		PQhashsize = 4 * sqrt_nsites ;
-		PQhash = (Halfedge *)myalloc(PQhashsize * sizeof *PQhash) ;
-		for (i = 0 ; i < PQhashsize; i++)
+		//hull edge first , so walking around a hull site starts from the open side
+		for( int e = 0 ; e < (int)triangles.size() ; ++e )
 		{
-			PQhash[i].PQnext = (Halfedge *)NULL ;
+			int p = triangles[ DelaunayMesh::NextHalfedge( e ) ];
+			if ( halfedges[e] == -1 || mInEdges[p] == -1 )
+				mInEdges[p] = e;
 		}
+		return true;
 	}
 
-	extern int sqrt_nsites, siteidx ;
-
-	void freeinit(Freelist * fl, int size)
+	int VoronoiBuilder::getNeighbors( int site , std::vector< int >& outSites ) const
 	{
-		fl->head = (Freenode *)NULL ;
-		fl->nodesize = size ;
-	}
+		outSites.clear();
+		int e0 = mInEdges[ site ];
+		if ( e0 == -1 )
+			return 0;
 
-	char *
-		getfree(Freelist * fl)
-	{
-		int i ;
-		Freenode * t ;
-		if (fl->head == (Freenode *)NULL)
+		std::vector< int > const& triangles = mMesh.triangles;
+		std::vector< int > const& halfedges = mMesh.halfedges;
+
+		int e = e0;
+		do
 		{
-			t =  (Freenode *) myalloc(sqrt_nsites * fl->nodesize) ;
-			for(i = 0 ; i < sqrt_nsites ; i++)
+			outSites.push_back( triangles[e] );
+			//edge from the site , its twin ends at the site
+			int out = DelaunayMesh::NextHalfedge( e );
+			e = halfedges[ out ];
+			if ( e == -1 )
 			{
-				makefree((Freenode *)((char *)t+i*fl->nodesize), fl) ;
+				int last = triangles[ DelaunayMesh::NextHalfedge( out ) ];
+				if ( last != outSites[0] )
+					outSites.push_back( last );
+				break;
 			}
 		}
-		t = fl->head ;
-		fl->head = (fl->head)->nextfree ;
-		return ((char *)t) ;
+		while( e != e0 );
+
+		return (int)outSites.size();
 	}
 
-	void
-		makefree(Freenode * curr, Freelist * fl)
+	bool VoronoiBuilder::getCellRing( int site , Vec2d const& boundMin , Vec2d const& boundMax , std::vector< Vec2d >& outPoly ) const
 	{
-		curr->nextfree = fl->head ;
-		fl->head = curr ;
-	}
+		int e0 = mInEdges[ site ];
+		if ( e0 == -1 )
+			return false;
 
-	int total_alloc ;
+		std::vector< int > const& halfedges = mMesh.halfedges;
 
-	char *
-		myalloc(unsigned n)
-	{
-		char * t ;
-		if ((t=(char*)malloc(n)) == 0)
+		//circumcenters of the triangles around the site , in the same turn as the bound
+		int e = e0;
+		do
 		{
-			fprintf(stderr,"Insufficient memory processing site %d (%d bytes in use)\n",
-				siteidx, total_alloc) ;
-			exit(0) ;
-		}
-		total_alloc += n ;
-		return (t) ;
-	}
-
-	extern int triangulate, plot, debug ;
-	extern float ymax, ymin, xmax, xmin ;
+			Vec2d const& v = mVertices[ e / 3 ];
+			if ( v.x < boundMin.x || v.x > boundMax.x ||
+				 v.y < boundMin.y || v.y > boundMax.y )
+				return false;
+			outPoly.push_back( v );
 
-	float pxmin, pxmax, pymin, pymax, cradius;
+			e = halfedges[ DelaunayMesh::NextHalfedge( e ) ];
+			//hull site , cell is open
+			if ( e == -1 )
+				return false;
+		}
+		while( e != e0 );
 
-	void
-		openpl(void)
-	{
+		return outPoly.size() >= 3;
 	}
 
-#pragma argsused
-	void
-		line(float ax, float ay, float bx, float by)
+	int VoronoiBuilder::getCellPolygon( int site , Vec2d const& boundMin , Vec2d const& boundMax , std::vector< Vec2d >& outPoly ) const
 	{
-	}
+		outPoly.clear();
+		if ( getCellRing( site , boundMin , boundMax , outPoly ) )
+			return (int)outPoly.size();
 
-#pragma argsused
-	void
-		circle(float ax, float ay, float radius)
-	{
-	}
+		outPoly.clear();
+		if ( getNeighbors( site , mTempSites ) == 0 )
+			return 0;
 
-#pragma argsused
-	void
-		range(float pxmin, float pxmax, float pymin, float pymax)
-	{
-	}
+		outPoly.push_back( boundMin );
+		outPoly.push_back( Vec2d( boundMax.x , boundMin.y ) );
+		outPoly.push_back( boundMax );
+		outPoly.push_back( Vec2d( boundMin.x , boundMax.y ) );
 
-	void
-		out_bisector(Edge * e)
-	{
-		if (triangulate && plot && !debug)
-		{
-			line(e->reg[0]->coord.x, e->reg[0]->coord.y,
-				e->reg[1]->coord.x, e->reg[1]->coord.y) ;
-		}
-		if (!triangulate && !plot && !debug)
+		Vec2d const& s = mPoints[ site ];
+		//clip by the half plane of the bisector of each Delaunay edge
+		for( int n = 0 ; n < (int)mTempSites.size() ; ++n )
 		{
-			printf("l %f %f %f\n", e->a, e->b, e->c) ;
-		}
-		if (debug)
-		{
-			printf("line(%d) %gx+%gy=%g, bisecting %d %d\n", e->edgenbr,
-				e->a, e->b, e->c, e->reg[LEDGE]->sitenbr, e->reg[REDGE]->sitenbr) ;
-		}
-	}
+			Vec2d dir = mPoints[ mTempSites[n] ] - s;
+			double limit = 0.5 * dir.length2();
 
-	void
-		out_ep(Edge * e)
-	{
-		if (!triangulate && plot)
-		{
-			clip_line(e) ;
-		}
-		if (!triangulate && !plot)
-		{
-			printf("e %d", e->edgenbr);
-			printf(" %d ", e->ep[LEDGE] != (Site *)NULL ? e->ep[LEDGE]->sitenbr : -1) ;
-			printf("%d\n", e->ep[REDGE] != (Site *)NULL ? e->ep[REDGE]->sitenbr : -1) ;
-		}
-	}
+			mTempPoly.swap( outPoly );
+			outPoly.clear();
 
-	void
-		out_vertex(Site * v)
-	{
-		if (!triangulate && !plot && !debug)
-		{
-			printf ("v %f %f\n", v->coord.x, v->coord.y) ;
-		}
-		if (debug)
-		{
-			printf("vertex(%d) at %f %f\n", v->sitenbr, v->coord.x, v->coord.y) ;
-		}
-	}
+			int num = (int)mTempPoly.size();
+			for( int i = 0 ; i < num ; ++i )
+			{
+				Vec2d const& cur  = mTempPoly[i];
+				Vec2d const& next = mTempPoly[ ( i + 1 ) % num ];
+				double dCur  = ( cur - s ).dot( dir ) - limit;
+				double dNext = ( next - s ).dot( dir ) - limit;
 
-	void
-		out_site(Site * s)
-	{
-		if (!triangulate && plot && !debug)
-		{
-			circle (s->coord.x, s->coord.y, cradius) ;
-		}
-		if (!triangulate && !plot && !debug)
-		{
-			printf("s %f %f\n", s->coord.x, s->coord.y) ;
-		}
-		if (debug)
-		{
-			printf("site (%d) at %f %f\n", s->sitenbr, s->coord.x, s->coord.y) ;
+				if ( dCur <= 0 )
+					outPoly.push_back( cur );
+				if ( ( dCur < 0 && dNext > 0 ) || ( dCur > 0 && dNext < 0 ) )
+					outPoly.push_back( cur + ( dCur / ( dCur - dNext ) ) * ( next - cur ) );
+			}
+			if ( outPoly.size() < 3 )
+			{
+				outPoly.clear();
+				return 0;
+			}
 		}
+		return (int)outPoly.size();
 	}
 
-	void
-		out_triple(Site * s1, Site * s2, Site * s3)
+	void VoronoiBuilder::relax( Vec2d* points , int numPoint , Vec2d const& boundMin , Vec2d const& boundMax , int numIteration )
 	{
-		if (triangulate && !plot && !debug)
+		//start from the current diagram if it was built from these points
+		bool bNeedBuild = ( points != mPoints || numPoint != mNumPoint || mMesh.triangles.empty() );
+		for( int iter = 0 ; iter < numIteration ; ++iter )
 		{
-			printf("%d %d %d\n", s1->sitenbr, s2->sitenbr, s3->sitenbr) ;
-		}
-		if (debug)
-		{
-			printf("circle through left=%d right=%d bottom=%d\n",
-				s1->sitenbr, s2->sitenbr, s3->sitenbr) ;
-		}
-	}
+			if ( bNeedBuild && !build( points , numPoint ) )
+				return;
+			bNeedBuild = true;
 
-	void
-		plotinit(void)
-	{
-		float dx, dy, d ;
-
-		dy = ymax - ymin ;
-		dx = xmax - xmin ;
-		d = ( dx > dy ? dx : dy) * 1.1 ;
-		pxmin = xmin - (d-dx) / 2.0 ;
-		pxmax = xmax + (d-dx) / 2.0 ;
-		pymin = ymin - (d-dy) / 2.0 ;
-		pymax = ymax + (d-dy) / 2.0 ;
-		cradius = (pxmax - pxmin) / 350.0 ;
-		openpl() ;
-		range(pxmin, pymin, pxmax, pymax) ;
-	}
+			std::vector< int > const& triangles = mMesh.triangles;
+			std::vector< int > const& halfedges = mMesh.halfedges;
 
-	void
-		clip_line(Edge * e)
-	{
-		Site * s1, * s2 ;
-		float x1, x2, y1, y2 ;
-
-		if (e->a == 1.0 && e->b >= 0.0)
-		{
-			s1 = e->ep[1] ;
-			s2 = e->ep[0] ;
-		}
-		else
-		{
-			s1 = e->ep[0] ;
-			s2 = e->ep[1] ;
-		}
-		if (e->a == 1.0)
-		{
-			y1 = pymin ;
-			if (s1 != (Site *)NULL && s1->coord.y > pymin)
-			{
-				y1 = s1->coord.y ;
-			}
-			if (y1 > pymax)
-			{
-				return ;
-			}
-			x1 = e->c - e->b * y1 ;
-			y2 = pymax ;
-			if (s2 != (Site *)NULL && s2->coord.y < pymax)
-			{
-				y2 = s2->coord.y ;
-			}
-			if (y2 < pymin)
-			{
-				return ;
-			}
-			x2 = e->c - e->b * y2 ;
-			if (((x1 > pxmax) && (x2 > pxmax)) || ((x1 < pxmin) && (x2 < pxmin)))
-			{
-				return ;
-			}
-			if (x1 > pxmax)
-			{
-				x1 = pxmax ;
-				y1 = (e->c - x1) / e->b ;
-			}
-			if (x1 < pxmin)
-			{
-				x1 = pxmin ;
-				y1 = (e->c - x1) / e->b ;
-			}
-			if (x2 > pxmax)
-			{
-				x2 = pxmax ;
-				y2 = (e->c - x2) / e->b ;
-			}
-			if (x2 < pxmin)
-			{
-				x2 = pxmin ;
-				y2 = (e->c - x2) / e->b ;
-			}
-		}
-		else
-		{
-			x1 = pxmin ;
-			if (s1 != (Site *)NULL && s1->coord.x > pxmin)
-			{
-				x1 = s1->coord.x ;
-			}
-			if (x1 > pxmax)
-			{
-				return ;
-			}
-			y1 = e->c - e->a * x1 ;
-			x2 = pxmax ;
-			if (s2 != (Site *)NULL && s2->coord.x < pxmax)
-			{
-				x2 = s2->coord.x ;
-			}
-			if (x2 < pxmin)
-			{
-				return ;
-			}
-			y2 = e->c - e->a * x2 ;
-			if (((y1 > pymax) && (y2 > pymax)) || ((y1 < pymin) && (y2 <pymin)))
-			{
-				return ;
-			}
-			if (y1> pymax)
+			//accumulate the area weighted centroid of each closed cell edge by edge ,
+			//walking half edges in memory order instead of around every site.
+			//edge e from site p separates the triangles of the cell vertices e / 3 and halfedges[e] / 3 ,
+			//the turn is the same for all edges from p , so the sign cancels in the centroid
+			int numTri = mMesh.getTriangleNum();
+			mVertexOut.resize( numTri );
+			for( int t = 0 ; t < numTri ; ++t )
 			{
-				y1 = pymax ;
-				x1 = (e->c - y1) / e->a ;
+				Vec2d const& v = mVertices[t];
+				mVertexOut[t] = v.x < boundMin.x || v.x > boundMax.x || v.y < boundMin.y || v.y > boundMax.y;
 			}
-			if (y1 < pymin)
-			{
-				y1 = pymin ;
-				x1 = (e->c - y1) / e->a ;
-			}
-			if (y2 > pymax)
-			{
-				y2 = pymax ;
-				x2 = (e->c - y2) / e->a ;
-			}
-			if (y2 < pymin)
+
+			mCellAreas.assign( numPoint , 0 );
+			mCentroids.assign( numPoint , Vec2d( 0 , 0 ) );
+			//open cell : hull site or vertex out of bound , clip it later
+			mCellClip.assign( numPoint , 0 );
+			for( int e = 0 ; e < (int)triangles.size() ; ++e )
 			{
-				y2 = pymin ;
-				x2 = (e->c - y2) / e->a ;
+				int p = triangles[e];
+				int h = halfedges[e];
+				if ( h == -1 || mVertexOut[ e / 3 ] )
+				{
+					mCellClip[p] = 1;
+					continue;
+				}
+				Vec2d const& s = points[p];
+				Vec2d a = mVertices[ e / 3 ] - s;
+				Vec2d b = mVertices[ h / 3 ] - s;
+				double area = a.cross( b );
+				mCellAreas[p] += area;
+				mCentroids[p] += area * ( a + b );
 			}
-		}
-		line(x1,y1,x2,y2);
-	}
-
 
-	extern Site * bottomsite ;
-
-	/*** implicit parameters: nsites, sqrt_nsites, xmin, xmax, ymin, ymax,
-	: deltax, deltay (can all be estimates).
-	: Performance suffers if they are wrong; better to make nsites,
-	: deltax, and deltay too big than too small.  (?)
-	***/
-
-	void voronoi(Site *(*nextsite)(void))
-	{
-		Site * newsite, * bot, * top, * temp, * p, * v ;
-		Point newintstar ;
-		int pm ;
-		Halfedge * lbnd, * rbnd, * llbnd, * rrbnd, * bisector ;
-		Edge * e ;
-
-		mQueue.initialize() ;
-		bottomsite = (*nextsite)() ;
-		out_site(bottomsite) ;
-		mEL.initialize() ;
-		newsite = (*nextsite)() ;
-		while (1)
-		{
-			if(!mQueue.empty())
+			for( int i = 0 ; i < numPoint ; ++i )
 			{
-				newintstar = mQueue.min() ;
-			}
-			if (newsite != (Site *)NULL && (mQueue.empty()
-				|| newsite -> coord.y < newintstar.y
-				|| (newsite->coord.y == newintstar.y
-				&& newsite->coord.x < newintstar.x))) {/* new site is
-													   smallest */
-					{
-						out_site(newsite) ;
-					}
-					lbnd = mEL.leftbnd(&(newsite->coord)) ;
-					rbnd = ELright(lbnd) ;
-					bot = rightreg(lbnd) ;
-					e = bisect(bot, newsite) ;
-					bisector = mEL.create(e, LEDGE) ;
-					mEL.insert(lbnd, bisector) ;
-					p = intersect(lbnd, bisector) ;
-					if (p != (Site *)NULL)
-					{
-						mQueue.remove(lbnd) ;
-						mQueue.insert(lbnd, p, dist(p,newsite)) ;
-					}
-					lbnd = bisector ;
-					bisector = mEL.create(e, REDGE) ;
-					mEL.insert(lbnd, bisector) ;
-					p = intersect(bisector, rbnd) ;
-					if (p != (Site *)NULL)
+				if ( mCellClip[i] )
+				{
+					mCentroids[i] = points[i];
+					int num = getCellPolygon( i , boundMin , boundMax , mCellPoly );
+					if ( num == 0 )
+						continue;
+
+					//area weighted centroid of the triangle fan
+					Vec2d const& org = mCellPoly[0];
+					double area = 0;
+					Vec2d  sum( 0 , 0 );
+					for( int n = 1 ; n + 1 < num ; ++n )
 					{
-						mQueue.insert(bisector, p, dist(p,newsite)) ;
+						double a = ( mCellPoly[n] - org ).cross( mCellPoly[ n + 1 ] - org );
+						area += a;
+						sum  += a * ( org + mCellPoly[n] + mCellPoly[ n + 1 ] );
 					}
-					newsite = (*nextsite)() ;
-			}
-			else if (!mQueue.empty())   /* intersection is smallest */
-			{
-				lbnd = mQueue.extractmin() ;
-				llbnd = ELleft(lbnd) ;
-				rbnd = ELright(lbnd) ;
-				rrbnd = ELright(rbnd) ;
-				bot = leftreg(lbnd) ;
-				top = rightreg(rbnd) ;
-				out_triple(bot, top, rightreg(lbnd)) ;
-				v = lbnd->vertex ;
-				makevertex(v) ;
-				endpoint(lbnd->ELedge, lbnd->ELpm, v);
-				endpoint(rbnd->ELedge, rbnd->ELpm, v) ;
-				mEL.remove(lbnd) ;
-				mQueue.remove(rbnd) ;
-				mEL.remove(rbnd) ;
-				pm = LEDGE ;
-				if (bot->coord.y > top->coord.y)
-				{
-					temp = bot ;
-					bot = top ;
-					top = temp ;
-					pm = REDGE ;
+					if ( area != 0 )
+						mCentroids[i] = sum / ( 3 * area );
 				}
-				e = bisect(bot, top) ;
-				bisector = mEL.create(e, pm) ;
-				mEL.insert(llbnd, bisector) ;
-				endpoint(e, REDGE-pm, v) ;
-				decref(v) ;
-				p = intersect(llbnd, bisector) ;
-				if (p  != (Site *) NULL)
+				else if ( mCellAreas[i] != 0 )
 				{
-					mQueue.remove(llbnd) ;
-					mQueue.insert(llbnd, p, dist(p,bot)) ;
+					mCentroids[i] = points[i] + mCentroids[i] / ( 3 * mCellAreas[i] );
 				}
-				p = intersect(bisector, rrbnd) ;
-				if (p != (Site *) NULL)
+				else
 				{
-					mQueue.insert(bisector, p, dist(p,bot)) ;
+					//site skipped by the triangulation
+					mCentroids[i] = points[i];
 				}
 			}
-			else
-			{
-				break ;
-			}
+			std::copy( mCentroids.begin() , mCentroids.end() , points );
 		}
-
-		for( lbnd = ELright( mEL.ELleftend ) ;
-			lbnd != mEL.ELrightend ;
-			lbnd = ELright(lbnd))
-		{
-			e = lbnd->ELedge ;
-			out_ep(e) ;
-		}
-	}
-
-
-
-	Site * readone(void), * nextone(void) ;
-	void readsites(void) ;
-
-	int sorted, triangulate, plot, debug, nsites, siteidx ;
-	float xmin, xmax, ymin, ymax ;
-	Site * sites ;
-	Freelist sfl ;
-
-	int main(int argc, char *argv[])
-	{
-		int c ;
-		Site *(*next)() ;
-
-		sorted = triangulate = plot = debug = 0 ;
-#if 0
-		while ((c = getopt(argc, argv, "dpst")) != EOF)
-		{
-			switch(c)
-			{
-			case 'd':
-				debug = 1 ;
-				break ;
-			case 's':
-				sorted = 1 ;
-				break ;
-			case 't':
-				triangulate = 1 ;
-				break ;
-			case 'p':
-				plot = 1 ;
-				break ;
-			}
-		}
-#endif
-
-		freeinit(&sfl, sizeof(Site)) ;
-		if (sorted)
-		{
-			scanf("%d %f %f %f %f", &nsites, &xmin, &xmax, &ymin, &ymax) ;
-			next = readone ;
-		}
-		else
-		{
-			readsites() ;
-			next = nextone ;
-		}
-		siteidx = 0 ;
-		geominit() ;
-		if (plot)
-		{
-			plotinit() ;
-		}
-		voronoi(next) ;
-		return (0) ;
-	}
-
-	/*** sort sites on y, then x, coord ***/
-
-	int scomp(const void * vs1, const void * vs2)
-	{
-		Point * s1 = (Point *)vs1 ;
-		Point * s2 = (Point *)vs2 ;
-
-		if (s1->y < s2->y)
-		{
-			return (-1) ;
-		}
-		if (s1->y > s2->y)
-		{
-			return (1) ;
-		}
-		if (s1->x < s2->x)
-		{
-			return (-1) ;
-		}
-		if (s1->x > s2->x)
-		{
-			return (1) ;
-		}
-		return (0) ;
+		//keep the diagram of the final sites
+		build( points , numPoint );
 	}
 
-	/*** return a single in-storage site ***/
-
-	Site * nextone(void)
+	//rand() has only 15 bits on some platforms , too few for a million points
+	static unsigned BenchRandom( unsigned& seed )
 	{
-		Site * s ;
-
-		if (siteidx < nsites)
-		{
-			s = &sites[siteidx++];
-			return (s) ;
-		}
-		else
-		{
-			return ((Site *)NULL) ;
-		}
+		seed = seed * 1664525u + 1013904223u;
+		return seed >> 8;
 	}
 
-	/*** read all sites, sort, and compute xmin, xmax, ymin, ymax ***/
-
-	void readsites(void)
+	void RunBuildBenchmark( int const numPoints[] , int numCase , BuildBenchResult results[] )
 	{
-		int i ;
+		VoronoiBuilder builder;
+		std::vector< Vec2d > points;
+		TClock clock;
+		unsigned seed = 12345;
 
-		nsites = 0 ;
-		sites = (Site *) myalloc(4000 * sizeof(Site));
-		while (scanf("%f %f", &sites[nsites].coord.x,
-			&sites[nsites].coord.y) !=EOF)
+		for( int n = 0 ; n < numCase ; ++n )
 		{
-			sites[nsites].sitenbr = nsites ;
-			sites[nsites++].refcnt = 0 ;
-			if (nsites % 4000 == 0)
-				sites = (Site *)
-				realloc(sites,(nsites+4000)*sizeof(Site));
-		}
-
-		qsort((void *)sites, nsites, sizeof(Site), scomp) ;
-		xmin = sites[0].coord.x ;
-		xmax = sites[0].coord.x ;
-		for (i = 1 ; i < nsites ; ++i)
-		{
-			if(sites[i].coord.x < xmin)
-			{
-				xmin = sites[i].coord.x ;
-			}
-			if (sites[i].coord.x > xmax)
+			int num = numPoints[n];
+			points.resize( num );
+			for( int i = 0 ; i < num ; ++i )
 			{
-				xmax = sites[i].coord.x ;
+				double x = BenchRandom( seed ) / double( 1 << 24 );
+				double y = BenchRandom( seed ) / double( 1 << 24 );
+				points[i] = Vec2d( 1000 * x , 1000 * y );
 			}
-		}
-		ymin = sites[0].coord.y ;
-		ymax = sites[nsites-1].coord.y ;
-	}
 
-	/*** read one site ***/
+			BuildBenchResult& result = results[n];
+			result.numPoint = num;
 
-	Site * readone(void)
-	{
-		Site * s ;
+			clock.reset();
+			builder.build( &points[0] , num );
+			result.buildTime   = clock.getTimeMicroseconds() / 1000.0;
+			result.numTriangle = builder.getMesh().getTriangleNum();
 
-		s = (Site *)getfree(&sfl) ;
-		s->refcnt = 0 ;
-		s->sitenbr = siteidx++ ;
-		if (scanf("%f %f", &(s->coord.x), &(s->coord.y)) == EOF)
-		{
-			return ((Site *)NULL ) ;
+			clock.reset();
+			builder.relax( &points[0] , num , Vec2d( 0 , 0 ) , Vec2d( 1000 , 1000 ) , 1 );
+			result.relaxTime = clock.getTimeMicroseconds() / 1000.0;
 		}
-		return (s) ;
 	}
 
-
-}//namespace Vor2
\ No newline at end of file
+}//namespace Voronoi
@@ -12,7 +12,12 @@ namespace Voronoi
 	{
 		typedef StageBase BaseClass;
 	public:
-		TestStage(){}
+		TestStage()
+		{
+			mbRelax = false;
+			mbShowDelaunay = false;
+			mNumBench = 0;
+		}
 
 		virtual bool onInit()
 		{
@@ -40,17 +45,76 @@ namespace Voronoi
 		void onRender( float dFrame )
 		{
 			Graphics2D& g = Global::getGraphics2D();
+
+			RenderUtility::setPen( g , Color::eGray );
+			RenderUtility::setBrush( g , Color::eGray );
+			g.drawRect( Vec2i(0,0) , Global::getDrawEngine()->getScreenSize() );
+
+			DelaunayMesh const& mesh = mBuilder.getMesh();
+
+			//Voronoi edges join circumcenters of adjacent triangles
+			RenderUtility::setPen( g , Color::eYellow );
+			for( int e = 0 ; e < (int)mesh.halfedges.size() ; ++e )
+			{
+				int other = mesh.halfedges[e];
+				if ( other < e )
+					continue;
+				g.drawLine( toScreen( mBuilder.getVertex( e / 3 ) ) , toScreen( mBuilder.getVertex( other / 3 ) ) );
+			}
+
+			if ( mbShowDelaunay )
+			{
+				RenderUtility::setPen( g , Color::eBlue );
+				for( int e = 0 ; e < (int)mesh.triangles.size() ; ++e )
+				{
+					if ( mesh.halfedges[e] > e )
+						continue;
+					Vec2d const& p1 = mSites[ mesh.triangles[e] ];
+					Vec2d const& p2 = mSites[ mesh.triangles[ DelaunayMesh::NextHalfedge( e ) ] ];
+					g.drawLine( toScreen( p1 ) , toScreen( p2 ) );
+				}
+			}
+
+			RenderUtility::setPen( g , Color::eBlack );
+			RenderUtility::setBrush( g , Color::eRed );
+			for( int i = 0 ; i < (int)mSites.size() ; ++i )
+				g.drawCircle( toScreen( mSites[i] ) , 2 );
+
+			FixString< 128 > str;
+			g.setTextColor( 255 , 255 , 0 );
+			str.format( "Sites = %d Triangles = %d Lloyd = %s" , (int)mSites.size() , mesh.getTriangleNum() , mbRelax ? "On" : "Off" );
+			g.drawText( Vec2i( 10 , 10 ) , str );
+			for( int i = 0 ; i < mNumBench ; ++i )
+			{
+				BuildBenchResult const& result = mBenchResults[i];
+				str.format( "%7d points : build %.1f ms , Lloyd step %.1f ms" , result.numPoint , result.buildTime , result.relaxTime );
+				g.drawText( Vec2i( 10 , 30 + 16 * i ) , str );
+			}
 		}
 
 		void restart()
 		{
-
+			Vec2i size = Global::getDrawEngine()->getScreenSize();
+			mBoundMin = Vec2d( 0 , 0 );
+			mBoundMax = Vec2d( size.x , size.y );
+
+			mSites.resize( 300 );
+			for( int i = 0 ; i < (int)mSites.size() ; ++i )
+				mSites[i] = Vec2d( rand() % size.x , rand() % size.y );
+			updateDiagram();
 		}
 
+		void updateDiagram()
+		{
+			if ( mSites.empty() )
+				return;
+			mBuilder.build( &mSites[0] , (int)mSites.size() );
+		}
 
 		void tick()
 		{
-
+			if ( mbRelax && !mSites.empty() )
+				mBuilder.relax( &mSites[0] , (int)mSites.size() , mBoundMin , mBoundMax , 1 );
 		}
 
 		void updateFrame( int frame )
@@ -58,10 +122,23 @@ namespace Voronoi
 
 		}
 
+		void runBenchmark()
+		{
+			int const numPoints[] = { 10000 , 100000 , 1000000 };
+			mNumBench = ARRAY_SIZE( numPoints );
+			RunBuildBenchmark( numPoints , mNumBench , mBenchResults );
+		}
+
 		bool onMouse( MouseMsg const& msg )
 		{
 			if ( !BaseClass::onMouse( msg ) )
 				return false;
+
+			if ( msg.onLeftDown() )
+			{
+				mSites.push_back( Vec2d( msg.getPos().x , msg.getPos().y ) );
+				updateDiagram();
+			}
 			return true;
 		}
 
@@ -73,12 +150,24 @@ namespace Voronoi
 			switch( key )
 			{
 			case 'R': restart(); break;
+			case 'L': mbRelax = !mbRelax; break;
+			case 'D': mbShowDelaunay = !mbShowDelaunay; break;
+			case 'B': runBenchmark(); break;
 			}
 			return false;
 		}
 
 	protected:
-		Solver mSolver;
+		static Vec2i toScreen( Vec2d const& p ){ return Vec2i( int( p.x ) , int( p.y ) ); }
+
+		VoronoiBuilder       mBuilder;
+		std::vector< Vec2d > mSites;
+		Vec2d                mBoundMin;
+		Vec2d                mBoundMax;
+		bool                 mbRelax;
+		bool                 mbShowDelaunay;
+		int                  mNumBench;
+		BuildBenchResult     mBenchResults[ 3 ];
 
 	};
 
@@ -108,7 +108,7 @@ namespace AStar
 
 
 	template< class T , class Node , 
-		      template< class > class AllocatePolicy     = NewDeletePolicy , 
+		      template< class > class AllocatePolicy     = PoolAllocatePolicy , 
 		      template< class > class MapPolicy          = STLVecotorMapPolicy  , 
 		      template< class ,class > class QueuePolicy = STLHeapQueuePolicy >
 	class AStarT : private AllocatePolicy< Node >
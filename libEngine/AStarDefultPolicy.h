@@ -1,6 +1,8 @@
 #ifndef AStarDefultPolicy_h__
 #define AStarDefultPolicy_h__
 
+#include "PoolAllocator.h"
+
 #include <vector>
 #include <algorithm>
 
@@ -51,6 +53,11 @@ namespace AStar
 		void free(T* ptr){ delete ptr; }
 	};
 
+	template < class T >
+	class PoolAllocatePolicy : public TPoolAllocatePolicy< T >
+	{
+	};
+
 
 }//namespace AStar
 
@@ -0,0 +1,231 @@
+#ifndef FixedPoint_h__
+#define FixedPoint_h__
+
+#include "IntegerType.h"
+#include "TVector2.h"
+
+#include <cassert>
+
+//  Signed fixed point number in int32 with FracBits fraction bits.
+//  All ops are integer ops , so every machine gets same bits from same inputs
+//  and lockstep games can simulate with it without desync.
+template< int FracBits >
+class TFixed
+{
+public:
+	static int const   NumFracBits = FracBits;
+	static int32 const OneRaw = int32( 1 ) << FracBits;
+
+	TFixed(){}
+	//shifts of negative values are not defined before C++20 , so scale by multiply
+	TFixed( int value ):mValue( int32( value ) * OneRaw ){}
+	//only use for setup data , float rounding mode is not same everywhere
+	explicit TFixed( float value ):mValue( int32( value * OneRaw + ( value < 0 ? -0.5f : 0.5f ) ) ){}
+	explicit TFixed( double value ):mValue( int32( value * OneRaw + ( value < 0 ? -0.5 : 0.5 ) ) ){}
+
+	static TFixed FromRaw( int32 raw ){ TFixed result; result.mValue = raw; return result; }
+	//value = num / den
+	static TFixed FromRatio( int num , int den ){ return FromRaw( int32( int64( num ) * OneRaw / den ) ); }
+
+	int32  getRaw() const { return mValue; }
+	//round to negative infinity
+	int    toInt() const { return mValue >> FracBits; }
+	int    toRoundInt() const { return ( mValue + ( OneRaw >> 1 ) ) >> FracBits; }
+	float  toFloat() const { return float( mValue ) / OneRaw; }
+	double toDouble() const { return double( mValue ) / OneRaw; }
+
+	TFixed const operator - () const { return FromRaw( -mValue ); }
+
+	TFixed& operator += ( TFixed const& rhs ){ mValue += rhs.mValue; return *this; }
+	TFixed& operator -= ( TFixed const& rhs ){ mValue -= rhs.mValue; return *this; }
+	TFixed& operator *= ( TFixed const& rhs ){ mValue = int32( ( int64( mValue ) * rhs.mValue ) >> FracBits ); return *this; }
+	TFixed& operator /= ( TFixed const& rhs ){ assert( rhs.mValue ); mValue = int32( int64( mValue ) * OneRaw / rhs.mValue ); return *this; }
+
+	friend TFixed const operator + ( TFixed const& a , TFixed const& b ){ return FromRaw( a.mValue + b.mValue ); }
+	friend TFixed const operator - ( TFixed const& a , TFixed const& b ){ return FromRaw( a.mValue - b.mValue ); }
+	friend TFixed const operator * ( TFixed const& a , TFixed const& b ){ TFixed result( a ); return result *= b; }
+	friend TFixed const operator / ( TFixed const& a , TFixed const& b ){ TFixed result( a ); return result /= b; }
+
+	friend bool operator == ( TFixed const& a , TFixed const& b ){ return a.mValue == b.mValue; }
+	friend bool operator != ( TFixed const& a , TFixed const& b ){ return a.mValue != b.mValue; }
+	friend bool operator <  ( TFixed const& a , TFixed const& b ){ return a.mValue <  b.mValue; }
+	friend bool operator <= ( TFixed const& a , TFixed const& b ){ return a.mValue <= b.mValue; }
+	friend bool operator >  ( TFixed const& a , TFixed const& b ){ return a.mValue >  b.mValue; }
+	friend bool operator >= ( TFixed const& a , TFixed const& b ){ return a.mValue >= b.mValue; }
+
+private:
+	int32 mValue;
+};
+
+//range +-32767 , precision 1/65536
+typedef TFixed< 16 > Fixed;
+typedef TVector2< Fixed > Vec2x;
+
+namespace FixedMath
+{
+	//constants are kept in 28 fraction bits
+	int const ConstFracBits = 28;
+	int64 const PIRaw28     = 843314857;
+	int64 const HalfPIRaw28 = 421657428;
+	int64 const QuartPIRaw28 = 210828714;
+	//2PI = TwoPIRaw28 / 2^28 + TwoPILowRaw56 / 2^56
+	int64 const TwoPIRaw28    = 1686629713;
+	int64 const TwoPILowRaw56 = 17516050;
+
+	template< int F >
+	inline TFixed< F > MakeConst( int64 raw28 ){ return TFixed< F >::FromRaw( int32( raw28 >> ( ConstFracBits - F ) ) ); }
+
+	template< int F > inline TFixed< F > PI(){ return MakeConst< F >( PIRaw28 ); }
+	template< int F > inline TFixed< F > HalfPI(){ return MakeConst< F >( HalfPIRaw28 ); }
+
+	template< int F >
+	inline TFixed< F > Abs( TFixed< F > const& v ){ return ( v.getRaw() < 0 ) ? -v : v; }
+	template< int F >
+	inline TFixed< F > Min( TFixed< F > const& a , TFixed< F > const& b ){ return ( a < b ) ? a : b; }
+	template< int F >
+	inline TFixed< F > Max( TFixed< F > const& a , TFixed< F > const& b ){ return ( a > b ) ? a : b; }
+	template< int F >
+	inline TFixed< F > Clamp( TFixed< F > const& v , TFixed< F > const& minV , TFixed< F > const& maxV ){ return Min( Max( minV , v ) , maxV ); }
+	template< int F >
+	inline TFixed< F > Floor( TFixed< F > const& v ){ return TFixed< F >::FromRaw( v.getRaw() & ~( TFixed< F >::OneRaw - 1 ) ); }
+
+	inline uint64 ISqrt( uint64 value )
+	{
+		uint64 result = 0;
+		uint64 bit = uint64( 1 ) << 62;
+		while( bit > value )
+			bit >>= 2;
+		while( bit )
+		{
+			if ( value >= result + bit )
+			{
+				value -= result + bit;
+				result = ( result >> 1 ) + bit;
+			}
+			else
+			{
+				result >>= 1;
+			}
+			bit >>= 2;
+		}
+		return result;
+	}
+
+	template< int F >
+	inline TFixed< F > Sqrt( TFixed< F > const& v )
+	{
+		if ( v.getRaw() <= 0 )
+			return TFixed< F >( 0 );
+		return TFixed< F >::FromRaw( int32( ISqrt( uint64( v.getRaw() ) << F ) ) );
+	}
+
+	template< int F >
+	inline TFixed< F > Sin( TFixed< F > const& angle )
+	{
+		typedef TFixed< F > T;
+		//reduce in 28 fraction bits , the low part of 2PI is taken off too ,
+		//so the error doesn't grow with the number of turns in the angle
+		int64 const scale = int64( 1 ) << ( ConstFracBits - F );
+		int64 x = int64( angle.getRaw() ) * scale;
+		int64 turn = x / TwoPIRaw28;
+		x -= turn * TwoPIRaw28;
+		x -= turn * TwoPILowRaw56 / ( int64( 1 ) << ConstFracBits );
+
+		//to [ -PI , PI ] , then [ -PI/2 , PI/2 ]
+		if ( x > PIRaw28 )
+			x -= TwoPIRaw28;
+		else if ( x < -PIRaw28 )
+			x += TwoPIRaw28;
+		if ( x > HalfPIRaw28 )
+			x = PIRaw28 - x;
+		else if ( x < -HalfPIRaw28 )
+			x = -PIRaw28 - x;
+		x = ( x + ( x < 0 ? -scale : scale ) / 2 ) / scale;
+
+		//taylor series to x^11 , error is under the precision
+		T v = T::FromRaw( int32( x ) );
+		T s = v * v;
+		T r = T( 1 ) - s / T( 110 );
+		r = T( 1 ) - s / T( 72 ) * r;
+		r = T( 1 ) - s / T( 42 ) * r;
+		r = T( 1 ) - s / T( 20 ) * r;
+		r = T( 1 ) - s / T( 6 ) * r;
+		return v * r;
+	}
+
+	template< int F >
+	inline TFixed< F > Cos( TFixed< F > const& angle ){ return Sin( HalfPI< F >() - angle ); }
+
+	template< int F >
+	inline void SinCos( TFixed< F > const& angle , TFixed< F >& s , TFixed< F >& c ){ s = Sin( angle ); c = Cos( angle ); }
+
+	//z in [ -tan(PI/8) , tan(PI/8) ]
+	template< int F >
+	inline TFixed< F > ATanSmall( TFixed< F > const& z )
+	{
+		typedef TFixed< F > T;
+		T s = z * z;
+		T r = T( 1 ) / T( 9 ) - s / T( 11 );
+		r = T( 1 ) / T( 7 ) - s * r;
+		r = T( 1 ) / T( 5 ) - s * r;
+		r = T( 1 ) / T( 3 ) - s * r;
+		r = T( 1 ) - s * r;
+		return z * r;
+	}
+
+	template< int F >
+	inline TFixed< F > ATan2( TFixed< F > const& y , TFixed< F > const& x )
+	{
+		typedef TFixed< F > T;
+		T ax = Abs( x );
+		T ay = Abs( y );
+		if ( ax.getRaw() == 0 && ay.getRaw() == 0 )
+			return T( 0 );
+
+		//angle in [ 0 , PI/4 ] , then mirror to other octants
+		bool bSwap = ay > ax;
+		T z = bSwap ? ( ax / ay ) : ( ay / ax );
+		T angle;
+		//tan(PI/8)
+		if ( z > MakeConst< F >( 111189606 ) )
+			angle = MakeConst< F >( QuartPIRaw28 ) + ATanSmall( ( z - T( 1 ) ) / ( z + T( 1 ) ) );
+		else
+			angle = ATanSmall( z );
+
+		if ( bSwap )
+			angle = HalfPI< F >() - angle;
+		if ( x.getRaw() < 0 )
+			angle = PI< F >() - angle;
+		if ( y.getRaw() < 0 )
+			angle = -angle;
+		return angle;
+	}
+
+	//squares are summed in 64 bits , result saturates to max value if the length is out of range
+	template< int F >
+	inline TFixed< F > Length( TVector2< TFixed< F > > const& v )
+	{
+		int64 x = v.x.getRaw();
+		int64 y = v.y.getRaw();
+		uint64 len = ISqrt( uint64( x * x ) + uint64( y * y ) );
+		if ( len > uint64( 0x7fffffff ) )
+			len = 0x7fffffff;
+		return TFixed< F >::FromRaw( int32( len ) );
+	}
+
+	//scale by larger component first , so any vector in range can be normalized
+	template< int F >
+	inline TVector2< TFixed< F > > Normalize( TVector2< TFixed< F > > const& v )
+	{
+		typedef TFixed< F > T;
+		T m = Max( Abs( v.x ) , Abs( v.y ) );
+		if ( m.getRaw() == 0 )
+			return TVector2< T >( 0 , 0 );
+		TVector2< T > dir( v.x / m , v.y / m );
+		T len = Length( dir );
+		return TVector2< T >( dir.x / len , dir.y / len );
+	}
+
+}//namespace FixedMath
+
+#endif // FixedPoint_h__
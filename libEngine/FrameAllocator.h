@@ -3,10 +3,24 @@
 
 #include "IntegerType.h"
 #include <new>
+#include <cstdlib>
+#include <cstddef>
 
+template< class T >
+struct TAlignOf
+{
+	struct Helper { char c; T value; };
+	enum { Value = sizeof( Helper ) - sizeof( T ) };
+};
+
+//  Linear allocator for temporaries , memory is only released by clearFrame.
+//  clearFrame merges the pages used by the frame into one page , so capacity
+//  grows to the peak frame usage and later frames don't call malloc.
 class FrameAllocator
 {
 public:
+	static size_t const DefaultAlign = 16;
+
 	FrameAllocator( size_t size )
 	{
 		mUsageSize = 0;
@@ -16,82 +30,144 @@ public:
 
 	~FrameAllocator()
 	{
-		Page* page = mUsage;
-		while( page )
-		{ 
-			Page* next = page->link;  
-			::free( page );
-			page = next;
-		};
+		freePages( mUsage );
 	}
 
-	void* alloc( size_t size )
+	void* alloc( size_t size , size_t align = DefaultAlign )
 	{
-		if ( mUsage->size < mUsageSize + size )
+		size_t offset = calcAlignOffset( mUsage , mUsageSize , align );
+		if ( mUsage->size < offset + size )
 		{
-			Page* page = allocPage( mUsage->size * 2 );
+			size_t pageSize = mUsage->size * 2;
+			if ( pageSize < size + align )
+				pageSize = size + align;
+
+			Page* page = allocPage( pageSize );
 			page->link = mUsage;
 			mUsage = page;
-			mUsageSize = 0;
+			offset = calcAlignOffset( mUsage , 0 , align );
 		}
 
-		uint8* out = &mUsage->storage[0] + mUsageSize;
-		mUsageSize += size;
+		uint8* out = mUsage->storage + offset;
+		mUsageSize = offset + size;
 		return out;
 	}
 
 	void clearFrame()
 	{
-		Page* page = mUsage->link;
-		while( page )
-		{ 
-			Page* next = page->link;  
-			::free( page );
-			page = next;
-		};
-		mUsage->link = NULL;
+		if ( mUsage->link )
+		{
+			size_t totalSize = 0;
+			for( Page* page = mUsage ; page ; page = page->link )
+				totalSize += page->size;
+
+			freePages( mUsage );
+			mUsage = allocPage( totalSize );
+			mUsage->link = NULL;
+		}
 		mUsageSize = 0;
 	}
 
+	size_t getCapacity() const
+	{
+		size_t result = 0;
+		for( Page* page = mUsage ; page ; page = page->link )
+			result += page->size;
+		return result;
+	}
+
+private:
+
 	struct Page
 	{
 		size_t size;
 		Page*  link;
-		uint8  storage[0];
+		uint8  storage[1];
 	};
 
+	static size_t calcAlignOffset( Page* page , size_t offset , size_t align )
+	{
+		size_t addr = size_t( page->storage ) + offset;
+		return offset + ( ( align - ( addr & ( align - 1 ) ) ) & ( align - 1 ) );
+	}
 
-	Page* allocPage( size_t size )
+	static Page* allocPage( size_t size )
 	{
-		Page* page = (Page*)::malloc( size + sizeof( Page ) );
+		Page* page = (Page*)::malloc( size + offsetof( Page , storage ) );
+		if ( !page )
+			throw std::bad_alloc();
 		page->size = size;
 		return page;
 	}
 
+	static void freePages( Page* page )
+	{
+		while( page )
+		{
+			Page* next = page->link;
+			::free( page );
+			page = next;
+		}
+	}
+
 	Page*  mUsage;
-	int    mUsageSize;
+	size_t mUsageSize;
+};
+
+//  STL allocator over a FrameAllocator , deallocate does nothing.
+//  Container must not live past the clearFrame of the allocator.
+template< class T >
+class TFrameStlAllocator
+{
+public:
+	typedef T         value_type;
+	typedef T*        pointer;
+	typedef T const*  const_pointer;
+	typedef T&        reference;
+	typedef T const&  const_reference;
+	typedef size_t    size_type;
+	typedef ptrdiff_t difference_type;
+
+	template< class U >
+	struct rebind { typedef TFrameStlAllocator< U > other; };
 
+	explicit TFrameStlAllocator( FrameAllocator& allocator ):mAllocator( &allocator ){}
+	template< class U >
+	TFrameStlAllocator( TFrameStlAllocator< U > const& rhs ):mAllocator( rhs.mAllocator ){}
+
+	pointer   address( reference value ) const { return &value; }
+	const_pointer address( const_reference value ) const { return &value; }
+
+	pointer   allocate( size_type num , void const* = 0 )
+	{
+		return static_cast< pointer >( mAllocator->alloc( num * sizeof( T ) , TAlignOf< T >::Value ) );
+	}
+	void      deallocate( pointer , size_type ){}
+	size_type max_size() const { return size_type( -1 ) / sizeof( T ); }
+
+	void      construct( pointer ptr , T const& value ){ ::new ( (void*)ptr ) T( value ); }
+	void      destroy( pointer ptr ){ ptr->~T(); }
+
+	template< class U >
+	bool operator == ( TFrameStlAllocator< U > const& rhs ) const { return mAllocator == rhs.mAllocator; }
+	template< class U >
+	bool operator != ( TFrameStlAllocator< U > const& rhs ) const { return mAllocator != rhs.mAllocator; }
+
+	FrameAllocator* mAllocator;
 };
 
 inline void* operator new ( size_t size , FrameAllocator& allocator  )
 {
-	void* out = allocator.alloc( size );
-	if ( !out )
-		throw std::bad_alloc();
-
-	return out;
+	return allocator.alloc( size );
 }
 
 inline void* operator new[] ( size_t size , FrameAllocator& allocator  )
 {
-	void* out = allocator.alloc( size );
-	if ( !out )
-		throw std::bad_alloc();
-
-	return out;
+	return allocator.alloc( size );
 }
 
-
-
+//only called when constructor throws
+inline void operator delete ( void* , FrameAllocator& ){}
+inline void operator delete[] ( void* , FrameAllocator& ){}
 
 #endif // FrameAllocator_h__
@@ -36,6 +36,8 @@ protected:
 	void onEnd()                    {}
 	long onUpdate( long shouldTime ){ return shouldTime; }
 	void onRender()                 {}
+	//end of loop , temporaries of the tick can be released here
+	void onEndTick()                {}
 
 
 private:
@@ -71,6 +73,7 @@ void GameLoopT< T , PP >::run()
 			}
 			long updateTime = _this()->onUpdate( intervalTime );
 			_this()->onRender();
+			_this()->onEndTick();
 
 			beforeTime += updateTime;
 			mFrameTime += updateTime;
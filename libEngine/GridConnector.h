@@ -0,0 +1,138 @@
+#ifndef GridConnector_h__
+#define GridConnector_h__
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+class GridVisitMap
+{
+public:
+	GridVisitMap(){ mNumCell = 0; }
+
+	void resize( int numCell )
+	{
+		mNumCell = numCell;
+		mBits.resize( ( numCell + 31 ) / 32 );
+		clear();
+	}
+	int  getCellNum() const { return mNumCell; }
+	void clear(){ std::fill( mBits.begin() , mBits.end() , 0 ); }
+
+	bool test( int idx ) const
+	{
+		assert( 0 <= idx && idx < mNumCell );
+		return ( mBits[ idx >> 5 ] & ( 1u << ( idx & 31 ) ) ) != 0;
+	}
+	void mark( int idx )
+	{
+		assert( 0 <= idx && idx < mNumCell );
+		mBits[ idx >> 5 ] |= ( 1u << ( idx & 31 ) );
+	}
+	//return false if idx was marked
+	bool testAndMark( int idx )
+	{
+		assert( 0 <= idx && idx < mNumCell );
+		unsigned& word = mBits[ idx >> 5 ];
+		unsigned  bit  = 1u << ( idx & 31 );
+		if ( word & bit )
+			return false;
+		word |= bit;
+		return true;
+	}
+
+private:
+	std::vector< unsigned > mBits;
+	int mNumCell;
+};
+
+//  Linker for TGrid2D index ( x + sizeX * y ) with 4 neighbors
+class GridLinker4
+{
+public:
+	GridLinker4( int sizeX , int sizeY ):mSizeX( sizeX ),mSizeY( sizeY ){}
+
+	int  getLinkNum() const { return 4; }
+	int  getLinkIndex( int idx , int dir ) const
+	{
+		int x = idx % mSizeX;
+		switch( dir )
+		{
+		case 0: return ( x + 1 < mSizeX ) ? idx + 1 : -1;
+		case 1: return ( idx + mSizeX < mSizeX * mSizeY ) ? idx + mSizeX : -1;
+		case 2: return ( x > 0 ) ? idx - 1 : -1;
+		case 3: return ( idx >= mSizeX ) ? idx - mSizeX : -1;
+		}
+		return -1;
+	}
+protected:
+	int mSizeX;
+	int mSizeY;
+};
+
+//  Iterative search of connected cells. The stack is kept between searches ,
+//  so a level can hold one connector and run many searches per frame.
+//
+//  Linker must provide :
+//    int  getLinkNum() const
+//    int  getLinkIndex( int idx , int dir ) const  - return -1 if no cell
+//    bool visit( int idx )  - mark the cell , return false if the cell is not
+//                             in the group or was visited
+//  The connector doesn't clear marks , so several searches can share them.
+class GridConnector
+{
+public:
+	struct NullOutput
+	{
+		NullOutput& operator * (){ return *this; }
+		NullOutput& operator ++ (){ return *this; }
+		NullOutput& operator ++ (int){ return *this; }
+		template< class T >
+		NullOutput& operator = ( T const& ){ return *this; }
+	};
+
+	template< class Linker >
+	int collect( int idxStart , Linker& linker )
+	{
+		return collect( idxStart , linker , NullOutput() );
+	}
+
+	template< class Linker , class OutIterator >
+	int collect( int idxStart , Linker& linker , OutIterator out )
+	{
+		if ( !linker.visit( idxStart ) )
+			return 0;
+
+		mStack.clear();
+		mStack.push_back( idxStart );
+
+		int num = 0;
+		int numLink = linker.getLinkNum();
+		while( !mStack.empty() )
+		{
+			int idx = mStack.back();
+			mStack.pop_back();
+
+			*out = idx;
+			++out;
+			++num;
+
+			for( int dir = 0 ; dir < numLink ; ++dir )
+			{
+				int idxLink = linker.getLinkIndex( idx , dir );
+				if ( idxLink < 0 )
+					continue;
+				if ( linker.visit( idxLink ) )
+					mStack.push_back( idxLink );
+			}
+		}
+		return num;
+	}
+
+	void reserve( int numCell ){ mStack.reserve( numCell ); }
+
+private:
+	std::vector< int > mStack;
+};
+
+#endif // GridConnector_h__
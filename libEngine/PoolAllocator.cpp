@@ -0,0 +1,232 @@
+#include "PoolAllocator.h"
+
+#include "CompilerConfig.h"
+#include "Thread.h"
+
+#include <cstdlib>
+#include <cassert>
+
+#if defined ( CPP_COMPILER_MSVC )
+#	define POOL_THREAD_LOCAL __declspec( thread )
+#else
+#	define POOL_THREAD_LOCAL __thread
+#endif
+
+namespace
+{
+	int const NumSizeClass = 16;
+	size_t const ClassSize[ NumSizeClass ] =
+	{
+		8 , 16 , 24 , 32 , 40 , 48 , 56 , 64 ,
+		80 , 96 , 112 , 128 , 160 , 192 , 224 , 256 ,
+	};
+	size_t const ChunkSize = 64 * 1024;
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	//blocks moved between thread cache and depot at once
+	int CalcBatchNum( int idxClass )
+	{
+		int num = int( 4096 / ClassSize[ idxClass ] );
+		if ( num < 8 )
+			return 8;
+		if ( num > 64 )
+			return 64;
+		return num;
+	}
+
+	class Depot
+	{
+	public:
+		Depot()
+		{
+			for( int i = 0 ; i < NumSizeClass ; ++i )
+				mFreeList[i] = NULL;
+		}
+
+		//return num blocks linked
+		FreeBlock* fetch( int idxClass , int num )
+		{
+			Mutex::Locker locker( mMutex[ idxClass ] );
+
+			FreeBlock* head = NULL;
+			for( int i = 0 ; i < num ; ++i )
+			{
+				FreeBlock* block = mFreeList[ idxClass ];
+				if ( !block )
+				{
+					block = allocChunk( idxClass );
+					if ( !block )
+						break;
+				}
+				mFreeList[ idxClass ] = block->next;
+				block->next = head;
+				head = block;
+			}
+			return head;
+		}
+
+		void release( int idxClass , FreeBlock* head , FreeBlock* tail )
+		{
+			Mutex::Locker locker( mMutex[ idxClass ] );
+			tail->next = mFreeList[ idxClass ];
+			mFreeList[ idxClass ] = head;
+		}
+
+	private:
+		//chunk memory is never returned , blocks of it stay in pool
+		FreeBlock* allocChunk( int idxClass )
+		{
+			char* chunk = (char*)::malloc( ChunkSize );
+			if ( !chunk )
+				return NULL;
+
+			size_t size = ClassSize[ idxClass ];
+			size_t num  = ChunkSize / size;
+			for( size_t i = 0 ; i < num ; ++i )
+			{
+				FreeBlock* block = reinterpret_cast< FreeBlock* >( chunk + i * size );
+				block->next = ( i + 1 < num ) ? reinterpret_cast< FreeBlock* >( chunk + ( i + 1 ) * size ) : NULL;
+			}
+			mFreeList[ idxClass ] = reinterpret_cast< FreeBlock* >( chunk );
+			return mFreeList[ idxClass ];
+		}
+
+		Mutex      mMutex[ NumSizeClass ];
+		FreeBlock* mFreeList[ NumSizeClass ];
+	};
+
+	//created on first use , so allocs from static constructors of any unit are safe
+	Depot& GetDepot()
+	{
+		static Depot depot;
+		return depot;
+	}
+	//local statics are not thread safe in VC2008 , make sure the depot is created
+	//during static init , before any thread can use the pool
+	Depot& gDepotInit = GetDepot();
+
+	struct ThreadCache
+	{
+		FreeBlock* freeList[ NumSizeClass ];
+		int        numFree[ NumSizeClass ];
+	};
+	POOL_THREAD_LOCAL ThreadCache* gThreadCache = NULL;
+
+	ThreadCache& GetThreadCache()
+	{
+		if ( !gThreadCache )
+		{
+			gThreadCache = (ThreadCache*)::malloc( sizeof( ThreadCache ) );
+			if ( !gThreadCache )
+				throw std::bad_alloc();
+			for( int i = 0 ; i < NumSizeClass ; ++i )
+			{
+				gThreadCache->freeList[i] = NULL;
+				gThreadCache->numFree[i]  = 0;
+			}
+		}
+		return *gThreadCache;
+	}
+
+	void ReleaseBlocks( ThreadCache& cache , int idxClass , int num )
+	{
+		FreeBlock* head = cache.freeList[ idxClass ];
+		FreeBlock* tail = head;
+		for( int i = 1 ; i < num ; ++i )
+			tail = tail->next;
+
+		cache.freeList[ idxClass ] = tail->next;
+		cache.numFree[ idxClass ] -= num;
+		GetDepot().release( idxClass , head , tail );
+	}
+
+}//namespace
+
+int PoolAllocator::GetSizeClass( size_t size )
+{
+	assert( size <= MaxPoolSize );
+	//classes step 8 up to 64 , 16 up to 128 , 32 up to 256
+	if ( size <= 64 )
+		return ( size == 0 ) ? 0 : int( ( size + 7 ) / 8 ) - 1;
+	if ( size <= 128 )
+		return 7 + int( ( size - 64 + 15 ) / 16 );
+	return 11 + int( ( size - 128 + 31 ) / 32 );
+}
+
+size_t PoolAllocator::GetClassSize( int idxClass )
+{
+	return ClassSize[ idxClass ];
+}
+
+void* PoolAllocator::Alloc( size_t size )
+{
+	if ( size > MaxPoolSize )
+	{
+		void* ptr = ::malloc( size );
+		if ( !ptr )
+			throw std::bad_alloc();
+		return ptr;
+	}
+
+	int idxClass = GetSizeClass( size );
+	ThreadCache& cache = GetThreadCache();
+
+	FreeBlock* block = cache.freeList[ idxClass ];
+	if ( !block )
+	{
+		int num = CalcBatchNum( idxClass );
+		block = GetDepot().fetch( idxClass , num );
+		if ( !block )
+			throw std::bad_alloc();
+
+		for( FreeBlock* cur = block ; cur ; cur = cur->next )
+			++cache.numFree[ idxClass ];
+	}
+
+	cache.freeList[ idxClass ] = block->next;
+	--cache.numFree[ idxClass ];
+	return block;
+}
+
+void PoolAllocator::Free( void* ptr , size_t size )
+{
+	if ( !ptr )
+		return;
+
+	if ( size > MaxPoolSize )
+	{
+		::free( ptr );
+		return;
+	}
+
+	int idxClass = GetSizeClass( size );
+	ThreadCache& cache = GetThreadCache();
+
+	FreeBlock* block = static_cast< FreeBlock* >( ptr );
+	block->next = cache.freeList[ idxClass ];
+	cache.freeList[ idxClass ] = block;
+	++cache.numFree[ idxClass ];
+
+	//keep one batch for next allocs , give the others back
+	int num = CalcBatchNum( idxClass );
+	if ( cache.numFree[ idxClass ] >= 2 * num )
+		ReleaseBlocks( cache , idxClass , num );
+}
+
+void PoolAllocator::FlushThreadCache()
+{
+	if ( !gThreadCache )
+		return;
+
+	for( int i = 0 ; i < NumSizeClass ; ++i )
+	{
+		if ( gThreadCache->numFree[i] )
+			ReleaseBlocks( *gThreadCache , i , gThreadCache->numFree[i] );
+	}
+	::free( gThreadCache );
+	gThreadCache = NULL;
+}
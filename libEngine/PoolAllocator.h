@@ -0,0 +1,37 @@
+#ifndef PoolAllocator_h__
+#define PoolAllocator_h__
+
+#include <cstddef>
+#include <new>
+
+//  Small object allocator with size classes.
+//  Each thread keeps free lists of blocks per class and moves blocks from/to
+//  a central depot in batches , so most calls take no lock.
+//  Free must get the same size as Alloc , size over MaxPoolSize goes to malloc.
+class PoolAllocator
+{
+public:
+	static size_t const MaxPoolSize = 256;
+
+	static void* Alloc( size_t size );
+	static void  Free( void* ptr , size_t size );
+	//return cached blocks of calling thread to depot , ThreadT calls it when run returns
+	static void  FlushThreadCache();
+
+	static int   GetSizeClass( size_t size );
+	static size_t GetClassSize( int idxClass );
+};
+
+template< class T >
+class TPoolAllocatePolicy
+{
+public:
+	T*   alloc(){ return new ( PoolAllocator::Alloc( sizeof( T ) ) ) T; }
+	void free( T* ptr )
+	{
+		ptr->~T();
+		PoolAllocator::Free( ptr , sizeof( T ) );
+	}
+};
+
+#endif // PoolAllocator_h__
@@ -1,6 +1,8 @@
 #ifndef TQuadTree_h__
 #define TQuadTree_h__
 
+#include "PoolAllocator.h"
+
 
 enum NodeFlag
 {
@@ -95,10 +97,10 @@ protected:
 	void onMergeNode( GrayNode* node ){}
 	void onClearNode( Node* node ){}
 
-	GrayNode* createGrayNode(){  return new GrayNode;  }
-	LeafNode* createLeafNode(){  return new LeafNode;  }
-	void      destoryNode( LeafNode* node ){  delete node;  }
-	void      destoryNode( GrayNode* node ){  delete node;  }
+	GrayNode* createGrayNode(){  return TPoolAllocatePolicy< GrayNode >().alloc();  }
+	LeafNode* createLeafNode(){  return TPoolAllocatePolicy< LeafNode >().alloc();  }
+	void      destoryNode( LeafNode* node ){  TPoolAllocatePolicy< LeafNode >().free( node );  }
+	void      destoryNode( GrayNode* node ){  TPoolAllocatePolicy< GrayNode >().free( node );  }
 ////////////////////////////////
 
 public:
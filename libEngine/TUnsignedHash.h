@@ -1,6 +1,8 @@
 #ifndef TUnsignedHash_h__
 #define TUnsignedHash_h__
 
+#include "PoolAllocator.h"
+
 #include <algorithm>
 
 #define END_ADDRESS ((void*)-1)
@@ -16,7 +18,7 @@ namespace Private
 }
 
 
-template< class T , template < class > class AllocatePolicy >
+template< class T , template < class > class AllocatePolicy = TPoolAllocatePolicy >
 class TUnisgnedHash : private AllocatePolicy< Private::Node< T > >
 {
 public:
@@ -0,0 +1,9 @@
+#include "Thread.h"
+
+#include "PoolAllocator.h"
+
+void OnThreadExit()
+{
+	//blocks cached by this thread would be lost after exit
+	PoolAllocator::FlushThreadCache();
+}
@@ -4,6 +4,9 @@
 #include "Win32Header.h"
 #include <process.h>
 
+//called on a ThreadT thread after run returns , releases per thread data of engine systems
+void OnThreadExit();
+
 class WinThread
 {
 public:
@@ -84,6 +87,7 @@ private:
 	{
 		ThreadT* ptrThread = static_cast< ThreadT* >( t );
 		unsigned reault = ptrThread->_this()->run();
+		OnThreadExit();
 		ptrThread->endRunning( reault );
 		return reault;
 	}